@@ -0,0 +1,238 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE BUFFER POOL
+// Stream audio buffers reserved up front in a few size classes and recycled, so
+// opening a stream does not wait on page allocation. Portable: builds against the
+// WDK or the host stand-ins; where the memory comes from is a PageSource.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#define LEYLINE_POOL_MAX_CLASSES    4
+#define LEYLINE_POOL_MAX_BLOCKS     32          // Per class: one bit each in the free mask
+#define LEYLINE_POOL_UNPOOLED       0xFFFFFFFF  // PoolBuffer::Class of a miss
+
+// A piece of backing memory: its address and whatever the source needs to give it
+// back (the MDL, in the driver).
+struct PoolBlock
+{
+    PVOID   Address;
+    PVOID   Handle;
+    SIZE_T  Bytes;
+};
+
+// Where blocks come from: locked, kernel-mapped pages in the driver, plain memory
+// on the host. Allocate is only called at PASSIVE_LEVEL.
+class PageSource
+{
+public:
+    virtual NTSTATUS Allocate(SIZE_T bytes, PoolBlock* block) = 0;
+    virtual void     Free(const PoolBlock& block) = 0;
+};
+
+struct BufferPoolClass
+{
+    SIZE_T  BlockBytes;
+    ULONG   Blocks;             // 1 .. LEYLINE_POOL_MAX_BLOCKS
+};
+
+// A buffer handed out by the pool; give it back through Release.
+struct PoolBuffer
+{
+    PoolBlock   Block;          // Block.Bytes may exceed what was asked for
+    ULONG       Class;          // LEYLINE_POOL_UNPOOLED: straight from the source
+    ULONG       Index;
+};
+
+struct LeylineBufferPoolClassStats
+{
+    ULONG   BlockBytes;
+    ULONG   Blocks;             // Reserved; fewer than configured if memory ran short
+    ULONG   InUse;
+    ULONG   HighWater;          // Most ever in use at once
+};
+
+// Output of IOCTL_LEYLINE_GET_BUFFER_POOL_STATS.
+struct LeylineBufferPoolStats
+{
+    ULONG   Classes;
+    ULONG   Hits;               // Served from a reserved block
+    ULONG   Misses;             // Served straight from the source: every class busy, or too big
+    ULONG   Unpooled;           // Misses not yet released
+    LeylineBufferPoolClassStats Class[LEYLINE_POOL_MAX_CLASSES];
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BUFFER POOL
+// Each class keeps its free blocks as bits of one mask. Acquire takes the lowest
+// set bit of the smallest class that fits with a compare-exchange, moving up a
+// class if that one is empty; Release sets the bit again. No locks and no lists,
+// so no ABA, and both are O(classes).
+//
+// Reserve and Shutdown run at PASSIVE_LEVEL with no buffer outstanding; Acquire
+// and Release may race each other freely.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class BufferPool
+{
+public:
+    BufferPool() : m_Source(nullptr), m_Classes(0), m_Hits(0), m_Misses(0), m_Unpooled(0)
+    {
+        RtlZeroMemory(m_Class, sizeof(m_Class));
+    }
+
+    // `classes` must be in ascending BlockBytes. A class the source cannot fill
+    // keeps the blocks it got; only a source that yields nothing at all fails.
+    NTSTATUS Reserve(PageSource* source, const BufferPoolClass* classes, ULONG count)
+    {
+        if (!source || !classes || count == 0 || count > LEYLINE_POOL_MAX_CLASSES || m_Source)
+            return STATUS_INVALID_PARAMETER;
+        for (ULONG c = 0; c < count; ++c)
+        {
+            if (classes[c].BlockBytes == 0 || classes[c].Blocks == 0 || classes[c].Blocks > LEYLINE_POOL_MAX_BLOCKS ||
+                (c > 0 && classes[c].BlockBytes <= classes[c - 1].BlockBytes))
+                return STATUS_INVALID_PARAMETER;
+        }
+
+        ULONG reserved = 0;
+        for (ULONG c = 0; c < count; ++c)
+        {
+            Class& cls = m_Class[c];
+            cls.BlockBytes = classes[c].BlockBytes;
+            cls.Blocks     = 0;
+            for (ULONG i = 0; i < classes[c].Blocks; ++i)
+            {
+                if (!NT_SUCCESS(source->Allocate(cls.BlockBytes, &cls.Block[i]))) break;
+                cls.Blocks++;
+            }
+            cls.FreeMask = cls.Blocks == 32 ? (LONG)0xFFFFFFFF : (LONG)((1u << cls.Blocks) - 1);
+            reserved += cls.Blocks;
+        }
+
+        m_Classes = count;
+        m_Source  = source;
+        if (reserved == 0)
+        {
+            Shutdown();
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+        return STATUS_SUCCESS;
+    }
+
+    // Hands every reserved block back to the source.
+    void Shutdown()
+    {
+        for (ULONG c = 0; c < m_Classes; ++c)
+        {
+            for (ULONG i = 0; i < m_Class[c].Blocks; ++i) m_Source->Free(m_Class[c].Block[i]);
+        }
+        RtlZeroMemory(m_Class, sizeof(m_Class));
+        m_Classes = 0;
+        m_Source  = nullptr;
+    }
+
+    BOOLEAN IsReady() const { return m_Source != nullptr; }
+
+    // The source Reserve was given, so its owner can free it after Shutdown.
+    PageSource* GetSource() const { return m_Source; }
+
+    // A reserved block of at least `bytes`, or failing that a fresh one from the
+    // source. Contents are whatever the last user left.
+    NTSTATUS Acquire(SIZE_T bytes, PoolBuffer* buffer)
+    {
+        if (!m_Source || bytes == 0) return STATUS_INVALID_PARAMETER;
+
+        for (ULONG c = 0; c < m_Classes; ++c)
+        {
+            Class& cls = m_Class[c];
+            if (cls.BlockBytes < bytes) continue;
+
+            LONG mask = ReadAcquire(&cls.FreeMask);
+            while (mask)
+            {
+                ULONG index;
+                BitScanForward(&index, (ULONG)mask);
+                LONG seen = InterlockedCompareExchange(&cls.FreeMask, mask & ~(LONG)(1u << index), mask);
+                if (seen != mask) { mask = seen; continue; }
+
+                NoteInUse(cls, InterlockedIncrement(&cls.InUse));
+                InterlockedIncrement(&m_Hits);
+                buffer->Block = cls.Block[index];
+                buffer->Class = c;
+                buffer->Index = index;
+                return STATUS_SUCCESS;
+            }
+        }
+
+        NTSTATUS status = m_Source->Allocate(bytes, &buffer->Block);
+        if (!NT_SUCCESS(status)) return status;
+        InterlockedIncrement(&m_Misses);
+        InterlockedIncrement(&m_Unpooled);
+        buffer->Class = LEYLINE_POOL_UNPOOLED;
+        buffer->Index = 0;
+        return STATUS_SUCCESS;
+    }
+
+    void Release(const PoolBuffer& buffer)
+    {
+        if (buffer.Class == LEYLINE_POOL_UNPOOLED)
+        {
+            m_Source->Free(buffer.Block);
+            InterlockedDecrement(&m_Unpooled);
+            return;
+        }
+
+        Class& cls = m_Class[buffer.Class];
+        InterlockedDecrement(&cls.InUse);
+        InterlockedOr(&cls.FreeMask, (LONG)(1u << buffer.Index));
+    }
+
+    void GetStats(LeylineBufferPoolStats* stats) const
+    {
+        RtlZeroMemory(stats, sizeof(*stats));
+        stats->Classes  = m_Classes;
+        stats->Hits     = (ULONG)ReadNoFence(&m_Hits);
+        stats->Misses   = (ULONG)ReadNoFence(&m_Misses);
+        stats->Unpooled = (ULONG)ReadNoFence(&m_Unpooled);
+        for (ULONG c = 0; c < m_Classes; ++c)
+        {
+            stats->Class[c].BlockBytes = (ULONG)m_Class[c].BlockBytes;
+            stats->Class[c].Blocks     = m_Class[c].Blocks;
+            stats->Class[c].InUse      = (ULONG)ReadNoFence(&m_Class[c].InUse);
+            stats->Class[c].HighWater  = (ULONG)ReadNoFence(&m_Class[c].HighWater);
+        }
+    }
+
+private:
+    struct Class
+    {
+        SIZE_T          BlockBytes;
+        ULONG           Blocks;
+        volatile LONG   FreeMask;       // Bit i set: Block[i] is free
+        volatile LONG   InUse;
+        volatile LONG   HighWater;
+        PoolBlock       Block[LEYLINE_POOL_MAX_BLOCKS];
+    };
+
+    static void NoteInUse(Class& cls, LONG inUse)
+    {
+        LONG high = ReadNoFence(&cls.HighWater);
+        while (inUse > high)
+        {
+            LONG seen = InterlockedCompareExchange(&cls.HighWater, inUse, high);
+            if (seen == high) break;
+            high = seen;
+        }
+    }
+
+    PageSource*     m_Source;
+    ULONG           m_Classes;
+    Class           m_Class[LEYLINE_POOL_MAX_CLASSES];
+    volatile LONG   m_Hits;
+    volatile LONG   m_Misses;
+    volatile LONG   m_Unpooled;
+};
@@ -13,6 +13,26 @@
 #include <stdarg.h>
 #include <intrin.h>
 
+#include "leyline_ringbuffer.h"
+#include "leyline_wavertmath.h"
+#include "leyline_loopback.h"
+#include "leyline_registers.h"
+#include "leyline_resampler.h"
+#include "leyline_meter.h"
+#include "leyline_gain.h"
+#include "leyline_mixer.h"
+#include "leyline_shared.h"
+#include "leyline_bufferpool.h"
+#include "leyline_slab.h"
+#include "leyline_intersect.h"
+#include "leyline_planar.h"
+#include "leyline_endpoints.h"
+#include "leyline_trace.h"
+#include "leyline_glitch.h"
+#include "leyline_latency.h"
+#include "leyline_snapshot.h"
+#include "leyline_mapping.h"
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // IOCTL DEFINITIONS
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -29,124 +49,147 @@
 #define IOCTL_LEYLINE_MAP_PARAMS \
     CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 3, METHOD_BUFFERED, FILE_ANY_ACCESS)
 
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// SHARED PARAMETER BLOCK
-// Layout must be identical between kernel, APO, and HSA.
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#define IOCTL_LEYLINE_SET_LOOPBACK_CONFIG \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 4, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_SET_REGISTER_PERIOD \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 5, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_SET_RESAMPLER_QUALITY \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 6, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_SET_METER_BALLISTICS \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 7, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_SET_ROUTE \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 8, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_GET_BUFFER_POOL_STATS \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 9, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_GET_OBJECT_STATS \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 10, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_READ_PLANES \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 11, METHOD_BUFFERED, FILE_ANY_ACCESS)
 
-#pragma pack(push, 1)
-struct LeylineSharedParameters
+#define IOCTL_LEYLINE_GET_GLITCH_STATS \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 12, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_MEASURE_LATENCY \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 13, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_GET_LATENCY \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 14, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+#define IOCTL_LEYLINE_GET_SNAPSHOT \
+    CTL_CODE(FILE_DEVICE_LEYLINE, LEYLINE_IOCTL_BASE + 15, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+// Cables are numbered from 0 in subdevice order; cable 0 is the original
+// "Leyline Output"/"Leyline Input" pair. Input for IOCTL_LEYLINE_MAP_BUFFER: none
+// for cable 0, or a ULONG cable index. It and IOCTL_LEYLINE_MAP_PARAMS (no input)
+// return a PVOID: the cable's loopback pages or the LeylineSharedParameters page,
+// mapped into the calling process. Repeat calls on a handle return the same
+// address; the mappings last until the handle is closed, and only the process
+// that opened it can map through it.
+
+// Upper bound for the render-to-capture delay; the cable holds far more than this.
+#define LEYLINE_MAX_CABLE_LATENCY_FRAMES    8192
+
+// Input for IOCTL_LEYLINE_SET_LOOPBACK_CONFIG. Takes effect on the next
+// AllocateAudioBuffer (Enabled) or GetPosition (LatencyFrames). Callers built
+// before Cable existed send the first two fields, which configures cable 0.
+struct LeylineLoopbackConfig
 {
-    ULONG   MasterGainBits;     // IEEE 754 float bits for master gain
-    ULONG   PeakLBits;          // IEEE 754 float bits for left peak
-    ULONG   PeakRBits;          // IEEE 754 float bits for right peak
-    LONGLONG QpcFrequency;
-    LONGLONG RenderStartQpc;
-    LONGLONG CaptureStartQpc;
-    ULONG   BufferSize;
-    ULONG   ByteRate;
-    ULONG   WritePos;           // Current render position (byte offset)
-    ULONG   ReadPos;            // Current capture position (byte offset)
+    ULONG   Enabled;            // Nonzero: render and capture share the cable pages
+    ULONG   LatencyFrames;      // Capture trails render play by this many frames
+    ULONG   Cable;
 };
-#pragma pack(pop)
 
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// RING BUFFER
-// A simple, lock-free ring buffer for audio samples.
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#define LEYLINE_LOOPBACK_CONFIG_V1_SIZE     (2 * sizeof(ULONG))
+
+// Input for IOCTL_LEYLINE_SET_REGISTER_PERIOD: a single ULONG, the position/clock
+// register refresh period in milliseconds (1 .. LEYLINE_MAX_REGISTER_PERIOD_MS).
+// Streams pick it up at their next KSSTATE_RUN.
+
+// Input for IOCTL_LEYLINE_SET_RESAMPLER_QUALITY: a single ULONG SrcQuality, used
+// when a cable capture runs at a different rate than the render owner. Applies to
+// captures that allocate their buffer afterwards.
 
-class RingBuffer
+// Input for IOCTL_LEYLINE_SET_METER_BALLISTICS. Picked up by the metered render
+// stream at its next KSSTATE_RUN.
+struct LeylineMeterConfig
 {
-public:
-    RingBuffer() : m_Buffer(nullptr), m_Size(0), m_WritePos(0), m_ReadPos(0) {}
-
-    void Init(PUCHAR buffer, SIZE_T size)
-    {
-        m_Buffer   = buffer;
-        m_Size     = size;
-        m_WritePos = 0;
-        m_ReadPos  = 0;
-    }
-
-    PUCHAR GetBaseAddress() const { return m_Buffer; }
-    SIZE_T GetSize()        const { return m_Size; }
-
-    SIZE_T AvailableWrite() const
-    {
-        if (m_Size == 0) return 0;
-        if (m_WritePos >= m_ReadPos)
-            return m_Size - (m_WritePos - m_ReadPos) - 1;
-        return m_ReadPos - m_WritePos - 1;
-    }
-
-    SIZE_T AvailableRead() const
-    {
-        if (m_Size == 0) return 0;
-        if (m_WritePos >= m_ReadPos)
-            return m_WritePos - m_ReadPos;
-        return m_Size - (m_ReadPos - m_WritePos);
-    }
-
-    SIZE_T Write(const PUCHAR data, SIZE_T len)
-    {
-        SIZE_T available = AvailableWrite();
-        SIZE_T toWrite   = min(len, available);
-        if (toWrite == 0) return 0;
-
-        SIZE_T firstPart = min(toWrite, m_Size - m_WritePos);
-        RtlCopyMemory(m_Buffer + m_WritePos, data, firstPart);
-
-        if (firstPart < toWrite)
-            RtlCopyMemory(m_Buffer, data + firstPart, toWrite - firstPart);
-
-        m_WritePos = (m_WritePos + toWrite) % m_Size;
-        return toWrite;
-    }
-
-    SIZE_T Read(PUCHAR data, SIZE_T len)
-    {
-        SIZE_T available = AvailableRead();
-        SIZE_T toRead    = min(len, available);
-        if (toRead == 0) return 0;
-
-        SIZE_T firstPart = min(toRead, m_Size - m_ReadPos);
-        RtlCopyMemory(data, m_Buffer + m_ReadPos, firstPart);
-
-        if (firstPart < toRead)
-            RtlCopyMemory(data + firstPart, m_Buffer, toRead - firstPart);
-
-        m_ReadPos = (m_ReadPos + toRead) % m_Size;
-        return toRead;
-    }
-
-    void Reset() { m_WritePos = m_ReadPos = 0; }
-
-private:
-    PUCHAR  m_Buffer;
-    SIZE_T  m_Size;
-    SIZE_T  m_WritePos;
-    SIZE_T  m_ReadPos;
+    ULONG   DecayDbPerSecond;   // Peak hold fall, 0 .. LEYLINE_METER_MAX_DECAY_DB; 0 = no hold
+    ULONG   RmsWindowMs;        // RMS time constant, 0 .. LEYLINE_METER_MAX_RMS_MS
 };
 
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// AUDIO MATH UTILITIES
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Input for IOCTL_LEYLINE_SET_ROUTE: this header, then Outputs x Inputs float
+// gains, row-major by output (see ChannelRouter::Init). Routes one render
+// stream's channels into the cable; Inputs must be that stream's channel count
+// and Outputs the cable's, or the route is ignored. Inputs 0 removes the route.
+// The change crossfades over the next mix period.
+#define LEYLINE_ROUTE_ALL_STREAMS   0   // StreamId for streams without their own route
+
+struct LeylineRouteConfig
+{
+    ULONG   StreamId;           // Render stream, as logged at stream Init
+    ULONG   Inputs;             // 0 .. LEYLINE_ROUTE_MAX_CHANNELS
+    ULONG   Outputs;            // 1 .. LEYLINE_ROUTE_MAX_CHANNELS
+};
 
-namespace WaveRTMath
+// Output of IOCTL_LEYLINE_GET_BUFFER_POOL_STATS: a LeylineBufferPoolStats.
+
+// Output of IOCTL_LEYLINE_GET_OBJECT_STATS: a LeylineObjectStats, covering the
+// streams, miniports, routes and resampler banks.
+
+// Input for IOCTL_LEYLINE_READ_PLANES. Reads a cable owner's frames out of the
+// planar side ring as float, one channel or all of them interleaved. Frames
+// count from the owner's KSSTATE_RUN; the ring keeps the last
+// LEYLINE_PLANAR_RING_FRAMES, and a request for older ones starts at the oldest.
+#define LEYLINE_PLANES_ALL_CHANNELS 0xFFFFFFFF
+
+struct LeylinePlaneRequest
 {
-    // Convert elapsed QPC ticks to an absolute byte offset.
-    inline ULONGLONG TicksToBytes(LONGLONG elapsedTicks, ULONG byteRate, LONGLONG frequency)
-    {
-        if (frequency <= 0) return 0;
-        // Standard 64-bit math is safe for >100 days of continuous playback at 192kHz/24bit.
-        return (ULONGLONG)((elapsedTicks * (unsigned __int64)byteRate) / (unsigned __int64)frequency);
-    }
-
-    // Clamp a byte offset into a ring buffer.
-    inline ULONGLONG CalculatePosition(LONGLONG elapsedTicks, ULONG byteRate, LONGLONG frequency, SIZE_T bufferSize)
-    {
-        ULONGLONG bytes = TicksToBytes(elapsedTicks, byteRate, frequency);
-        if (bufferSize > 0) bytes %= (ULONGLONG)bufferSize;
-        return bytes;
-    }
-}
+    ULONG       Channel;        // 0 .. Channels - 1, or LEYLINE_PLANES_ALL_CHANNELS
+    ULONG       Cable;          // Was Reserved (zero), so older callers read cable 0
+    ULONGLONG   Frame;          // First frame wanted
+};
+
+// Output of IOCTL_LEYLINE_READ_PLANES: this header, then Frames floats (times
+// Channels for LEYLINE_PLANES_ALL_CHANNELS), as many as the buffer holds.
+struct LeylinePlaneHeader
+{
+    ULONGLONG   Frame;          // First frame returned; resume at Frame + Frames
+    ULONGLONG   Written;        // Frames the ring has taken this run
+    ULONG       Frames;
+    ULONG       Channels;       // 0: no cable owner has run yet
+    ULONG       SampleRate;
+    ULONG       Capacity;
+};
+
+// Output of IOCTL_LEYLINE_GET_GLITCH_STATS: a LeylineGlitchReport, then one
+// LeylineGlitchStats per open stream, as many as fit. Counts run from NewStream.
+
+// Input for IOCTL_LEYLINE_MEASURE_LATENCY. Arms the cable's latency probe: the
+// running render owner plays Bursts markers over its audio, starting on its next
+// period, and the first running capture on the cable times each one's return.
+// Bursts 0 stops a measurement and clears any applied result. The interval must
+// exceed the latency being measured; a marker later than that is not counted.
+#define LEYLINE_LATENCY_APPLY   0x1     // Report the mean through GetHWLatency once done
+
+struct LeylineLatencyConfig
+{
+    ULONG   Cable;
+    ULONG   Bursts;             // 0 .. LEYLINE_LATENCY_MAX_BURSTS
+    ULONG   IntervalMs;         // LEYLINE_LATENCY_MIN_INTERVAL_MS .. _MAX_INTERVAL_MS
+    ULONG   Flags;
+};
+
+// Output of IOCTL_LEYLINE_GET_LATENCY, given none for cable 0 or a ULONG cable
+// index: a LeylineLatencyReport, partial while the probe runs.
+
+// Output of IOCTL_LEYLINE_GET_SNAPSHOT: at least a LeylineSnapshotHeader, then as
+// much of the device, pool and per-stream sections as fits (see
+// leyline_snapshot.h). Call once with a bare header for TotalBytes, then again
+// with that much; parse with SnapshotReader.
@@ -22,6 +22,7 @@ NTSTATUS MuteHandler(PPCPROPERTY_REQUEST PropertyRequest);
 NTSTATUS PinCategoryHandler(PPCPROPERTY_REQUEST PropertyRequest);
 NTSTATUS PinNameHandler(PPCPROPERTY_REQUEST PropertyRequest);
 NTSTATUS ProposedFormatHandler(PPCPROPERTY_REQUEST PropertyRequest);
+NTSTATUS WritePositionHandler(PPCPROPERTY_REQUEST PropertyRequest);
 NTSTATUS AudioEffectsDiscoveryHandler(PPCPROPERTY_REQUEST PropertyRequest);
 NTSTATUS AudioModuleHandler(PPCPROPERTY_REQUEST PropertyRequest);
 
@@ -47,7 +48,5 @@ extern const KSDATARANGE                g_BridgeDataRange;
 extern const KSDATARANGE * const        g_WaveDataRanges[2];
 extern const KSDATARANGE * const        g_BridgeDataRanges[1];
 
-extern const PCFILTER_DESCRIPTOR        g_WaveRenderFilterDescriptor;
-extern const PCFILTER_DESCRIPTOR        g_WaveCaptureFilterDescriptor;
-extern const PCFILTER_DESCRIPTOR        g_TopoRenderFilterDescriptor;
-extern const PCFILTER_DESCRIPTOR        g_TopoCaptureFilterDescriptor;
+// Shared by every cable's filters of that kind.
+const PCFILTER_DESCRIPTOR* EndpointFilterDescriptor(EndpointFilterKind Kind);
@@ -0,0 +1,264 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE ENDPOINT GRAPH
+// What StartDevice registers: per virtual cable, a render and a capture endpoint,
+// each a wave filter bridged to a topology filter. Filter descriptors follow from
+// the filter's kind, the subdevice list and physical connections from the cable
+// count, all at compile time. Portable: builds against the WDK or the host
+// stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+#include <portcls.h>
+
+#include "leyline_guids.h"
+
+#define LEYLINE_MAX_CABLES              32      // Endpoint pairs one adapter can expose
+#define LEYLINE_DEFAULT_CABLES          1
+#define LEYLINE_SUBDEVICE_NAME_CHARS    24
+
+// Streams one wave filter's streaming pin takes at once.
+#define LEYLINE_STREAMING_PIN_INSTANCES 4
+
+// Node pins, as KSNODEPIN_STANDARD_IN / KSNODEPIN_STANDARD_OUT.
+#define LEYLINE_NODE_PIN_IN             1
+#define LEYLINE_NODE_PIN_OUT            0
+
+// In subdevice order within a cable.
+enum EndpointFilterKind
+{
+    EndpointFilter_WaveRender  = 0,
+    EndpointFilter_WaveCapture = 1,
+    EndpointFilter_TopoRender  = 2,
+    EndpointFilter_TopoCapture = 3,
+    EndpointFilter_Count       = 4,
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// FILTER SHAPES
+// Every filter has two pins. A wave filter's streaming pin (KSPIN_WAVE_SINK) is
+// where the client connects, its bridge (KSPIN_WAVE_BRIDGE) leads to the topology
+// filter; render data comes in through the streaming pin and leaves through the
+// bridge, capture the other way round. A topology filter takes data in at
+// KSPIN_TOPO_BRIDGE and hands it on at KSPIN_TOPO_LINEOUT; the device-side pin
+// (the output for render, the input for capture) carries the jack category.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+constexpr BOOLEAN IsTopologyFilter(EndpointFilterKind kind)
+{
+    return kind == EndpointFilter_TopoRender || kind == EndpointFilter_TopoCapture;
+}
+
+constexpr BOOLEAN IsCaptureFilter(EndpointFilterKind kind)
+{
+    return kind == EndpointFilter_WaveCapture || kind == EndpointFilter_TopoCapture;
+}
+
+constexpr KSPIN_DATAFLOW EndpointPinFlow(EndpointFilterKind kind, ULONG pin)
+{
+    BOOLEAN in = IsTopologyFilter(kind) ? pin == KSPIN_TOPO_BRIDGE
+                                        : (pin == KSPIN_WAVE_SINK) != !!IsCaptureFilter(kind);
+    return in ? KSPIN_DATAFLOW_IN : KSPIN_DATAFLOW_OUT;
+}
+
+constexpr BOOLEAN EndpointPinStreams(EndpointFilterKind kind, ULONG pin)
+{
+    return !IsTopologyFilter(kind) && pin == KSPIN_WAVE_SINK;
+}
+
+constexpr BOOLEAN EndpointPinIsJack(EndpointFilterKind kind, ULONG pin)
+{
+    return IsTopologyFilter(kind) && (EndpointPinFlow(kind, pin) == KSPIN_DATAFLOW_IN) == !!IsCaptureFilter(kind);
+}
+
+constexpr ULONG EndpointInputPin(EndpointFilterKind kind)
+{
+    return EndpointPinFlow(kind, 0) == KSPIN_DATAFLOW_IN ? 0 : 1;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// FILTER DESCRIPTORS
+// EndpointFilter<Tables, Kind>::Descriptor is the PCFILTER_DESCRIPTOR of a Kind
+// filter. Tables holds what the filters share, as static constexpr members:
+//   PinAutomation, WaveFilterAutomation, TopoFilterAutomation
+//   Interfaces, InterfaceCount         the streaming pin's interfaces
+//   WaveRanges, WaveRangeCount         ...and data ranges
+//   BridgeRanges, BridgeRangeCount
+//   Nodes, NodeCount                   topology nodes; render chains through them in order
+//   AudioCategory, SpeakerCategory, MicrophoneCategory
+//   WaveRenderCategories, WaveCaptureCategories, TopologyCategories (+ ...Count)
+// Capture topology lists the nodes too, but nothing runs through them.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+template <class Tables>
+constexpr PCPIN_DESCRIPTOR EndpointPin(EndpointFilterKind kind, ULONG pin)
+{
+    const BOOLEAN streams   = EndpointPinStreams(kind, pin);
+    const ULONG   instances = streams ? LEYLINE_STREAMING_PIN_INSTANCES : 1;
+    const GUID*   category  = !EndpointPinIsJack(kind, pin) ? Tables::AudioCategory
+                            : IsCaptureFilter(kind)         ? Tables::MicrophoneCategory
+                                                            : Tables::SpeakerCategory;
+    PCPIN_DESCRIPTOR d =
+    {
+        instances, instances, 1,
+        Tables::PinAutomation,
+        {
+            streams ? Tables::InterfaceCount : 0, streams ? Tables::Interfaces : nullptr,
+            0, nullptr,
+            streams ? Tables::WaveRangeCount : Tables::BridgeRangeCount,
+            streams ? Tables::WaveRanges     : Tables::BridgeRanges,
+            EndpointPinFlow(kind, pin),
+            streams ? KSPIN_COMMUNICATION_SINK : KSPIN_COMMUNICATION_NONE,
+            category, nullptr, 0
+        }
+    };
+    return d;
+}
+
+template <ULONG Count>
+struct EndpointConnections
+{
+    PCCONNECTION_DESCRIPTOR Items[Count];
+};
+
+// Input pin, through the first `chain` nodes, to the output pin.
+template <ULONG Chain>
+constexpr EndpointConnections<Chain + 1> EndpointChain(EndpointFilterKind kind)
+{
+    EndpointConnections<Chain + 1> c = {};
+    for (ULONG i = 0; i <= Chain; ++i)
+    {
+        c.Items[i].FromNode    = i == 0 ? PCFILTER_NODE : i - 1;
+        c.Items[i].FromNodePin = i == 0 ? EndpointInputPin(kind) : LEYLINE_NODE_PIN_OUT;
+        c.Items[i].ToNode      = i == Chain ? PCFILTER_NODE : i;
+        c.Items[i].ToNodePin   = i == Chain ? 1 - EndpointInputPin(kind) : LEYLINE_NODE_PIN_IN;
+    }
+    return c;
+}
+
+template <class Tables, EndpointFilterKind Kind>
+struct EndpointFilter
+{
+    static constexpr BOOLEAN Topology = IsTopologyFilter(Kind);
+    static constexpr ULONG   Chain    = Kind == EndpointFilter_TopoRender ? Tables::NodeCount : 0;
+
+    static constexpr PCPIN_DESCRIPTOR               Pins[2]     = { EndpointPin<Tables>(Kind, 0), EndpointPin<Tables>(Kind, 1) };
+    static constexpr EndpointConnections<Chain + 1> Connections = EndpointChain<Chain>(Kind);
+
+    static constexpr PCFILTER_DESCRIPTOR Descriptor =
+    {
+        0, Topology ? Tables::TopoFilterAutomation : Tables::WaveFilterAutomation,
+        sizeof(PCPIN_DESCRIPTOR), 2, Pins,
+        Topology ? (ULONG)sizeof(PCNODE_DESCRIPTOR) : 0, Topology ? Tables::NodeCount : 0, Topology ? Tables::Nodes : nullptr,
+        Chain + 1, Connections.Items,
+        Topology                           ? Tables::TopologyCategoryCount
+        : Kind == EndpointFilter_WaveRender ? Tables::WaveRenderCategoryCount : Tables::WaveCaptureCategoryCount,
+        Topology                           ? Tables::TopologyCategories
+        : Kind == EndpointFilter_WaveRender ? Tables::WaveRenderCategories : Tables::WaveCaptureCategories,
+    };
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ENDPOINT GRAPH
+// Four subdevices per cable, cable by cable, so the graph for N cables is the
+// first 4N subdevices and 2N links of any larger one. The first cable keeps the
+// original reference strings ("WaveRender", ...), which the INF lists; cable k
+// after it appends k + 1 ("WaveRender2").
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct EndpointSubdevice
+{
+    EndpointFilterKind Kind;
+    ULONG              Cable;
+    WCHAR              Name[LEYLINE_SUBDEVICE_NAME_CHARS];     // PcRegisterSubdevice reference string
+};
+
+// A PcRegisterPhysicalConnection: From's output bridge pin feeds To's input one.
+struct EndpointLink
+{
+    ULONG   FromSubdevice;
+    ULONG   FromPin;
+    ULONG   ToSubdevice;
+    ULONG   ToPin;
+};
+
+constexpr const char* EndpointBaseName(EndpointFilterKind kind)
+{
+    return kind == EndpointFilter_WaveRender  ? "WaveRender"
+         : kind == EndpointFilter_WaveCapture ? "WaveCapture"
+         : kind == EndpointFilter_TopoRender  ? "TopologyRender"
+                                              : "TopologyCapture";
+}
+
+template <ULONG Cables>
+struct EndpointGraph
+{
+    static_assert(Cables >= 1 && Cables <= LEYLINE_MAX_CABLES, "cable count out of range");
+
+    static constexpr ULONG SubdeviceCount = Cables * EndpointFilter_Count;
+    static constexpr ULONG LinkCount      = Cables * 2;
+
+    EndpointSubdevice Subdevices[SubdeviceCount];
+    EndpointLink      Links[LinkCount];
+
+    constexpr EndpointGraph() : Subdevices(), Links()
+    {
+        for (ULONG cable = 0; cable < Cables; ++cable)
+        {
+            const ULONG base = cable * EndpointFilter_Count;
+            for (ULONG k = 0; k < EndpointFilter_Count; ++k)
+            {
+                EndpointSubdevice& s = Subdevices[base + k];
+                s.Kind  = (EndpointFilterKind)k;
+                s.Cable = cable;
+
+                for (WCHAR& c : s.Name) c = 0;     // GCC won't constant-evaluate the value-initialized tail
+
+                ULONG       at   = 0;
+                const char* name = EndpointBaseName(s.Kind);
+                while (name[at]) { s.Name[at] = (WCHAR)name[at]; ++at; }
+                if (cable == 0) continue;
+                if (cable + 1 >= 10) s.Name[at++] = (WCHAR)('0' + (cable + 1) / 10);
+                s.Name[at] = (WCHAR)('0' + (cable + 1) % 10);
+            }
+
+            Links[cable * 2]     = { base + EndpointFilter_WaveRender,  KSPIN_WAVE_BRIDGE,
+                                     base + EndpointFilter_TopoRender,  KSPIN_TOPO_BRIDGE };
+            Links[cable * 2 + 1] = { base + EndpointFilter_TopoCapture, KSPIN_TOPO_LINEOUT,
+                                     base + EndpointFilter_WaveCapture, KSPIN_WAVE_BRIDGE };
+        }
+    }
+
+    // Each link joins a wave and a topology filter of one cable, out of a bridge
+    // pin that data leaves by into one it enters by, and each subdevice has
+    // exactly one link.
+    constexpr BOOLEAN IsConsistent() const
+    {
+        ULONG used[SubdeviceCount] = {};
+        for (ULONG i = 0; i < LinkCount; ++i)
+        {
+            const EndpointLink& l = Links[i];
+            if (l.FromSubdevice >= SubdeviceCount || l.ToSubdevice >= SubdeviceCount || l.FromPin > 1 || l.ToPin > 1)
+                return FALSE;
+
+            const EndpointSubdevice& from = Subdevices[l.FromSubdevice];
+            const EndpointSubdevice& to   = Subdevices[l.ToSubdevice];
+            if (from.Cable != to.Cable || IsTopologyFilter(from.Kind) == IsTopologyFilter(to.Kind) ||
+                IsCaptureFilter(from.Kind) != IsCaptureFilter(to.Kind))
+                return FALSE;
+            if (EndpointPinFlow(from.Kind, l.FromPin) != KSPIN_DATAFLOW_OUT || EndpointPinStreams(from.Kind, l.FromPin) ||
+                EndpointPinFlow(to.Kind, l.ToPin) != KSPIN_DATAFLOW_IN || EndpointPinStreams(to.Kind, l.ToPin))
+                return FALSE;
+
+            ++used[l.FromSubdevice];
+            ++used[l.ToSubdevice];
+        }
+        for (ULONG i = 0; i < SubdeviceCount; ++i)
+            if (used[i] != 1 || Subdevices[i].Cable != i / EndpointFilter_Count) return FALSE;
+        return TRUE;
+    }
+};
@@ -0,0 +1,119 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE SAMPLE FORMATS
+// Sample-format conversion between every container the wave data ranges accept:
+// PCM 8 (unsigned), 16, 24 (packed), 32 and IEEE float32. Kernels live in
+// src/dsp/format_convert.cpp. Portable: builds against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+enum LeylineSampleFormat
+{
+    SampleFormat_Unknown = 0,
+    SampleFormat_Pcm8    = 1,   // Unsigned, silence is 0x80
+    SampleFormat_Pcm16   = 2,
+    SampleFormat_Pcm24   = 3,   // Packed little-endian, 3 bytes per sample
+    SampleFormat_Pcm32   = 4,
+    SampleFormat_Float32 = 5,
+};
+
+enum SimdLevel
+{
+    SimdLevel_Scalar = 0,
+    SimdLevel_Sse2   = 1,
+    SimdLevel_Avx2   = 2,
+};
+
+// TPDF dither (+/-1 LSB, triangular) whenever the destination has fewer bits than
+// the source. Off by default; widening and float destinations are never dithered.
+#define LEYLINE_CONVERT_DITHER      0x00000001
+
+// Samples converted per pass through the on-stack float staging block.
+#define LEYLINE_CONVERT_CHUNK       256
+
+inline ULONG SampleFormatBytes(LeylineSampleFormat format)
+{
+    switch (format)
+    {
+    case SampleFormat_Pcm8:    return 1;
+    case SampleFormat_Pcm16:   return 2;
+    case SampleFormat_Pcm24:   return 3;
+    case SampleFormat_Pcm32:   return 4;
+    case SampleFormat_Float32: return 4;
+    default:                   return 0;
+    }
+}
+
+// Maps a negotiated WAVEFORMATEX(TENSIBLE) onto a sample format, from the
+// container size (nBlockAlign / nChannels) rather than wBitsPerSample.
+inline LeylineSampleFormat SampleFormatFromWave(BOOLEAN isFloat, ULONG containerBytes)
+{
+    if (isFloat) return containerBytes == 4 ? SampleFormat_Float32 : SampleFormat_Unknown;
+    switch (containerBytes)
+    {
+    case 1:  return SampleFormat_Pcm8;
+    case 2:  return SampleFormat_Pcm16;
+    case 3:  return SampleFormat_Pcm24;
+    case 4:  return SampleFormat_Pcm32;
+    default: return SampleFormat_Unknown;
+    }
+}
+
+// Writes digital silence in `format`.
+inline void FillSilence(LeylineSampleFormat format, PVOID dst, SIZE_T samples)
+{
+    SIZE_T bytes = samples * SampleFormatBytes(format);
+    if (format == SampleFormat_Pcm8) RtlFillMemory(dst, bytes, 0x80);
+    else                             RtlZeroMemory(dst, bytes);
+}
+
+// Highest instruction set the CPU and OS support; detected once.
+SimdLevel DetectSimdLevel();
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// FORMAT CONVERTER
+// Every pair goes source -> float -> destination, LEYLINE_CONVERT_CHUNK samples at a
+// time; float on either end skips the staging block. All SIMD levels produce output
+// bit-identical to the scalar path, dither included: the dither generator is eight
+// xorshift32 lanes, sample i of a call drawing from lane i % 8.
+//
+// Float -> int scales by 2^(bits-1), clamps to the integer range, and rounds to
+// nearest-even. Not thread-safe; one converter per stream.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class FormatConverter
+{
+public:
+    typedef void (*DecodeFn)(const UCHAR* src, float* dst, SIZE_T samples);
+    typedef void (*EncodeFn)(const float* src, UCHAR* dst, SIZE_T samples, ULONG* ditherLanes);
+
+    NTSTATUS Init(LeylineSampleFormat source, LeylineSampleFormat destination, ULONG flags, SimdLevel level);
+
+    // Converts `samples` interleaved samples (frames x channels).
+    void Convert(const void* src, void* dst, SIZE_T samples);
+
+    void ResetDither(ULONG seed);
+
+    LeylineSampleFormat GetSourceFormat()      const { return m_Source; }
+    LeylineSampleFormat GetDestinationFormat() const { return m_Destination; }
+    SimdLevel           GetLevel()             const { return m_Level; }
+    BOOLEAN             IsDithering()          const { return m_Dither; }
+
+private:
+    void Run(DecodeFn decode, EncodeFn encode, const UCHAR* src, UCHAR* dst, SIZE_T samples);
+
+    LeylineSampleFormat m_Source;
+    LeylineSampleFormat m_Destination;
+    SimdLevel           m_Level;
+    BOOLEAN             m_Dither;
+    DecodeFn            m_Decode;
+    EncodeFn            m_Encode;
+    DecodeFn            m_FallbackDecode;   // SSE2 kernels, if AVX state cannot be saved
+    EncodeFn            m_FallbackEncode;
+    ULONG               m_DitherLanes[8];
+};
@@ -0,0 +1,188 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE GAIN
+// Per-channel volume/mute state behind the topology volume and mute nodes, the
+// GET/SET side of their KS properties, and the ramped gain stage the render
+// streams run it through. Kernels live in src/dsp/gain.cpp. Portable: builds
+// against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+#include <ks.h>
+
+#include "leyline_format.h"
+
+#define LEYLINE_GAIN_MAX_CHANNELS       16
+
+// KSNODEPROPERTY_AUDIO_CHANNEL.Channel addressing every channel at once.
+#define LEYLINE_MASTER_CHANNEL          0xFFFFFFFF
+
+// Volume range advertised by the volume node, in KS 16.16 fixed-point dB.
+#define LEYLINE_VOLUME_MIN_DB           (-96 * 0x10000)
+#define LEYLINE_VOLUME_MAX_DB           0
+#define LEYLINE_VOLUME_STEP_DB          0x10000
+
+// Gain changes, mute included, move linearly over this long instead of jumping.
+#define LEYLINE_GAIN_RAMP_MS            5
+
+// Linear gain for a 16.16 dB level, clamped to the advertised range. Read from a
+// constexpr table at 1/16 dB resolution.
+float DbToLinear(LONG db);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CHANNEL CONTROLS
+// What the volume and mute nodes report and what the render path applies. All
+// zero is 0 dB and unmuted, so a zeroed device extension needs no init. Setters
+// run at PASSIVE_LEVEL from the property handlers; the streams' DPCs poll
+// GetGeneration and re-read the targets when it moves.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class ChannelControls
+{
+public:
+    LONG    GetVolume(ULONG channel) const { return ReadNoFence(&m_Volume[channel]); }
+    BOOLEAN GetMute(ULONG channel)   const { return ReadNoFence(&m_Mute[channel]) != 0; }
+    LONG    GetGeneration()          const { return ReadAcquire(&m_Generation); }
+
+    // LEYLINE_MASTER_CHANNEL sets every channel. Volume is clamped to the range.
+    void SetVolume(ULONG channel, LONG db)
+    {
+        if (db < LEYLINE_VOLUME_MIN_DB) db = LEYLINE_VOLUME_MIN_DB;
+        if (db > LEYLINE_VOLUME_MAX_DB) db = LEYLINE_VOLUME_MAX_DB;
+        for (ULONG ch = 0; ch < LEYLINE_GAIN_MAX_CHANNELS; ++ch)
+            if (channel == LEYLINE_MASTER_CHANNEL || channel == ch) WriteNoFence(&m_Volume[ch], db);
+        InterlockedIncrement(&m_Generation);
+    }
+
+    void SetMute(ULONG channel, BOOLEAN mute)
+    {
+        for (ULONG ch = 0; ch < LEYLINE_GAIN_MAX_CHANNELS; ++ch)
+            if (channel == LEYLINE_MASTER_CHANNEL || channel == ch) WriteNoFence(&m_Mute[ch], mute ? 1 : 0);
+        InterlockedIncrement(&m_Generation);
+    }
+
+    // Linear target per channel, 0 where muted, times `master`.
+    void GetTargets(float* gains, ULONG channels, float master) const
+    {
+        for (ULONG ch = 0; ch < channels; ++ch)
+            gains[ch] = GetMute(ch) ? 0.0f : DbToLinear(GetVolume(ch)) * master;
+    }
+
+private:
+    volatile LONG m_Volume[LEYLINE_GAIN_MAX_CHANNELS];     // 16.16 dB
+    volatile LONG m_Mute[LEYLINE_GAIN_MAX_CHANNELS];
+    volatile LONG m_Generation;                             // Bumped after every change
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// NODE PROPERTY REQUESTS
+// GET and SET of KSPROPERTY_AUDIO_VOLUMELEVEL and KSPROPERTY_AUDIO_MUTE (basic
+// support stays with the KS descriptors). `Request` is PCPROPERTY_REQUEST in the
+// driver; anything with the same fields works. The instance is the channel of
+// KSNODEPROPERTY_AUDIO_CHANNEL; GET on the master channel reports channel 0.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+enum ChannelProperty
+{
+    ChannelProperty_Volume = 0,
+    ChannelProperty_Mute   = 1,
+};
+
+template <typename Request>
+NTSTATUS HandleChannelProperty(ChannelControls* controls, Request* request, ChannelProperty property)
+{
+    if (!controls) return STATUS_INVALID_DEVICE_REQUEST;
+
+    ULONG channel = LEYLINE_MASTER_CHANNEL;
+    if (request->InstanceSize >= sizeof(ULONG) && request->Instance)
+        channel = *reinterpret_cast<const ULONG*>(request->Instance);
+    if (channel != LEYLINE_MASTER_CHANNEL && channel >= LEYLINE_GAIN_MAX_CHANNELS)
+        return STATUS_INVALID_PARAMETER;
+
+    if (request->ValueSize == 0)
+    {
+        request->ValueSize = sizeof(LONG);
+        return STATUS_BUFFER_OVERFLOW;
+    }
+    if (request->ValueSize < sizeof(LONG)) return STATUS_BUFFER_TOO_SMALL;
+
+    LONG* value = reinterpret_cast<LONG*>(request->Value);
+    if (!value) return STATUS_INVALID_PARAMETER;
+
+    if (request->Verb & KSPROPERTY_TYPE_GET)
+    {
+        ULONG ch = channel == LEYLINE_MASTER_CHANNEL ? 0 : channel;
+        *value = property == ChannelProperty_Volume ? controls->GetVolume(ch) : (LONG)controls->GetMute(ch);
+        request->ValueSize = sizeof(LONG);
+        return STATUS_SUCCESS;
+    }
+    if (request->Verb & KSPROPERTY_TYPE_SET)
+    {
+        if (property == ChannelProperty_Volume) controls->SetVolume(channel, *value);
+        else                                    controls->SetMute(channel, *value != 0);
+        return STATUS_SUCCESS;
+    }
+    return STATUS_INVALID_DEVICE_REQUEST;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GAIN STAGE
+// Multiplies interleaved frames in place by a per-channel gain. A new target is
+// reached by a linear ramp over LEYLINE_GAIN_RAMP_MS, so volume and mute changes
+// do not click. Unity gain touches nothing; a settled gain of zero writes digital
+// silence. Integer formats go through float and back (TPDF-dithered) in
+// LEYLINE_CONVERT_CHUNK pieces; every SIMD level matches the scalar kernels bit
+// for bit.
+//
+// Never allocates; may run at DISPATCH_LEVEL. Not thread-safe; one per stream.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class GainStage
+{
+public:
+    // Constant gain per channel, and gain start + step * i for frame i.
+    typedef void (*ScaleFn)(float* samples, ULONG frames, ULONG channels, const float* gains);
+    typedef void (*RampFn)(float* samples, ULONG frames, ULONG channels, const float* start, const float* step);
+
+    NTSTATUS Init(LeylineSampleFormat format, ULONG channels, ULONG sampleRate, SimdLevel level);
+
+    // Straight to `gains` (one per channel), no ramp: for KSSTATE_RUN.
+    void Jump(const float* gains);
+
+    // Ramps from wherever the gain is now, mid-ramp included.
+    void RampTo(const float* gains);
+
+    void Apply(void* samples, ULONG frames);
+
+    BOOLEAN IsRamping() const { return m_RampLeft != 0; }
+    BOOLEAN IsSilent()  const;          // Settled at zero on every channel
+    float   GetGain(ULONG channel) const;
+
+    ULONG      GetChannels() const { return m_Channels; }
+    SimdLevel  GetLevel()    const { return m_Level; }
+
+private:
+    void Process(ScaleFn scale, RampFn ramp, float* samples, ULONG frames);
+    void Run(ScaleFn scale, RampFn ramp, void* samples, ULONG frames);
+
+    LeylineSampleFormat m_Format;
+    ULONG       m_Channels;
+    ULONG       m_RampFrames;
+    SimdLevel   m_Level;
+    ScaleFn     m_Scale;
+    RampFn      m_Ramp;
+    ScaleFn     m_FallbackScale;        // SSE2, if AVX state cannot be saved
+    RampFn      m_FallbackRamp;
+    FormatConverter m_Decoder;          // Integer formats only
+    FormatConverter m_Encoder;
+
+    float       m_Gain[LEYLINE_GAIN_MAX_CHANNELS];      // Settled gain, or the ramp's target
+    float       m_RampStart[LEYLINE_GAIN_MAX_CHANNELS];
+    float       m_RampStep[LEYLINE_GAIN_MAX_CHANNELS];
+    ULONG       m_RampPos;              // Frames into the ramp
+    ULONG       m_RampLeft;             // Frames to its end, 0 when settled
+};
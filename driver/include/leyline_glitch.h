@@ -0,0 +1,180 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE GLITCH DETECTOR
+// Per-stream underrun/overrun accounting. Each period the stream's DPC compares the
+// clock-derived device position against how far its client has got: a render
+// client that has not written what is being played is starving the stream, a
+// capture reader the writer has lapped by more than a buffer has lost frames. A
+// glitch runs from the period it is first seen to the one it is gone in; its
+// duration is the frames it cost. Portable: builds against the WDK or the host
+// stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+enum GlitchKind : ULONG
+{
+    GlitchKind_None     = 0,
+    GlitchKind_Underrun = 1,    // Render: the device played frames the client had not written
+    GlitchKind_Overrun  = 2,    // Capture: the device overwrote frames the client had not read
+};
+
+// One stream's counters, as IOCTL_LEYLINE_GET_GLITCH_STATS returns them.
+struct LeylineGlitchStats
+{
+    ULONG     StreamId;
+    ULONG     Direction;            // LEYLINE_STREAM_RENDER / _CAPTURE
+    ULONG     SampleRate;           // Frames below are at this rate
+    ULONG     Reserved;
+    ULONG     Underruns;            // Glitches, not periods: a stall across five periods is one
+    ULONG     Overruns;
+    ULONGLONG GlitchFrames;         // Frames lost to all of them
+    ULONGLONG LongestGlitchFrames;
+    ULONGLONG LastGlitchFrame;      // Stream frame the latest one started at
+    ULONGLONG Periods;              // Observations made
+};
+
+// Output of IOCTL_LEYLINE_GET_GLITCH_STATS: this header, then Returned
+// LeylineGlitchStats. Streams > Returned means the buffer was too short for all.
+struct LeylineGlitchReport
+{
+    ULONG Streams;
+    ULONG Returned;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GLITCH DETECTOR
+// Observe* are for one thread, the stream's DPC. Record is for glitches another
+// thread notices (the cable owner mixing this stream) and only touches counters.
+// Readers get each counter whole, not all of them from one instant.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class GlitchDetector
+{
+public:
+    // A new run: the positions start again from zero. Counters carry on.
+    void Restart()
+    {
+        m_Active  = GlitchKind_None;
+        m_Length  = 0;
+        m_Device  = 0;
+        m_Through = 0;
+    }
+
+    void ResetCounters()
+    {
+        Restart();
+        WriteNoFence(&m_Underruns, 0);
+        WriteNoFence(&m_Overruns, 0);
+        WriteNoFence64(&m_GlitchFrames, 0);
+        WriteNoFence64(&m_Longest, 0);
+        WriteNoFence64(&m_LastAt, 0);
+        WriteNoFence64(&m_Periods, 0);
+    }
+
+    // Render: `Played` frames have gone out, the client has written `Written`.
+    // Returns the frames played this period that the client never wrote.
+    ULONGLONG ObserveRender(ULONGLONG Played, ULONGLONG Written)
+    {
+        Tick();
+        ULONGLONG device = m_Device;
+        m_Device = Played;
+        if (Played <= Written)
+        {
+            m_Active = GlitchKind_None;
+            return 0;
+        }
+
+        ULONGLONG from    = Written > device ? Written : device;
+        ULONGLONG starved = Played > from ? Played - from : 0;
+        Extend(GlitchKind_Underrun, starved, from);
+        return starved;
+    }
+
+    // Capture: the device has written `Written` frames into a `BufferFrames` ring,
+    // the client has read `Read`. Returns the frames overwritten unread since the
+    // last observation.
+    ULONGLONG ObserveCapture(ULONGLONG Written, ULONGLONG Read, ULONGLONG BufferFrames)
+    {
+        Tick();
+        if (Written <= Read || Written - Read <= BufferFrames)
+        {
+            m_Active = GlitchKind_None;
+            return 0;
+        }
+
+        // Frames before `oldest` are gone; those before m_Through were counted.
+        ULONGLONG oldest = Written - BufferFrames;
+        ULONGLONG from   = Read > m_Through ? Read : m_Through;
+        ULONGLONG lost   = oldest > from ? oldest - from : 0;
+        if (oldest > m_Through) m_Through = oldest;
+        Extend(GlitchKind_Overrun, lost, from);
+        return lost;
+    }
+
+    // A whole glitch seen from outside the stream's own DPC.
+    void Record(GlitchKind Kind, ULONGLONG Frames, ULONGLONG AtFrame)
+    {
+        if (Kind == GlitchKind_None) return;
+        InterlockedIncrement(Kind == GlitchKind_Underrun ? &m_Underruns : &m_Overruns);
+        InterlockedExchangeAdd64(&m_GlitchFrames, (LONG64)Frames);
+        WriteNoFence64(&m_LastAt, (LONG64)AtFrame);
+        RaiseLongest(Frames);
+    }
+
+    GlitchKind Active() const { return m_Active; }
+
+    void GetStats(LeylineGlitchStats* Stats) const
+    {
+        Stats->Underruns           = (ULONG)ReadNoFence(&m_Underruns);
+        Stats->Overruns            = (ULONG)ReadNoFence(&m_Overruns);
+        Stats->GlitchFrames        = (ULONGLONG)ReadNoFence64(&m_GlitchFrames);
+        Stats->LongestGlitchFrames = (ULONGLONG)ReadNoFence64(&m_Longest);
+        Stats->LastGlitchFrame     = (ULONGLONG)ReadNoFence64(&m_LastAt);
+        Stats->Periods             = (ULONGLONG)ReadNoFence64(&m_Periods);
+    }
+
+private:
+    void Tick() { WriteNoFence64(&m_Periods, ReadNoFence64(&m_Periods) + 1); }
+
+    // Opens a glitch of `Kind` at `From` unless one is running, then adds `Frames`.
+    void Extend(GlitchKind Kind, ULONGLONG Frames, ULONGLONG From)
+    {
+        if (m_Active != Kind)
+        {
+            m_Active = Kind;
+            m_Length = 0;
+            InterlockedIncrement(Kind == GlitchKind_Underrun ? &m_Underruns : &m_Overruns);
+            WriteNoFence64(&m_LastAt, (LONG64)From);
+        }
+        m_Length += Frames;
+        InterlockedExchangeAdd64(&m_GlitchFrames, (LONG64)Frames);
+        RaiseLongest(m_Length);
+    }
+
+    void RaiseLongest(ULONGLONG Frames)
+    {
+        LONG64 seen = ReadNoFence64(&m_Longest);
+        while ((ULONGLONG)seen < Frames)
+        {
+            LONG64 prior = InterlockedCompareExchange64(&m_Longest, (LONG64)Frames, seen);
+            if (prior == seen) break;
+            seen = prior;
+        }
+    }
+
+    GlitchKind      m_Active;       // The glitch still running at the last observation
+    ULONGLONG       m_Length;       // ...and its frames so far
+    ULONGLONG       m_Device;       // Render: Played at the last observation
+    ULONGLONG       m_Through;      // Capture: frames before this are counted as lost
+    volatile LONG   m_Underruns;
+    volatile LONG   m_Overruns;
+    volatile LONG64 m_GlitchFrames;
+    volatile LONG64 m_Longest;
+    volatile LONG64 m_LastAt;
+    volatile LONG64 m_Periods;
+};
@@ -0,0 +1,277 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE FORMAT INTERSECTION
+// Wave formats against the pins' data ranges: DataRangeIntersection, the proposed
+// format property and SetFormat all go through here. Portable: builds against the
+// WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+#include "leyline_guids.h"
+
+// Where a request leaves a choice open and nothing was proposed, the pick is the
+// one closest to these: the format every stream ran at before negotiation.
+#define LEYLINE_PREFERRED_SAMPLE_RATE   48000
+#define LEYLINE_PREFERRED_CHANNELS      2
+#define LEYLINE_PREFERRED_PCM_BITS      16
+
+// Channels the wave pins admit: up to 7.1.4 with speaker positions, 16 direct-out.
+#define LEYLINE_WAVE_MAX_CHANNELS       16
+
+// Height layouts; older ksmedia.h headers stop at 7.1.
+#ifndef KSAUDIO_SPEAKER_5POINT1POINT4
+#define KSAUDIO_SPEAKER_5POINT1POINT4   (KSAUDIO_SPEAKER_5POINT1 | SPEAKER_TOP_FRONT_LEFT | SPEAKER_TOP_FRONT_RIGHT | \
+                                         SPEAKER_TOP_BACK_LEFT | SPEAKER_TOP_BACK_RIGHT)
+#endif
+#ifndef KSAUDIO_SPEAKER_7POINT1POINT4
+#define KSAUDIO_SPEAKER_7POINT1POINT4   (KSAUDIO_SPEAKER_7POINT1_SURROUND | SPEAKER_TOP_FRONT_LEFT | SPEAKER_TOP_FRONT_RIGHT | \
+                                         SPEAKER_TOP_BACK_LEFT | SPEAKER_TOP_BACK_RIGHT)
+#endif
+
+// A wave format, whichever KS structure carried it.
+struct WaveFormat
+{
+    BOOLEAN Float;
+    ULONG   Channels;
+    ULONG   SampleRate;
+    ULONG   ContainerBits;      // wBitsPerSample
+    ULONG   ValidBits;          // wValidBitsPerSample; ContainerBits outside EXTENSIBLE
+    ULONG   ChannelMask;        // KSAUDIO_SPEAKER_DIRECTOUT (0): no speaker positions
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// FORMAT INTERSECTION
+// A client request is one of three shapes, told apart by FormatSize:
+//   - exactly a KSDATARANGE_AUDIO: limits on channels, bits and rate. Each value
+//     it pins down is taken as is; where it leaves room, the caller's preferred
+//     format (the proposed one), clamped into what both sides allow.
+//   - a KSDATAFORMAT_WAVEFORMATEX(TENSIBLE): one format, accepted verbatim
+//     (valid bits and channel mask included) if the pin admits it.
+//   - a bare KSDATARANGE: anything; the preferred format, as far as the pin allows.
+// Pin ranges are KSDATARANGE_AUDIO. Bits are container bits; PCM comes in 8, 16,
+// 24 (packed) and 32, float only in 32.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class FormatIntersection
+{
+public:
+    static BOOLEAN IsExtensibleSpecifier(REFGUID specifier)
+    {
+        return !!IsEqualGUID(specifier, KSDATAFORMAT_SPECIFIER_WAVEFORMATEXTENSIBLE);
+    }
+
+    // The usual speaker layout for `channels`; DIRECTOUT where there is none.
+    static ULONG DefaultChannelMask(ULONG channels)
+    {
+        switch (channels)
+        {
+        case 1:  return KSAUDIO_SPEAKER_MONO;
+        case 2:  return KSAUDIO_SPEAKER_STEREO;
+        case 3:  return KSAUDIO_SPEAKER_STEREO | SPEAKER_FRONT_CENTER;
+        case 4:  return KSAUDIO_SPEAKER_QUAD;
+        case 5:  return KSAUDIO_SPEAKER_QUAD | SPEAKER_FRONT_CENTER;
+        case 6:  return KSAUDIO_SPEAKER_5POINT1;
+        case 7:  return KSAUDIO_SPEAKER_5POINT1 | SPEAKER_BACK_CENTER;
+        case 8:  return KSAUDIO_SPEAKER_7POINT1_SURROUND;
+        case 10: return KSAUDIO_SPEAKER_5POINT1POINT4;
+        case 12: return KSAUDIO_SPEAKER_7POINT1POINT4;
+        default: return KSAUDIO_SPEAKER_DIRECTOUT;
+        }
+    }
+
+    // Whether the answer to `request` has to be a WAVEFORMATEXTENSIBLE: asked for
+    // one, or `format` has more than WAVEFORMATEX can say.
+    static BOOLEAN WantsExtensible(const KSDATARANGE* request, const WaveFormat& format)
+    {
+        if (IsExtensibleSpecifier(request->Specifier)) return TRUE;
+        if (request->FormatSize != sizeof(KSDATARANGE_AUDIO) &&
+            request->FormatSize >= sizeof(KSDATAFORMAT) + sizeof(WAVEFORMATEX) &&
+            reinterpret_cast<const WAVEFORMATEX*>(request + 1)->wFormatTag == WAVE_FORMAT_EXTENSIBLE)
+            return TRUE;
+        return format.Channels > 2 || format.ContainerBits > 16 || format.ValidBits != format.ContainerBits ||
+               format.ChannelMask != DefaultChannelMask(format.Channels);
+    }
+
+    // The LEYLINE_PREFERRED_* format; 32-bit for float.
+    static WaveFormat Preferred(BOOLEAN isFloat)
+    {
+        WaveFormat format;
+        format.Float         = isFloat;
+        format.Channels      = LEYLINE_PREFERRED_CHANNELS;
+        format.SampleRate    = LEYLINE_PREFERRED_SAMPLE_RATE;
+        format.ContainerBits = isFloat ? 32 : LEYLINE_PREFERRED_PCM_BITS;
+        format.ValidBits     = format.ContainerBits;
+        format.ChannelMask   = DefaultChannelMask(LEYLINE_PREFERRED_CHANNELS);
+        return format;
+    }
+
+    // Bytes Build writes. A plain WAVEFORMATEX result is sized without the struct's
+    // tail padding, which would make it exactly as long as a KSDATARANGE_AUDIO.
+    static ULONG FormatSize(BOOLEAN extensible)
+    {
+        return extensible ? sizeof(KSDATAFORMAT_WAVEFORMATEXTENSIBLE) : sizeof(KSDATAFORMAT) + sizeof(WAVEFORMATEX);
+    }
+
+    // The format both `pinRange` and `request` allow, as close to `preferred` as
+    // they let it be (Preferred() when null or of the other sample type), or
+    // STATUS_NO_MATCH.
+    static NTSTATUS Intersect(const KSDATARANGE* pinRange, const KSDATARANGE* request,
+                              const WaveFormat* preferred, WaveFormat* result)
+    {
+        if (!pinRange || !request || !result) return STATUS_INVALID_PARAMETER;
+        if (pinRange->FormatSize < sizeof(KSDATARANGE_AUDIO) ||
+            !IsEqualGUID(request->MajorFormat, KSDATAFORMAT_TYPE_AUDIO) ||
+            !IsEqualGUID(request->SubFormat, pinRange->SubFormat))
+            return STATUS_NO_MATCH;
+        if (!IsEqualGUID(request->Specifier, KSDATAFORMAT_SPECIFIER_WAVEFORMATEX) && !IsExtensibleSpecifier(request->Specifier))
+            return STATUS_NO_MATCH;
+
+        const KSDATARANGE_AUDIO* pin     = reinterpret_cast<const KSDATARANGE_AUDIO*>(pinRange);
+        BOOLEAN                  isFloat = !!IsEqualGUID(pinRange->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
+
+        if (request->FormatSize != sizeof(KSDATARANGE_AUDIO) &&
+            request->FormatSize >= sizeof(KSDATAFORMAT) + sizeof(WAVEFORMATEX))
+        {
+            WaveFormat asked;
+            if (!NT_SUCCESS(Parse(request, request->FormatSize, &asked)) || asked.Float != isFloat ||
+                !Admits(pinRange, asked))
+                return STATUS_NO_MATCH;
+            *result = asked;
+            return STATUS_SUCCESS;
+        }
+
+        ULONG maxChannels = pin->MaximumChannels;
+        ULONG minBits = pin->MinimumBitsPerSample,   maxBits = pin->MaximumBitsPerSample;
+        ULONG minRate = pin->MinimumSampleFrequency, maxRate = pin->MaximumSampleFrequency;
+        if (request->FormatSize == sizeof(KSDATARANGE_AUDIO))
+        {
+            const KSDATARANGE_AUDIO* asked = reinterpret_cast<const KSDATARANGE_AUDIO*>(request);
+            maxChannels = Min(maxChannels, asked->MaximumChannels);
+            minBits     = Max(minBits, asked->MinimumBitsPerSample);
+            maxBits     = Min(maxBits, asked->MaximumBitsPerSample);
+            minRate     = Max(minRate, asked->MinimumSampleFrequency);
+            maxRate     = Min(maxRate, asked->MaximumSampleFrequency);
+        }
+        if (maxChannels == 0 || minRate > maxRate || minRate == 0) return STATUS_NO_MATCH;
+
+        WaveFormat want = (preferred && preferred->Float == isFloat) ? *preferred : Preferred(isFloat);
+        ULONG bits;
+        if (isFloat) bits = 32;
+        else         bits = (Clamp(want.ContainerBits, minBits, maxBits) + 7) & ~7u;
+        if (bits < minBits || bits > maxBits || bits < 8 || bits > 32) return STATUS_NO_MATCH;
+
+        result->Float         = isFloat;
+        result->Channels      = Clamp(want.Channels, 1, maxChannels);
+        result->SampleRate    = Clamp(want.SampleRate, minRate, maxRate);
+        result->ContainerBits = bits;
+        result->ValidBits     = bits == want.ContainerBits ? want.ValidBits : bits;
+        result->ChannelMask   = result->Channels == want.Channels ? want.ChannelMask
+                                                                  : DefaultChannelMask(result->Channels);
+        return STATUS_SUCCESS;
+    }
+
+    // Reads a KSDATAFORMAT_WAVEFORMATEX(TENSIBLE) of `size` bytes. Rejects what no
+    // stream could play: unknown tags, odd containers, a block size that disagrees.
+    static NTSTATUS Parse(const KSDATAFORMAT* format, ULONG size, WaveFormat* result)
+    {
+        if (!format || !result || size < sizeof(KSDATAFORMAT) + sizeof(WAVEFORMATEX) ||
+            format->FormatSize < sizeof(KSDATAFORMAT) + sizeof(WAVEFORMATEX))
+            return STATUS_INVALID_PARAMETER;
+        if (!IsEqualGUID(format->MajorFormat, KSDATAFORMAT_TYPE_AUDIO))
+            return STATUS_NOT_SUPPORTED;
+
+        const WAVEFORMATEX* wave = reinterpret_cast<const WAVEFORMATEX*>(format + 1);
+        result->Channels      = wave->nChannels;
+        result->SampleRate    = wave->nSamplesPerSec;
+        result->ContainerBits = wave->wBitsPerSample;
+        result->ValidBits     = wave->wBitsPerSample;
+        result->ChannelMask   = DefaultChannelMask(wave->nChannels);
+
+        switch (wave->wFormatTag)
+        {
+        case WAVE_FORMAT_PCM:        result->Float = FALSE; break;
+        case WAVE_FORMAT_IEEE_FLOAT: result->Float = TRUE;  break;
+        case WAVE_FORMAT_EXTENSIBLE:
+        {
+            if (wave->cbSize < sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX) ||
+                size < sizeof(KSDATAFORMAT_WAVEFORMATEXTENSIBLE) || format->FormatSize < sizeof(KSDATAFORMAT_WAVEFORMATEXTENSIBLE))
+                return STATUS_INVALID_PARAMETER;
+            const WAVEFORMATEXTENSIBLE* ext = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(wave);
+            if (IsEqualGUID(ext->SubFormat, KSDATAFORMAT_SUBTYPE_PCM))             result->Float = FALSE;
+            else if (IsEqualGUID(ext->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)) result->Float = TRUE;
+            else return STATUS_NOT_SUPPORTED;
+            if (ext->Samples.wValidBitsPerSample) result->ValidBits = ext->Samples.wValidBitsPerSample;
+            result->ChannelMask = ext->dwChannelMask;
+            break;
+        }
+        default:
+            return STATUS_NOT_SUPPORTED;
+        }
+
+        ULONG bits = result->ContainerBits;
+        if (result->Channels == 0 || result->SampleRate == 0 || bits < 8 || bits > 32 || (bits & 7) ||
+            (result->Float && bits != 32) || result->ValidBits > bits ||
+            wave->nBlockAlign != result->Channels * (bits / 8))
+            return STATUS_NOT_SUPPORTED;
+        return STATUS_SUCCESS;
+    }
+
+    // Whether `pinRange` (a KSDATARANGE_AUDIO) takes `format`.
+    static BOOLEAN Admits(const KSDATARANGE* pinRange, const WaveFormat& format)
+    {
+        if (!pinRange || pinRange->FormatSize < sizeof(KSDATARANGE_AUDIO)) return FALSE;
+        const KSDATARANGE_AUDIO* pin = reinterpret_cast<const KSDATARANGE_AUDIO*>(pinRange);
+        BOOLEAN isFloat = !!IsEqualGUID(pinRange->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
+        return format.Float == isFloat &&
+               format.Channels >= 1 && format.Channels <= pin->MaximumChannels &&
+               format.ContainerBits >= pin->MinimumBitsPerSample && format.ContainerBits <= pin->MaximumBitsPerSample &&
+               format.SampleRate >= pin->MinimumSampleFrequency && format.SampleRate <= pin->MaximumSampleFrequency;
+    }
+
+    // Writes `format` as a KSDATAFORMAT_WAVEFORMATEX, or with `extensible` a
+    // KSDATAFORMAT_WAVEFORMATEXTENSIBLE, under `specifier` (KS uses the
+    // WAVEFORMATEX one for both); `out` has FormatSize(extensible) bytes.
+    static void Build(const WaveFormat& format, BOOLEAN extensible, REFGUID specifier, PVOID out)
+    {
+        ULONG size = FormatSize(extensible);
+        RtlZeroMemory(out, size);
+
+        KSDATAFORMAT* header = static_cast<KSDATAFORMAT*>(out);
+        WAVEFORMATEX* wave   = reinterpret_cast<WAVEFORMATEX*>(header + 1);
+        const GUID&   sub    = format.Float ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT : KSDATAFORMAT_SUBTYPE_PCM;
+
+        wave->nChannels       = (USHORT)format.Channels;
+        wave->nSamplesPerSec  = format.SampleRate;
+        wave->wBitsPerSample  = (USHORT)format.ContainerBits;
+        wave->nBlockAlign     = (USHORT)(format.Channels * format.ContainerBits / 8);
+        wave->nAvgBytesPerSec = format.SampleRate * wave->nBlockAlign;
+
+        header->FormatSize  = size;
+        header->SampleSize  = wave->nBlockAlign;
+        header->MajorFormat = KSDATAFORMAT_TYPE_AUDIO;
+        header->SubFormat   = sub;
+        header->Specifier   = specifier;
+        if (extensible)
+        {
+            WAVEFORMATEXTENSIBLE* ext = reinterpret_cast<WAVEFORMATEXTENSIBLE*>(wave);
+            wave->wFormatTag                 = WAVE_FORMAT_EXTENSIBLE;
+            wave->cbSize                     = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+            ext->Samples.wValidBitsPerSample = (USHORT)format.ValidBits;
+            ext->dwChannelMask               = format.ChannelMask;
+            ext->SubFormat                   = sub;
+        }
+        else
+        {
+            wave->wFormatTag = format.Float ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+        }
+    }
+
+private:
+    static ULONG Min(ULONG a, ULONG b) { return a < b ? a : b; }
+    static ULONG Max(ULONG a, ULONG b) { return a > b ? a : b; }
+    static ULONG Clamp(ULONG v, ULONG lo, ULONG hi) { return v < lo ? lo : (v > hi ? hi : v); }
+};
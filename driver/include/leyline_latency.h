@@ -0,0 +1,297 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE LATENCY PROBE
+// Round-trip measurement through a cable: the render owner overwrites bursts of a
+// maximum-length sequence into what it has played, a capture stream correlates
+// what it delivers against the same sequence, and each burst found is timed from
+// the moment render played its last frame to the moment that frame became
+// readable on the capture side. Kernels live in src/dsp/latency.cpp. Portable:
+// builds against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+// One period of the 10-bit MLS: a flat spectrum, and a circular autocorrelation of
+// 1023 at lag 0 and -1 everywhere else.
+#define LEYLINE_LATENCY_MARKER_FRAMES   1023
+#define LEYLINE_LATENCY_MARKER_LEVEL    0.5f        // -6 dBFS chips on every channel
+
+// A correlation this close to a perfect match (1.0) starts a detection, which then
+// takes the best score within the next LEYLINE_LATENCY_PEAK_FRAMES.
+#define LEYLINE_LATENCY_DETECT_SCORE    0.5f
+#define LEYLINE_LATENCY_PEAK_FRAMES     64
+
+#define LEYLINE_LATENCY_MAX_BURSTS      256
+#define LEYLINE_LATENCY_MIN_INTERVAL_MS 50          // Must stay above the latency measured
+#define LEYLINE_LATENCY_MAX_INTERVAL_MS 5000
+#define LEYLINE_LATENCY_LEAD_MS         100         // First burst after the owner picks it up
+
+// DPC periods the capture side remembers to date a marker's last frame.
+#define LEYLINE_LATENCY_LOG_ENTRIES     8
+
+enum LatencyProbeState : ULONG
+{
+    LatencyProbe_Idle    = 0,
+    LatencyProbe_Armed   = 1,   // Waiting for the cable owner's next period
+    LatencyProbe_Running = 2,
+    LatencyProbe_Done    = 3,
+};
+
+// Output of IOCTL_LEYLINE_GET_LATENCY. Frames are at the owner's SampleRate; all
+// figures are 0 until a burst has been matched.
+struct LeylineLatencyReport
+{
+    ULONG   State;              // LatencyProbeState
+    ULONG   Bursts;             // Asked for
+    ULONG   Injected;           // Played so far
+    ULONG   Detected;           // Matched to a burst
+    ULONG   SampleRate;
+    ULONG   AppliedUs;          // Mean reported through GetHWLatency, 0 for none
+    ULONG   MinFrames;
+    ULONG   MeanFrames;
+    ULONG   P99Frames;
+    ULONG   MaxFrames;
+    ULONG   MinUs;
+    ULONG   MeanUs;
+    ULONG   P99Us;
+    ULONG   MaxUs;
+};
+
+// Fills `chips` with LEYLINE_LATENCY_MARKER_FRAMES values of +/-1.
+void GenerateMls(float* chips);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BURST SCHEDULE
+// Burst k covers frames [Origin + k * Interval, + LEYLINE_LATENCY_MARKER_FRAMES) of
+// the owner's run.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct LatencyBurst
+{
+    ULONGLONG Frame;            // First frame of [From, To) the burst covers
+    ULONG     Chip;             // ...and the chip that goes there
+    ULONG     Frames;
+};
+
+class BurstSchedule
+{
+public:
+    void Init(ULONGLONG origin, ULONG interval, ULONG bursts)
+    {
+        m_Origin   = origin;
+        m_Interval = interval;
+        m_Bursts   = bursts;
+    }
+
+    ULONGLONG BurstFrame(ULONG burst) const { return m_Origin + (ULONGLONG)burst * m_Interval; }
+
+    // The frame after the last chip of the last burst.
+    ULONGLONG End() const { return m_Bursts ? BurstFrame(m_Bursts - 1) + LEYLINE_LATENCY_MARKER_FRAMES : m_Origin; }
+
+    // Bursts that have started before frame `played`.
+    ULONG Started(ULONGLONG played) const
+    {
+        if (played <= m_Origin || !m_Interval) return 0;
+        ULONGLONG started = (played - m_Origin - 1) / m_Interval + 1;
+        return started > m_Bursts ? m_Bursts : (ULONG)started;
+    }
+
+    // The first stretch of [from, to) a burst covers; FALSE for none.
+    BOOLEAN Next(ULONGLONG from, ULONGLONG to, LatencyBurst* out) const
+    {
+        if (!m_Bursts || from >= to || to <= m_Origin || from >= End()) return FALSE;
+
+        ULONG burst = from <= m_Origin ? 0 : (ULONG)((from - m_Origin) / m_Interval);
+        if (burst >= m_Bursts) return FALSE;
+        ULONGLONG start = BurstFrame(burst);
+        if (from >= start + LEYLINE_LATENCY_MARKER_FRAMES)
+        {
+            if (++burst >= m_Bursts) return FALSE;
+            start = BurstFrame(burst);
+        }
+
+        ULONGLONG first = from > start ? from : start;
+        ULONGLONG last  = start + LEYLINE_LATENCY_MARKER_FRAMES;
+        if (last > to) last = to;
+        if (first >= last) return FALSE;
+
+        out->Frame  = first;
+        out->Chip   = (ULONG)(first - start);
+        out->Frames = (ULONG)(last - first);
+        return TRUE;
+    }
+
+private:
+    ULONGLONG m_Origin;
+    ULONG     m_Interval;
+    ULONG     m_Bursts;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MARKER DETECTOR
+// Normalised cross-correlation of the last LEYLINE_LATENCY_MARKER_FRAMES mono
+// samples against the marker, at every sample: scale-invariant, so capture gain
+// does not matter, and near zero on anything but the sequence itself. The window
+// is kept twice over so it is always contiguous for the SSE2 dot product.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct MarkerHit
+{
+    ULONGLONG Frame;            // Where the marker's first chip landed
+    float     Score;
+};
+
+class MarkerDetector
+{
+public:
+    // `marker` is read, not copied, and must outlive the detector.
+    void Init(const float* marker)
+    {
+        m_Marker = marker;
+        Reset();
+    }
+
+    void Reset();
+
+    // Feeds `count` samples, the first being frame `frame`; returns the markers
+    // completed in them, at most `maxHits`.
+    ULONG Push(const float* samples, ULONG count, ULONGLONG frame, MarkerHit* hits, ULONG maxHits);
+
+private:
+    float Correlate(const float* window, double energy) const;
+
+    const float* m_Marker;
+    float        m_Window[2 * LEYLINE_LATENCY_MARKER_FRAMES];
+    ULONG        m_Head;        // Next slot; the window starts here
+    ULONG        m_Filled;
+    double       m_Energy;      // Sum of squares over the window, kept as it slides
+    ULONG        m_Tracking;    // Samples left to look for a higher peak
+    ULONG        m_Holdoff;     // Samples left before another marker can start
+    float        m_Best;
+    ULONGLONG    m_BestAt;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LATENCY STATS
+// Measurements in nanoseconds, kept sorted as they arrive so the percentile is an
+// index.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class LatencyStats
+{
+public:
+    void Reset() { m_Count = 0; m_Sum = 0; }
+
+    // FALSE once LEYLINE_LATENCY_MAX_BURSTS are held.
+    BOOLEAN Add(ULONGLONG ns);
+
+    ULONG Count() const { return m_Count; }
+    ULONGLONG MeanNs() const { return m_Count ? (m_Sum + m_Count / 2) / m_Count : 0; }
+
+    // The Min..Max fields of `report`, with frames at `sampleRate`.
+    void Summarize(ULONG sampleRate, LeylineLatencyReport* report) const;
+
+private:
+    ULONGLONG m_Ns[LEYLINE_LATENCY_MAX_BURSTS];
+    ULONG     m_Count;
+    ULONGLONG m_Sum;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LATENCY PROBE
+// Valid zeroed, once Init has built the marker. Three parties use it:
+//   - whoever configures it: Arm, Stop, GetReport;
+//   - the cable owner's DPC: Begin, Advance, NextBurst, GetMarker;
+//   - one capture stream's DPC: StartCapture, Capture, then Match.
+// Arm, Stop, GetReport, Begin, Advance and Match take the caller's lock; the rest
+// belong to their one thread, the capture side's only once it has claimed the
+// probe.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class LatencyProbe
+{
+public:
+    void Init()
+    {
+        GenerateMls(m_Marker);
+        m_Detector.Init(m_Marker);
+    }
+
+    // A new measurement of `bursts`, `intervalMs` apart, forgetting the last one's
+    // results. With `apply`, its mean goes to GetAppliedUs once done.
+    void Arm(ULONG bursts, ULONG intervalMs, BOOLEAN apply);
+
+    // Ends a measurement early, keeping what it found; `forget` also drops the
+    // applied latency.
+    void Stop(BOOLEAN forget);
+
+    LatencyProbeState GetState() const { return (LatencyProbeState)ReadAcquire(&m_State); }
+    ULONG GetAppliedUs() const { return (ULONG)ReadNoFence(&m_AppliedUs); }
+    void GetReport(LeylineLatencyReport* report) const;
+
+    // Owner: places the schedule in its run on the first period after Arm. TRUE
+    // while the probe runs in that run.
+    BOOLEAN Begin(ULONGLONG played, LONG64 startQpc, LONG64 frequency, ULONG sampleRate);
+
+    // Owner: frames before `played` carry their bursts. Done once the last burst
+    // has had an interval to come back.
+    void Advance(ULONGLONG played);
+
+    BOOLEAN NextBurst(ULONGLONG from, ULONGLONG to, LatencyBurst* out) const { return m_Schedule.Next(from, to, out); }
+    const float* GetMarker() const { return m_Marker; }
+
+    // Owner frames marked so far: a capture reading the owner's pages directly
+    // should not look past them.
+    ULONGLONG GetMarked() const { return (ULONGLONG)ReadAcquire64(&m_Marked); }
+
+    // Capture: starts listening with `frames` delivered at `qpc`. `continuous`
+    // when the position moves with the clock between periods, not in steps.
+    void StartCapture(ULONGLONG frames, LONG64 qpc, BOOLEAN continuous);
+
+    // Capture, each period: `frames` delivered by `qpc`; then feeds mono samples
+    // from frame `first` on. Returns how many markers ended in them, each with
+    // the QPC its last frame became readable at.
+    void Observe(ULONGLONG frames, LONG64 qpc);
+    ULONG Capture(const float* mono, ULONG count, ULONGLONG first, LONG64* seen, ULONG maxSeen);
+
+    // Capture: times a marker read at `seen` against the burst played before it.
+    // FALSE if none was played within an interval.
+    BOOLEAN Match(LONG64 seen);
+
+    // When frame `frame` of the owner's run has played: the position passes it.
+    static LONG64 FrameQpc(LONG64 startQpc, LONG64 frequency, ULONG sampleRate, ULONGLONG frame);
+
+private:
+    LONG64 VisibleAt(ULONGLONG frame) const;
+
+    struct LogEntry
+    {
+        ULONGLONG Frames;
+        LONG64    Qpc;
+    };
+
+    float           m_Marker[LEYLINE_LATENCY_MARKER_FRAMES];
+    BurstSchedule   m_Schedule;
+    LatencyStats    m_Stats;
+    ULONG           m_Bursts;
+    ULONG           m_IntervalMs;
+    BOOLEAN         m_Apply;
+    ULONG           m_Injected;
+    ULONG           m_NextBurst;    // Bursts before this are matched or passed over
+    LONG64          m_StartQpc;     // Owner's run, from Begin
+    LONG64          m_Frequency;
+    ULONG           m_SampleRate;
+    volatile LONG   m_State;
+    volatile LONG   m_AppliedUs;
+    volatile LONG64 m_Marked;
+
+    // Capture side.
+    MarkerDetector  m_Detector;
+    LogEntry        m_Log[LEYLINE_LATENCY_LOG_ENTRIES];
+    ULONG           m_LogCount;
+    BOOLEAN         m_Continuous;
+};
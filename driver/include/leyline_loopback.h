@@ -0,0 +1,160 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE LOOPBACK CABLE
+// Virtual-cable bookkeeping: the render stream that owns the shared loopback pages
+// publishes its clock here, and capture streams mapped onto the same pages derive
+// their position from it. Portable: builds against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#include "leyline_format.h"
+
+// One 10 ms period at 48 kHz.
+#define LEYLINE_DEFAULT_CABLE_LATENCY_FRAMES    480
+
+// SetProcessedFrames for an owner that leaves its pages as the client wrote them.
+#define LEYLINE_CABLE_ALL_FRAMES                0xFFFFFFFFFFFFFFFFULL
+
+// Clock parameters of the render stream feeding the cable.
+struct LoopbackSourceClock
+{
+    LONG64  StartQpc;       // 0 when no render stream is running on the cable
+    LONG64  Frequency;
+    ULONG   ByteRate;
+    ULONG   BlockAlign;
+    ULONG   BufferSize;     // Frame-aligned size of the shared pages
+    ULONG   SampleFormat;   // LeylineSampleFormat of the shared pages
+    ULONG   Channels;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LOOPBACK CABLE
+// No audio is moved: render and capture share the same physical pages, and the
+// capture "write" position is simply the render play position minus the configured
+// latency. The source clock is published under a sequence counter so a capture
+// GetPosition never sees a half-updated start time / byte rate pair.
+//
+// The owner's DPC works on frames in place once they have played (gain, the mix
+// bus, latency bursts), so a capture also stops at the last frame the owner has
+// processed; without that, a short latency reads the client's raw audio.
+//
+// A capture stream that negotiated a different sample format than the owner (same
+// rate and channel count) cannot share the pages; it converts out of them into its
+// own buffer instead, which is why the owner's format is known from the moment it
+// claims the cable, before it ever runs.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class LoopbackCable
+{
+public:
+    void Configure(BOOLEAN enabled, ULONG latencyFrames)
+    {
+        WriteNoFence(&m_LatencyFrames, (LONG)latencyFrames);
+        WriteRelease(&m_Enabled, enabled ? 1 : 0);
+    }
+
+    BOOLEAN IsEnabled()        const { return ReadAcquire(&m_Enabled) != 0; }
+    ULONG   GetLatencyFrames() const { return (ULONG)ReadNoFence(&m_LatencyFrames); }
+
+    // ---- Render side (one owner at a time, serialized by SetState) ----
+    // Readers spin while an update is in flight, so in the driver these run at
+    // DISPATCH_LEVEL, where nothing on the same processor can wait on them.
+
+    void PublishSource(const LoopbackSourceClock& clock)
+    {
+        LONG seq = ReadNoFence(&m_Sequence);
+        WriteNoFence(&m_Sequence, seq + 1);
+        WriteRelease64(&m_Frequency, clock.Frequency);
+        WriteRelease(&m_ByteRate, (LONG)clock.ByteRate);
+        WriteRelease(&m_BlockAlign, (LONG)clock.BlockAlign);
+        WriteRelease(&m_BufferSize, (LONG)clock.BufferSize);
+        WriteRelease(&m_SampleFormat, (LONG)clock.SampleFormat);
+        WriteRelease(&m_Channels, (LONG)clock.Channels);
+        WriteRelease64(&m_StartQpc, clock.StartQpc);
+        WriteRelease(&m_Sequence, seq + 2);
+    }
+
+    void RetractSource()
+    {
+        LoopbackSourceClock none = {};
+        PublishSource(none);
+    }
+
+    // Frames of this run the owner has finished with, counted like the clock. Set
+    // to 0 (or LEYLINE_CABLE_ALL_FRAMES) before PublishSource starts a run, then
+    // raised after each batch is written.
+    void SetProcessedFrames(ULONGLONG frames) { WriteRelease64(&m_ProcessedFrames, (LONG64)frames); }
+
+    void SetOwnerFormat(LeylineSampleFormat format, ULONG channels, ULONG sampleRate)
+    {
+        LONG64 packed = (LONG64)format | ((LONG64)(channels & 0xFFFFFF) << 8) | ((LONG64)sampleRate << 32);
+        WriteRelease64(&m_OwnerFormat, packed);
+    }
+
+    void ClearOwnerFormat() { WriteRelease64(&m_OwnerFormat, 0); }
+
+    // ---- Capture side ----
+
+    // Returns FALSE when no render stream is currently running on the cable.
+    BOOLEAN GetSource(LoopbackSourceClock* clock) const
+    {
+        for (;;)
+        {
+            LONG seq = ReadAcquire(&m_Sequence);
+            if (seq & 1) { YieldProcessor(); continue; }
+
+            // Acquire loads keep the closing sequence read after the field reads.
+            clock->Frequency    = ReadAcquire64(&m_Frequency);
+            clock->ByteRate     = (ULONG)ReadAcquire(&m_ByteRate);
+            clock->BlockAlign   = (ULONG)ReadAcquire(&m_BlockAlign);
+            clock->BufferSize   = (ULONG)ReadAcquire(&m_BufferSize);
+            clock->SampleFormat = (ULONG)ReadAcquire(&m_SampleFormat);
+            clock->Channels     = (ULONG)ReadAcquire(&m_Channels);
+            clock->StartQpc     = ReadAcquire64(&m_StartQpc);
+
+            if (ReadAcquire(&m_Sequence) == seq) break;
+        }
+        return clock->StartQpc != 0 && clock->BlockAlign != 0 && clock->BufferSize != 0;
+    }
+
+    ULONGLONG GetProcessedFrames() const { return (ULONGLONG)ReadAcquire64(&m_ProcessedFrames); }
+
+    // Format of the render stream that claimed the pages; FALSE while unclaimed.
+    BOOLEAN GetOwnerFormat(LeylineSampleFormat* format, ULONG* channels, ULONG* sampleRate) const
+    {
+        LONG64 packed = ReadAcquire64(&m_OwnerFormat);
+        if (packed == 0) return FALSE;
+        *format     = (LeylineSampleFormat)(packed & 0xFF);
+        *channels   = (ULONG)((packed >> 8) & 0xFFFFFF);
+        *sampleRate = (ULONG)((ULONGLONG)packed >> 32);
+        return TRUE;
+    }
+
+    // Frames of valid capture data given how far the source has played: held back
+    // by `latencyFrames`, zero until the source has played that much, and never
+    // past what the owner has processed.
+    static ULONGLONG CaptureFrames(ULONGLONG sourcePlayedFrames, ULONG latencyFrames, ULONGLONG processedFrames)
+    {
+        ULONGLONG frames = (sourcePlayedFrames > latencyFrames) ? sourcePlayedFrames - latencyFrames : 0;
+        return frames < processedFrames ? frames : processedFrames;
+    }
+
+private:
+    volatile LONG   m_Enabled;
+    volatile LONG   m_LatencyFrames;
+    volatile LONG   m_Sequence;
+    volatile LONG   m_ByteRate;
+    volatile LONG   m_BlockAlign;
+    volatile LONG   m_BufferSize;
+    volatile LONG   m_SampleFormat;
+    volatile LONG   m_Channels;
+    volatile LONG64 m_StartQpc;
+    volatile LONG64 m_Frequency;
+    volatile LONG64 m_OwnerFormat;      // format | channels << 8 | rate << 32
+    volatile LONG64 m_ProcessedFrames;
+};
@@ -0,0 +1,107 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE USER MAPPINGS
+// The pages a control-device handle has mapped into its process: the shared
+// parameter page and the cables' loopback buffers. Asking twice hands back the
+// same address, and everything is unmapped together when the handle goes away.
+// Portable: builds against the WDK or the host stand-ins; what maps and unmaps
+// is a MappingSource.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#include "leyline_endpoints.h"
+
+#define LEYLINE_MAPPING_PARAMS      0xFFFFFFFF  // Key of the shared parameter page; a cable's is its index
+#define LEYLINE_MAX_USER_MAPPINGS   (LEYLINE_MAX_CABLES + 1)
+
+// Maps `pages` (the MDL, in the driver) into the calling process and back out.
+// Both are called in the owner's process context at PASSIVE_LEVEL.
+class MappingSource
+{
+public:
+    virtual NTSTATUS Map(PVOID pages, PVOID* address) = 0;
+    virtual void     Unmap(PVOID pages, PVOID address) = 0;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// USER MAPPINGS
+// One per handle. Only the process that opened the handle may map through it:
+// a mapping lives in one address space and has to be taken down from there. The
+// live entries are packed at the front, so lookups stop at the count. The caller
+// serializes Map and Release.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class UserMappings
+{
+public:
+    void Init(PVOID owner)
+    {
+        m_Owner = owner;
+        m_Count = 0;
+    }
+
+    PVOID Owner() const { return m_Owner; }
+    ULONG GetCount() const { return m_Count; }
+
+    // The existing mapping under `key`, or a new one. Pages that changed under a
+    // key are unmapped first; on failure nothing is left behind.
+    NTSTATUS Map(MappingSource* source, PVOID caller, ULONG key, PVOID pages, PVOID* address)
+    {
+        if (!source || !pages || !address) return STATUS_INVALID_PARAMETER;
+        if (caller != m_Owner) return STATUS_ACCESS_DENIED;
+
+        for (ULONG e = 0; e < m_Count; ++e)
+        {
+            if (m_Entry[e].Key != key) continue;
+            if (m_Entry[e].Pages == pages)
+            {
+                *address = m_Entry[e].Address;
+                return STATUS_SUCCESS;
+            }
+            source->Unmap(m_Entry[e].Pages, m_Entry[e].Address);
+            m_Entry[e] = m_Entry[--m_Count];
+            break;
+        }
+        if (m_Count == LEYLINE_MAX_USER_MAPPINGS) return STATUS_INSUFFICIENT_RESOURCES;
+
+        PVOID mapped = nullptr;
+        NTSTATUS status = source->Map(pages, &mapped);
+        if (!NT_SUCCESS(status)) return status;
+
+        m_Entry[m_Count].Key     = key;
+        m_Entry[m_Count].Pages   = pages;
+        m_Entry[m_Count].Address = mapped;
+        ++m_Count;
+        *address = mapped;
+        return STATUS_SUCCESS;
+    }
+
+    // Unmaps everything, newest first. Returns how many.
+    ULONG Release(MappingSource* source)
+    {
+        ULONG released = m_Count;
+        while (m_Count)
+        {
+            --m_Count;
+            source->Unmap(m_Entry[m_Count].Pages, m_Entry[m_Count].Address);
+        }
+        return released;
+    }
+
+private:
+    struct Entry
+    {
+        ULONG   Key;
+        PVOID   Pages;
+        PVOID   Address;
+    };
+
+    PVOID   m_Owner;
+    ULONG   m_Count;
+    Entry   m_Entry[LEYLINE_MAX_USER_MAPPINGS];
+};
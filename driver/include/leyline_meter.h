@@ -0,0 +1,128 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE METERING
+// Per-channel peak, RMS and clip counts over the frames a stream played each timer
+// period, and the block they are published through. Kernels live in
+// src/dsp/meter.cpp. Portable: builds against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#include "leyline_format.h"
+
+#define LEYLINE_METER_MAX_CHANNELS          8
+
+// Ballistics. Peak hold falls at a fixed rate in dB per second; RMS is the square
+// root of an exponential average of the mean square with the given time constant.
+#define LEYLINE_METER_DEFAULT_DECAY_DB      20          // dB per second
+#define LEYLINE_METER_DEFAULT_RMS_MS        300
+#define LEYLINE_METER_MAX_DECAY_DB          1000
+#define LEYLINE_METER_MAX_RMS_MS            10000
+
+// |sample| at or above this counts as a clip: 32767 / 32768, the largest positive
+// 16-bit value, so full-scale integer audio clips the same as overdriven float.
+#define LEYLINE_METER_CLIP_LEVEL            0.999969482421875f
+
+// The shared block carries floats as their IEEE 754 bits.
+inline ULONG FloatToBits(float value)
+{
+    union { float Value; ULONG Bits; } u;
+    u.Value = value;
+    return u.Bits;
+}
+
+inline float BitsToFloat(ULONG bits)
+{
+    union { ULONG Bits; float Value; } u;
+    u.Bits = bits;
+    return u.Value;
+}
+
+// Published meter values. Single writer; readers take a consistent copy through
+// PeakMeter::Snapshot. Levels are IEEE 754 float bits, linear, 1.0 = full scale.
+struct LeylineMeterBlock
+{
+    volatile ULONG  Sequence;       // Odd while an update is in flight
+    volatile ULONG  Channels;       // Channels of the metered stream, 0 if none
+    volatile ULONG  PeakBits[LEYLINE_METER_MAX_CHANNELS];
+    volatile ULONG  RmsBits[LEYLINE_METER_MAX_CHANNELS];
+    volatile ULONG  ClipCount[LEYLINE_METER_MAX_CHANNELS];  // Clipped samples since KSSTATE_RUN
+};
+
+struct MeterReading
+{
+    ULONG   Channels;
+    float   Peak[LEYLINE_METER_MAX_CHANNELS];
+    float   Rms[LEYLINE_METER_MAX_CHANNELS];
+    ULONG   Clips[LEYLINE_METER_MAX_CHANNELS];
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PEAK METER
+// Accumulate folds interleaved frames into the current period (max |x|, sum of
+// x^2 and clip count per channel, SIMD across frames); EndPeriod applies the
+// ballistics for however many frames the period held, so the result does not
+// depend on the timer period. Samples in any LeylineSampleFormat are decoded to
+// float in LEYLINE_CONVERT_CHUNK pieces first.
+//
+// Never allocates; Accumulate and EndPeriod may run at DISPATCH_LEVEL. Not
+// thread-safe; one meter per stream.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class PeakMeter
+{
+public:
+    // Folds `frames` interleaved float frames into per-channel peak / sum of
+    // squares / clip count, which it updates rather than overwrites.
+    typedef void (*ReduceFn)(const float* samples, ULONG frames, ULONG channels,
+                             float* peak, float* sumSquares, ULONG* clips);
+
+    NTSTATUS Init(LeylineSampleFormat format, ULONG channels, ULONG sampleRate, SimdLevel level);
+
+    // Takes effect from the next EndPeriod. A decay of 0 disables peak hold (each
+    // period shows its own peak); an RMS time constant of 0 shows each period's RMS.
+    void SetBallistics(ULONG decayDbPerSecond, ULONG rmsWindowMs);
+
+    // Back to silence with no clips, as at KSSTATE_RUN.
+    void Reset();
+
+    void Accumulate(const void* samples, ULONG frames);
+    void EndPeriod();
+
+    void Read(MeterReading* reading) const;
+
+    // Seqlock publish / consistent read of a LeylineMeterBlock.
+    static void Publish(LeylineMeterBlock* block, const MeterReading& reading);
+    static void Snapshot(const LeylineMeterBlock* block, MeterReading* reading);
+
+    ULONG      GetChannels() const { return m_Channels; }
+    SimdLevel  GetLevel()    const { return m_Level; }
+
+private:
+    void Reduce(ReduceFn reduce, const float* samples, ULONG frames);
+
+    LeylineSampleFormat m_Format;
+    ULONG       m_Channels;
+    ULONG       m_SampleRate;
+    SimdLevel   m_Level;
+    ReduceFn    m_Reduce;
+    ReduceFn    m_FallbackReduce;       // SSE2, if AVX state cannot be saved
+    FormatConverter m_Decoder;          // Non-float formats only
+    double      m_DecayPerFrame;        // Natural-log peak fall per frame, 0 for no hold
+    double      m_RmsFrames;            // RMS time constant in frames, 0 for none
+    ULONG       m_StepFrames;           // Period length the two factors below are for
+    double      m_StepFall;
+    double      m_StepAlpha;
+
+    ULONG       m_PeriodFrames;
+    float       m_PeriodPeak[LEYLINE_METER_MAX_CHANNELS];
+    double      m_PeriodSumSquares[LEYLINE_METER_MAX_CHANNELS];
+
+    double      m_Peak[LEYLINE_METER_MAX_CHANNELS];
+    double      m_MeanSquare[LEYLINE_METER_MAX_CHANNELS];
+    ULONG       m_Clips[LEYLINE_METER_MAX_CHANNELS];
+};
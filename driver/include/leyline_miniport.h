@@ -18,40 +18,119 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 class CMiniportWaveRT;
+class CMiniportWaveRTStream;
 class CMiniportTopology;
 
-struct DeviceExtension
+// Routing matrices held at once, across all streams.
+#define LEYLINE_ROUTE_SLOTS     16
+
+// Open streams DeviceExtension::Streams lists for the glitch and snapshot IOCTLs.
+// Past this many a stream still works, it just isn't reported.
+#define LEYLINE_MAX_LIVE_STREAMS    64
+
+// A routing matrix set through IOCTL_LEYLINE_SET_ROUTE, allocated with its taps
+// right behind it. Immutable; Refs (the slot, plus each stream mixed through it)
+// only changes under MixLock, and the last release frees it.
+struct MixRoute
 {
-    PDEVICE_OBJECT  ControlDeviceObject;
-    LeylineSharedParameters* SharedParams;
-    PMDL            SharedParamsMdl;
-    PVOID           SharedParamsUserMapping;
+    LONG          Refs;
+    ULONG         StreamId;
+    ChannelRouter Router;
+};
+
+// Stream buffer pages for DeviceExtension::AudioBuffers: nonpaged, below 4 GB,
+// mapped into system space. Also serves streams directly when nothing could be
+// reserved. The pool's own source comes from Objects ('LLBP').
+class LockedPageSource : public PageSource,
+                         public HeapObject
+{
+public:
+    NTSTATUS Allocate(SIZE_T Bytes, PoolBlock* Block) override;
+    void     Free(const PoolBlock& Block) override;
+};
+
+// One virtual cable: a render and a capture endpoint (EndpointGraph order) and the
+// loopback pages between them. Allocated zeroed from Objects at StartDevice and
+// kept until unload.
+struct CableEndpoint
+{
+    ULONG           Index;
     PMDL            LoopbackMdl;
     PUCHAR          LoopbackBuffer;
     SIZE_T          LoopbackSize;
-    PVOID           UserMapping;
+    LoopbackCable   Cable;              // Virtual-cable clock + latency config
+    PVOID           CableOwner;         // Render stream mapped onto the loopback pages
+    ChannelControls RenderControls;     // Topology volume/mute nodes; zeroed is 0 dB, unmuted
+    ChannelControls CaptureControls;
+    CMiniportWaveRTStream* MixSources[LEYLINE_MIX_MAX_INPUTS];  // Running render streams off the cable, under MixLock
+    ULONG           MixSourceCount;
+    KSPIN_LOCK      PlanesLock;         // Keeps CablePlanes' layout still under IOCTL readers
+    PlanarRing      CablePlanes;        // The cable owner's frames, one plane per channel
+    PVOID           CablePlanesStorage; // Sized for LEYLINE_PLANAR_MAX_CHANNELS at StartDevice
+    KSPIN_LOCK      ProbeLock;          // Orders Probe's shared calls: the IOCTLs, the owner, the listener
+    LatencyProbe*   Probe;              // Allocated at StartDevice; idle until armed
+    PVOID           ProbeListener;      // Capture stream timing Probe's markers
     CMiniportWaveRT* RenderMiniport;
     CMiniportWaveRT* CaptureMiniport;
     CMiniportTopology* RenderTopoMiniport;
     CMiniportTopology* CaptureTopoMiniport;
 };
 
+struct DeviceExtension
+{
+    PDEVICE_OBJECT  ControlDeviceObject;
+    LeylineSharedParameters* SharedParams;
+    PMDL            SharedParamsMdl;
+    CableEndpoint*  Cables[LEYLINE_MAX_CABLES];
+    ULONG           CableCount;         // "CablePairs" from the device's driver key
+    volatile LONG   RegisterPeriodMs;   // Register page refresh period for new runs
+    volatile LONG   ResamplerQuality;   // SrcQuality for newly allocated cable captures
+    volatile LONG   MeterDecayDb;       // LeylineMeterConfig, for the next metered run
+    volatile LONG   MeterRmsMs;
+    PVOID           MeterOwner;         // Render stream publishing SharedParams->Meter
+    KSPIN_LOCK      MixLock;            // Guards every cable's MixSources, and Routes, against the owners' DPCs
+    MixRoute*       Routes[LEYLINE_ROUTE_SLOTS];   // Under MixLock; null slots are free
+    volatile LONG   NextStreamId;
+    KSPIN_LOCK      StreamsLock;        // Guards Streams; a stream unlists itself before it goes
+    CMiniportWaveRTStream* Streams[LEYLINE_MAX_LIVE_STREAMS];  // Open streams, null slots are free
+    BufferPool      AudioBuffers;       // Private stream buffers, reserved at StartDevice
+    ObjectHeap      Objects;            // Miniports, streams, routes, cables, CDO handles; streams slabbed at StartDevice
+};
+
 // The PortCls reference driver reserves this many pointer-sized slots
 // in the DeviceExtension before our own fields begin.
 static const SIZE_T LEYLINE_PORT_CLASS_DEVICE_EXTENSION_SIZE = 64 * sizeof(PVOID);
 
+// IOCTL_LEYLINE_SET_ROUTE, after the buffer has been size-checked. PASSIVE_LEVEL.
+NTSTATUS SetMixRoute(DeviceExtension* DevExt, const LeylineRouteConfig* Config, const float* Gains);
+
+// IOCTL_LEYLINE_READ_PLANES into `Output` (the request already copied out of it).
+NTSTATUS ReadCablePlanes(CableEndpoint* Cable, const LeylinePlaneRequest& Request,
+                         PVOID Output, ULONG OutputLength, ULONG_PTR* Written);
+
+// IOCTL_LEYLINE_GET_GLITCH_STATS into `Output`, at least a LeylineGlitchReport.
+NTSTATUS ReadGlitchStats(DeviceExtension* DevExt, PVOID Output, ULONG OutputLength, ULONG_PTR* Written);
+
+// IOCTL_LEYLINE_MEASURE_LATENCY, range-checked, and IOCTL_LEYLINE_GET_LATENCY.
+NTSTATUS MeasureLatency(CableEndpoint* Cable, const LeylineLatencyConfig& Config);
+NTSTATUS ReadLatency(CableEndpoint* Cable, LeylineLatencyReport* Report);
+
+// IOCTL_LEYLINE_GET_SNAPSHOT into `Output`, at least a LeylineSnapshotHeader.
+NTSTATUS ReadSnapshot(DeviceExtension* DevExt, PVOID Output, ULONG OutputLength, ULONG_PTR* Written);
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // WAVE RT STREAM
 // Manages a single audio stream (render or capture).
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 class CMiniportWaveRTStream : public IMiniportWaveRTStream,
-                              public CUnknown
+                              public CUnknown,
+                              public HeapObject
 {
 public:
     DECLARE_STD_UNKNOWN();
 
-    CMiniportWaveRTStream(PUNKNOWN OuterUnknown, DeviceExtension* DevExt);
+    CMiniportWaveRTStream(PUNKNOWN OuterUnknown, DeviceExtension* DevExt, CableEndpoint* Cable);
     virtual ~CMiniportWaveRTStream();
 
     // IMiniportWaveRTStream
@@ -66,20 +145,123 @@ public:
     STDMETHODIMP GetPositionRegister(KSRTAUDIO_HWREGISTER* Register) override;
     STDMETHODIMP GetClockRegister(KSRTAUDIO_HWREGISTER* Register) override;
 
-    // Initialization helper.
+    // Initialization helpers.
     NTSTATUS Init(ULONG PinId, BOOLEAN Capture, PKSDATAFORMAT Format);
+    void ClaimSlot();
+    void List();
+
+    // KSPROPERTY_AUDIO_WAVERT_CURRENT_WRITE_POSITION: how far a render client has
+    // written, as a byte offset into the buffer.
+    NTSTATUS SetClientWritePosition(ULONG Offset);
+
+    // Under DevExt->StreamsLock.
+    void GetGlitchStats(LeylineGlitchStats* Stats) const;
+    void GetSnapshot(LeylineSnapshotStream* Snapshot, LONGLONG Now);
 
 private:
-    RingBuffer         m_Buffer;
+    NTSTATUS ApplyFormat(PKSDATAFORMAT Format);
+    NTSTATUS AssignAudioBuffer(ULONG RequestedSize, PMDL* AudioBufferMdl, ULONG* ActualSize,
+                               ULONG* OffsetFromFirstPage, MEMORY_CACHING_TYPE* CacheType);
+    NTSTATUS UseSharedBuffer(PMDL* AudioBufferMdl, ULONG* ActualSize,
+                             ULONG* OffsetFromFirstPage, MEMORY_CACHING_TYPE* CacheType);
+    void ReleaseAudioBuffer();
+    ULONGLONG CurrentFrames(LONGLONG Now);
+    void PumpCable(LONGLONG Now);
+    ULONGLONG PumpSource(const LoopbackSourceClock& Source, ULONGLONG Available, ULONGLONG Done);
+    ULONGLONG ResampleFrames(const UCHAR* In, ULONG Stride, ULONG Count, ULONGLONG Done);
+    ULONGLONG WriteCaptureFrames(const UCHAR* In, ULONG Stride, ULONG Count, ULONGLONG Done);
+    NTSTATUS PrepareCableConversion(LeylineSampleFormat OwnerFormat, ULONG OwnerRate);
+    void UpdateGain(BOOLEAN Jump);
+    void ProcessPlayed(ULONGLONG Frames);
+    PUCHAR FrameAt(ULONGLONG Frame, ULONG* Contiguous) const;
+    void JoinMix();
+    void LeaveMix();
+    void MixSources(ULONGLONG From, ULONGLONG To);
+    void PrepareMixBus();
+    MixRoute* FindRoute(const CMiniportWaveRTStream* Stream) const;
+    void SwitchRoute(CMiniportWaveRTStream* Stream, MixRoute* Route, ULONG Count, BOOLEAN Fade, MixInput* Input);
+    void ReleaseMeter();
+    void PublishPosition(LONGLONG Now);
+    void PublishCableClock(const LoopbackSourceClock* Clock);
+    void PublishSharedPosition(ULONG Position, ULONGLONG Frames, LONGLONG Now);
+    void StartRegisterTimer(LONGLONG Now);
+    void StopRegisterTimer();
+    void UseRegisters();
+    void ReportGlitch(TraceGlitchKind Kind, ULONGLONG Frames, ULONGLONG AtFrame) const;
+    void MarkPlayed(ULONGLONG From, ULONGLONG To);
+    void ListenForMarkers(ULONGLONG Frames, LONGLONG Now);
+    void StopListening();
+    void ObserveClient(ULONGLONG Frames);
+    void Unlist();
+
+    static EXT_CALLBACK RegisterTimerCallback;
+
     KSSTATE            m_State;
     PMDL               m_Mdl;
     PVOID              m_Mapping;
     BOOLEAN            m_IsCapture;
     BOOLEAN            m_OwnsMdl;
+    PoolBuffer         m_Pages;             // m_OwnsMdl: the block behind m_Mdl...
+    BOOLEAN            m_Pooled;            // ...from DevExt->AudioBuffers, else LockedPageSource
+    BOOLEAN            m_OnCable;           // Mapped onto the shared loopback pages
+    ULONG              m_BufferSize;        // DMA buffer size in bytes, as handed to PortCls
     LONGLONG           m_StartTime;
     ULONG              m_ByteRate;
+    ULONG              m_BlockAlign;
+    ULONG              m_SampleRate;
+    ULONG              m_Channels;
+    LeylineSampleFormat m_SampleFormat;
     LONGLONG           m_Frequency;
+    WaveRTMath::StreamClock m_Clock;        // Reciprocals fixed at KSSTATE_RUN
+    PMDL               m_RegisterMdl;       // One page holding LeylineStreamRegisters
+    StreamRegisterWriter m_Registers;
+    ULONG              m_RegisterPeriodMs;  // Period the running timer was armed with
+    PEX_TIMER          m_RegisterTimer;     // High resolution; allocated in Init
+    BOOLEAN            m_TimerArmed;
+    BOOLEAN            m_RegistersInUse;    // Handed to the audio engine; refreshed while running
+    FormatConverter    m_Converter;         // Cable capture in a format other than the owner's
+    BOOLEAN            m_CableConvert;
+    volatile LONG64    m_ConvertedFrames;   // Frames written into the private buffer this run
+    LONG64             m_ConvertOrigin;     // Source StartQpc being followed, 0 for none
+    LONG64             m_ConvertDelta;      // No source: capture frames minus capture clock
+    BOOLEAN            m_CableResample;     // ...and at another rate
+    FormatConverter    m_SourceDecoder;     // Owner format -> float, ahead of the resampler
+    Resampler          m_Resampler;
+    float*             m_ResamplerBank;
+    WaveRTMath::StreamClock m_SourceClock;  // Owner's clock, at the owner's rate
+    ULONGLONG          m_SourceFrames;      // Next owner frame to take
+    PeakMeter          m_Meter;             // Render only
+    BOOLEAN            m_MeterReady;        // Format is one the meter reads
+    BOOLEAN            m_Metering;          // Owns DevExt->MeterOwner while running
+    GainStage          m_Gain;              // Render only
+    BOOLEAN            m_GainReady;         // Format is one the gain stage can scale
+    BOOLEAN            m_Gaining;           // Running with a mapped buffer
+    LONG               m_GainGeneration;    // RenderControls generation the targets came from
+    ULONG              m_GainMasterBits;    // ...and the shared master gain it applied
+    ULONGLONG          m_PlayedFrames;      // Frames already gained/mixed/metered this run
+    MixBus*            m_Mix;               // Cable owner: sums the other render streams into its pages
+    BOOLEAN            m_Mixing;            // Cable owner, running
+    BOOLEAN            m_MixSource;         // Listed in m_Cable->MixSources while running
+    volatile LONG64    m_MixableFrames;     // Frames of this run ProcessPlayed is done with
+    volatile LONG64    m_SilentFrom;        // First of those the gain is settled at zero from
+    ULONGLONG          m_MixedFrames;       // Owner's cursor into this stream, under MixLock
+    MixRoute*          m_MixRoute;          // Route this stream was last mixed through, under MixLock
+    ULONG              m_StreamId;          // LeylineRouteConfig::StreamId
+    LeylineStreamSlot* m_Slot;              // Telemetry slot in SharedParams, if one was free
+    BOOLEAN            m_Planar;            // Cable owner, running: feeds m_Cable->CablePlanes
+    ULONG              m_PositionCalls;     // GetPosition calls since the last traced one
+    GlitchDetector     m_Glitches;          // Counts from NewStream; valid zeroed
+    volatile LONG64    m_ClientWritten;     // Render: bytes the client has written, from the run's start
+    ULONG              m_ClientOffset;      // ...and the offset it last reported
+    BOOLEAN            m_ClientReports;     // The client has reported a write position since STOP
+    BOOLEAN            m_Listed;            // In DevExt->Streams
+    FormatConverter    m_ProbeCodec;        // Marker float -> owner format, or capture format -> float
+    BOOLEAN            m_Marking;           // Cable owner, running: plays m_Cable->Probe's bursts
+    BOOLEAN            m_Listening;         // Cable capture, running: may time them
+    BOOLEAN            m_Probing;           // ...and holds m_Cable->ProbeListener
+    ULONGLONG          m_ProbeFrames;       // Next capture frame to feed the probe
     DeviceExtension*   m_DevExt;
+    CableEndpoint*     m_Cable;             // The endpoint pair this stream's filter belongs to
 };
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -87,12 +269,13 @@ private:
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 class CMiniportWaveRT : public IMiniportWaveRT,
-                        public CUnknown
+                        public CUnknown,
+                        public HeapObject
 {
 public:
     DECLARE_STD_UNKNOWN();
 
-    CMiniportWaveRT(PUNKNOWN OuterUnknown, BOOLEAN IsCapture, DeviceExtension* DevExt);
+    CMiniportWaveRT(PUNKNOWN OuterUnknown, BOOLEAN IsCapture, DeviceExtension* DevExt, CableEndpoint* Cable);
     virtual ~CMiniportWaveRT();
 
     // IMiniport
@@ -111,10 +294,19 @@ public:
                            ULONG PinId, BOOLEAN Capture,
                            PKSDATAFORMAT DataFormat) override;
 
+    // KSPROPERTY_PIN_PROPOSEDATAFORMAT: the format open choices in
+    // DataRangeIntersection lean towards, once one has been set.
+    BOOLEAN  GetProposedFormat(WaveFormat* Format);
+    NTSTATUS SetProposedFormat(const WaveFormat& Format);
+
 private:
     BOOLEAN          m_IsCapture;
     BOOLEAN          m_IsInitialized;
     DeviceExtension* m_DevExt;
+    CableEndpoint*   m_Cable;
+    KSPIN_LOCK       m_FormatLock;      // Guards the proposed format
+    WaveFormat       m_Proposed;
+    BOOLEAN          m_HasProposed;
 };
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -122,12 +314,13 @@ private:
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 class CMiniportTopology : public IMiniportTopology,
-                          public CUnknown
+                          public CUnknown,
+                          public HeapObject
 {
 public:
     DECLARE_STD_UNKNOWN();
 
-    CMiniportTopology(PUNKNOWN OuterUnknown, BOOLEAN IsCapture);
+    CMiniportTopology(PUNKNOWN OuterUnknown, BOOLEAN IsCapture, CableEndpoint* Cable);
     virtual ~CMiniportTopology();
 
     // IMiniport
@@ -141,10 +334,14 @@ public:
     STDMETHODIMP Init(PUNKNOWN UnknownAdapter, PRESOURCELIST ResourceList,
                       IPortTopology* Port) override;
 
+    // State behind this filter's volume and mute nodes.
+    ChannelControls* GetControls();
+
 private:
     BOOLEAN  m_IsCapture;
     BOOLEAN  m_IsInitialized;
     PVOID    m_Port;
+    CableEndpoint* m_Cable;
 };
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
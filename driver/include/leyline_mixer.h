@@ -0,0 +1,164 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE MIX BUS
+// Sums render streams into the loopback bus, each optionally through a channel
+// routing matrix. Kernels live in src/dsp/mixer.cpp.
+// Portable: builds against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#include "leyline_format.h"
+
+// Render streams one bus mixes at most, besides the one whose pages it writes.
+#define LEYLINE_MIX_MAX_INPUTS      64
+
+// Channels on either side of a routing matrix, and the largest gain it may hold.
+#define LEYLINE_ROUTE_MAX_CHANNELS  64
+#define LEYLINE_ROUTE_MAX_GAIN      8.0f
+
+// Frames a routed input is taken in at a time: four independent AVX sums per row.
+#define LEYLINE_ROUTE_BLOCK_FRAMES  32
+
+// Samples the bus sums per pass: a block of frames at the widest layout.
+#define LEYLINE_MIX_CHUNK_SAMPLES   (LEYLINE_ROUTE_MAX_CHANNELS * LEYLINE_ROUTE_BLOCK_FRAMES)
+
+// One nonzero coefficient: Gain times input channel Input, into output channel Output.
+struct RouteTap
+{
+    USHORT  Input;
+    USHORT  Output;
+    float   Gain;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CHANNEL ROUTER
+// An outputs x inputs gain matrix kept as its nonzero coefficients only, ordered
+// by output, in caller-owned storage sized by TableBytes. Cost is per tap, so a
+// sparse 64 x 64 matrix costs what its few taps do. Immutable once built; the mix
+// bus runs it.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class ChannelRouter
+{
+public:
+    // Nonzero coefficients in `gains`, and the table bytes they need.
+    static ULONG  TapCount(const float* gains, ULONG inputs, ULONG outputs);
+    static SIZE_T TableBytes(ULONG taps) { return (SIZE_T)taps * sizeof(RouteTap); }
+
+    // `gains` is row-major by output: gains[o * inputs + i] takes input channel i
+    // into output o. Each must be finite and within +-LEYLINE_ROUTE_MAX_GAIN.
+    NTSTATUS Init(const float* gains, ULONG inputs, ULONG outputs, RouteTap* table, SIZE_T tableBytes);
+
+    // Channel i to channel i at unity, for `channels` taps.
+    NTSTATUS InitIdentity(ULONG channels, RouteTap* table, SIZE_T tableBytes);
+
+    ULONG           GetInputs()     const { return m_Inputs; }
+    ULONG           GetOutputs()    const { return m_Outputs; }
+    ULONG           GetTapCount()   const { return m_TapCount; }
+    const RouteTap* GetTaps()       const { return m_Taps; }
+    ULONGLONG       GetUsedInputs() const { return m_UsedInputs; }     // Bit i: input i has a tap
+
+private:
+    ULONG           m_Inputs;
+    ULONG           m_Outputs;
+    ULONG           m_TapCount;
+    ULONGLONG       m_UsedInputs;
+    const RouteTap* m_Taps;
+};
+
+// One stream's frames for a Mix call, interleaved. A null Samples or an unknown
+// Format is skipped. Without a Route the input is at the bus channel count and
+// layout; with one, at the route's input count, and the route's outputs must be
+// the bus channels. Samples may be the bus itself at the same frames.
+//
+// With FadeFrom (same shape as Route), frame k of the call goes through Route
+// weighted Fade + k * FadeStep and through FadeFrom weighted by the rest, which
+// is how a route change crossfades instead of clicking.
+struct MixInput
+{
+    const void*          Samples;
+    LeylineSampleFormat  Format;
+    const ChannelRouter* Route    = nullptr;
+    const ChannelRouter* FadeFrom = nullptr;
+    float                Fade     = 0.0f;
+    float                FadeStep = 0.0f;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MIX BUS
+// Inputs are decoded to float (float inputs are read in place), summed in a
+// block of LEYLINE_MIX_CHUNK_SAMPLES samples, and written back in the bus
+// format saturated to full scale: integer buses clamp in the encoder, a float
+// bus to [-1, 1]. No dither, so integer inputs summing onto an integer bus of at
+// least their width come out exact. Cost is one pass per input.
+//
+// A routed input is taken LEYLINE_ROUTE_BLOCK_FRAMES frames at a time: its used
+// channels are transposed into planes, each output row sums its taps over the
+// planes in SIMD registers, and the row is added into the bus frames.
+//
+// The blocks live in the object (about 25 KB), so allocate it rather than put it
+// on a kernel stack. Every SIMD level matches the scalar kernels bit for bit.
+// Never allocates; may run at DISPATCH_LEVEL. Not thread-safe; one per bus.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class MixBus
+{
+public:
+    // sum[i] += samples[i], and out[i] = clamp(sum[i], -1, 1) (NaN becomes -1).
+    typedef void (*AccumulateFn)(float* sum, const float* samples, SIZE_T count);
+    typedef void (*SaturateFn)(const float* sum, float* out, SIZE_T count);
+
+    // One block of a routed input: for each output row of `taps`, the gain-weighted
+    // sum of the input planes (LEYLINE_ROUTE_BLOCK_FRAMES floats each), times
+    // weights[k], added to sum[k * stride + output] for k < frames.
+    typedef void (*RouteFn)(const float* planes, const RouteTap* taps, ULONG count,
+                            float* sum, ULONG stride, ULONG frames, const float* weights);
+
+    NTSTATUS Init(LeylineSampleFormat format, ULONG channels, SimdLevel level);
+
+    // Writes the sum of `count` inputs of `frames` frames into `out`. With
+    // `includeOut` the frames already in `out` are one more input, so a stream
+    // whose buffer is the bus keeps its own audio; without inputs that leaves
+    // `out` untouched. Otherwise no inputs means silence.
+    void Mix(const MixInput* inputs, ULONG count, void* out, ULONG frames, BOOLEAN includeOut);
+
+    // Channel i to channel i at the bus channel count, to fade to or from.
+    const ChannelRouter* GetIdentity() const { return &m_Identity; }
+
+    LeylineSampleFormat GetFormat()   const { return m_Format; }
+    ULONG               GetChannels() const { return m_Channels; }
+    SimdLevel           GetLevel()    const { return m_Level; }
+
+private:
+    struct Kernels
+    {
+        AccumulateFn Accumulate;
+        SaturateFn   Saturate;
+        RouteFn      Route;
+    };
+
+    BOOLEAN IsLive(const MixInput& input) const;
+    void Run(const Kernels& kernels, const MixInput* inputs, ULONG count, UCHAR* out, ULONG frames,
+             BOOLEAN includeOut);
+    void Load(const void* samples, LeylineSampleFormat format, SIZE_T count, AccumulateFn accumulate,
+              BOOLEAN first);
+    void LoadRouted(const Kernels& kernels, const MixInput& input, ULONG pos, ULONG frames);
+
+    LeylineSampleFormat m_Format;
+    ULONG           m_Channels;
+    SimdLevel       m_Level;
+    Kernels         m_Kernels;
+    Kernels         m_Fallback;             // SSE2, if AVX state cannot be saved
+    FormatConverter m_Decoders[SampleFormat_Float32];   // Integer formats -> float, by format
+    FormatConverter m_Encoder;                          // Float -> an integer bus
+    ChannelRouter   m_Identity;
+    RouteTap        m_IdentityTaps[LEYLINE_ROUTE_MAX_CHANNELS];
+    float           m_Sum[LEYLINE_MIX_CHUNK_SAMPLES];
+    float           m_Staging[LEYLINE_MIX_CHUNK_SAMPLES];   // Decoded input
+    float           m_Planes[LEYLINE_MIX_CHUNK_SAMPLES];    // A routed block, [channel][frame]
+};
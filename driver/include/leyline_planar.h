@@ -0,0 +1,112 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE PLANAR AUDIO
+// Interleave/deinterleave kernels and a side ring holding the cable's audio one
+// float plane per channel, for consumers that work on a single channel at a time.
+// Kernels live in src/dsp/planar.cpp. Portable: builds against the WDK or the host
+// stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#include "leyline_format.h"
+
+#define LEYLINE_PLANAR_MAX_CHANNELS     16
+
+// Frames of history the driver's side ring keeps (~85 ms at 48 kHz).
+#define LEYLINE_PLANAR_RING_FRAMES      4096
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// KERNELS
+// Float frames <-> one array per channel. Channels go four at a time through 4x4
+// transposes (SSE2: four frames, AVX2: eight, two per 128-bit lane); stereo has
+// its own shuffle, and channels past the last group of four a scalar loop. Pure
+// data movement, so every level gives the same bits. Up to
+// LEYLINE_PLANAR_MAX_CHANNELS channels; YMM state is saved around AVX2 as for the
+// other kernels.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef void (*DeinterleaveFn)(const float* in, ULONG channels, ULONG frames, float* const* planes);
+typedef void (*InterleaveFn)(const float* const* planes, ULONG channels, ULONG frames, float* out);
+
+void Deinterleave(const float* in, ULONG channels, ULONG frames, float* const* planes, SimdLevel level);
+void Interleave(const float* const* planes, ULONG channels, ULONG frames, float* out, SimdLevel level);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PLANAR RING
+// One writer, any number of readers, overwrite-oldest. Write takes interleaved
+// frames in any LeylineSampleFormat, decodes them to float in
+// LEYLINE_CONVERT_CHUNK pieces and spreads them over the planes; frame `f` sits
+// at index f & (capacity - 1) of every plane. Cursors are monotonic frame
+// counts: the writer announces what it is about to overwrite (m_ReservePos),
+// fills it and publishes it (m_WritePos); readers copy, then keep only frames
+// still at or past m_ReservePos - capacity.
+//
+// Storage comes from the caller (Bytes()); nothing here allocates, and Write and
+// the reads may run at DISPATCH_LEVEL.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class PlanarRing
+{
+public:
+    // Storage for `channels` planes of `frames` (a power of two) floats, each
+    // plane starting on its own cache line.
+    static SIZE_T Bytes(ULONG channels, ULONG frames)
+    {
+        return (SIZE_T)channels * PlaneStride(frames) * sizeof(float) + SYSTEM_CACHE_ALIGNMENT_SIZE;
+    }
+
+    NTSTATUS Init(LeylineSampleFormat format, ULONG channels, ULONG sampleRate, ULONG frames,
+                  SimdLevel level, PVOID storage, SIZE_T bytes);
+
+    // Starts over at frame 0, e.g. for a new run. Writer side only.
+    void Reset();
+
+    // Appends `frames` interleaved frames in the ring's format.
+    void Write(const void* samples, ULONG frames);
+
+    // Frames written so far; the ring holds the last GetCapacity() of them.
+    ULONGLONG GetWritten() const { return (ULONGLONG)ReadAcquire64(&m_WritePos); }
+
+    // Copies up to `count` frames of one channel starting at frame `*from`. Frames
+    // the writer has already overwritten are skipped: `*from` moves up to the first
+    // frame returned. Returns the frames copied, 0 past the write position.
+    ULONG ReadPlane(ULONG channel, ULONGLONG* from, ULONG count, float* out) const;
+
+    // The same for every channel at once, re-interleaved into `out`.
+    ULONG ReadFrames(ULONGLONG* from, ULONG count, float* out) const;
+
+    // Plane `channel` for in-place reads; index with a frame & (capacity - 1).
+    const float* GetPlane(ULONG channel) const { return m_Planes[channel]; }
+
+    LeylineSampleFormat GetFormat()     const { return m_Format; }
+    ULONG               GetChannels()   const { return m_Channels; }
+    ULONG               GetSampleRate() const { return m_SampleRate; }
+    ULONG               GetCapacity()   const { return m_Capacity; }
+    SimdLevel           GetLevel()      const { return m_Level; }
+
+private:
+    static ULONG PlaneStride(ULONG frames)
+    {
+        const ULONG perLine = SYSTEM_CACHE_ALIGNMENT_SIZE / sizeof(float);
+        return (frames + perLine - 1) & ~(perLine - 1);
+    }
+
+    void  Fill(const UCHAR* in, ULONG frames, LONG64 pos, DeinterleaveFn deinterleave);
+    void  Spread(const float* in, ULONG frames, ULONG at, DeinterleaveFn deinterleave);
+    ULONG Read(ULONG channel, ULONGLONG* from, ULONG count, float* out) const;
+
+    LeylineSampleFormat m_Format;
+    ULONG           m_Channels;
+    ULONG           m_SampleRate;
+    ULONG           m_Capacity;
+    SimdLevel       m_Level;
+    FormatConverter m_Decoder;          // Non-float formats only
+    float*          m_Planes[LEYLINE_PLANAR_MAX_CHANNELS];
+    DECLSPEC_CACHEALIGN volatile LONG64 m_ReservePos;
+    volatile LONG64 m_WritePos;
+};
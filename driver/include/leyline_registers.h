@@ -0,0 +1,83 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE STREAM REGISTERS
+// Virtual position/clock register page refreshed by a periodic timer and handed to
+// the audio engine through KSRTAUDIO_HWREGISTER. Portable: builds against the WDK
+// or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#define LEYLINE_DEFAULT_REGISTER_PERIOD_MS  1
+#define LEYLINE_MAX_REGISTER_PERIOD_MS      100
+
+// One per stream, alone on its own page so it can be mapped into user mode.
+// Position and Frames are naturally aligned, so each is a single atomic load for
+// a client that polls only one of them; Sequence ties all three together.
+struct LeylineStreamRegisters
+{
+    volatile ULONG   Position;      // Position register: byte offset in the DMA buffer
+    volatile ULONG   Sequence;      // Odd while an update is in flight
+    volatile ULONG64 Frames;        // Clock register: frames since KSSTATE_RUN
+    volatile LONG64  Qpc;           // QPC the two registers were computed for
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// STREAM REGISTER WRITER
+// Single writer (the stream's timer DPC, or SetState with the timer cancelled).
+// Readers either take the registers one at a time, like the audio engine does, or
+// use Snapshot for a matched {Position, Frames, Qpc} triple.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class StreamRegisterWriter
+{
+public:
+    void Attach(LeylineStreamRegisters* page) { m_Page = page; }
+    LeylineStreamRegisters* GetPage() const   { return m_Page; }
+
+    void Publish(LONG64 qpc, ULONGLONG frames, ULONG position)
+    {
+        if (!m_Page) return;
+        LONG seq = ReadNoFence(SequencePtr());
+        WriteNoFence(SequencePtr(), seq + 1);
+        WriteRelease64(reinterpret_cast<volatile LONG64*>(&m_Page->Frames), (LONG64)frames);
+        WriteRelease64(&m_Page->Qpc, qpc);
+        WriteRelease(reinterpret_cast<volatile LONG*>(&m_Page->Position), (LONG)position);
+        WriteRelease(SequencePtr(), seq + 2);
+    }
+
+    void Reset() { Publish(0, 0, 0); }
+
+    static void Snapshot(const LeylineStreamRegisters* page, ULONG* position, ULONGLONG* frames, LONG64* qpc)
+    {
+        const volatile LONG* sequence = reinterpret_cast<const volatile LONG*>(&page->Sequence);
+        for (;;)
+        {
+            LONG seq = ReadAcquire(sequence);
+            if (seq & 1) { YieldProcessor(); continue; }
+
+            *frames   = (ULONGLONG)ReadAcquire64(reinterpret_cast<const volatile LONG64*>(&page->Frames));
+            *qpc      = ReadAcquire64(&page->Qpc);
+            *position = (ULONG)ReadAcquire(reinterpret_cast<const volatile LONG*>(&page->Position));
+
+            if (ReadAcquire(sequence) == seq) return;
+        }
+    }
+
+    // Worst-case staleness of the position register, in bytes: one timer period
+    // of audio, rounded up to whole frames.
+    static ULONG AccuracyBytes(ULONG periodMs, ULONG sampleRate, ULONG blockAlign)
+    {
+        ULONGLONG frames = ((ULONGLONG)periodMs * sampleRate + 999) / 1000;
+        return (ULONG)(frames * blockAlign);
+    }
+
+private:
+    volatile LONG* SequencePtr() { return reinterpret_cast<volatile LONG*>(&m_Page->Sequence); }
+
+    LeylineStreamRegisters* m_Page;
+};
@@ -0,0 +1,101 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE RESAMPLER
+// Rational-ratio polyphase sample-rate converter on interleaved float frames.
+// Kernels live in src/dsp/resampler.cpp. Portable: builds against the WDK or the
+// host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#include "leyline_format.h"
+
+// Quality / CPU presets. Cost per output frame is Taps multiply-adds per channel.
+enum SrcQuality
+{
+    SrcQuality_Low    = 0,      // 16 taps per phase
+    SrcQuality_Medium = 1,      // 32 taps per phase
+    SrcQuality_High   = 2,      // 64 taps per phase
+};
+
+#define LEYLINE_SRC_DEFAULT_QUALITY     SrcQuality_Medium
+#define LEYLINE_SRC_MAX_CHANNELS        16
+#define LEYLINE_SRC_MAX_TAPS            64
+#define LEYLINE_SRC_HISTORY_STRIDE      (2 * LEYLINE_SRC_MAX_TAPS)
+
+// Phases are the reduced interpolation factor L of outRate / inRate = L / M:
+// 44.1 -> 48 kHz needs 160, 48 -> 44.1 kHz 147, 11.025 -> 96 kHz 1280.
+#define LEYLINE_SRC_MAX_PHASES          1280
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RESAMPLER
+// The filter bank (L phases x Taps Kaiser-windowed sinc coefficients, each phase
+// normalized to unity DC gain) is computed once by Init into caller-owned storage
+// sized by BankBytes. Per-stream state, the tap history of every channel, lives
+// inside the object, so Process never allocates and may run at DISPATCH_LEVEL.
+//
+// Output frame k sits at input position k * M / L, delayed by Taps / 2 input frames.
+// Not thread-safe; one resampler per stream.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class Resampler
+{
+public:
+    // One output frame: every channel's window (rows LEYLINE_SRC_HISTORY_STRIDE
+    // floats apart) against the same phase's coefficients.
+    typedef void (*FilterFn)(const float* window, const float* coefficients, ULONG taps, ULONG channels, float* out);
+
+    // Bytes of filter bank needed for the conversion, or 0 if the ratio is not
+    // supported (a rate outside 1 Hz .. 1 MHz, or more than LEYLINE_SRC_MAX_PHASES).
+    static SIZE_T BankBytes(ULONG inRate, ULONG outRate, SrcQuality quality);
+
+    // PASSIVE_LEVEL: builds the filter bank into `bank` and resets the state.
+    NTSTATUS Init(ULONG inRate, ULONG outRate, ULONG channels, SrcQuality quality,
+                  SimdLevel level, float* bank, SIZE_T bankBytes);
+
+    // Forgets all history, as if no input had ever been seen.
+    void Reset();
+
+    // Consumes up to `inFrames` and produces up to `outFrames` interleaved frames.
+    // Stops as soon as either side is exhausted; returns frames produced and sets
+    // `*consumed`. Input not consumed must be passed again on the next call.
+    ULONG Process(const float* in, ULONG inFrames, ULONG* consumed, float* out, ULONG outFrames);
+
+    // Upper bound on what Process can produce from `inFrames`.
+    ULONG MaxOutputFrames(ULONG inFrames) const
+    {
+        return (ULONG)(((ULONGLONG)inFrames * m_Interpolation + m_Decimation - 1) / m_Decimation) + 1;
+    }
+
+    ULONG      GetInputRate()     const { return m_InputRate; }
+    ULONG      GetOutputRate()    const { return m_OutputRate; }
+    ULONG      GetInterpolation() const { return m_Interpolation; }
+    ULONG      GetDecimation()    const { return m_Decimation; }
+    ULONG      GetTaps()          const { return m_Taps; }
+    SimdLevel  GetLevel()         const { return m_Level; }
+
+private:
+    ULONG Run(FilterFn filter, const float* in, ULONG inFrames, ULONG* consumed, float* out, ULONG outFrames);
+
+    ULONG       m_InputRate;
+    ULONG       m_OutputRate;
+    ULONG       m_Interpolation;    // L
+    ULONG       m_Decimation;       // M
+    ULONG       m_Taps;
+    ULONG       m_Channels;
+    SimdLevel   m_Level;
+    FilterFn    m_Filter;
+    FilterFn    m_FallbackFilter;   // SSE2, if AVX state cannot be saved
+    const float* m_Bank;            // [phase][tap]
+    ULONG       m_Phase;            // Current output's phase, 0 .. L - 1
+    ULONG       m_Need;             // Input frames to take before the next output
+    ULONG       m_Write;            // Next history slot, 0 .. Taps - 1
+
+    // Each channel's last Taps input frames, stored twice so the window ending at
+    // the newest frame is always contiguous: slots [m_Write, m_Write + Taps).
+    DECLSPEC_CACHEALIGN float m_History[LEYLINE_SRC_MAX_CHANNELS][LEYLINE_SRC_HISTORY_STRIDE];
+};
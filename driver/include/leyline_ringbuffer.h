@@ -0,0 +1,203 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE RING BUFFER
+// Single-producer / single-consumer byte ring shared between the render DPC and
+// user-mode consumers. Portable: builds against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#define LEYLINE_CACHE_LINE_SIZE 64
+
+// A contiguous region inside the ring. A wrapped region is reported as two spans.
+struct RingSpan
+{
+    PUCHAR  Data;
+    SIZE_T  Length;
+};
+
+struct RingSpans
+{
+    RingSpan First;
+    RingSpan Second;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RING BUFFER
+// Cursors are monotonically increasing 64-bit byte indices; the buffer offset is
+// `index & mask`, so the capacity must be a power of two and no division is done.
+// The write cursor is published with release semantics after the data copy, and the
+// read cursor likewise after the data is consumed. Each side keeps a cached copy of
+// the remote cursor and only re-reads the shared one when the cache says it is short.
+//
+// Besides the copying Write/Read, both sides can work in place: AcquireWrite/CommitWrite
+// and PeekRead/ReleaseRead hand out spans of the underlying buffer (usually the DMA
+// buffer mapped by AllocateAudioBuffer), so mixers and converters need no staging copy.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class RingBuffer
+{
+public:
+    RingBuffer()
+        : m_Buffer(nullptr), m_Size(0), m_Mask(0)
+        , m_WritePos(0), m_CachedReadPos(0), m_Acquired(0)
+        , m_ReadPos(0), m_CachedWritePos(0), m_Peeked(0)
+    {}
+
+    // `size` must be a power of two. Anything else leaves the ring empty and
+    // unusable rather than quietly shorter than the buffer it was given.
+    NTSTATUS Init(PUCHAR buffer, SIZE_T size)
+    {
+        BOOLEAN valid = buffer && size && (size & (size - 1)) == 0;
+        m_Buffer = valid ? buffer : nullptr;
+        m_Size   = valid ? size : 0;
+        m_Mask   = valid ? size - 1 : 0;
+        Reset();
+        return valid ? STATUS_SUCCESS : STATUS_INVALID_PARAMETER;
+    }
+
+    PUCHAR GetBaseAddress() const { return m_Buffer; }
+    SIZE_T GetSize()        const { return m_Size; }
+
+    // Producer side. Uses the cached read cursor first and refreshes it only
+    // when that would report less than `wanted` bytes of room. The default
+    // always refreshes, so a bare call returns the exact amount.
+    SIZE_T AvailableWrite(SIZE_T wanted = (SIZE_T)-1)
+    {
+        LONG64 writePos = ReadNoFence64(&m_WritePos);
+        SIZE_T free     = m_Size - (SIZE_T)(writePos - m_CachedReadPos);
+        if (free < wanted || free == 0)
+        {
+            m_CachedReadPos = ReadAcquire64(&m_ReadPos);
+            free = m_Size - (SIZE_T)(writePos - m_CachedReadPos);
+        }
+        return free;
+    }
+
+    // Consumer side. Mirror image of AvailableWrite.
+    SIZE_T AvailableRead(SIZE_T wanted = (SIZE_T)-1)
+    {
+        LONG64 readPos = ReadNoFence64(&m_ReadPos);
+        SIZE_T used    = (SIZE_T)(m_CachedWritePos - readPos);
+        if (used < wanted || used == 0)
+        {
+            m_CachedWritePos = ReadAcquire64(&m_WritePos);
+            used = (SIZE_T)(m_CachedWritePos - readPos);
+        }
+        return used;
+    }
+
+    // ---- Zero-copy producer API ----
+    // Exposes up to `len` bytes of free space as at most two contiguous spans
+    // (the second one only when the region wraps). Fill them in place, then
+    // publish the bytes actually written with CommitWrite.
+    SIZE_T AcquireWrite(SIZE_T len, RingSpans* spans)
+    {
+        SIZE_T count = AvailableWrite(len);
+        if (count > len) count = len;
+        SplitSpans(ReadNoFence64(&m_WritePos), count, spans);
+        m_Acquired = count;
+        return count;
+    }
+
+    // `len` is at most what the last AcquireWrite returned.
+    void CommitWrite(SIZE_T len)
+    {
+        NT_ASSERT(len <= m_Acquired);
+        m_Acquired = 0;
+        WriteRelease64(&m_WritePos, ReadNoFence64(&m_WritePos) + (LONG64)len);
+    }
+
+    // ---- Zero-copy consumer API ----
+    // Exposes up to `len` readable bytes in place; ReleaseRead hands the space
+    // back to the producer once the consumer is done with it.
+    SIZE_T PeekRead(SIZE_T len, RingSpans* spans)
+    {
+        SIZE_T count = AvailableRead(len);
+        if (count > len) count = len;
+        SplitSpans(ReadNoFence64(&m_ReadPos), count, spans);
+        m_Peeked = count;
+        return count;
+    }
+
+    // `len` is at most what the last PeekRead returned.
+    void ReleaseRead(SIZE_T len)
+    {
+        NT_ASSERT(len <= m_Peeked);
+        m_Peeked = 0;
+        WriteRelease64(&m_ReadPos, ReadNoFence64(&m_ReadPos) + (LONG64)len);
+    }
+
+    // ---- Copying API ----
+
+    SIZE_T Write(const UCHAR* data, SIZE_T len)
+    {
+        RingSpans spans;
+        SIZE_T toWrite = AcquireWrite(len, &spans);
+        if (toWrite == 0) return 0;
+
+        RtlCopyMemory(spans.First.Data, data, spans.First.Length);
+        if (spans.Second.Length)
+            RtlCopyMemory(spans.Second.Data, data + spans.First.Length, spans.Second.Length);
+
+        CommitWrite(toWrite);
+        return toWrite;
+    }
+
+    SIZE_T Read(PUCHAR data, SIZE_T len)
+    {
+        RingSpans spans;
+        SIZE_T toRead = PeekRead(len, &spans);
+        if (toRead == 0) return 0;
+
+        RtlCopyMemory(data, spans.First.Data, spans.First.Length);
+        if (spans.Second.Length)
+            RtlCopyMemory(data + spans.First.Length, spans.Second.Data, spans.Second.Length);
+
+        ReleaseRead(toRead);
+        return toRead;
+    }
+
+    // Only valid while neither side is running.
+    void Reset()
+    {
+        WriteNoFence64(&m_WritePos, 0);
+        WriteNoFence64(&m_ReadPos, 0);
+        m_CachedReadPos  = 0;
+        m_CachedWritePos = 0;
+        m_Acquired       = 0;
+        m_Peeked         = 0;
+    }
+
+private:
+    void SplitSpans(LONG64 position, SIZE_T count, RingSpans* spans) const
+    {
+        SIZE_T offset    = (SIZE_T)position & m_Mask;
+        SIZE_T firstPart = m_Size - offset;
+        if (firstPart > count) firstPart = count;
+
+        spans->First.Data    = m_Buffer + offset;
+        spans->First.Length  = firstPart;
+        spans->Second.Data   = m_Buffer;
+        spans->Second.Length = count - firstPart;
+    }
+
+    // Read-only after Init.
+    PUCHAR  m_Buffer;
+    SIZE_T  m_Size;
+    SIZE_T  m_Mask;
+
+    // Producer-owned line.
+    DECLSPEC_CACHEALIGN volatile LONG64 m_WritePos;
+    LONG64  m_CachedReadPos;
+    SIZE_T  m_Acquired;         // Last AcquireWrite, not yet committed
+
+    // Consumer-owned line.
+    DECLSPEC_CACHEALIGN volatile LONG64 m_ReadPos;
+    LONG64  m_CachedWritePos;
+    SIZE_T  m_Peeked;           // Last PeekRead, not yet released
+};
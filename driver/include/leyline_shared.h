@@ -0,0 +1,326 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE SHARED PARAMETERS
+// The parameter block mapped into the APO and HSA, and the sequence-counter
+// protocol both sides use on it. Portable: builds against the WDK or the host
+// stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#include "leyline_meter.h"
+
+#define LEYLINE_SHARED_PARAMS_VERSION   2
+
+// Control.MasterGainBits until a v2 client writes it: a NaN, which the driver
+// reads as "use the v1 field".
+#define LEYLINE_MASTER_GAIN_UNSET       0xFFFFFFFFu
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// VERSION 1
+// The original packed layout. Still at offset 0 and still kept current, so v1
+// readers work unchanged -- including its misaligned QPC fields and unsynchronized
+// positions, which is why v2 exists.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma pack(push, 1)
+struct LeylineSharedParametersV1
+{
+    ULONG   MasterGainBits;     // IEEE 754 float bits for master gain
+    ULONG   PeakLBits;          // IEEE 754 float bits for left peak (Meter.PeakBits[0])
+    ULONG   PeakRBits;          // IEEE 754 float bits for right peak (Meter.PeakBits[1])
+    LONGLONG QpcFrequency;
+    LONGLONG RenderStartQpc;
+    LONGLONG CaptureStartQpc;
+    ULONG   BufferSize;
+    ULONG   ByteRate;
+    ULONG   WritePos;           // Current render position (byte offset)
+    ULONG   ReadPos;            // Current capture position (byte offset)
+    LeylineMeterBlock Meter;    // Metered render stream; read through PeakMeter::Snapshot
+};
+#pragma pack(pop)
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// VERSION 2
+// Naturally aligned, with everything a given writer touches on cache lines of its
+// own: the header is written once, Control only by clients, Render and Capture by
+// the streams of that direction, Meter by the metered render stream, and each of
+// Streams by the stream holding it. A reader polling one line is never slowed by
+// writes to another.
+//
+// A v2 reader checks Header.Version first; a driver that predates the header
+// leaves it zero (GetVersion reports 1), and the reader falls back to Legacy.
+// New fields go at the end, with Header.Size telling readers how much is there.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct LeylineSharedHeader
+{
+    ULONG   Version;            // LEYLINE_SHARED_PARAMS_VERSION, 0 from older drivers
+    ULONG   Size;               // sizeof(LeylineSharedParameters) the driver was built with
+    LONG64  QpcFrequency;
+};
+
+struct LeylineControlBlock
+{
+    volatile ULONG  MasterGainBits; // IEEE 754 float bits; LEYLINE_MASTER_GAIN_UNSET defers to v1
+};
+
+// One direction's stream position. Any number of writers; readers take a
+// consistent copy through SharedParameterBlock::ReadPosition.
+struct LeylinePositionBlock
+{
+    volatile LONG   Sequence;       // Odd while an update is in flight
+    volatile LONG   Position;       // Byte offset into the publishing stream's buffer
+    volatile LONG   BufferSize;     // ...of that buffer
+    volatile LONG   ByteRate;
+    volatile LONG64 StartQpc;       // KSSTATE_RUN of the publishing stream
+    volatile LONG64 UpdateQpc;      // When Position was taken
+};
+
+struct LeylinePosition
+{
+    ULONG   Position;
+    ULONG   BufferSize;
+    ULONG   ByteRate;
+    LONG64  StartQpc;
+    LONG64  UpdateQpc;
+};
+
+// One stream's telemetry, for as long as the stream exists. A slot is free while
+// Owner is zero; a stream takes it with a compare-exchange on Owner and the rest
+// is published under Sequence, StreamId 0 meaning the slot is empty.
+#define LEYLINE_STREAM_SLOTS            16
+
+#define LEYLINE_STREAM_RENDER           0
+#define LEYLINE_STREAM_CAPTURE          1
+
+struct DECLSPEC_CACHEALIGN LeylineStreamSlot
+{
+    volatile LONG   Owner;          // Claim word; not part of the published data
+    volatile LONG   Sequence;       // Odd while an update is in flight
+    volatile LONG   StreamId;       // LeylineRouteConfig::StreamId, 0 while free
+    volatile LONG   Direction;      // LEYLINE_STREAM_RENDER / _CAPTURE
+    volatile LONG   SampleFormat;   // LeylineSampleFormat
+    volatile LONG   Channels;
+    volatile LONG   SampleRate;
+    volatile LONG   State;          // KSSTATE
+    volatile LONG   Position;       // Byte offset into the stream's buffer
+    volatile LONG   Underruns;      // Mix periods the stream could not fill
+    volatile LONG   Overruns;       // Times frames were dropped because a reader fell behind
+    volatile LONG64 Frames;         // Frames played or captured this run
+    volatile LONG64 UpdateQpc;      // When Position and Frames were taken
+};
+
+struct LeylineStreamInfo
+{
+    ULONG       StreamId;
+    ULONG       Direction;
+    ULONG       SampleFormat;
+    ULONG       Channels;
+    ULONG       SampleRate;
+    ULONG       State;
+    ULONG       Position;
+    ULONG       Underruns;
+    ULONG       Overruns;
+    ULONGLONG   Frames;
+    LONG64      UpdateQpc;
+};
+
+struct LeylineSharedParameters
+{
+    LeylineSharedParametersV1                   Legacy;     // Offset 0, for v1 readers
+    DECLSPEC_CACHEALIGN LeylineSharedHeader     Header;
+    DECLSPEC_CACHEALIGN LeylineControlBlock     Control;
+    DECLSPEC_CACHEALIGN LeylinePositionBlock    Render;
+    DECLSPEC_CACHEALIGN LeylinePositionBlock    Capture;
+    DECLSPEC_CACHEALIGN LeylineMeterBlock       Meter;
+    LeylineStreamSlot                           Streams[LEYLINE_STREAM_SLOTS];
+};
+
+static_assert(sizeof(LeylinePositionBlock) <= SYSTEM_CACHE_ALIGNMENT_SIZE, "one line per direction");
+static_assert(sizeof(LeylineStreamSlot) == SYSTEM_CACHE_ALIGNMENT_SIZE, "one line per stream");
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SHARED PARAMETER BLOCK
+// Several streams of one direction publish positions (and GetPosition can race the
+// timer DPC within one stream), so a writer claims the sequence with a
+// compare-exchange instead of owning it. One that loses just skips its update:
+// whoever won is publishing a position at least as fresh. Writers must not be
+// preempted while the sequence is odd, or readers spin until they run again; the
+// driver publishes at DISPATCH_LEVEL.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class SharedParameterBlock
+{
+public:
+    // Fills a zeroed block as the driver maps it: both versions' static fields,
+    // unity master gain.
+    static void Init(LeylineSharedParameters* params, LONG64 qpcFrequency, ULONG bufferSize, ULONG byteRate)
+    {
+        params->Legacy.QpcFrequency   = qpcFrequency;
+        params->Legacy.BufferSize     = bufferSize;
+        params->Legacy.ByteRate       = byteRate;
+        params->Legacy.MasterGainBits = FloatToBits(1.0f);
+        params->Control.MasterGainBits = LEYLINE_MASTER_GAIN_UNSET;
+        params->Header.QpcFrequency   = qpcFrequency;
+        params->Header.Size           = sizeof(LeylineSharedParameters);
+        WriteRelease(reinterpret_cast<volatile LONG*>(&params->Header.Version), LEYLINE_SHARED_PARAMS_VERSION);
+    }
+
+    // 1 for a block without the v2 header.
+    static ULONG GetVersion(const LeylineSharedParameters* params)
+    {
+        ULONG version = (ULONG)ReadAcquire(reinterpret_cast<const volatile LONG*>(&params->Header.Version));
+        return version ? version : 1;
+    }
+
+    // The master gain the driver applies: Control once a v2 client has set it,
+    // otherwise the v1 field.
+    static ULONG GetMasterGainBits(const LeylineSharedParameters* params)
+    {
+        ULONG bits = (ULONG)ReadNoFence(reinterpret_cast<const volatile LONG*>(&params->Control.MasterGainBits));
+        if (bits != LEYLINE_MASTER_GAIN_UNSET) return bits;
+        return (ULONG)ReadNoFence(reinterpret_cast<const volatile LONG*>(&params->Legacy.MasterGainBits));
+    }
+
+    // FALSE when another writer held the block and this update was dropped.
+    static BOOLEAN PublishPosition(LeylinePositionBlock* block, const LeylinePosition& position)
+    {
+        LONG seq = ReadNoFence(&block->Sequence);
+        if ((seq & 1) || InterlockedCompareExchange(&block->Sequence, seq + 1, seq) != seq) return FALSE;
+
+        WriteRelease(&block->Position, (LONG)position.Position);
+        WriteRelease(&block->BufferSize, (LONG)position.BufferSize);
+        WriteRelease(&block->ByteRate, (LONG)position.ByteRate);
+        WriteRelease64(&block->StartQpc, position.StartQpc);
+        WriteRelease64(&block->UpdateQpc, position.UpdateQpc);
+        WriteRelease(&block->Sequence, seq + 2);
+        return TRUE;
+    }
+
+    static void ReadPosition(const LeylinePositionBlock* block, LeylinePosition* position)
+    {
+        for (;;)
+        {
+            LONG seq = ReadAcquire(&block->Sequence);
+            if (seq & 1) { YieldProcessor(); continue; }
+
+            // Acquire loads keep the closing sequence read after the field reads.
+            position->Position   = (ULONG)ReadAcquire(&block->Position);
+            position->BufferSize = (ULONG)ReadAcquire(&block->BufferSize);
+            position->ByteRate   = (ULONG)ReadAcquire(&block->ByteRate);
+            position->StartQpc   = ReadAcquire64(&block->StartQpc);
+            position->UpdateQpc  = ReadAcquire64(&block->UpdateQpc);
+
+            if (ReadAcquire(&block->Sequence) == seq) return;
+        }
+    }
+
+    // ---- Stream slots ----
+
+    // Takes a free slot for a new stream (State KSSTATE_STOP, counters zero);
+    // nullptr when every slot is in use, in which case the stream goes unlisted.
+    static LeylineStreamSlot* ClaimStreamSlot(LeylineSharedParameters* params, const LeylineStreamInfo& info)
+    {
+        for (ULONG i = 0; i < LEYLINE_STREAM_SLOTS; ++i)
+        {
+            LeylineStreamSlot* slot = &params->Streams[i];
+            if (ReadNoFence(&slot->Owner) || InterlockedCompareExchange(&slot->Owner, 1, 0) != 0) continue;
+
+            LONG seq;
+            LockSlot(slot, TRUE, &seq);
+            WriteRelease(&slot->StreamId, (LONG)info.StreamId);
+            WriteRelease(&slot->Direction, (LONG)info.Direction);
+            WriteRelease(&slot->SampleFormat, (LONG)info.SampleFormat);
+            WriteRelease(&slot->Channels, (LONG)info.Channels);
+            WriteRelease(&slot->SampleRate, (LONG)info.SampleRate);
+            WriteRelease(&slot->State, 0);
+            WriteRelease(&slot->Position, 0);
+            WriteRelease(&slot->Underruns, 0);
+            WriteRelease(&slot->Overruns, 0);
+            WriteRelease64(&slot->Frames, 0);
+            WriteRelease64(&slot->UpdateQpc, 0);
+            WriteRelease(&slot->Sequence, seq + 2);
+            return slot;
+        }
+        return nullptr;
+    }
+
+    // Empties the slot, then hands it back. The stream must not publish to it again.
+    static void ReleaseStreamSlot(LeylineStreamSlot* slot)
+    {
+        LONG seq;
+        LockSlot(slot, TRUE, &seq);
+        WriteRelease(&slot->StreamId, 0);
+        WriteRelease(&slot->State, 0);
+        WriteRelease(&slot->Sequence, seq + 2);
+        WriteRelease(&slot->Owner, 0);
+    }
+
+    static void SetStreamState(LeylineStreamSlot* slot, ULONG state)
+    {
+        LONG seq;
+        LockSlot(slot, TRUE, &seq);
+        WriteRelease(&slot->State, (LONG)state);
+        WriteRelease(&slot->Sequence, seq + 2);
+    }
+
+    // Like PublishPosition: dropped when another update of the slot is in flight.
+    static BOOLEAN PublishStreamProgress(LeylineStreamSlot* slot, ULONG position, ULONGLONG frames, LONG64 now)
+    {
+        LONG seq;
+        if (!LockSlot(slot, FALSE, &seq)) return FALSE;
+        WriteRelease(&slot->Position, (LONG)position);
+        WriteRelease64(&slot->Frames, (LONG64)frames);
+        WriteRelease64(&slot->UpdateQpc, now);
+        WriteRelease(&slot->Sequence, seq + 2);
+        return TRUE;
+    }
+
+    // The counters only ever grow, so they skip the sequence; whoever notices the
+    // glitch counts it, which need not be the stream's own DPC.
+    static void CountUnderrun(LeylineStreamSlot* slot) { InterlockedIncrement(&slot->Underruns); }
+    static void CountOverrun(LeylineStreamSlot* slot)  { InterlockedIncrement(&slot->Overruns); }
+
+    // FALSE for a free slot.
+    static BOOLEAN ReadStreamSlot(const LeylineStreamSlot* slot, LeylineStreamInfo* info)
+    {
+        for (;;)
+        {
+            LONG seq = ReadAcquire(&slot->Sequence);
+            if (seq & 1) { YieldProcessor(); continue; }
+
+            info->StreamId     = (ULONG)ReadAcquire(&slot->StreamId);
+            info->Direction    = (ULONG)ReadAcquire(&slot->Direction);
+            info->SampleFormat = (ULONG)ReadAcquire(&slot->SampleFormat);
+            info->Channels     = (ULONG)ReadAcquire(&slot->Channels);
+            info->SampleRate   = (ULONG)ReadAcquire(&slot->SampleRate);
+            info->State        = (ULONG)ReadAcquire(&slot->State);
+            info->Position     = (ULONG)ReadAcquire(&slot->Position);
+            info->Underruns    = (ULONG)ReadAcquire(&slot->Underruns);
+            info->Overruns     = (ULONG)ReadAcquire(&slot->Overruns);
+            info->Frames       = (ULONGLONG)ReadAcquire64(&slot->Frames);
+            info->UpdateQpc    = ReadAcquire64(&slot->UpdateQpc);
+
+            if (ReadAcquire(&slot->Sequence) == seq) return info->StreamId != 0;
+        }
+    }
+
+private:
+    // Makes the sequence odd for this writer, leaving its previous value in `seq`.
+    // FALSE only without `wait`, when another writer has it.
+    static BOOLEAN LockSlot(LeylineStreamSlot* slot, BOOLEAN wait, LONG* seq)
+    {
+        for (;;)
+        {
+            *seq = ReadNoFence(&slot->Sequence);
+            if (!(*seq & 1) && InterlockedCompareExchange(&slot->Sequence, *seq + 1, *seq) == *seq) return TRUE;
+            if (!wait) return FALSE;
+            YieldProcessor();
+        }
+    }
+};
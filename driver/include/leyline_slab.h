@@ -0,0 +1,321 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE OBJECT HEAP
+// Nonpaged allocations for the driver's own objects, counted by pool tag, with
+// fixed-size slabs reserved for the ones that come and go (streams), so opening
+// and closing a stream does not touch the pool once the device has started.
+// Portable: builds against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#define LEYLINE_SLAB_MAX_SLABS      4
+#define LEYLINE_SLAB_MAX_OBJECTS    32          // Per slab: one bit each in the free mask
+#define LEYLINE_SLAB_MAX_TAGS       16          // Distinct tags counted; later ones are only totalled
+
+struct LeylineSlabStats
+{
+    ULONG   Tag;
+    ULONG   ObjectBytes;
+    ULONG   Objects;
+    ULONG   InUse;
+    ULONG   HighWater;          // Most ever in use at once
+};
+
+struct LeylinePoolTagStats
+{
+    ULONG   Tag;
+    ULONG   Live;
+    ULONG   Peak;               // Most ever live at once
+    ULONG   Allocations;        // Ever made
+    ULONG64 Bytes;              // Live, as asked for; headers and slab slack not included
+    ULONG64 PeakBytes;
+};
+
+// Output of IOCTL_LEYLINE_GET_OBJECT_STATS.
+struct LeylineObjectStats
+{
+    ULONG   Slabs;
+    ULONG   Tags;
+    ULONG   SlabHits;           // Served from a slab
+    ULONG   SlabMisses;         // Slabbed tag served from the pool: slab full, or object too big
+    ULONG   Untracked;          // Allocations under a tag that found the tag table full
+    ULONG   Reserved;
+    LeylineSlabStats    Slab[LEYLINE_SLAB_MAX_SLABS];
+    LeylinePoolTagStats Tag[LEYLINE_SLAB_MAX_TAGS];
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// OBJECT HEAP
+// Every allocation carries a small header naming its heap, tag and size, so Free
+// needs only the pointer. A slab is one pool block cut into equal slots, handed
+// out by the lowest set bit of a free mask as in BufferPool; each slot starts on
+// a cache line, which the pool alone does not promise (the stream's resampler
+// history is cache aligned), and its header sits in the tail of the slot
+// before. Anything a slab cannot serve goes to ExAllocatePool2 under its own
+// tag, a cache line over, so the object can be rounded up to one as well; the
+// pool block's address is kept just before the header. Tag counters are claimed
+// by compare-exchange on first use and never given back.
+//
+// Reserve and Shutdown run at PASSIVE_LEVEL with nothing outstanding; Allocate
+// and Free may race each other freely at IRQL <= DISPATCH_LEVEL.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class ObjectHeap
+{
+public:
+    // Keeps the object behind it at MEMORY_ALLOCATION_ALIGNMENT.
+    static const SIZE_T HeaderBytes = 16;
+
+    ObjectHeap() : m_Slabs(0), m_Hits(0), m_Misses(0), m_Untracked(0)
+    {
+        RtlZeroMemory(m_Slab, sizeof(m_Slab));
+        RtlZeroMemory(m_Tally, sizeof(m_Tally));
+    }
+
+    // Sets aside `count` slots for objects of up to `objectBytes` under `tag`.
+    NTSTATUS Reserve(ULONG tag, SIZE_T objectBytes, ULONG count)
+    {
+        if (tag == 0 || objectBytes == 0 || objectBytes > MAXULONG || count == 0 ||
+            count > LEYLINE_SLAB_MAX_OBJECTS || m_Slabs == LEYLINE_SLAB_MAX_SLABS)
+            return STATUS_INVALID_PARAMETER;
+        for (ULONG s = 0; s < m_Slabs; ++s)
+        {
+            if (m_Slab[s].Tag == tag) return STATUS_INVALID_PARAMETER;
+        }
+
+        const SIZE_T line = SYSTEM_CACHE_ALIGNMENT_SIZE;
+        Slab& slab = m_Slab[m_Slabs];
+        slab.Stride  = (objectBytes + HeaderBytes + line - 1) & ~(line - 1);
+        slab.Storage = static_cast<PUCHAR>(ExAllocatePool2(POOL_FLAG_NON_PAGED, 2 * line + slab.Stride * count, tag));
+        if (!slab.Storage) return STATUS_INSUFFICIENT_RESOURCES;
+        slab.First = reinterpret_cast<PUCHAR>((reinterpret_cast<ULONG_PTR>(slab.Storage) + 2 * line - 1) & ~(ULONG_PTR)(line - 1));
+
+        slab.Tag         = tag;
+        slab.ObjectBytes = objectBytes;
+        slab.Objects     = count;
+        slab.FreeMask    = count == 32 ? (LONG)0xFFFFFFFF : (LONG)((1u << count) - 1);
+        m_Slabs++;
+        return STATUS_SUCCESS;
+    }
+
+    // Gives the slab blocks back. Tag counters are kept, so a leak still shows.
+    void Shutdown()
+    {
+        for (ULONG s = 0; s < m_Slabs; ++s) ExFreePoolWithTag(m_Slab[s].Storage, m_Slab[s].Tag);
+        RtlZeroMemory(m_Slab, sizeof(m_Slab));
+        m_Slabs = 0;
+    }
+
+    BOOLEAN IsReady() const { return m_Slabs != 0; }
+
+    // Zeroed, like ExAllocatePool2. Null when the pool is out.
+    PVOID Allocate(SIZE_T bytes, ULONG tag)
+    {
+        if (bytes == 0 || bytes > MAXULONG) return nullptr;
+
+        Header* header  = nullptr;
+        BOOLEAN slabbed = FALSE;
+        for (ULONG s = 0; s < m_Slabs && !header; ++s)
+        {
+            Slab& slab = m_Slab[s];
+            if (slab.Tag != tag) continue;
+            slabbed = TRUE;
+            if (slab.ObjectBytes < bytes) continue;
+
+            LONG mask = ReadAcquire(&slab.FreeMask);
+            while (mask)
+            {
+                ULONG index;
+                BitScanForward(&index, (ULONG)mask);
+                LONG seen = InterlockedCompareExchange(&slab.FreeMask, mask & ~(LONG)(1u << index), mask);
+                if (seen != mask) { mask = seen; continue; }
+
+                RaiseTo(&slab.HighWater, InterlockedIncrement(&slab.InUse));
+                InterlockedIncrement(&m_Hits);
+                header = reinterpret_cast<Header*>(slab.First + index * slab.Stride - HeaderBytes);
+                RtlZeroMemory(header, HeaderBytes + bytes);
+                break;
+            }
+        }
+
+        if (!header)
+        {
+            const SIZE_T line  = SYSTEM_CACHE_ALIGNMENT_SIZE;
+            PUCHAR       block = static_cast<PUCHAR>(
+                ExAllocatePool2(POOL_FLAG_NON_PAGED, line + sizeof(PVOID) + HeaderBytes + bytes, tag));
+            if (!block) return nullptr;
+            if (slabbed) InterlockedIncrement(&m_Misses);
+
+            PUCHAR object = reinterpret_cast<PUCHAR>(
+                (reinterpret_cast<ULONG_PTR>(block) + sizeof(PVOID) + HeaderBytes + line - 1) & ~(ULONG_PTR)(line - 1));
+            header = reinterpret_cast<Header*>(object - HeaderBytes);
+            *reinterpret_cast<PVOID*>(object - HeaderBytes - sizeof(PVOID)) = block;
+        }
+
+        header->Heap  = this;
+        header->Tag   = tag;
+        header->Bytes = (ULONG)bytes;
+
+        Tally* tally = FindTally(tag, TRUE);
+        if (tally)
+        {
+            InterlockedIncrement(&tally->Allocations);
+            RaiseTo(&tally->Peak, InterlockedIncrement(&tally->Live));
+            RaiseTo64(&tally->PeakBytes, InterlockedExchangeAdd64(&tally->Bytes, (LONG64)bytes) + (LONG64)bytes);
+        }
+        else InterlockedIncrement(&m_Untracked);
+
+        return reinterpret_cast<PUCHAR>(header) + HeaderBytes;
+    }
+
+    // Anything Allocate returned, from any heap; null is ignored.
+    static void Free(PVOID object)
+    {
+        if (!object) return;
+        Header*     header = reinterpret_cast<Header*>(static_cast<PUCHAR>(object) - HeaderBytes);
+        ObjectHeap* heap   = header->Heap;
+
+        Tally* tally = heap->FindTally(header->Tag, FALSE);
+        if (tally)
+        {
+            InterlockedDecrement(&tally->Live);
+            InterlockedExchangeAdd64(&tally->Bytes, -(LONG64)header->Bytes);
+        }
+
+        for (ULONG s = 0; s < heap->m_Slabs; ++s)
+        {
+            Slab&  slab   = heap->m_Slab[s];
+            SIZE_T offset = (SIZE_T)(static_cast<PUCHAR>(object) - slab.First);
+            if (static_cast<PUCHAR>(object) < slab.First || offset >= slab.Stride * slab.Objects) continue;
+
+            InterlockedDecrement(&slab.InUse);
+            InterlockedOr(&slab.FreeMask, (LONG)(1u << (ULONG)(offset / slab.Stride)));
+            return;
+        }
+        ExFreePoolWithTag(*reinterpret_cast<PVOID*>(reinterpret_cast<PUCHAR>(header) - sizeof(PVOID)), header->Tag);
+    }
+
+    void GetStats(LeylineObjectStats* stats) const
+    {
+        RtlZeroMemory(stats, sizeof(*stats));
+        stats->Slabs      = m_Slabs;
+        stats->SlabHits   = (ULONG)ReadNoFence(&m_Hits);
+        stats->SlabMisses = (ULONG)ReadNoFence(&m_Misses);
+        stats->Untracked  = (ULONG)ReadNoFence(&m_Untracked);
+        for (ULONG s = 0; s < m_Slabs; ++s)
+        {
+            stats->Slab[s].Tag         = m_Slab[s].Tag;
+            stats->Slab[s].ObjectBytes = (ULONG)m_Slab[s].ObjectBytes;
+            stats->Slab[s].Objects     = m_Slab[s].Objects;
+            stats->Slab[s].InUse       = (ULONG)ReadNoFence(&m_Slab[s].InUse);
+            stats->Slab[s].HighWater   = (ULONG)ReadNoFence(&m_Slab[s].HighWater);
+        }
+        for (ULONG t = 0; t < LEYLINE_SLAB_MAX_TAGS; ++t)
+        {
+            const Tally& tally = m_Tally[t];
+            ULONG tag = (ULONG)ReadAcquire(&tally.Tag);
+            if (!tag) break;
+            LeylinePoolTagStats& out = stats->Tag[stats->Tags++];
+            out.Tag         = tag;
+            out.Live        = (ULONG)ReadNoFence(&tally.Live);
+            out.Peak        = (ULONG)ReadNoFence(&tally.Peak);
+            out.Allocations = (ULONG)ReadNoFence(&tally.Allocations);
+            out.Bytes       = (ULONG64)ReadNoFence64(&tally.Bytes);
+            out.PeakBytes   = (ULONG64)ReadNoFence64(&tally.PeakBytes);
+        }
+    }
+
+private:
+    struct Header
+    {
+        ObjectHeap* Heap;
+        ULONG       Tag;
+        ULONG       Bytes;
+    };
+    static_assert(sizeof(Header) <= HeaderBytes, "ObjectHeap header outgrew its slot");
+
+    struct Slab
+    {
+        ULONG           Tag;
+        ULONG           Objects;
+        SIZE_T          ObjectBytes;
+        SIZE_T          Stride;         // Object plus the next one's header, in whole cache lines
+        PUCHAR          Storage;        // The pool block
+        PUCHAR          First;          // Slot 0's object, cache aligned, its header just before
+        volatile LONG   FreeMask;       // Bit i set: slot i is free
+        volatile LONG   InUse;
+        volatile LONG   HighWater;
+    };
+
+    struct Tally
+    {
+        volatile LONG   Tag;            // 0: unclaimed
+        volatile LONG   Live;
+        volatile LONG   Peak;
+        volatile LONG   Allocations;
+        volatile LONG64 Bytes;
+        volatile LONG64 PeakBytes;
+    };
+
+    // Claimed entries form a prefix of the table, so the first empty one ends the search.
+    Tally* FindTally(ULONG tag, BOOLEAN claim)
+    {
+        for (ULONG t = 0; t < LEYLINE_SLAB_MAX_TAGS; ++t)
+        {
+            LONG held = ReadAcquire(&m_Tally[t].Tag);
+            if (held == 0)
+            {
+                if (!claim) return nullptr;
+                held = InterlockedCompareExchange(&m_Tally[t].Tag, (LONG)tag, 0);
+                if (held == 0) return &m_Tally[t];
+            }
+            if ((ULONG)held == tag) return &m_Tally[t];
+        }
+        return nullptr;
+    }
+
+    static void RaiseTo(volatile LONG* high, LONG value)
+    {
+        LONG seen = ReadNoFence(high);
+        while (value > seen)
+        {
+            LONG prior = InterlockedCompareExchange(high, value, seen);
+            if (prior == seen) break;
+            seen = prior;
+        }
+    }
+
+    static void RaiseTo64(volatile LONG64* high, LONG64 value)
+    {
+        LONG64 seen = ReadNoFence64(high);
+        while (value > seen)
+        {
+            LONG64 prior = InterlockedCompareExchange64(high, value, seen);
+            if (prior == seen) break;
+            seen = prior;
+        }
+    }
+
+    ULONG           m_Slabs;
+    Slab            m_Slab[LEYLINE_SLAB_MAX_SLABS];
+    Tally           m_Tally[LEYLINE_SLAB_MAX_TAGS];
+    volatile LONG   m_Hits;
+    volatile LONG   m_Misses;
+    volatile LONG   m_Untracked;
+};
+
+// Base for classes allocated with `new (heap, tag) T(...)`. A plain `delete`
+// (CUnknown's `delete this` included) returns the object to its heap, as long as
+// the destructor is virtual.
+class HeapObject
+{
+public:
+    static void* operator new(size_t bytes, ObjectHeap& heap, ULONG tag) noexcept { return heap.Allocate(bytes, tag); }
+    static void  operator delete(void* object) { ObjectHeap::Free(object); }
+    static void  operator delete(void* object, ObjectHeap&, ULONG) { ObjectHeap::Free(object); }
+};
@@ -0,0 +1,248 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE SNAPSHOT
+// IOCTL_LEYLINE_GET_SNAPSHOT's layout, the writer the driver fills it with and the
+// reader tools parse it with. One buffer holds the device configuration, the
+// buffer pool counters and a record per open stream. Every section carries its
+// size, so a reader built against an older version reads the fields it knows
+// from a newer driver, and a newer reader zeroes what an older driver did not
+// send. Portable: builds against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+#include "leyline_bufferpool.h"
+#include "leyline_endpoints.h"
+
+#define LEYLINE_SNAPSHOT_MAGIC      0x4E534C4C  // "LLSN"
+#define LEYLINE_SNAPSHOT_VERSION    1
+
+// Always at the start of the buffer, whatever else fits. A section that did not
+// fit has offset 0; TotalBytes over WrittenBytes means call again with at least
+// TotalBytes (plus room for streams opened in between).
+struct LeylineSnapshotHeader
+{
+    ULONG   Magic;
+    ULONG   Version;
+    ULONG   HeaderBytes;
+    ULONG   TotalBytes;
+    ULONG   WrittenBytes;
+    ULONG   DeviceOffset;
+    ULONG   DeviceBytes;
+    ULONG   PoolOffset;
+    ULONG   PoolBytes;
+    ULONG   StreamOffset;
+    ULONG   StreamBytes;        // One record
+    ULONG   Streams;            // Open when the snapshot was taken
+    ULONG   StreamsReturned;    // Records that fit, from StreamOffset on
+    ULONG   Reserved;
+    LONG64  Qpc;                // When it was taken
+    LONG64  Frequency;
+};
+
+struct LeylineSnapshotDevice
+{
+    ULONG   CableCount;
+    ULONG   RegisterPeriodMs;
+    ULONG   ResamplerQuality;   // SrcQuality
+    ULONG   MeterDecayDb;
+    ULONG   MeterRmsMs;
+    ULONG   StreamsCreated;     // Stream ids handed out so far
+    ULONG   LoopbackEnabled;    // Bit n: cable n shares its pages
+    ULONG   Reserved;
+    ULONG   LatencyFrames[LEYLINE_MAX_CABLES];
+};
+
+#define LEYLINE_SNAPSHOT_ON_CABLE       0x001   // Mapped onto the cable's pages
+#define LEYLINE_SNAPSHOT_CABLE_OWNER    0x002   // ...and rendering: drives the cable clock
+#define LEYLINE_SNAPSHOT_CONVERTING     0x004   // Cable capture in another format
+#define LEYLINE_SNAPSHOT_RESAMPLING     0x008   // ...and at another rate
+#define LEYLINE_SNAPSHOT_GAIN           0x010
+#define LEYLINE_SNAPSHOT_MIXING         0x020   // Summing the other render streams
+#define LEYLINE_SNAPSHOT_MIX_SOURCE     0x040   // Summed into the cable
+#define LEYLINE_SNAPSHOT_METERING       0x080
+#define LEYLINE_SNAPSHOT_REGISTERS      0x100   // Position/clock registers handed to the engine
+#define LEYLINE_SNAPSHOT_CLIENT_WRITES  0x200   // Reports its write position
+
+struct LeylineSnapshotStream
+{
+    ULONG     StreamId;
+    ULONG     Direction;        // LEYLINE_STREAM_RENDER / _CAPTURE
+    ULONG     Cable;
+    ULONG     State;            // KSSTATE
+    ULONG     Flags;            // LEYLINE_SNAPSHOT_*
+    ULONG     SampleFormat;     // LeylineSampleFormat
+    ULONG     SampleRate;
+    ULONG     Channels;
+    ULONG     BlockAlign;
+    ULONG     BufferSize;
+    ULONG     Position;         // Byte offset in the buffer; 0 unless running
+    ULONG     Underruns;
+    ULONG     Overruns;
+    ULONG     Reserved;
+    ULONGLONG Frames;           // Since KSSTATE_RUN; 0 unless running
+    ULONGLONG GlitchFrames;
+    ULONGLONG Periods;
+    LONG64    StartQpc;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SNAPSHOT WRITER
+// Straight into the caller's buffer: each section is handed out zeroed in place
+// for the caller to fill, or null once the buffer is full, and is counted either
+// way. Nothing is allocated or copied twice.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class SnapshotWriter
+{
+public:
+    // `length` is at least a header.
+    void Begin(PVOID buffer, ULONG length, LONG64 qpc, LONG64 frequency)
+    {
+        m_Buffer = static_cast<PUCHAR>(buffer);
+        m_Length = length;
+        m_Header = reinterpret_cast<LeylineSnapshotHeader*>(m_Buffer);
+        RtlZeroMemory(m_Header, sizeof(*m_Header));
+        m_Header->Magic        = LEYLINE_SNAPSHOT_MAGIC;
+        m_Header->Version      = LEYLINE_SNAPSHOT_VERSION;
+        m_Header->HeaderBytes  = sizeof(LeylineSnapshotHeader);
+        m_Header->DeviceBytes  = sizeof(LeylineSnapshotDevice);
+        m_Header->PoolBytes    = sizeof(LeylineBufferPoolStats);
+        m_Header->StreamBytes  = sizeof(LeylineSnapshotStream);
+        m_Header->StreamOffset = kStreams;
+        m_Header->Qpc          = qpc;
+        m_Header->Frequency    = frequency;
+        m_Written = sizeof(LeylineSnapshotHeader);
+    }
+
+    LeylineSnapshotDevice* Device()
+    {
+        return static_cast<LeylineSnapshotDevice*>(Section(kDevice, sizeof(LeylineSnapshotDevice), &m_Header->DeviceOffset));
+    }
+
+    LeylineBufferPoolStats* Pool()
+    {
+        return static_cast<LeylineBufferPoolStats*>(Section(kPool, sizeof(LeylineBufferPoolStats), &m_Header->PoolOffset));
+    }
+
+    LeylineSnapshotStream* AddStream()
+    {
+        ULONG at = kStreams + m_Header->Streams++ * (ULONG)sizeof(LeylineSnapshotStream);
+        if (m_Header->StreamsReturned + 1 != m_Header->Streams || at + sizeof(LeylineSnapshotStream) > m_Length)
+            return nullptr;
+
+        ++m_Header->StreamsReturned;
+        m_Written = at + (ULONG)sizeof(LeylineSnapshotStream);
+        LeylineSnapshotStream* stream = reinterpret_cast<LeylineSnapshotStream*>(m_Buffer + at);
+        RtlZeroMemory(stream, sizeof(*stream));
+        return stream;
+    }
+
+    // Bytes to return to the caller.
+    ULONG Finish()
+    {
+        if (!m_Header->StreamsReturned) m_Header->StreamOffset = 0;
+        m_Header->TotalBytes   = kStreams + m_Header->Streams * (ULONG)sizeof(LeylineSnapshotStream);
+        m_Header->WrittenBytes = m_Written;
+        return m_Written;
+    }
+
+private:
+    static const ULONG kDevice  = sizeof(LeylineSnapshotHeader);
+    static const ULONG kPool    = kDevice + sizeof(LeylineSnapshotDevice);
+    static const ULONG kStreams = kPool + sizeof(LeylineBufferPoolStats);
+
+    PVOID Section(ULONG at, ULONG bytes, ULONG* offset)
+    {
+        if (at + bytes > m_Length) return nullptr;
+        *offset = at;
+        if (at + bytes > m_Written) m_Written = at + bytes;
+        RtlZeroMemory(m_Buffer + at, bytes);
+        return m_Buffer + at;
+    }
+
+    PUCHAR                 m_Buffer;
+    ULONG                  m_Length;
+    ULONG                  m_Written;
+    LeylineSnapshotHeader* m_Header;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SNAPSHOT READER
+// Checks the header against the bytes actually returned before trusting any
+// offset in it; the Get calls then copy out as much of each record as both sides
+// know and zero the rest.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class SnapshotReader
+{
+public:
+    BOOLEAN Parse(const void* buffer, ULONG length)
+    {
+        m_Buffer = static_cast<const UCHAR*>(buffer);
+        RtlZeroMemory(&m_Header, sizeof(m_Header));
+        if (length < sizeof(ULONG) * 3) return FALSE;
+
+        const LeylineSnapshotHeader* header = static_cast<const LeylineSnapshotHeader*>(buffer);
+        if (header->Magic != LEYLINE_SNAPSHOT_MAGIC || header->Version == 0 ||
+            header->HeaderBytes < sizeof(LeylineSnapshotHeader) || header->HeaderBytes > length)
+            return FALSE;
+        RtlCopyMemory(&m_Header, header, sizeof(m_Header));
+
+        ULONG end = m_Header.WrittenBytes;
+        if (end < m_Header.HeaderBytes || end > length) return FALSE;
+        if (!Fits(m_Header.DeviceOffset, m_Header.DeviceBytes, 1, end) ||
+            !Fits(m_Header.PoolOffset, m_Header.PoolBytes, 1, end) ||
+            !Fits(m_Header.StreamOffset, m_Header.StreamBytes, m_Header.StreamsReturned, end) ||
+            m_Header.StreamsReturned > m_Header.Streams)
+            return FALSE;
+        return TRUE;
+    }
+
+    const LeylineSnapshotHeader& Header() const { return m_Header; }
+
+    // Everything the driver had fitted in the buffer.
+    BOOLEAN IsComplete() const { return m_Header.TotalBytes <= m_Header.WrittenBytes; }
+
+    BOOLEAN GetDevice(LeylineSnapshotDevice* device) const
+    {
+        return Copy(m_Header.DeviceOffset, m_Header.DeviceBytes, device, sizeof(*device));
+    }
+
+    BOOLEAN GetPool(LeylineBufferPoolStats* pool) const
+    {
+        return Copy(m_Header.PoolOffset, m_Header.PoolBytes, pool, sizeof(*pool));
+    }
+
+    ULONG GetStreamCount() const { return m_Header.StreamsReturned; }
+
+    BOOLEAN GetStream(ULONG index, LeylineSnapshotStream* stream) const
+    {
+        if (index >= m_Header.StreamsReturned) return FALSE;
+        return Copy(m_Header.StreamOffset + index * m_Header.StreamBytes, m_Header.StreamBytes, stream, sizeof(*stream));
+    }
+
+private:
+    // Offset 0 is a section that is not there, which is fine.
+    static BOOLEAN Fits(ULONG offset, ULONG bytes, ULONG count, ULONG end)
+    {
+        if (!offset) return TRUE;
+        ULONGLONG last = (ULONGLONG)offset + (ULONGLONG)bytes * count;
+        return bytes && offset >= sizeof(LeylineSnapshotHeader) && last <= end;
+    }
+
+    BOOLEAN Copy(ULONG offset, ULONG bytes, void* out, ULONG size) const
+    {
+        RtlZeroMemory(out, size);
+        if (!offset) return FALSE;
+        RtlCopyMemory(out, m_Buffer + offset, bytes < size ? bytes : size);
+        return TRUE;
+    }
+
+    const UCHAR*          m_Buffer;
+    LeylineSnapshotHeader m_Header;
+};
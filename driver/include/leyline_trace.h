@@ -0,0 +1,206 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE TRACE EVENTS
+// The provider's event set (stream lifecycle, sampled positions, glitches) and the
+// writer in front of it. Every event is gated on one relaxed load of the mask the
+// enable callback computes, so with no session listening a trace point is a load
+// and a branch. Where events go is a sink: EtwWrite in the driver, a capture buffer
+// in the host tests. Portable: builds against the WDK or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+// Keywords a session enables the events by.
+#define LEYLINE_TRACE_KEYWORD_LIFECYCLE 0x0000000000000001ULL   // NewStream, SetState, AllocateAudioBuffer
+#define LEYLINE_TRACE_KEYWORD_POSITION  0x0000000000000002ULL   // Sampled GetPosition
+#define LEYLINE_TRACE_KEYWORD_GLITCH    0x0000000000000004ULL   // Underruns and overruns
+
+// winmeta.xml levels.
+#define LEYLINE_TRACE_LEVEL_WARNING     3
+#define LEYLINE_TRACE_LEVEL_INFO        4
+#define LEYLINE_TRACE_LEVEL_VERBOSE     5
+
+// One GetPosition in this many is traced per stream. The audio engine polls every
+// period, which would otherwise swamp a session with near-identical events.
+#define LEYLINE_TRACE_POSITION_SAMPLE   64
+
+enum TraceEvent : USHORT
+{
+    TraceEvent_NewStream      = 1,
+    TraceEvent_SetState       = 2,
+    TraceEvent_AllocateBuffer = 3,
+    TraceEvent_Position       = 4,
+    TraceEvent_Glitch         = 5,
+    TraceEvent_Count
+};
+
+enum TraceTask : USHORT
+{
+    TraceTask_Stream   = 1,
+    TraceTask_Position = 2,
+    TraceTask_Glitch   = 3,
+};
+
+enum TraceGlitchKind : ULONG
+{
+    TraceGlitch_Underrun = 1,   // The stream had fewer frames than the period needed
+    TraceGlitch_Overrun  = 2,   // Frames were overwritten before the stream read them
+};
+
+// TraceAllocateBuffer::Flags
+#define LEYLINE_TRACE_BUFFER_CABLE      0x00000001  // The cable's shared loopback pages
+#define LEYLINE_TRACE_BUFFER_POOLED     0x00000002  // A block from the device's buffer pool
+#define LEYLINE_TRACE_BUFFER_CONVERT    0x00000004  // Private pages behind a cable converter
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PAYLOADS
+// One fixed layout per event, written as a single data descriptor. Fields are only
+// ever appended, and the event's Version goes up when they are, so a decoder keyed
+// on {Id, Version} reads any payload at least as long as the layout it knows.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct TraceNewStream
+{
+    static constexpr TraceEvent Event = TraceEvent_NewStream;
+
+    ULONG StreamId;
+    ULONG Cable;
+    ULONG Capture;
+    ULONG SampleRate;
+    ULONG Channels;
+    ULONG BlockAlign;
+    ULONG SampleFormat;         // LeylineSampleFormat
+};
+
+struct TraceSetState
+{
+    static constexpr TraceEvent Event = TraceEvent_SetState;
+
+    ULONG  StreamId;
+    ULONG  From;                // KSSTATE
+    ULONG  To;
+    ULONG  Reserved;
+    LONG64 Qpc;
+};
+
+struct TraceAllocateBuffer
+{
+    static constexpr TraceEvent Event = TraceEvent_AllocateBuffer;
+
+    ULONG    StreamId;
+    NTSTATUS Status;
+    ULONG    RequestedBytes;
+    ULONG    ActualBytes;
+    ULONG    BufferUs;          // ActualBytes at the stream's rate: the most latency the buffer holds
+    ULONG    Flags;             // LEYLINE_TRACE_BUFFER_*
+    ULONG64  ElapsedNs;         // How long the allocation took
+};
+
+struct TracePosition
+{
+    static constexpr TraceEvent Event = TraceEvent_Position;
+
+    ULONG   StreamId;
+    ULONG   Position;           // Byte offset in the buffer
+    ULONG64 Frames;             // Frames since KSSTATE_RUN
+    LONG64  Qpc;
+};
+
+struct TraceGlitch
+{
+    static constexpr TraceEvent Event = TraceEvent_Glitch;
+
+    ULONG   StreamId;
+    ULONG   Kind;               // TraceGlitchKind
+    ULONG   Frames;             // Frames lost to an overrun, or missing from an underrun
+    ULONG   Reserved;
+    ULONG64 AtFrame;            // Where in the stream it happened
+};
+
+static_assert(sizeof(TraceNewStream)      == 28, "TraceNewStream layout");
+static_assert(sizeof(TraceSetState)       == 24, "TraceSetState layout");
+static_assert(sizeof(TraceAllocateBuffer) == 32, "TraceAllocateBuffer layout");
+static_assert(sizeof(TracePosition)       == 24, "TracePosition layout");
+static_assert(sizeof(TraceGlitch)         == 24, "TraceGlitch layout");
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// TRACE PROVIDER
+// Valid zeroed, with nothing enabled: the driver's instance is a global that no
+// constructor runs for. Attach the sink before registering with ETW, since the
+// enable callback can fire from inside EtwRegister.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Same shape as EtwWrite past the registration handle and activity ID.
+typedef NTSTATUS (*TraceSink)(PVOID Context, PCEVENT_DESCRIPTOR Descriptor, ULONG Count, PEVENT_DATA_DESCRIPTOR Data);
+
+class TraceProvider
+{
+public:
+    // Id, Version, Channel, Level, Opcode (winmeta: 0 Info, 1 Start), Task, Keyword.
+    static constexpr EVENT_DESCRIPTOR kEvents[TraceEvent_Count] =
+    {
+        {},
+        { TraceEvent_NewStream,      0, 0, LEYLINE_TRACE_LEVEL_INFO,    1, TraceTask_Stream,   LEYLINE_TRACE_KEYWORD_LIFECYCLE },
+        { TraceEvent_SetState,       0, 0, LEYLINE_TRACE_LEVEL_INFO,    0, TraceTask_Stream,   LEYLINE_TRACE_KEYWORD_LIFECYCLE },
+        { TraceEvent_AllocateBuffer, 0, 0, LEYLINE_TRACE_LEVEL_INFO,    0, TraceTask_Stream,   LEYLINE_TRACE_KEYWORD_LIFECYCLE },
+        { TraceEvent_Position,       0, 0, LEYLINE_TRACE_LEVEL_VERBOSE, 0, TraceTask_Position, LEYLINE_TRACE_KEYWORD_POSITION },
+        { TraceEvent_Glitch,         0, 0, LEYLINE_TRACE_LEVEL_WARNING, 0, TraceTask_Glitch,   LEYLINE_TRACE_KEYWORD_GLITCH },
+    };
+
+    // Once, before anything can call Enable; the release there publishes the sink.
+    void Attach(TraceSink Sink, PVOID Context)
+    {
+        m_Sink    = Sink;
+        m_Context = Context;
+    }
+
+    // The session's level and any-keyword mask, as the enable callback gets them.
+    // ETW treats 0 as "everything" for both.
+    void Enable(UCHAR Level, ULONGLONG Keywords)
+    {
+        if (Level == 0)    Level    = 0xFF;
+        if (Keywords == 0) Keywords = ~0ULL;
+
+        LONG events = 0;
+        for (ULONG id = 1; id < TraceEvent_Count; ++id)
+        {
+            if ((kEvents[id].Keyword & Keywords) && kEvents[id].Level <= Level) events |= 1L << id;
+        }
+        WriteRelease(&m_Events, events);
+    }
+
+    void Disable() { WriteRelease(&m_Events, 0); }
+
+    BOOLEAN IsEnabled(TraceEvent Event) const { return (ReadNoFence(&m_Events) & (1L << Event)) != 0; }
+
+    template<class Payload>
+    void Write(const Payload& Data)
+    {
+        if (!IsEnabled(Payload::Event) || !m_Sink) return;
+
+        EVENT_DATA_DESCRIPTOR data;
+        EventDataDescCreate(&data, &Data, sizeof(Data));
+        if (!NT_SUCCESS(m_Sink(m_Context, &kEvents[Payload::Event], 1, &data))) InterlockedIncrement(&m_Dropped);
+    }
+
+    // Events a sink refused, e.g. ETW out of buffers.
+    ULONG Dropped() const { return (ULONG)ReadNoFence(&m_Dropped); }
+
+    // TRUE on every `Period`th call with the same counter.
+    static BOOLEAN Sample(ULONG* Counter, ULONG Period)
+    {
+        if (++*Counter < Period) return FALSE;
+        *Counter = 0;
+        return TRUE;
+    }
+
+private:
+    TraceSink       m_Sink;
+    PVOID           m_Context;
+    volatile LONG   m_Events;       // Bit n: event n is enabled
+    volatile LONG   m_Dropped;
+};
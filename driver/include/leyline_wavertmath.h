@@ -0,0 +1,102 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LEYLINE WAVERT MATH
+// QPC-to-position helpers shared by the streams. Portable: builds against the WDK
+// or the host stand-ins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+
+namespace WaveRTMath
+{
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // RECIPROCAL
+    // Exact unsigned division by a divisor fixed ahead of time. Multiplier is
+    // floor((2^64 - 1) / Divisor), so the high half of x * Multiplier undershoots
+    // x / Divisor by at most 2 and a short correction loop makes it exact.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    struct Reciprocal
+    {
+        ULONGLONG Divisor;
+        ULONGLONG Multiplier;
+
+        void Init(ULONGLONG divisor)
+        {
+            Divisor    = divisor ? divisor : 1;
+            Multiplier = ~0ULL / Divisor;
+        }
+
+        ULONGLONG Divide(ULONGLONG x, ULONGLONG* remainder) const
+        {
+            ULONGLONG q = UnsignedMultiplyHigh(x, Multiplier);
+            ULONGLONG r = x - q * Divisor;
+            while (r >= Divisor) { r -= Divisor; ++q; }
+            *remainder = r;
+            return q;
+        }
+    };
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // STREAM CLOCK
+    // Whole frames elapsed since the stream entered RUN:
+    //
+    //     frames = floor(ticks * sampleRate / frequency)
+    //
+    // evaluated as whole seconds plus the fraction of the current second, so no
+    // intermediate exceeds frequency * sampleRate and nothing overflows for the
+    // ~29,000 years a 10 MHz QPC takes to wrap. Every result is exact, so the
+    // position never drifts from the QPC. Both divides and the buffer-wrap modulo
+    // go through reciprocals computed once in Start; GetPosition does none.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    class StreamClock
+    {
+    public:
+        // Called at KSSTATE_RUN. `bufferSize` is trimmed to whole frames.
+        void Start(LONG64 startQpc, LONG64 frequency, ULONG sampleRate, ULONG blockAlign, ULONG bufferSize)
+        {
+            m_StartQpc   = startQpc;
+            m_SampleRate = sampleRate;
+            m_BlockAlign = blockAlign ? blockAlign : 1;
+            m_Ticks.Init(frequency > 0 ? (ULONGLONG)frequency : 1);
+            m_BufferFrames.Init(bufferSize / m_BlockAlign);
+        }
+
+        LONG64 GetStartQpc()   const { return m_StartQpc; }
+        ULONG  GetBlockAlign() const { return m_BlockAlign; }
+
+        // Frames played between two QPC readings taken on this clock's timebase.
+        ULONGLONG FramesBetween(LONG64 startQpc, LONG64 nowQpc) const
+        {
+            if (nowQpc <= startQpc) return 0;
+
+            ULONGLONG partial;
+            ULONGLONG seconds = m_Ticks.Divide((ULONGLONG)(nowQpc - startQpc), &partial);
+            ULONGLONG unused;
+            return seconds * m_SampleRate + m_Ticks.Divide(partial * m_SampleRate, &unused);
+        }
+
+        ULONGLONG FramesAt(LONG64 nowQpc) const { return FramesBetween(m_StartQpc, nowQpc); }
+
+        // Byte offset of a monotonic frame count inside the DMA buffer; always on
+        // a frame boundary.
+        ULONG BufferOffset(ULONGLONG frames) const
+        {
+            ULONGLONG frame;
+            m_BufferFrames.Divide(frames, &frame);
+            return (ULONG)frame * m_BlockAlign;
+        }
+
+    private:
+        LONG64      m_StartQpc;
+        ULONG       m_SampleRate;
+        ULONG       m_BlockAlign;
+        Reciprocal  m_Ticks;
+        Reciprocal  m_BufferFrames;
+    };
+}
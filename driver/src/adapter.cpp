@@ -18,12 +18,94 @@ ULONGLONG      g_EtwRegHandle           = 0;
 
 static PDRIVER_DISPATCH s_OriginalDispatchCreate  = nullptr;
 static PDRIVER_DISPATCH s_OriginalDispatchClose   = nullptr;
+static PDRIVER_DISPATCH s_OriginalDispatchCleanup = nullptr;
 static PDRIVER_DISPATCH s_OriginalDispatchControl = nullptr;
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONTROL HANDLES
+// Each handle on the CDO keeps, in its FsContext, what MAP_PARAMS and MAP_BUFFER
+// mapped through it into the process that opened it. Cleanup (the last handle
+// closing, in that process unless the handle was duplicated elsewhere) unmaps
+// them; close unmaps anything left and frees the rest.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct ControlHandle
+{
+    FAST_MUTEX      Lock;               // Orders the map IOCTLs against cleanup
+    PEPROCESS       Process;            // Opened the handle; referenced until close
+    UserMappings    Mappings;
+};
+
+// Locked pages into the current process. A UserMode mapping raises instead of
+// returning null when it cannot be made.
+class UserPageMapper : public MappingSource
+{
+public:
+    NTSTATUS Map(PVOID Pages, PVOID* Address) override
+    {
+        PVOID mapping = nullptr;
+        __try
+        {
+            mapping = MmMapLockedPagesSpecifyCache(static_cast<PMDL>(Pages), UserMode, MmCached, nullptr, FALSE, NormalPagePriority);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER)
+        {
+            mapping = nullptr;
+        }
+        *Address = mapping;
+        return mapping ? STATUS_SUCCESS : STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    void Unmap(PVOID Pages, PVOID Address) override
+    {
+        MmUnmapLockedPages(Address, static_cast<PMDL>(Pages));
+    }
+};
+
+// MAP_PARAMS and MAP_BUFFER: the handle's mapping of `Mdl` under `Key`, made on
+// the first call.
+static NTSTATUS MapForHandle(PFILE_OBJECT FileObject, ULONG Key, PMDL Mdl, PVOID* Address)
+{
+    ControlHandle *handle = static_cast<ControlHandle*>(FileObject->FsContext);
+    if (!handle) return STATUS_DEVICE_NOT_READY;
+
+    UserPageMapper mapper;
+    ExAcquireFastMutex(&handle->Lock);
+    NTSTATUS status = handle->Mappings.Map(&mapper, PsGetCurrentProcess(), Key, Mdl, Address);
+    ExReleaseFastMutex(&handle->Lock);
+    return status;
+}
+
+// A user mapping can only be taken down from inside its process.
+static void UnmapForHandle(ControlHandle* Handle)
+{
+    UserPageMapper mapper;
+    ExAcquireFastMutex(&Handle->Lock);
+    if (Handle->Mappings.GetCount())
+    {
+        if (PsGetCurrentProcess() == Handle->Process)
+            Handle->Mappings.Release(&mapper);
+        else
+        {
+            KAPC_STATE apc;
+            KeStackAttachProcess(Handle->Process, &apc);
+            Handle->Mappings.Release(&mapper);
+            KeUnstackDetachProcess(&apc);
+        }
+    }
+    ExReleaseFastMutex(&Handle->Lock);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // IRP DISPATCH ROUTINES
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+// The cable an IOCTL names; null past the configured count.
+static CableEndpoint* FindCable(DeviceExtension* Ext, ULONG Index)
+{
+    return Index < Ext->CableCount ? Ext->Cables[Index] : nullptr;
+}
+
 static NTSTATUS DispatchCreate(PDEVICE_OBJECT DeviceObject, PIRP Irp)
 {
     if (DeviceObject != g_ControlDeviceObject)
@@ -32,6 +114,43 @@ static NTSTATUS DispatchCreate(PDEVICE_OBJECT DeviceObject, PIRP Irp)
             return s_OriginalDispatchCreate(DeviceObject, Irp);
         return STATUS_DEVICE_NOT_READY;
     }
+
+    NTSTATUS status = STATUS_SUCCESS;
+    if (!g_FunctionalDeviceObject)
+        status = STATUS_DEVICE_NOT_READY;
+    else
+    {
+        ControlHandle *handle = static_cast<ControlHandle*>(
+            GetDeviceExtension(g_FunctionalDeviceObject)->Objects.Allocate(sizeof(ControlHandle), 'LLCH'));
+        if (!handle)
+            status = STATUS_INSUFFICIENT_RESOURCES;
+        else
+        {
+            ExInitializeFastMutex(&handle->Lock);
+            handle->Process = PsGetCurrentProcess();
+            ObReferenceObject(handle->Process);
+            handle->Mappings.Init(handle->Process);
+            IoGetCurrentIrpStackLocation(Irp)->FileObject->FsContext = handle;
+        }
+    }
+    Irp->IoStatus.Status      = status;
+    Irp->IoStatus.Information = 0;
+    IoCompleteRequest(Irp, IO_NO_INCREMENT);
+    return status;
+}
+
+static NTSTATUS DispatchCleanup(PDEVICE_OBJECT DeviceObject, PIRP Irp)
+{
+    if (DeviceObject != g_ControlDeviceObject)
+    {
+        if (s_OriginalDispatchCleanup)
+            return s_OriginalDispatchCleanup(DeviceObject, Irp);
+        return STATUS_DEVICE_NOT_READY;
+    }
+
+    ControlHandle *handle = static_cast<ControlHandle*>(IoGetCurrentIrpStackLocation(Irp)->FileObject->FsContext);
+    if (handle) UnmapForHandle(handle);
+
     Irp->IoStatus.Status      = STATUS_SUCCESS;
     Irp->IoStatus.Information = 0;
     IoCompleteRequest(Irp, IO_NO_INCREMENT);
@@ -46,6 +165,17 @@ static NTSTATUS DispatchClose(PDEVICE_OBJECT DeviceObject, PIRP Irp)
             return s_OriginalDispatchClose(DeviceObject, Irp);
         return STATUS_DEVICE_NOT_READY;
     }
+
+    PFILE_OBJECT   fileObject = IoGetCurrentIrpStackLocation(Irp)->FileObject;
+    ControlHandle *handle     = static_cast<ControlHandle*>(fileObject->FsContext);
+    if (handle)
+    {
+        UnmapForHandle(handle);
+        ObDereferenceObject(handle->Process);
+        fileObject->FsContext = nullptr;
+        ObjectHeap::Free(handle);
+    }
+
     Irp->IoStatus.Status      = STATUS_SUCCESS;
     Irp->IoStatus.Information = 0;
     IoCompleteRequest(Irp, IO_NO_INCREMENT);
@@ -78,22 +208,229 @@ static NTSTATUS DispatchDeviceControl(PDEVICE_OBJECT DeviceObject, PIRP Irp)
         break;
 
     case IOCTL_LEYLINE_MAP_BUFFER:
-        if (g_FunctionalDeviceObject)
+        if (stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(PVOID))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
         {
-            DeviceExtension *ext = GetDeviceExtension(g_FunctionalDeviceObject);
-            if (ext->LoopbackMdl)
+            ULONG index = stack->Parameters.DeviceIoControl.InputBufferLength >= sizeof(ULONG)
+                        ? *reinterpret_cast<const ULONG*>(Irp->AssociatedIrp.SystemBuffer) : 0;
+            CableEndpoint *cable = FindCable(GetDeviceExtension(g_FunctionalDeviceObject), index);
+            if (!cable)
+                status = STATUS_INVALID_PARAMETER;
+            else if (!cable->LoopbackMdl)
+                status = STATUS_DEVICE_NOT_READY;
+            else
             {
-                PVOID userAddr = MmMapLockedPagesSpecifyCache(ext->LoopbackMdl, UserMode, MmCached, nullptr, FALSE, NormalPagePriority);
-                if (userAddr)
-                {
-                    *reinterpret_cast<PVOID*>(Irp->AssociatedIrp.SystemBuffer) = userAddr;
-                    info = sizeof(PVOID);
-                }
-                else status = STATUS_INSUFFICIENT_RESOURCES;
+                status = MapForHandle(stack->FileObject, index, cable->LoopbackMdl,
+                                      reinterpret_cast<PVOID*>(Irp->AssociatedIrp.SystemBuffer));
+                if (NT_SUCCESS(status)) info = sizeof(PVOID);
             }
-            else status = STATUS_DEVICE_NOT_READY;
         }
-        else status = STATUS_DEVICE_NOT_READY;
+        break;
+
+    case IOCTL_LEYLINE_MAP_PARAMS:
+        if (stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(PVOID))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject || !GetDeviceExtension(g_FunctionalDeviceObject)->SharedParamsMdl)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            status = MapForHandle(stack->FileObject, LEYLINE_MAPPING_PARAMS,
+                                  GetDeviceExtension(g_FunctionalDeviceObject)->SharedParamsMdl,
+                                  reinterpret_cast<PVOID*>(Irp->AssociatedIrp.SystemBuffer));
+            if (NT_SUCCESS(status)) info = sizeof(PVOID);
+        }
+        break;
+
+    case IOCTL_LEYLINE_SET_LOOPBACK_CONFIG:
+        if (stack->Parameters.DeviceIoControl.InputBufferLength < LEYLINE_LOOPBACK_CONFIG_V1_SIZE)
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            const LeylineLoopbackConfig *config = reinterpret_cast<const LeylineLoopbackConfig*>(Irp->AssociatedIrp.SystemBuffer);
+            ULONG index = stack->Parameters.DeviceIoControl.InputBufferLength >= sizeof(LeylineLoopbackConfig) ? config->Cable : 0;
+            CableEndpoint *cable = FindCable(GetDeviceExtension(g_FunctionalDeviceObject), index);
+            if (!cable || config->LatencyFrames > LEYLINE_MAX_CABLE_LATENCY_FRAMES)
+                status = STATUS_INVALID_PARAMETER;
+            else
+                cable->Cable.Configure(config->Enabled != 0, config->LatencyFrames);
+        }
+        break;
+
+    case IOCTL_LEYLINE_SET_REGISTER_PERIOD:
+        if (stack->Parameters.DeviceIoControl.InputBufferLength < sizeof(ULONG))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            ULONG periodMs = *reinterpret_cast<const ULONG*>(Irp->AssociatedIrp.SystemBuffer);
+            if (periodMs == 0 || periodMs > LEYLINE_MAX_REGISTER_PERIOD_MS)
+                status = STATUS_INVALID_PARAMETER;
+            else
+                InterlockedExchange(&GetDeviceExtension(g_FunctionalDeviceObject)->RegisterPeriodMs, (LONG)periodMs);
+        }
+        break;
+
+    case IOCTL_LEYLINE_SET_RESAMPLER_QUALITY:
+        if (stack->Parameters.DeviceIoControl.InputBufferLength < sizeof(ULONG))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            ULONG quality = *reinterpret_cast<const ULONG*>(Irp->AssociatedIrp.SystemBuffer);
+            if (quality > SrcQuality_High)
+                status = STATUS_INVALID_PARAMETER;
+            else
+                InterlockedExchange(&GetDeviceExtension(g_FunctionalDeviceObject)->ResamplerQuality, (LONG)quality);
+        }
+        break;
+
+    case IOCTL_LEYLINE_SET_METER_BALLISTICS:
+        if (stack->Parameters.DeviceIoControl.InputBufferLength < sizeof(LeylineMeterConfig))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            const LeylineMeterConfig *config = reinterpret_cast<const LeylineMeterConfig*>(Irp->AssociatedIrp.SystemBuffer);
+            if (config->DecayDbPerSecond > LEYLINE_METER_MAX_DECAY_DB || config->RmsWindowMs > LEYLINE_METER_MAX_RMS_MS)
+                status = STATUS_INVALID_PARAMETER;
+            else
+            {
+                DeviceExtension *ext = GetDeviceExtension(g_FunctionalDeviceObject);
+                InterlockedExchange(&ext->MeterDecayDb, (LONG)config->DecayDbPerSecond);
+                InterlockedExchange(&ext->MeterRmsMs, (LONG)config->RmsWindowMs);
+            }
+        }
+        break;
+
+    case IOCTL_LEYLINE_SET_ROUTE:
+        if (stack->Parameters.DeviceIoControl.InputBufferLength < sizeof(LeylineRouteConfig))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            const LeylineRouteConfig *config = reinterpret_cast<const LeylineRouteConfig*>(Irp->AssociatedIrp.SystemBuffer);
+            if (config->Inputs > LEYLINE_ROUTE_MAX_CHANNELS || config->Outputs > LEYLINE_ROUTE_MAX_CHANNELS ||
+                (config->Inputs && config->Outputs == 0))
+                status = STATUS_INVALID_PARAMETER;
+            else if (stack->Parameters.DeviceIoControl.InputBufferLength <
+                     sizeof(LeylineRouteConfig) + (SIZE_T)config->Inputs * config->Outputs * sizeof(float))
+                status = STATUS_BUFFER_TOO_SMALL;
+            else
+                status = SetMixRoute(GetDeviceExtension(g_FunctionalDeviceObject), config,
+                                     reinterpret_cast<const float*>(config + 1));
+        }
+        break;
+
+    case IOCTL_LEYLINE_GET_BUFFER_POOL_STATS:
+        if (stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(LeylineBufferPoolStats))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            GetDeviceExtension(g_FunctionalDeviceObject)->AudioBuffers.GetStats(
+                reinterpret_cast<LeylineBufferPoolStats*>(Irp->AssociatedIrp.SystemBuffer));
+            info = sizeof(LeylineBufferPoolStats);
+        }
+        break;
+
+    case IOCTL_LEYLINE_GET_OBJECT_STATS:
+        if (stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(LeylineObjectStats))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            GetDeviceExtension(g_FunctionalDeviceObject)->Objects.GetStats(
+                reinterpret_cast<LeylineObjectStats*>(Irp->AssociatedIrp.SystemBuffer));
+            info = sizeof(LeylineObjectStats);
+        }
+        break;
+
+    case IOCTL_LEYLINE_READ_PLANES:
+        if (stack->Parameters.DeviceIoControl.InputBufferLength < sizeof(LeylinePlaneRequest) ||
+            stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(LeylinePlaneHeader))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            // Input and output share the system buffer.
+            LeylinePlaneRequest request = *reinterpret_cast<const LeylinePlaneRequest*>(Irp->AssociatedIrp.SystemBuffer);
+            CableEndpoint *cable = FindCable(GetDeviceExtension(g_FunctionalDeviceObject), request.Cable);
+            if (!cable)
+                status = STATUS_INVALID_PARAMETER;
+            else
+                status = ReadCablePlanes(cable, request, Irp->AssociatedIrp.SystemBuffer,
+                                         stack->Parameters.DeviceIoControl.OutputBufferLength, &info);
+        }
+        break;
+
+    case IOCTL_LEYLINE_GET_GLITCH_STATS:
+        if (stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(LeylineGlitchReport))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+            status = ReadGlitchStats(GetDeviceExtension(g_FunctionalDeviceObject), Irp->AssociatedIrp.SystemBuffer,
+                                     stack->Parameters.DeviceIoControl.OutputBufferLength, &info);
+        break;
+
+    case IOCTL_LEYLINE_MEASURE_LATENCY:
+        if (stack->Parameters.DeviceIoControl.InputBufferLength < sizeof(LeylineLatencyConfig))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            const LeylineLatencyConfig *config = reinterpret_cast<const LeylineLatencyConfig*>(Irp->AssociatedIrp.SystemBuffer);
+            CableEndpoint *cable = FindCable(GetDeviceExtension(g_FunctionalDeviceObject), config->Cable);
+            if (!cable || config->Bursts > LEYLINE_LATENCY_MAX_BURSTS ||
+                (config->Bursts && (config->IntervalMs < LEYLINE_LATENCY_MIN_INTERVAL_MS ||
+                                    config->IntervalMs > LEYLINE_LATENCY_MAX_INTERVAL_MS)))
+                status = STATUS_INVALID_PARAMETER;
+            else
+                status = MeasureLatency(cable, *config);
+        }
+        break;
+
+    case IOCTL_LEYLINE_GET_LATENCY:
+        if (stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(LeylineLatencyReport))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+        {
+            ULONG index = stack->Parameters.DeviceIoControl.InputBufferLength >= sizeof(ULONG)
+                        ? *reinterpret_cast<const ULONG*>(Irp->AssociatedIrp.SystemBuffer) : 0;
+            CableEndpoint *cable = FindCable(GetDeviceExtension(g_FunctionalDeviceObject), index);
+            if (!cable)
+                status = STATUS_INVALID_PARAMETER;
+            else
+            {
+                status = ReadLatency(cable, reinterpret_cast<LeylineLatencyReport*>(Irp->AssociatedIrp.SystemBuffer));
+                if (NT_SUCCESS(status)) info = sizeof(LeylineLatencyReport);
+            }
+        }
+        break;
+
+    case IOCTL_LEYLINE_GET_SNAPSHOT:
+        if (stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(LeylineSnapshotHeader))
+            status = STATUS_BUFFER_TOO_SMALL;
+        else if (!g_FunctionalDeviceObject)
+            status = STATUS_DEVICE_NOT_READY;
+        else
+            status = ReadSnapshot(GetDeviceExtension(g_FunctionalDeviceObject), Irp->AssociatedIrp.SystemBuffer,
+                                  stack->Parameters.DeviceIoControl.OutputBufferLength, &info);
         break;
 
     default:
@@ -108,160 +445,363 @@ static NTSTATUS DispatchDeviceControl(PDEVICE_OBJECT DeviceObject, PIRP Irp)
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// StartDevice - PORTCLS CALLBACK
+// AUDIO BUFFER POOL
+// Reserved once at StartDevice: enough for a handful of streams per class, about
+// 1.75 MB. 16 KB covers shared-mode periods at 48 kHz; the larger classes are for
+// long buffers and wide or high-rate formats. Anything past that is a miss and
+// gets fresh pages as before.
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-extern "C" NTSTATUS NTAPI StartDevice(PDEVICE_OBJECT DeviceObject, PIRP Irp, PRESOURCELIST ResourceList)
+static const BufferPoolClass s_AudioBufferClasses[] =
 {
-    NTSTATUS status;
-    DeviceExtension *devExt = GetDeviceExtension(DeviceObject);
+    {  16 * 1024, 16 },
+    {  64 * 1024,  8 },
+    { 256 * 1024,  4 },
+};
 
-    if (!devExt->LoopbackMdl)
+NTSTATUS LockedPageSource::Allocate(SIZE_T Bytes, PoolBlock* Block)
+{
+    PHYSICAL_ADDRESS low = {0}, high = {0}, skip = {0};
+    high.LowPart = 0xFFFFFFFF;
+
+    PMDL mdl = MmAllocatePagesForMdlEx(low, high, skip, Bytes, MmCached, MM_ALLOCATE_FULLY_REQUIRED);
+    if (!mdl) return STATUS_INSUFFICIENT_RESOURCES;
+
+    PVOID mapping = MmMapLockedPagesSpecifyCache(mdl, KernelMode, MmCached, nullptr, FALSE, NormalPagePriority);
+    if (!mapping)
     {
-        devExt->LoopbackSize = 128 * 1024;
-        PHYSICAL_ADDRESS low = {0}, high = {0}, skip = {0};
-        high.LowPart = 0xFFFFFFFF;
-        devExt->LoopbackMdl = MmAllocatePagesForMdlEx(low, high, skip, devExt->LoopbackSize, MmCached, MM_ALLOCATE_FULLY_REQUIRED);
-        if (devExt->LoopbackMdl)
-        {
-            devExt->LoopbackBuffer = (PUCHAR)MmMapLockedPagesSpecifyCache(devExt->LoopbackMdl, KernelMode, MmCached, nullptr, FALSE, NormalPagePriority);
-            if (devExt->LoopbackBuffer) RtlZeroMemory(devExt->LoopbackBuffer, devExt->LoopbackSize);
-        }
+        MmFreePagesFromMdl(mdl);
+        IoFreeMdl(mdl);
+        return STATUS_INSUFFICIENT_RESOURCES;
     }
 
-    if (!devExt->SharedParamsMdl)
+    Block->Address = mapping;
+    Block->Handle  = mdl;
+    Block->Bytes   = Bytes;
+    return STATUS_SUCCESS;
+}
+
+void LockedPageSource::Free(const PoolBlock& Block)
+{
+    PMDL mdl = static_cast<PMDL>(Block.Handle);
+    MmUnmapLockedPages(Block.Address, mdl);
+    MmFreePagesFromMdl(mdl);
+    IoFreeMdl(mdl);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ENDPOINTS
+// Every cable count uses a prefix of the largest graph (see leyline_endpoints.h),
+// so the adapter keeps just that one. "CablePairs" in the device's driver key
+// picks how many cables to bring up; the first keeps the names the INF
+// describes, the rest get their interface values written here before PortCls
+// enables them.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static constexpr EndpointGraph<LEYLINE_MAX_CABLES> s_Endpoints;
+static_assert(s_Endpoints.IsConsistent(), "endpoint graph does not hold together");
+
+// Per cable: 16-bit stereo at 48 kHz for ~680 ms.
+static const SIZE_T s_LoopbackBytes = 128 * 1024;
+
+static const ULONG s_MiniportTags[EndpointFilter_Count] = { 'LLWR', 'LLWC', 'LLTR', 'LLTC' };
+
+static ULONG ReadCablePairs(PDEVICE_OBJECT DeviceObject)
+{
+    ULONG          cables = LEYLINE_DEFAULT_CABLES;
+    PDEVICE_OBJECT pdo    = nullptr;
+    HANDLE         key    = nullptr;
+
+    if (NT_SUCCESS(PcGetPhysicalDeviceObject(DeviceObject, &pdo)) &&
+        NT_SUCCESS(IoOpenDeviceRegistryKey(pdo, PLUGPLAY_REGKEY_DRIVER, KEY_READ, &key)))
     {
-        PHYSICAL_ADDRESS low = {0}, high = {0}, skip = {0};
-        high.LowPart = 0xFFFFFFFF;
-        devExt->SharedParamsMdl = MmAllocatePagesForMdlEx(low, high, skip, sizeof(LeylineSharedParameters), MmCached, MM_ALLOCATE_FULLY_REQUIRED);
-        if (devExt->SharedParamsMdl)
+        UNICODE_STRING name;
+        RtlInitUnicodeString(&name, L"CablePairs");
+
+        struct { KEY_VALUE_PARTIAL_INFORMATION Info; ULONG Room; } value = {};
+        ULONG length = 0;
+        if (NT_SUCCESS(ZwQueryValueKey(key, &name, KeyValuePartialInformation, &value, sizeof(value), &length)) &&
+            value.Info.Type == REG_DWORD && value.Info.DataLength == sizeof(ULONG))
         {
-            devExt->SharedParams = (LeylineSharedParameters*)MmMapLockedPagesSpecifyCache(devExt->SharedParamsMdl, KernelMode, MmCached, nullptr, FALSE, NormalPagePriority);
-            if (devExt->SharedParams)
-            {
-                RtlZeroMemory(devExt->SharedParams, sizeof(LeylineSharedParameters));
-                devExt->SharedParams->BufferSize = (ULONG)devExt->LoopbackSize;
-                devExt->SharedParams->ByteRate   = 48000 * 4;
-                LARGE_INTEGER freq;
-                KeQueryPerformanceCounter(&freq);
-                devExt->SharedParams->QpcFrequency = freq.QuadPart;
-            }
+            cables = *reinterpret_cast<const ULONG*>(value.Info.Data);
         }
+        ZwClose(key);
     }
 
-    PPORT renderPort = nullptr;
-    PPORT capturePort = nullptr;
-    PPORT renderTopoPort = nullptr;
-    PPORT captureTopoPort = nullptr;
+    if (cables < 1) cables = 1;
+    if (cables > LEYLINE_MAX_CABLES) cables = LEYLINE_MAX_CABLES;
+    return cables;
+}
 
-    // ---- WaveRender ----
-    status = PcNewPort(&renderPort, CLSID_PortWaveRT);
-    if (NT_SUCCESS(status))
+static NTSTATUS SetInterfaceValue(HANDLE Key, PCWSTR Name, ULONG Type, const void* Data, ULONG Bytes)
+{
+    UNICODE_STRING name;
+    RtlInitUnicodeString(&name, Name);
+    return ZwSetValueKey(Key, &name, 0, Type, const_cast<PVOID>(Data), Bytes);
+}
+
+static NTSTATUS SetInterfaceString(HANDLE Key, PCWSTR Name, PCUNICODE_STRING Value)
+{
+    // REG_SZ data carries its terminator; Value's buffer was zeroed past Length.
+    return SetInterfaceValue(Key, Name, REG_SZ, Value->Buffer, Value->Length + sizeof(WCHAR));
+}
+
+static NTSTATUS OpenSubkey(HANDLE Parent, PCWSTR Name, HANDLE* Key)
+{
+    UNICODE_STRING    name;
+    OBJECT_ATTRIBUTES attributes;
+    RtlInitUnicodeString(&name, Name);
+    InitializeObjectAttributes(&attributes, &name, OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE, Parent, nullptr);
+    return ZwCreateKey(Key, KEY_ALL_ACCESS, &attributes, 0, nullptr, REG_OPTION_NON_VOLATILE, nullptr);
+}
+
+// What the INF's Leyline.I.* sections write for the first cable: the KS proxy,
+// a numbered friendly name and, on the topology side, the jack the endpoint
+// stands for.
+static NTSTATUS DescribeInterfaces(PDEVICE_OBJECT DeviceObject, const EndpointSubdevice& Subdevice)
+{
+    PDEVICE_OBJECT pdo;
+    NTSTATUS status = PcGetPhysicalDeviceObject(DeviceObject, &pdo);
+    if (!NT_SUCCESS(status)) return status;
+
+    const BOOLEAN capture = IsCaptureFilter(Subdevice.Kind);
+
+    WCHAR          nameBuffer[32] = {};
+    WCHAR          digitBuffer[12] = {};
+    UNICODE_STRING friendlyName, digits;
+    RtlInitEmptyUnicodeString(&friendlyName, nameBuffer, sizeof(nameBuffer) - sizeof(WCHAR));
+    RtlInitEmptyUnicodeString(&digits, digitBuffer, sizeof(digitBuffer));
+    RtlAppendUnicodeToString(&friendlyName, capture ? L"Leyline Input " : L"Leyline Output ");
+    RtlIntegerToUnicodeString(Subdevice.Cable + 1, 10, &digits);
+    RtlAppendUnicodeStringToString(&friendlyName, &digits);
+
+    UNICODE_STRING proxy, jack, reference;
+    RtlInitUnicodeString(&proxy, L"{17CCA71B-ECD7-11D0-B908-00A0C9223196}");
+    RtlInitUnicodeString(&jack, capture ? L"{DFF21BE1-F70F-11D0-B917-00A0C9223196}"     // KSNODETYPE_MICROPHONE
+                                        : L"{DFF21CE1-F70F-11D0-B917-00A0C9223196}");   // KSNODETYPE_SPEAKER
+    RtlInitUnicodeString(&reference, Subdevice.Name);
+
+    const PCFILTER_DESCRIPTOR* filter = EndpointFilterDescriptor(Subdevice.Kind);
+    for (ULONG i = 0; i < filter->CategoryCount && NT_SUCCESS(status); ++i)
     {
-        CMiniportWaveRT *renderMiniport = new (NonPagedPool, 'LLWR') CMiniportWaveRT(nullptr, FALSE, devExt);
-        if (renderMiniport)
+        UNICODE_STRING link = {};
+        status = IoRegisterDeviceInterface(pdo, &filter->Categories[i], &reference, &link);
+        if (!NT_SUCCESS(status)) break;
+
+        HANDLE key = nullptr;
+        status = IoOpenDeviceInterfaceRegistryKey(&link, KEY_ALL_ACCESS, &key);
+        if (NT_SUCCESS(status))
         {
-            renderMiniport->AddRef();
-            devExt->RenderMiniport = renderMiniport;
-            status = renderPort->Init(DeviceObject, Irp, renderMiniport, nullptr, ResourceList);
+            status = SetInterfaceString(key, L"CLSID", &proxy);
             if (NT_SUCCESS(status))
+                status = SetInterfaceString(key, L"FriendlyName", &friendlyName);
+
+            if (NT_SUCCESS(status) && IsTopologyFilter(Subdevice.Kind))
             {
-                status = PcRegisterSubdevice(DeviceObject, L"WaveRender", renderPort);
+                ULONG enableByDefault = capture ? 2 : 1;
+                status = SetInterfaceValue(key, L"{F3E80BEF-1723-4FF2-BCC4-7F83DC5E46D4},4", REG_DWORD,
+                                           &enableByDefault, sizeof(enableByDefault));
+
+                HANDLE ep = nullptr, ep0 = nullptr;
+                if (NT_SUCCESS(status)) status = OpenSubkey(key, L"EP", &ep);
+                if (NT_SUCCESS(status)) status = OpenSubkey(ep, L"0", &ep0);
+                if (NT_SUCCESS(status))
+                    status = SetInterfaceString(ep0, L"{1DA5D803-D492-4EDD-8C23-E0C0FFEE7F0E},2", &jack);
+                if (ep0) ZwClose(ep0);
+                if (ep)  ZwClose(ep);
             }
-            renderMiniport->Release();
+            ZwClose(key);
         }
-        else status = STATUS_INSUFFICIENT_RESOURCES;
+        RtlFreeUnicodeString(&link);
     }
-    if (!NT_SUCCESS(status)) goto Cleanup;
+    return status;
+}
 
-    // ---- WaveCapture ----
-    status = PcNewPort(&capturePort, CLSID_PortWaveRT);
+// A port and miniport for one subdevice, registered under its name. The port
+// keeps the miniport; *Port is left for the caller to release.
+static NTSTATUS CreateSubdevice(PDEVICE_OBJECT DeviceObject, PIRP Irp, PRESOURCELIST ResourceList,
+                                DeviceExtension* DevExt, const EndpointSubdevice& Subdevice, PPORT* Port)
+{
+    CableEndpoint *cable    = DevExt->Cables[Subdevice.Cable];
+    const BOOLEAN  topology = IsTopologyFilter(Subdevice.Kind);
+    const BOOLEAN  capture  = IsCaptureFilter(Subdevice.Kind);
+    const ULONG    tag      = s_MiniportTags[Subdevice.Kind];
+
+    NTSTATUS status = PcNewPort(Port, topology ? CLSID_PortTopology : CLSID_PortWaveRT);
+    if (!NT_SUCCESS(status)) return status;
+
+    PUNKNOWN miniport = nullptr;
+    if (topology)
+    {
+        CMiniportTopology *topo = new (DevExt->Objects, tag) CMiniportTopology(nullptr, capture, cable);
+        (capture ? cable->CaptureTopoMiniport : cable->RenderTopoMiniport) = topo;
+        miniport = topo;
+    }
+    else
+    {
+        CMiniportWaveRT *wave = new (DevExt->Objects, tag) CMiniportWaveRT(nullptr, capture, DevExt, cable);
+        (capture ? cable->CaptureMiniport : cable->RenderMiniport) = wave;
+        miniport = wave;
+    }
+    if (!miniport) return STATUS_INSUFFICIENT_RESOURCES;
+
+    miniport->AddRef();
+    status = (*Port)->Init(DeviceObject, Irp, miniport, nullptr, ResourceList);
+    if (NT_SUCCESS(status) && Subdevice.Cable > 0)
+        status = DescribeInterfaces(DeviceObject, Subdevice);
+    if (NT_SUCCESS(status))
+        status = PcRegisterSubdevice(DeviceObject, const_cast<PWSTR>(Subdevice.Name), *Port);
+    miniport->Release();
+    return status;
+}
+
+static NTSTATUS ConnectSubdevices(PDEVICE_OBJECT DeviceObject, PPORT From, ULONG FromPin, PPORT To, ULONG ToPin)
+{
+    PUNKNOWN fromUnk = nullptr;
+    NTSTATUS status  = From->QueryInterface(IID_IUnknown, (PVOID*)&fromUnk);
     if (NT_SUCCESS(status))
     {
-        CMiniportWaveRT *captureMiniport = new (NonPagedPool, 'LLWC') CMiniportWaveRT(nullptr, TRUE, devExt);
-        if (captureMiniport)
+        PUNKNOWN toUnk = nullptr;
+        status = To->QueryInterface(IID_IUnknown, (PVOID*)&toUnk);
+        if (NT_SUCCESS(status))
         {
-            captureMiniport->AddRef();
-            devExt->CaptureMiniport = captureMiniport;
-            status = capturePort->Init(DeviceObject, Irp, captureMiniport, nullptr, ResourceList);
-            if (NT_SUCCESS(status))
-            {
-                status = PcRegisterSubdevice(DeviceObject, L"WaveCapture", capturePort);
-            }
-            captureMiniport->Release();
+            status = PcRegisterPhysicalConnection(DeviceObject, fromUnk, FromPin, toUnk, ToPin);
+            toUnk->Release();
         }
-        else status = STATUS_INSUFFICIENT_RESOURCES;
+        fromUnk->Release();
     }
-    if (!NT_SUCCESS(status)) goto Cleanup;
+    return status;
+}
 
-    // ---- TopologyRender ----
-    status = PcNewPort(&renderTopoPort, CLSID_PortTopology);
-    if (NT_SUCCESS(status))
+// Loopback pages, planar storage and the latency probe for one cable. Failures
+// leave the cable without them: streams fall back to private buffers,
+// READ_PLANES reports no owner, MEASURE_LATENCY is refused.
+static CableEndpoint* SetUpCable(DeviceExtension* DevExt, ULONG Index)
+{
+    CableEndpoint *cable = DevExt->Cables[Index];
+    if (!cable)
     {
-        CMiniportTopology *renderTopoMiniport = new (NonPagedPool, 'LLTR') CMiniportTopology(nullptr, FALSE);
-        if (renderTopoMiniport)
+        cable = static_cast<CableEndpoint*>(DevExt->Objects.Allocate(sizeof(CableEndpoint), 'LLCE'));
+        if (!cable) return nullptr;
+        cable->Index = Index;
+        DevExt->Cables[Index] = cable;
+    }
+
+    if (!cable->LoopbackMdl)
+    {
+        cable->LoopbackSize = s_LoopbackBytes;
+        PHYSICAL_ADDRESS low = {0}, high = {0}, skip = {0};
+        high.LowPart = 0xFFFFFFFF;
+        cable->LoopbackMdl = MmAllocatePagesForMdlEx(low, high, skip, cable->LoopbackSize, MmCached, MM_ALLOCATE_FULLY_REQUIRED);
+        if (cable->LoopbackMdl)
         {
-            renderTopoMiniport->AddRef();
-            devExt->RenderTopoMiniport = renderTopoMiniport;
-            status = renderTopoPort->Init(DeviceObject, Irp, renderTopoMiniport, nullptr, ResourceList);
-            if (NT_SUCCESS(status))
+            cable->LoopbackBuffer = (PUCHAR)MmMapLockedPagesSpecifyCache(cable->LoopbackMdl, KernelMode, MmCached, nullptr, FALSE, NormalPagePriority);
+            if (cable->LoopbackBuffer)
             {
-                status = PcRegisterSubdevice(DeviceObject, L"TopologyRender", renderTopoPort);
+                RtlZeroMemory(cable->LoopbackBuffer, cable->LoopbackSize);
+                cable->Cable.Configure(TRUE, LEYLINE_DEFAULT_CABLE_LATENCY_FRAMES);
             }
-            renderTopoMiniport->Release();
         }
-        else status = STATUS_INSUFFICIENT_RESOURCES;
     }
-    if (!NT_SUCCESS(status)) goto Cleanup;
 
-    // ---- TopologyCapture ----
-    status = PcNewPort(&captureTopoPort, CLSID_PortTopology);
-    if (NT_SUCCESS(status))
+    // Planar side ring storage, laid out by the cable owner at KSSTATE_RUN.
+    KeInitializeSpinLock(&cable->PlanesLock);
+    if (!cable->CablePlanesStorage)
+        cable->CablePlanesStorage = DevExt->Objects.Allocate(
+            PlanarRing::Bytes(LEYLINE_PLANAR_MAX_CHANNELS, LEYLINE_PLANAR_RING_FRAMES), 'LLPL');
+
+    // The latency probe, so IOCTL_LEYLINE_MEASURE_LATENCY never allocates.
+    KeInitializeSpinLock(&cable->ProbeLock);
+    if (!cable->Probe)
     {
-        CMiniportTopology *captureTopoMiniport = new (NonPagedPool, 'LLTC') CMiniportTopology(nullptr, TRUE);
-        if (captureTopoMiniport)
+        cable->Probe = static_cast<LatencyProbe*>(DevExt->Objects.Allocate(sizeof(LatencyProbe), 'LLLP'));
+        if (cable->Probe) cable->Probe->Init();
+    }
+    return cable;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// StartDevice - PORTCLS CALLBACK
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+extern "C" NTSTATUS NTAPI StartDevice(PDEVICE_OBJECT DeviceObject, PIRP Irp, PRESOURCELIST ResourceList)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    DeviceExtension *devExt = GetDeviceExtension(DeviceObject);
+
+    if (!devExt->CableCount)
+    {
+        devExt->CableCount       = ReadCablePairs(DeviceObject);
+        devExt->ResamplerQuality = LEYLINE_SRC_DEFAULT_QUALITY;
+    }
+
+    if (!devExt->RegisterPeriodMs)
+        devExt->RegisterPeriodMs = LEYLINE_DEFAULT_REGISTER_PERIOD_MS;
+
+    // No stream exists yet, so nothing can hold them.
+    KeInitializeSpinLock(&devExt->MixLock);
+    KeInitializeSpinLock(&devExt->StreamsLock);
+
+    // Without a pool, streams allocate their pages directly.
+    if (!devExt->AudioBuffers.IsReady())
+    {
+        LockedPageSource *pages = new (devExt->Objects, 'LLBP') LockedPageSource;
+        if (pages && !NT_SUCCESS(devExt->AudioBuffers.Reserve(pages, s_AudioBufferClasses,
+                                                              sizeof(s_AudioBufferClasses) / sizeof(s_AudioBufferClasses[0]))))
         {
-            captureTopoMiniport->AddRef();
-            devExt->CaptureTopoMiniport = captureTopoMiniport;
-            status = captureTopoPort->Init(DeviceObject, Irp, captureTopoMiniport, nullptr, ResourceList);
-            if (NT_SUCCESS(status))
-            {
-                status = PcRegisterSubdevice(DeviceObject, L"TopologyCapture", captureTopoPort);
-            }
-            captureTopoMiniport->Release();
+            delete pages;
         }
-        else status = STATUS_INSUFFICIENT_RESOURCES;
     }
-    if (!NT_SUCCESS(status)) goto Cleanup;
 
-    // Physical connections
-    PUNKNOWN renderPortUnk = nullptr;
-    status = renderPort->QueryInterface(IID_IUnknown, (PVOID*)&renderPortUnk);
-    if (NT_SUCCESS(status))
+    // One slot per telemetry slot; streams past that come from the pool, still counted.
+    if (!devExt->Objects.IsReady())
+        devExt->Objects.Reserve('LLWS', sizeof(CMiniportWaveRTStream), LEYLINE_STREAM_SLOTS);
+
+    for (ULONG i = 0; i < devExt->CableCount; ++i)
     {
-        PUNKNOWN renderTopoPortUnk = nullptr;
-        status = renderTopoPort->QueryInterface(IID_IUnknown, (PVOID*)&renderTopoPortUnk);
-        if (NT_SUCCESS(status))
+        if (!SetUpCable(devExt, i)) return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    if (!devExt->SharedParamsMdl)
+    {
+        PHYSICAL_ADDRESS low = {0}, high = {0}, skip = {0};
+        high.LowPart = 0xFFFFFFFF;
+        devExt->SharedParamsMdl = MmAllocatePagesForMdlEx(low, high, skip, sizeof(LeylineSharedParameters), MmCached, MM_ALLOCATE_FULLY_REQUIRED);
+        if (devExt->SharedParamsMdl)
         {
-            PcRegisterPhysicalConnection(DeviceObject, renderPortUnk, 1, renderTopoPortUnk, 0);
-            renderTopoPortUnk->Release();
+            devExt->SharedParams = (LeylineSharedParameters*)MmMapLockedPagesSpecifyCache(devExt->SharedParamsMdl, KernelMode, MmCached, nullptr, FALSE, NormalPagePriority);
+            if (devExt->SharedParams)
+            {
+                RtlZeroMemory(devExt->SharedParams, sizeof(LeylineSharedParameters));
+                LARGE_INTEGER freq;
+                KeQueryPerformanceCounter(&freq);
+                SharedParameterBlock::Init(devExt->SharedParams, freq.QuadPart, (ULONG)s_LoopbackBytes, 48000 * 4);
+                devExt->MeterDecayDb = LEYLINE_METER_DEFAULT_DECAY_DB;
+                devExt->MeterRmsMs   = LEYLINE_METER_DEFAULT_RMS_MS;
+            }
         }
-        renderPortUnk->Release();
     }
 
-    PUNKNOWN capturePortUnk = nullptr;
-    status = capturePort->QueryInterface(IID_IUnknown, (PVOID*)&capturePortUnk);
-    if (NT_SUCCESS(status))
+    // Cable by cable: its four subdevices, then the two bridges between them.
+    for (ULONG cable = 0; cable < devExt->CableCount && NT_SUCCESS(status); ++cable)
     {
-        PUNKNOWN captureTopoPortUnk = nullptr;
-        status = captureTopoPort->QueryInterface(IID_IUnknown, (PVOID*)&captureTopoPortUnk);
-        if (NT_SUCCESS(status))
+        const ULONG base = cable * EndpointFilter_Count;
+        PPORT ports[EndpointFilter_Count] = {};
+
+        for (ULONG k = 0; k < EndpointFilter_Count && NT_SUCCESS(status); ++k)
+            status = CreateSubdevice(DeviceObject, Irp, ResourceList, devExt, s_Endpoints.Subdevices[base + k], &ports[k]);
+
+        for (ULONG l = cable * 2; l < cable * 2 + 2 && NT_SUCCESS(status); ++l)
         {
-            PcRegisterPhysicalConnection(DeviceObject, captureTopoPortUnk, 1, capturePortUnk, 1);
-            captureTopoPortUnk->Release();
+            const EndpointLink& link = s_Endpoints.Links[l];
+            status = ConnectSubdevices(DeviceObject, ports[link.FromSubdevice - base], link.FromPin,
+                                       ports[link.ToSubdevice - base], link.ToPin);
         }
-        capturePortUnk->Release();
+
+        for (PPORT port : ports)
+            if (port) port->Release();
     }
+    if (!NT_SUCCESS(status)) return status;
 
     // CDO Creation
     g_FunctionalDeviceObject = DeviceObject;
@@ -279,25 +819,22 @@ extern "C" NTSTATUS NTAPI StartDevice(PDEVICE_OBJECT DeviceObject, PIRP Irp, PRE
             // Hook dispatch routines
             s_OriginalDispatchCreate  = DeviceObject->DriverObject->MajorFunction[IRP_MJ_CREATE];
             s_OriginalDispatchClose   = DeviceObject->DriverObject->MajorFunction[IRP_MJ_CLOSE];
+            s_OriginalDispatchCleanup = DeviceObject->DriverObject->MajorFunction[IRP_MJ_CLEANUP];
             s_OriginalDispatchControl = DeviceObject->DriverObject->MajorFunction[IRP_MJ_DEVICE_CONTROL];
 
             DeviceObject->DriverObject->MajorFunction[IRP_MJ_CREATE]         = DispatchCreate;
             DeviceObject->DriverObject->MajorFunction[IRP_MJ_CLOSE]          = DispatchClose;
+            DeviceObject->DriverObject->MajorFunction[IRP_MJ_CLEANUP]        = DispatchCleanup;
             DeviceObject->DriverObject->MajorFunction[IRP_MJ_DEVICE_CONTROL] = DispatchDeviceControl;
         }
     }
 
-Cleanup:
-    if (renderPort) renderPort->Release();
-    if (capturePort) capturePort->Release();
-    if (renderTopoPort) renderTopoPort->Release();
-    if (captureTopoPort) captureTopoPort->Release();
-
     return status;
 }
 
 extern "C" NTSTATUS NTAPI AddDevice(PDRIVER_OBJECT DriverObject, PDEVICE_OBJECT PhysicalDeviceObject)
 {
     ULONG extensionSize = (ULONG)(PORT_CLASS_DEVICE_EXTENSION_SIZE + sizeof(DeviceExtension));
-    return PcAddAdapterDevice(DriverObject, PhysicalDeviceObject, StartDevice, 10, extensionSize);
+    return PcAddAdapterDevice(DriverObject, PhysicalDeviceObject, StartDevice,
+                              EndpointFilter_Count * LEYLINE_MAX_CABLES, extensionSize);
 }
@@ -56,6 +56,8 @@ static const PCPROPERTY_ITEM g_PinProperties[] =
       KSPROPERTY_TYPE_GET | KSPROPERTY_TYPE_BASICSUPPORT, JackDescriptionHandler },
     { &KSPROPSETID_Jack, KSPROPERTY_JACK_DESCRIPTION2,
       KSPROPERTY_TYPE_GET | KSPROPERTY_TYPE_BASICSUPPORT, JackDescriptionHandler },
+    { &KSPROPSETID_Audio, KSPROPERTY_AUDIO_WAVERT_CURRENT_WRITE_POSITION,
+      KSPROPERTY_TYPE_SET | KSPROPERTY_TYPE_BASICSUPPORT, WritePositionHandler },
 };
 
 static const PCPROPERTY_ITEM g_VolumeProperties[] =
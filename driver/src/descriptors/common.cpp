@@ -20,7 +20,7 @@ const KSDATARANGE_AUDIO_CUSTOM g_PcmDataRange =
         STATICGUIDOF(KSDATAFORMAT_SUBTYPE_PCM),
         STATICGUIDOF(KSDATAFORMAT_SPECIFIER_WAVEFORMATEX)
     },
-    2, 8, 32, 8000, 192000
+    LEYLINE_WAVE_MAX_CHANNELS, 8, 32, 8000, 192000
 };
 
 const KSDATARANGE_AUDIO_CUSTOM g_FloatDataRange =
@@ -31,7 +31,7 @@ const KSDATARANGE_AUDIO_CUSTOM g_FloatDataRange =
         STATICGUIDOF(KSDATAFORMAT_SUBTYPE_IEEE_FLOAT),
         STATICGUIDOF(KSDATAFORMAT_SPECIFIER_WAVEFORMATEX)
     },
-    2, 8, 32, 8000, 192000
+    LEYLINE_WAVE_MAX_CHANNELS, 8, 32, 8000, 192000
 };
 
 const KSDATARANGE g_BridgeDataRange =
@@ -49,7 +49,7 @@ const KSDATARANGE * const g_BridgeDataRanges[1] = { &g_BridgeDataRange };
 // INTERFACES
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-const KSIDENTIFIER g_KsInterfaces[] =
+const KSIDENTIFIER g_KsInterfaces[1] =
 {
     { STATICGUIDOF(KSINTERFACESETID_Standard), KSINTERFACE_STANDARD_STREAMING, 0 },
 };
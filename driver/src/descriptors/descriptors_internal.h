@@ -28,30 +28,18 @@ extern const PCAUTOMATION_TABLE g_VolumeAutomationTable;
 extern const PCAUTOMATION_TABLE g_MuteAutomationTable;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// PINS & NODES
+// NODES & CATEGORIES
+// Sized, so filters.cpp can count them at compile time.
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-extern const PCNODE_DESCRIPTOR      g_TopoNodes[];
-extern const PCPIN_DESCRIPTOR       g_WaveRenderPins[];
-extern const PCPIN_DESCRIPTOR       g_WaveCapturePins[];
-extern const PCPIN_DESCRIPTOR       g_TopoRenderPins[];
-extern const PCPIN_DESCRIPTOR       g_TopoCapturePins[];
+extern const PCNODE_DESCRIPTOR      g_TopoNodes[2];
 
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// CONNECTIONS & CATEGORIES
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-
-extern const PCCONNECTION_DESCRIPTOR g_WaveConnections[];
-extern const PCCONNECTION_DESCRIPTOR g_WaveCaptureConnections[];
-extern const PCCONNECTION_DESCRIPTOR g_TopoConnections[];
-extern const PCCONNECTION_DESCRIPTOR g_TopoCaptureConnections[];
-
-extern const GUID g_TopoFilterCategories[];
-extern const GUID g_WaveRenderCategories[];
-extern const GUID g_WaveCaptureCategories[];
+extern const GUID g_TopoFilterCategories[2];
+extern const GUID g_WaveRenderCategories[3];
+extern const GUID g_WaveCaptureCategories[3];
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // COMMON DATA
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-extern const KSIDENTIFIER g_KsInterfaces[];
+extern const KSIDENTIFIER g_KsInterfaces[1];
@@ -3,43 +3,48 @@
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // FILTER DESCRIPTORS
-// Combined PortCls descriptors for all virtual audio filters.
+// The four filter shapes, generated from the shared tables by leyline_endpoints.h.
+// Every cable's subdevices use the same descriptors.
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 #include "descriptors_internal.h"
 
-const PCFILTER_DESCRIPTOR g_WaveRenderFilterDescriptor =
+struct DriverTables
 {
-    0, &g_WaveFilterAutomationTable,
-    sizeof(PCPIN_DESCRIPTOR), SIZEOF_ARRAY(g_WaveRenderPins), g_WaveRenderPins,
-    0, 0, nullptr,
-    SIZEOF_ARRAY(g_WaveConnections), g_WaveConnections,
-    SIZEOF_ARRAY(g_WaveRenderCategories), g_WaveRenderCategories
-};
+    static constexpr const PCAUTOMATION_TABLE* PinAutomation        = &g_PinAutomationTable;
+    static constexpr const PCAUTOMATION_TABLE* WaveFilterAutomation = &g_WaveFilterAutomationTable;
+    static constexpr const PCAUTOMATION_TABLE* TopoFilterAutomation = &g_TopoFilterAutomationTable;
 
-const PCFILTER_DESCRIPTOR g_WaveCaptureFilterDescriptor =
-{
-    0, &g_WaveFilterAutomationTable,
-    sizeof(PCPIN_DESCRIPTOR), SIZEOF_ARRAY(g_WaveCapturePins), g_WaveCapturePins,
-    0, 0, nullptr,
-    SIZEOF_ARRAY(g_WaveCaptureConnections), g_WaveCaptureConnections,
-    SIZEOF_ARRAY(g_WaveCaptureCategories), g_WaveCaptureCategories
-};
+    static constexpr const KSPIN_INTERFACE* Interfaces       = g_KsInterfaces;
+    static constexpr ULONG                  InterfaceCount   = SIZEOF_ARRAY(g_KsInterfaces);
+    static constexpr const PKSDATARANGE*    WaveRanges       = (const PKSDATARANGE*)g_WaveDataRanges;
+    static constexpr ULONG                  WaveRangeCount   = SIZEOF_ARRAY(g_WaveDataRanges);
+    static constexpr const PKSDATARANGE*    BridgeRanges     = (const PKSDATARANGE*)g_BridgeDataRanges;
+    static constexpr ULONG                  BridgeRangeCount = SIZEOF_ARRAY(g_BridgeDataRanges);
 
-const PCFILTER_DESCRIPTOR g_TopoRenderFilterDescriptor =
-{
-    0, &g_TopoFilterAutomationTable,
-    sizeof(PCPIN_DESCRIPTOR), SIZEOF_ARRAY(g_TopoRenderPins), g_TopoRenderPins,
-    sizeof(PCNODE_DESCRIPTOR), SIZEOF_ARRAY(g_TopoNodes), g_TopoNodes,
-    SIZEOF_ARRAY(g_TopoConnections), g_TopoConnections,
-    SIZEOF_ARRAY(g_TopoFilterCategories), g_TopoFilterCategories
+    static constexpr const PCNODE_DESCRIPTOR* Nodes     = g_TopoNodes;
+    static constexpr ULONG                    NodeCount = SIZEOF_ARRAY(g_TopoNodes);
+
+    static constexpr const GUID* AudioCategory      = &KSCATEGORY_AUDIO;
+    static constexpr const GUID* SpeakerCategory    = &KSNODETYPE_SPEAKER;
+    static constexpr const GUID* MicrophoneCategory = &KSNODETYPE_MICROPHONE;
+
+    static constexpr const GUID* WaveRenderCategories     = g_WaveRenderCategories;
+    static constexpr ULONG       WaveRenderCategoryCount  = SIZEOF_ARRAY(g_WaveRenderCategories);
+    static constexpr const GUID* WaveCaptureCategories    = g_WaveCaptureCategories;
+    static constexpr ULONG       WaveCaptureCategoryCount = SIZEOF_ARRAY(g_WaveCaptureCategories);
+    static constexpr const GUID* TopologyCategories       = g_TopoFilterCategories;
+    static constexpr ULONG       TopologyCategoryCount    = SIZEOF_ARRAY(g_TopoFilterCategories);
 };
 
-const PCFILTER_DESCRIPTOR g_TopoCaptureFilterDescriptor =
+const PCFILTER_DESCRIPTOR* EndpointFilterDescriptor(EndpointFilterKind Kind)
 {
-    0, &g_TopoFilterAutomationTable,
-    sizeof(PCPIN_DESCRIPTOR), SIZEOF_ARRAY(g_TopoCapturePins), g_TopoCapturePins,
-    sizeof(PCNODE_DESCRIPTOR), SIZEOF_ARRAY(g_TopoNodes), g_TopoNodes,
-    SIZEOF_ARRAY(g_TopoCaptureConnections), g_TopoCaptureConnections,
-    SIZEOF_ARRAY(g_TopoFilterCategories), g_TopoFilterCategories
-};
+    switch (Kind)
+    {
+    case EndpointFilter_WaveRender:  return &EndpointFilter<DriverTables, EndpointFilter_WaveRender>::Descriptor;
+    case EndpointFilter_WaveCapture: return &EndpointFilter<DriverTables, EndpointFilter_WaveCapture>::Descriptor;
+    case EndpointFilter_TopoRender:  return &EndpointFilter<DriverTables, EndpointFilter_TopoRender>::Descriptor;
+    case EndpointFilter_TopoCapture: return &EndpointFilter<DriverTables, EndpointFilter_TopoCapture>::Descriptor;
+    default:                         return nullptr;
+    }
+}
@@ -7,6 +7,15 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 #include "descriptors_internal.h"
+#include "leyline_miniport.h"
+
+// Node properties arrive with the topology miniport as the major target.
+static ChannelControls* NodeControls(PPCPROPERTY_REQUEST PropertyRequest)
+{
+    if (!PropertyRequest->MajorTarget) return nullptr;
+    auto *topo = static_cast<CMiniportTopology*>(reinterpret_cast<IMiniportTopology*>(PropertyRequest->MajorTarget));
+    return topo->GetControls();
+}
 
 NTSTATUS ComponentIdHandler(PPCPROPERTY_REQUEST PropertyRequest)
 {
@@ -128,9 +137,9 @@ NTSTATUS VolumeHandler(PPCPROPERTY_REQUEST PropertyRequest)
                 v->hdr.MembersSize   = sizeof(KSPROPERTY_STEPPING_LONG);
                 v->hdr.MembersCount  = 1;
                 v->hdr.Flags         = 0;
-                v->stepping.Bounds.SignedMinimum  = -96 * 0x10000;
-                v->stepping.Bounds.SignedMaximum  = 0;
-                v->stepping.SteppingDelta  = 0x10000;
+                v->stepping.Bounds.SignedMinimum  = LEYLINE_VOLUME_MIN_DB;
+                v->stepping.Bounds.SignedMaximum  = LEYLINE_VOLUME_MAX_DB;
+                v->stepping.SteppingDelta  = LEYLINE_VOLUME_STEP_DB;
                 v->stepping.Reserved       = 0;
             }
             PropertyRequest->ValueSize = fullSize;
@@ -146,20 +155,7 @@ NTSTATUS VolumeHandler(PPCPROPERTY_REQUEST PropertyRequest)
         return STATUS_BUFFER_TOO_SMALL;
     }
 
-    if (PropertyRequest->ValueSize == 0)
-    {
-        PropertyRequest->ValueSize = sizeof(LONG);
-        return STATUS_BUFFER_OVERFLOW;
-    }
-    if (PropertyRequest->ValueSize < sizeof(LONG))
-        return STATUS_BUFFER_TOO_SMALL;
-
-    if (PropertyRequest->Verb & KSPROPERTY_TYPE_GET)
-    {
-        auto *val = reinterpret_cast<LONG*>(PropertyRequest->Value);
-        if (val) *val = 0;  // 0 dB default
-    }
-    return STATUS_SUCCESS;
+    return HandleChannelProperty(NodeControls(PropertyRequest), PropertyRequest, ChannelProperty_Volume);
 }
 
 NTSTATUS MuteHandler(PPCPROPERTY_REQUEST PropertyRequest)
@@ -171,15 +167,7 @@ NTSTATUS MuteHandler(PPCPROPERTY_REQUEST PropertyRequest)
     if (PropertyRequest->Verb & KSPROPERTY_TYPE_BASICSUPPORT)
         return HandleBasicSupportFull(PropertyRequest, rwFlags, VT_BOOL);
 
-    if (PropertyRequest->ValueSize == 0) { PropertyRequest->ValueSize = sizeof(LONG); return STATUS_BUFFER_OVERFLOW; }
-    if (PropertyRequest->ValueSize < sizeof(LONG)) return STATUS_BUFFER_TOO_SMALL;
-
-    if (PropertyRequest->Verb & KSPROPERTY_TYPE_GET)
-    {
-        auto *val = reinterpret_cast<LONG*>(PropertyRequest->Value);
-        if (val) *val = 0;  // Unmuted by default.
-    }
-    return STATUS_SUCCESS;
+    return HandleChannelProperty(NodeControls(PropertyRequest), PropertyRequest, ChannelProperty_Mute);
 }
 
 NTSTATUS PinCategoryHandler(PPCPROPERTY_REQUEST PropertyRequest)
@@ -228,6 +216,15 @@ NTSTATUS PinNameHandler(PPCPROPERTY_REQUEST PropertyRequest)
     return STATUS_SUCCESS;
 }
 
+// Filter properties arrive with the wave miniport as the major target.
+static CMiniportWaveRT* WaveMiniport(PPCPROPERTY_REQUEST PropertyRequest)
+{
+    if (!PropertyRequest->MajorTarget) return nullptr;
+    return static_cast<CMiniportWaveRT*>(reinterpret_cast<IMiniportWaveRT*>(PropertyRequest->MajorTarget));
+}
+
+// SET remembers a format the wave pins admit for DataRangeIntersection to lean
+// towards; GET returns it, or the preferred format until one was set.
 NTSTATUS ProposedFormatHandler(PPCPROPERTY_REQUEST PropertyRequest)
 {
     if (!PropertyRequest || !PropertyRequest->PropertyItem) return STATUS_INVALID_PARAMETER;
@@ -237,49 +234,54 @@ NTSTATUS ProposedFormatHandler(PPCPROPERTY_REQUEST PropertyRequest)
     if (PropertyRequest->Verb & KSPROPERTY_TYPE_BASICSUPPORT)
         return HandleBasicSupportFull(PropertyRequest, rwFlags, VT_I4);
 
+    CMiniportWaveRT* miniport = WaveMiniport(PropertyRequest);
+    if (!miniport) return STATUS_INVALID_DEVICE_REQUEST;
+
     if (PropertyRequest->Verb & KSPROPERTY_TYPE_SET)
-        return STATUS_SUCCESS;
+    {
+        if (!PropertyRequest->Value || PropertyRequest->ValueSize < sizeof(KSDATAFORMAT)) return STATUS_BUFFER_TOO_SMALL;
+
+        WaveFormat format;
+        NTSTATUS status = FormatIntersection::Parse(reinterpret_cast<PKSDATAFORMAT>(PropertyRequest->Value),
+                                                    PropertyRequest->ValueSize, &format);
+        if (!NT_SUCCESS(status)) return status;
+        return miniport->SetProposedFormat(format);
+    }
 
     if (PropertyRequest->Verb & KSPROPERTY_TYPE_GET)
     {
-        struct KSDATAFORMAT_WAVEFORMATEXTENSIBLE_LOCAL
-        {
-            KSDATAFORMAT        DataFormat;
-            WAVEFORMATEXTENSIBLE WaveFormatExt;
-        };
-
-        ULONG fmtSize = sizeof(KSDATAFORMAT_WAVEFORMATEXTENSIBLE_LOCAL);
+        ULONG fmtSize = FormatIntersection::FormatSize(TRUE);
         if (PropertyRequest->ValueSize == 0) { PropertyRequest->ValueSize = fmtSize; return STATUS_BUFFER_OVERFLOW; }
         if (PropertyRequest->ValueSize < fmtSize) return STATUS_BUFFER_TOO_SMALL;
 
-        auto *r = reinterpret_cast<KSDATAFORMAT_WAVEFORMATEXTENSIBLE_LOCAL*>(PropertyRequest->Value);
-        if (r)
-        {
-            r->DataFormat.FormatSize  = fmtSize;
-            r->DataFormat.Flags       = 0;
-            r->DataFormat.SampleSize  = 4;
-            r->DataFormat.Reserved    = 0;
-            r->DataFormat.MajorFormat = KSDATAFORMAT_TYPE_AUDIO;
-            r->DataFormat.SubFormat   = KSDATAFORMAT_SUBTYPE_PCM;
-            r->DataFormat.Specifier   = KSDATAFORMAT_SPECIFIER_WAVEFORMATEXTENSIBLE;
-
-            r->WaveFormatExt.Format.wFormatTag      = WAVE_FORMAT_EXTENSIBLE;
-            r->WaveFormatExt.Format.nChannels        = 2;
-            r->WaveFormatExt.Format.nSamplesPerSec   = 48000;
-            r->WaveFormatExt.Format.wBitsPerSample   = 16;
-            r->WaveFormatExt.Format.nBlockAlign      = 4;
-            r->WaveFormatExt.Format.nAvgBytesPerSec  = 48000 * 4;
-            r->WaveFormatExt.Format.cbSize            = 22;
-            r->WaveFormatExt.Samples.wValidBitsPerSample = 16;
-            r->WaveFormatExt.dwChannelMask            = KSAUDIO_SPEAKER_STEREO;
-            r->WaveFormatExt.SubFormat               = KSDATAFORMAT_SUBTYPE_PCM;
-        }
+        WaveFormat format;
+        if (!miniport->GetProposedFormat(&format)) format = FormatIntersection::Preferred(FALSE);
+        if (PropertyRequest->Value)
+            FormatIntersection::Build(format, TRUE, KSDATAFORMAT_SPECIFIER_WAVEFORMATEXTENSIBLE, PropertyRequest->Value);
         PropertyRequest->ValueSize = fmtSize;
         return STATUS_SUCCESS;
     }
     return STATUS_SUCCESS;
 }
 
+// Pin instance properties arrive with the stream as the minor target. The audio
+// engine sets the write position after each buffer it fills; the stream checks it
+// against play to count underruns.
+NTSTATUS WritePositionHandler(PPCPROPERTY_REQUEST PropertyRequest)
+{
+    if (!PropertyRequest || !PropertyRequest->PropertyItem) return STATUS_INVALID_PARAMETER;
+
+    if (PropertyRequest->Verb & KSPROPERTY_TYPE_BASICSUPPORT)
+        return HandleBasicSupportFull(PropertyRequest, KSPROPERTY_TYPE_SET | KSPROPERTY_TYPE_BASICSUPPORT, VT_UI4);
+
+    if (!(PropertyRequest->Verb & KSPROPERTY_TYPE_SET)) return STATUS_INVALID_DEVICE_REQUEST;
+    if (!PropertyRequest->MinorTarget) return STATUS_INVALID_DEVICE_REQUEST;
+    if (!PropertyRequest->Value || PropertyRequest->ValueSize < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+
+    auto *stream = static_cast<CMiniportWaveRTStream*>(reinterpret_cast<IMiniportWaveRTStream*>(PropertyRequest->MinorTarget));
+    return stream->SetClientWritePosition(*reinterpret_cast<const ULONG*>(PropertyRequest->Value));
+}
+
 NTSTATUS AudioEffectsDiscoveryHandler(PPCPROPERTY_REQUEST PropertyRequest)
 {
     if (!PropertyRequest || !PropertyRequest->PropertyItem) return STATUS_INVALID_PARAMETER;
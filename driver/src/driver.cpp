@@ -14,6 +14,28 @@ extern PDEVICE_OBJECT g_ControlDeviceObject;
 extern ULONGLONG      g_EtwRegHandle;
 extern "C" NTSTATUS NTAPI AddDevice(PDRIVER_OBJECT, PDEVICE_OBJECT);
 
+// Zeroed until a session enables it; see leyline_trace.h.
+TraceProvider g_Trace;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ETW
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static NTSTATUS EtwSink(PVOID Context, PCEVENT_DESCRIPTOR Descriptor, ULONG Count, PEVENT_DATA_DESCRIPTOR Data)
+{
+    return EtwWrite(*static_cast<REGHANDLE*>(Context), Descriptor, nullptr, Count, Data);
+}
+
+// Keeps g_Trace's enabled set in step with the sessions listening. A capture-state
+// request changes nothing: the events describe transitions, not state to replay.
+static VOID NTAPI EtwEnableCallback(LPCGUID /*SourceId*/, ULONG ControlCode, UCHAR Level, ULONGLONG MatchAnyKeyword,
+                                    ULONGLONG /*MatchAllKeyword*/, PEVENT_FILTER_DESCRIPTOR /*FilterData*/,
+                                    PVOID /*CallbackContext*/)
+{
+    if (ControlCode == EVENT_CONTROL_CODE_ENABLE_PROVIDER)       g_Trace.Enable(Level, MatchAnyKeyword);
+    else if (ControlCode == EVENT_CONTROL_CODE_DISABLE_PROVIDER) g_Trace.Disable();
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // DriverUnload
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -27,12 +49,21 @@ static void NTAPI DriverUnload(PDRIVER_OBJECT /*DriverObject*/)
         DeviceExtension *ext = GetDeviceExtension(g_FunctionalDeviceObject);
         if (ext)
         {
-            if (ext->LoopbackMdl)
+            for (ULONG i = 0; i < ext->CableCount; ++i)
             {
-                if (ext->LoopbackBuffer) MmUnmapLockedPages(ext->LoopbackBuffer, ext->LoopbackMdl);
-                MmFreePagesFromMdl(ext->LoopbackMdl);
-                IoFreeMdl(ext->LoopbackMdl);
-                ext->LoopbackMdl = nullptr;
+                CableEndpoint *cable = ext->Cables[i];
+                if (!cable) continue;
+                if (cable->LoopbackMdl)
+                {
+                    if (cable->LoopbackBuffer) MmUnmapLockedPages(cable->LoopbackBuffer, cable->LoopbackMdl);
+                    MmFreePagesFromMdl(cable->LoopbackMdl);
+                    IoFreeMdl(cable->LoopbackMdl);
+                    cable->LoopbackMdl = nullptr;
+                }
+                ObjectHeap::Free(cable->CablePlanesStorage);
+                ObjectHeap::Free(cable->Probe);
+                ObjectHeap::Free(cable);
+                ext->Cables[i] = nullptr;
             }
             if (ext->SharedParamsMdl)
             {
@@ -41,6 +72,33 @@ static void NTAPI DriverUnload(PDRIVER_OBJECT /*DriverObject*/)
                 IoFreeMdl(ext->SharedParamsMdl);
                 ext->SharedParamsMdl = nullptr;
             }
+
+            // Every stream is gone, so every block is back in the pool.
+            if (ext->AudioBuffers.IsReady())
+            {
+                LockedPageSource *pages = static_cast<LockedPageSource*>(ext->AudioBuffers.GetSource());
+                ext->AudioBuffers.Shutdown();
+                delete pages;
+            }
+
+            // Routes still set hold their slot's reference, and nothing else does.
+            for (ULONG i = 0; i < LEYLINE_ROUTE_SLOTS; ++i)
+            {
+                ObjectHeap::Free(ext->Routes[i]);
+                ext->Routes[i] = nullptr;
+            }
+
+            // Everything the driver allocated has been freed by now; a tag still
+            // live here is a leak.
+            ext->Objects.Shutdown();
+            LeylineObjectStats objects;
+            ext->Objects.GetStats(&objects);
+            for (ULONG t = 0; t < objects.Tags; ++t)
+            {
+                if (objects.Tag[t].Live)
+                    DbgPrint("Leyline: %u object(s) leaked under tag %.4s\n", objects.Tag[t].Live,
+                             reinterpret_cast<const char*>(&objects.Tag[t].Tag));
+            }
         }
     }
 
@@ -56,6 +114,7 @@ static void NTAPI DriverUnload(PDRIVER_OBJECT /*DriverObject*/)
 
     if (g_EtwRegHandle)
     {
+        g_Trace.Disable();
         EtwUnregister(g_EtwRegHandle);
         g_EtwRegHandle = 0;
     }
@@ -69,7 +128,8 @@ extern "C" NTSTATUS DriverEntry(PDRIVER_OBJECT DriverObject, PUNICODE_STRING Reg
 {
     DbgPrint("Leyline: DriverEntry v0.1.0\n");
 
-    EtwRegister(&ETW_PROVIDER_GUID, nullptr, nullptr, &g_EtwRegHandle);
+    g_Trace.Attach(EtwSink, &g_EtwRegHandle);
+    EtwRegister(&ETW_PROVIDER_GUID, EtwEnableCallback, nullptr, &g_EtwRegHandle);
 
     DriverObject->DriverUnload = DriverUnload;
 
@@ -77,6 +137,12 @@ extern "C" NTSTATUS DriverEntry(PDRIVER_OBJECT DriverObject, PUNICODE_STRING Reg
     if (!NT_SUCCESS(status))
     {
         DbgPrint("Leyline: PcInitializeAdapterDriver FAILED 0x%X\n", status);
+        if (g_EtwRegHandle)
+        {
+            g_Trace.Disable();
+            EtwUnregister(g_EtwRegHandle);
+            g_EtwRegHandle = 0;
+        }
         return status;
     }
 
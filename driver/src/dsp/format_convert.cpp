@@ -0,0 +1,628 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SAMPLE FORMAT CONVERSION KERNELS
+// Scalar reference, SSE2 and AVX2 decode (format -> float) and encode (float ->
+// format) kernels. The SIMD kernels perform the same IEEE operations in the same
+// order as the scalar ones (no FMA), which is what makes them bit-exact.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "leyline_format.h"
+
+#include <immintrin.h>
+#if !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+#if defined(_MSC_VER)
+#define LEYLINE_TARGET_AVX2
+#else
+#define LEYLINE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+    // Scale, clamp range and dither applicability per integer destination.
+    struct IntTarget
+    {
+        float Scale;
+        float Low;
+        float High;
+    };
+
+    const IntTarget kPcm8  = { 128.0f,        -128.0f,        127.0f };
+    const IntTarget kPcm16 = { 32768.0f,      -32768.0f,      32767.0f };
+    const IntTarget kPcm24 = { 8388608.0f,    -8388608.0f,    8388607.0f };
+    // 2^31 - 128 is the largest float below 2^31.
+    const IntTarget kPcm32 = { 2147483648.0f, -2147483648.0f, 2147483520.0f };
+
+    const float kInv8  = 1.0f / 128.0f;
+    const float kInv16 = 1.0f / 32768.0f;
+    const float kInv24 = 1.0f / 8388608.0f;
+    const float kInv32 = 1.0f / 2147483648.0f;
+    const float kDitherScale = 1.0f / 65536.0f;
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // SCALAR REFERENCE
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    inline ULONG NextDither(ULONG* lane)
+    {
+        ULONG x = *lane;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        *lane = x;
+        return x;
+    }
+
+    // Sum of two 16-bit uniforms: triangular over (-1, 1) LSB.
+    inline float TpdfSample(ULONG* lane)
+    {
+        ULONG r = NextDither(lane);
+        LONG  t = (LONG)((r & 0xFFFF) + (r >> 16)) - 65535;
+        return (float)t * kDitherScale;
+    }
+
+    // maxps/minps semantics (a NaN input yields the bound), then round to nearest-even
+    // as cvtps2dq does under the default MXCSR.
+    inline LONG ClampRound(float y, const IntTarget& t)
+    {
+        y = (y > t.Low) ? y : t.Low;
+        y = (y < t.High) ? y : t.High;
+        if (y >= 0.0f)
+        {
+            if (y < 8388608.0f) y = (y + 8388608.0f) - 8388608.0f;
+        }
+        else if (y > -8388608.0f)
+        {
+            y = (y - 8388608.0f) + 8388608.0f;
+        }
+        return (LONG)y;
+    }
+
+    inline LONG EncodeOne(const float* src, SIZE_T i, const IntTarget& t, ULONG* lanes)
+    {
+        float y = src[i] * t.Scale;
+        if (lanes) y = y + TpdfSample(&lanes[i & 7]);
+        return ClampRound(y, t);
+    }
+
+    inline LONG Load24(const UCHAR* p)
+    {
+        return (LONG)(((ULONG)p[0] << 8) | ((ULONG)p[1] << 16) | ((ULONG)p[2] << 24)) >> 8;
+    }
+
+    inline void Store24(UCHAR* p, LONG v)
+    {
+        p[0] = (UCHAR)v;
+        p[1] = (UCHAR)(v >> 8);
+        p[2] = (UCHAR)(v >> 16);
+    }
+
+    void DecodePcm8Scalar(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        for (SIZE_T i = 0; i < n; ++i) dst[i] = (float)((LONG)src[i] - 128) * kInv8;
+    }
+
+    void DecodePcm16Scalar(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const SHORT* s = reinterpret_cast<const SHORT*>(src);
+        for (SIZE_T i = 0; i < n; ++i) dst[i] = (float)s[i] * kInv16;
+    }
+
+    void DecodePcm24Scalar(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        for (SIZE_T i = 0; i < n; ++i) dst[i] = (float)Load24(src + 3 * i) * kInv24;
+    }
+
+    void DecodePcm32Scalar(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const LONG* s = reinterpret_cast<const LONG*>(src);
+        for (SIZE_T i = 0; i < n; ++i) dst[i] = (float)s[i] * kInv32;
+    }
+
+    void DecodeFloatScalar(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        RtlCopyMemory(dst, src, n * sizeof(float));
+    }
+
+    void EncodePcm8Scalar(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        for (SIZE_T i = 0; i < n; ++i) dst[i] = (UCHAR)(EncodeOne(src, i, kPcm8, lanes) + 128);
+    }
+
+    void EncodePcm16Scalar(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        SHORT* d = reinterpret_cast<SHORT*>(dst);
+        for (SIZE_T i = 0; i < n; ++i) d[i] = (SHORT)EncodeOne(src, i, kPcm16, lanes);
+    }
+
+    void EncodePcm24Scalar(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        for (SIZE_T i = 0; i < n; ++i) Store24(dst + 3 * i, EncodeOne(src, i, kPcm24, lanes));
+    }
+
+    void EncodePcm32Scalar(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        LONG* d = reinterpret_cast<LONG*>(dst);
+        for (SIZE_T i = 0; i < n; ++i) d[i] = EncodeOne(src, i, kPcm32, lanes);
+    }
+
+    void EncodeFloatScalar(const float* src, UCHAR* dst, SIZE_T n, ULONG* /*lanes*/)
+    {
+        RtlCopyMemory(dst, src, n * sizeof(float));
+    }
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // SSE2
+    // Eight samples per iteration (two registers), matching the eight dither lanes;
+    // the remainder goes through the scalar code with the same lanes.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    inline __m128i NextDither4(__m128i* state)
+    {
+        __m128i x = *state;
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+        *state = x;
+        return x;
+    }
+
+    inline __m128 Tpdf4(__m128i* state)
+    {
+        __m128i r = NextDither4(state);
+        __m128i t = _mm_add_epi32(_mm_and_si128(r, _mm_set1_epi32(0xFFFF)), _mm_srli_epi32(r, 16));
+        t = _mm_sub_epi32(t, _mm_set1_epi32(65535));
+        return _mm_mul_ps(_mm_cvtepi32_ps(t), _mm_set1_ps(kDitherScale));
+    }
+
+    inline __m128i Quantize4(__m128 x, const IntTarget& t, __m128i* lanes)
+    {
+        __m128 y = _mm_mul_ps(x, _mm_set1_ps(t.Scale));
+        if (lanes) y = _mm_add_ps(y, Tpdf4(lanes));
+        y = _mm_max_ps(y, _mm_set1_ps(t.Low));
+        y = _mm_min_ps(y, _mm_set1_ps(t.High));
+        return _mm_cvtps_epi32(y);
+    }
+
+    // Runs `body(i, lanesLo, lanesHi)` over whole groups of eight, then the scalar
+    // `tail` for what is left, with the dither lanes loaded and stored around it.
+    template <typename Body, typename Tail>
+    inline void EncodeLoop8Sse2(SIZE_T n, ULONG* lanes, Body body, Tail tail)
+    {
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        if (lanes)
+        {
+            lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes));
+            hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes + 4));
+        }
+        SIZE_T i = 0;
+        for (; i + 8 <= n; i += 8)
+            body(i, lanes ? &lo : nullptr, lanes ? &hi : nullptr);
+        if (lanes)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + 4), hi);
+        }
+        tail(i);
+    }
+
+    void DecodePcm8Sse2(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi32(128);
+        const __m128  inv  = _mm_set1_ps(kInv8);
+        SIZE_T i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128i b  = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)), zero);
+            __m128i lo = _mm_sub_epi32(_mm_unpacklo_epi16(b, zero), bias);
+            __m128i hi = _mm_sub_epi32(_mm_unpackhi_epi16(b, zero), bias);
+            _mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(lo), inv));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), inv));
+        }
+        DecodePcm8Scalar(src + i, dst + i, n - i);
+    }
+
+    void DecodePcm16Sse2(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const __m128 inv = _mm_set1_ps(kInv16);
+        SIZE_T i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128i s  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+            _mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(lo), inv));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), inv));
+        }
+        DecodePcm16Scalar(src + 2 * i, dst + i, n - i);
+    }
+
+    // SSE2 has no byte shuffle: gather the 24-bit words in scalar code, convert in SIMD.
+    void DecodePcm24Sse2(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const __m128 inv = _mm_set1_ps(kInv24);
+        SIZE_T i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const UCHAR* p = src + 3 * i;
+            __m128i v = _mm_setr_epi32(Load24(p), Load24(p + 3), Load24(p + 6), Load24(p + 9));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), inv));
+        }
+        DecodePcm24Scalar(src + 3 * i, dst + i, n - i);
+    }
+
+    void DecodePcm32Sse2(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const __m128 inv = _mm_set1_ps(kInv32);
+        SIZE_T i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), inv));
+        }
+        DecodePcm32Scalar(src + 4 * i, dst + i, n - i);
+    }
+
+    void EncodePcm8Sse2(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        EncodeLoop8Sse2(n, lanes,
+            [&](SIZE_T i, __m128i* lo, __m128i* hi) {
+                __m128i a = _mm_add_epi32(Quantize4(_mm_loadu_ps(src + i),     kPcm8, lo), _mm_set1_epi32(128));
+                __m128i b = _mm_add_epi32(Quantize4(_mm_loadu_ps(src + i + 4), kPcm8, hi), _mm_set1_epi32(128));
+                __m128i w = _mm_packs_epi32(a, b);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(w, w));
+            },
+            [&](SIZE_T i) { for (; i < n; ++i) dst[i] = (UCHAR)(EncodeOne(src, i, kPcm8, lanes) + 128); });
+    }
+
+    void EncodePcm16Sse2(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        SHORT* d = reinterpret_cast<SHORT*>(dst);
+        EncodeLoop8Sse2(n, lanes,
+            [&](SIZE_T i, __m128i* lo, __m128i* hi) {
+                __m128i a = Quantize4(_mm_loadu_ps(src + i),     kPcm16, lo);
+                __m128i b = Quantize4(_mm_loadu_ps(src + i + 4), kPcm16, hi);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_packs_epi32(a, b));
+            },
+            [&](SIZE_T i) { for (; i < n; ++i) d[i] = (SHORT)EncodeOne(src, i, kPcm16, lanes); });
+    }
+
+    void EncodePcm24Sse2(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        EncodeLoop8Sse2(n, lanes,
+            [&](SIZE_T i, __m128i* lo, __m128i* hi) {
+                alignas(16) LONG v[8];
+                _mm_store_si128(reinterpret_cast<__m128i*>(v),     Quantize4(_mm_loadu_ps(src + i),     kPcm24, lo));
+                _mm_store_si128(reinterpret_cast<__m128i*>(v + 4), Quantize4(_mm_loadu_ps(src + i + 4), kPcm24, hi));
+                for (int k = 0; k < 8; ++k) Store24(dst + 3 * (i + k), v[k]);
+            },
+            [&](SIZE_T i) { for (; i < n; ++i) Store24(dst + 3 * i, EncodeOne(src, i, kPcm24, lanes)); });
+    }
+
+    void EncodePcm32Sse2(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        LONG* d = reinterpret_cast<LONG*>(dst);
+        EncodeLoop8Sse2(n, lanes,
+            [&](SIZE_T i, __m128i* lo, __m128i* hi) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i),     Quantize4(_mm_loadu_ps(src + i),     kPcm32, lo));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i + 4), Quantize4(_mm_loadu_ps(src + i + 4), kPcm32, hi));
+            },
+            [&](SIZE_T i) { for (; i < n; ++i) d[i] = EncodeOne(src, i, kPcm32, lanes); });
+    }
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // AVX2
+    // One 256-bit register holds all eight dither lanes.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    LEYLINE_TARGET_AVX2 inline __m256 Tpdf8(__m256i* state)
+    {
+        __m256i x = *state;
+        x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+        x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+        *state = x;
+        __m256i t = _mm256_add_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0xFFFF)), _mm256_srli_epi32(x, 16));
+        t = _mm256_sub_epi32(t, _mm256_set1_epi32(65535));
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(t), _mm256_set1_ps(kDitherScale));
+    }
+
+    LEYLINE_TARGET_AVX2 inline __m256i Quantize8(__m256 x, const IntTarget& t, __m256i* lanes)
+    {
+        __m256 y = _mm256_mul_ps(x, _mm256_set1_ps(t.Scale));
+        if (lanes) y = _mm256_add_ps(y, Tpdf8(lanes));
+        y = _mm256_max_ps(y, _mm256_set1_ps(t.Low));
+        y = _mm256_min_ps(y, _mm256_set1_ps(t.High));
+        return _mm256_cvtps_epi32(y);
+    }
+
+    template <typename Body, typename Tail>
+    LEYLINE_TARGET_AVX2 inline void EncodeLoop8Avx2(SIZE_T n, ULONG* lanes, Body body, Tail tail)
+    {
+        __m256i state = lanes ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes)) : _mm256_setzero_si256();
+        SIZE_T i = 0;
+        for (; i + 8 <= n; i += 8)
+            body(i, lanes ? &state : nullptr);
+        if (lanes) _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), state);
+        tail(i);
+    }
+
+    LEYLINE_TARGET_AVX2 void DecodePcm8Avx2(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const __m256i bias = _mm256_set1_epi32(128);
+        const __m256  inv  = _mm256_set1_ps(kInv8);
+        SIZE_T i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i v = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i))), bias);
+            _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), inv));
+        }
+        DecodePcm8Scalar(src + i, dst + i, n - i);
+    }
+
+    LEYLINE_TARGET_AVX2 void DecodePcm16Avx2(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const __m256 inv = _mm256_set1_ps(kInv16);
+        SIZE_T i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i)));
+            _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), inv));
+        }
+        DecodePcm16Scalar(src + 2 * i, dst + i, n - i);
+    }
+
+    // Eight packed samples are 24 bytes; the 32-byte load is only issued while at
+    // least 32 bytes remain, so it never reads past the source.
+    LEYLINE_TARGET_AVX2 void DecodePcm24Avx2(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const __m256i spread  = _mm256_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5);
+        const __m256i shuffle = _mm256_setr_epi8(
+            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        const __m256 inv = _mm256_set1_ps(kInv24);
+        SIZE_T i = 0;
+        for (; i + 11 <= n; i += 8)
+        {
+            __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 3 * i));
+            __m256i v   = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(raw, spread), shuffle);
+            v = _mm256_srai_epi32(v, 8);
+            _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), inv));
+        }
+        DecodePcm24Scalar(src + 3 * i, dst + i, n - i);
+    }
+
+    LEYLINE_TARGET_AVX2 void DecodePcm32Avx2(const UCHAR* src, float* dst, SIZE_T n)
+    {
+        const __m256 inv = _mm256_set1_ps(kInv32);
+        SIZE_T i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * i));
+            _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), inv));
+        }
+        DecodePcm32Scalar(src + 4 * i, dst + i, n - i);
+    }
+
+    LEYLINE_TARGET_AVX2 void EncodePcm8Avx2(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        EncodeLoop8Avx2(n, lanes,
+            [&](SIZE_T i, __m256i* state) LEYLINE_TARGET_AVX2 {
+                __m256i v = _mm256_add_epi32(Quantize8(_mm256_loadu_ps(src + i), kPcm8, state), _mm256_set1_epi32(128));
+                __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(w, w));
+            },
+            [&](SIZE_T i) { for (; i < n; ++i) dst[i] = (UCHAR)(EncodeOne(src, i, kPcm8, lanes) + 128); });
+    }
+
+    LEYLINE_TARGET_AVX2 void EncodePcm16Avx2(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        SHORT* d = reinterpret_cast<SHORT*>(dst);
+        EncodeLoop8Avx2(n, lanes,
+            [&](SIZE_T i, __m256i* state) LEYLINE_TARGET_AVX2 {
+                __m256i v = Quantize8(_mm256_loadu_ps(src + i), kPcm16, state);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i),
+                                 _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+            },
+            [&](SIZE_T i) { for (; i < n; ++i) d[i] = (SHORT)EncodeOne(src, i, kPcm16, lanes); });
+    }
+
+    // Keep the low three bytes of each word, then close the 4-byte gap between the
+    // two 12-byte halves; exactly 24 bytes are stored.
+    LEYLINE_TARGET_AVX2 void EncodePcm24Avx2(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        const __m256i pack = _mm256_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+        EncodeLoop8Avx2(n, lanes,
+            [&](SIZE_T i, __m256i* state) LEYLINE_TARGET_AVX2 {
+                __m256i v = Quantize8(_mm256_loadu_ps(src + i), kPcm24, state);
+                v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, pack), join);
+                UCHAR* p = dst + 3 * i;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(v));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(p + 16), _mm256_extracti128_si256(v, 1));
+            },
+            [&](SIZE_T i) { for (; i < n; ++i) Store24(dst + 3 * i, EncodeOne(src, i, kPcm24, lanes)); });
+    }
+
+    LEYLINE_TARGET_AVX2 void EncodePcm32Avx2(const float* src, UCHAR* dst, SIZE_T n, ULONG* lanes)
+    {
+        LONG* d = reinterpret_cast<LONG*>(dst);
+        EncodeLoop8Avx2(n, lanes,
+            [&](SIZE_T i, __m256i* state) LEYLINE_TARGET_AVX2 {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i), Quantize8(_mm256_loadu_ps(src + i), kPcm32, state));
+            },
+            [&](SIZE_T i) { for (; i < n; ++i) d[i] = EncodeOne(src, i, kPcm32, lanes); });
+    }
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // KERNEL TABLES
+    // Indexed by [SimdLevel][LeylineSampleFormat].
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    const FormatConverter::DecodeFn kDecoders[3][6] =
+    {
+        { nullptr, DecodePcm8Scalar, DecodePcm16Scalar, DecodePcm24Scalar, DecodePcm32Scalar, DecodeFloatScalar },
+        { nullptr, DecodePcm8Sse2,   DecodePcm16Sse2,   DecodePcm24Sse2,   DecodePcm32Sse2,   DecodeFloatScalar },
+        { nullptr, DecodePcm8Avx2,   DecodePcm16Avx2,   DecodePcm24Avx2,   DecodePcm32Avx2,   DecodeFloatScalar },
+    };
+
+    const FormatConverter::EncodeFn kEncoders[3][6] =
+    {
+        { nullptr, EncodePcm8Scalar, EncodePcm16Scalar, EncodePcm24Scalar, EncodePcm32Scalar, EncodeFloatScalar },
+        { nullptr, EncodePcm8Sse2,   EncodePcm16Sse2,   EncodePcm24Sse2,   EncodePcm32Sse2,   EncodeFloatScalar },
+        { nullptr, EncodePcm8Avx2,   EncodePcm16Avx2,   EncodePcm24Avx2,   EncodePcm32Avx2,   EncodeFloatScalar },
+    };
+
+    // Effective resolution used to decide whether a conversion narrows.
+    ULONG ResolutionBits(LeylineSampleFormat format)
+    {
+        return format == SampleFormat_Float32 ? 25 : SampleFormatBytes(format) * 8;
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CPU DETECTION
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static SimdLevel ProbeSimdLevel()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    BOOLEAN osxsave = (info[2] & (1 << 27)) != 0;
+    BOOLEAN avx     = (info[2] & (1 << 28)) != 0;
+    __cpuidex(info, 7, 0);
+    BOOLEAN avx2    = (info[1] & (1 << 5)) != 0;
+    // The OS must be saving YMM state (XCR0 bits 1 and 2).
+    if (osxsave && avx && avx2 && (_xgetbv(0) & 0x6) == 0x6)
+        return SimdLevel_Avx2;
+#else
+    unsigned a, b, c, d;
+    if (__get_cpuid(1, &a, &b, &c, &d))
+    {
+        BOOLEAN osxsave = (c & (1u << 27)) != 0;
+        BOOLEAN avx     = (c & (1u << 28)) != 0;
+        if (osxsave && avx && __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & (1u << 5)))
+        {
+            unsigned lo, hi;
+            __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            if ((lo & 0x6) == 0x6) return SimdLevel_Avx2;
+        }
+    }
+#endif
+    return SimdLevel_Sse2;      // Baseline on x64.
+}
+
+SimdLevel DetectSimdLevel()
+{
+    static volatile LONG s_Level = -1;
+    LONG level = ReadNoFence(&s_Level);
+    if (level < 0)
+    {
+        level = (LONG)ProbeSimdLevel();
+        WriteNoFence(&s_Level, level);
+    }
+    return (SimdLevel)level;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// FORMAT CONVERTER
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+NTSTATUS FormatConverter::Init(LeylineSampleFormat source, LeylineSampleFormat destination, ULONG flags, SimdLevel level)
+{
+    if (source <= SampleFormat_Unknown || source > SampleFormat_Float32 ||
+        destination <= SampleFormat_Unknown || destination > SampleFormat_Float32 ||
+        level < SimdLevel_Scalar || level > SimdLevel_Avx2)
+        return STATUS_INVALID_PARAMETER;
+
+    m_Source         = source;
+    m_Destination    = destination;
+    m_Level          = level;
+    m_Decode         = kDecoders[level][source];
+    m_Encode         = kEncoders[level][destination];
+    m_FallbackDecode = kDecoders[SimdLevel_Sse2][source];
+    m_FallbackEncode = kEncoders[SimdLevel_Sse2][destination];
+    m_Dither         = (flags & LEYLINE_CONVERT_DITHER) && destination != SampleFormat_Float32 &&
+                       ResolutionBits(destination) < ResolutionBits(source);
+    ResetDither(0x1EE71E);
+    return STATUS_SUCCESS;
+}
+
+void FormatConverter::ResetDither(ULONG seed)
+{
+    // xorshift32 must never hold zero; spread the seed so the lanes are unrelated.
+    for (ULONG i = 0; i < 8; ++i)
+    {
+        ULONG x = (seed + 0x9E3779B9u * (i + 1)) ^ 0xA5A5A5A5u;
+        m_DitherLanes[i] = x ? x : 0x6D2B79F5u;
+    }
+}
+
+void FormatConverter::Run(DecodeFn decode, EncodeFn encode, const UCHAR* src, UCHAR* dst, SIZE_T samples)
+{
+    ULONG* lanes = m_Dither ? m_DitherLanes : nullptr;
+
+    if (m_Destination == SampleFormat_Float32)
+    {
+        decode(src, reinterpret_cast<float*>(dst), samples);
+        return;
+    }
+    if (m_Source == SampleFormat_Float32)
+    {
+        encode(reinterpret_cast<const float*>(src), dst, samples, lanes);
+        return;
+    }
+
+    // The chunk size is a multiple of eight, so sample i of the call keeps drawing
+    // from dither lane i % 8 across chunks.
+    float staging[LEYLINE_CONVERT_CHUNK];
+    const ULONG srcBytes = SampleFormatBytes(m_Source);
+    const ULONG dstBytes = SampleFormatBytes(m_Destination);
+    while (samples)
+    {
+        SIZE_T n = samples < LEYLINE_CONVERT_CHUNK ? samples : LEYLINE_CONVERT_CHUNK;
+        decode(src, staging, n);
+        encode(staging, dst, n, lanes);
+        src     += n * srcBytes;
+        dst     += n * dstBytes;
+        samples -= n;
+    }
+}
+
+void FormatConverter::Convert(const void* src, void* dst, SIZE_T samples)
+{
+    const UCHAR* in  = reinterpret_cast<const UCHAR*>(src);
+    UCHAR*       out = reinterpret_cast<UCHAR*>(dst);
+
+    if (m_Source == m_Destination)
+    {
+        RtlCopyMemory(out, in, samples * SampleFormatBytes(m_Source));
+        return;
+    }
+
+    if (m_Level != SimdLevel_Avx2)
+    {
+        Run(m_Decode, m_Encode, in, out, samples);
+        return;
+    }
+
+    // Kernel code must save the YMM state before touching it; if that fails, the
+    // SSE2 kernels produce the same bytes.
+    XSTATE_SAVE state;
+    if (NT_SUCCESS(KeSaveExtendedProcessorState(XSTATE_MASK_AVX, &state)))
+    {
+        Run(m_Decode, m_Encode, in, out, samples);
+        KeRestoreExtendedProcessorState(&state);
+    }
+    else
+    {
+        Run(m_FallbackDecode, m_FallbackEncode, in, out, samples);
+    }
+}
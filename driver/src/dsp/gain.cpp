@@ -0,0 +1,338 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GAIN STAGE
+// The dB-to-linear table (built at compile time), the scalar, SSE2 and AVX2 scale
+// and ramp kernels, and the ramp bookkeeping.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "leyline_gain.h"
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#define LEYLINE_TARGET_AVX2
+#else
+#define LEYLINE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // dB TABLE
+    // 10^(dB/20) for -96 .. 0 dB in 1/16 dB steps. e^x is halved into [-0.5, 0]
+    // range, summed as a Taylor series and squared back up.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    const ULONG kStepsPerDb = 16;
+    const ULONG kTableSize  = 96 * kStepsPerDb + 1;
+
+    constexpr double ConstExp(double x)
+    {
+        int halvings = 0;
+        while (x < -0.5) { x /= 2.0; ++halvings; }
+
+        double term = 1.0, sum = 1.0;
+        for (int k = 1; k < 20; ++k)
+        {
+            term *= x / k;
+            sum  += term;
+        }
+        while (halvings--) sum *= sum;
+        return sum;
+    }
+
+    struct DbTable
+    {
+        float Linear[kTableSize];
+
+        constexpr DbTable() : Linear()
+        {
+            for (ULONG i = 0; i < kTableSize; ++i)
+            {
+                double db = -96.0 + (double)i / kStepsPerDb;
+                Linear[i] = (float)ConstExp(db * 0.11512925464970228420);     // ln(10) / 20
+            }
+        }
+    };
+
+    constexpr DbTable kDbTable;
+
+    static_assert(kDbTable.Linear[kTableSize - 1] == 1.0f, "0 dB must be exactly unity");
+    static_assert(kDbTable.Linear[kTableSize - 1 - 20 * kStepsPerDb] > 0.0999999f &&
+                  kDbTable.Linear[kTableSize - 1 - 20 * kStepsPerDb] < 0.1000001f, "-20 dB is 0.1");
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // KERNELS
+    // Blocks of `channels` vectors hold whole frames, so vector k of every block
+    // has the same per-lane channels, (k * width + lane) % channels, and the same
+    // frame offsets, (k * width + lane) / channels. The ramp kernels form each
+    // frame index exactly in float and compute start + step * index just like the
+    // scalar loop, which keeps them bit-identical to it.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    void ScaleScalar(float* x, ULONG frames, ULONG channels, const float* gains)
+    {
+        for (ULONG i = 0; i < frames; ++i, x += channels)
+            for (ULONG ch = 0; ch < channels; ++ch)
+                x[ch] *= gains[ch];
+    }
+
+    void RampScalar(float* x, ULONG frames, ULONG channels, const float* start, const float* step)
+    {
+        for (ULONG i = 0; i < frames; ++i, x += channels)
+            for (ULONG ch = 0; ch < channels; ++ch)
+                x[ch] *= start[ch] + step[ch] * (float)i;
+    }
+
+    // Lane patterns for vector k of a block of `width`-wide vectors.
+    void LanePattern(ULONG width, ULONG channels, const float* perChannel, float* lanes)
+    {
+        for (ULONG i = 0; i < width * channels; ++i) lanes[i] = perChannel[i % channels];
+    }
+
+    void LaneFrames(ULONG width, ULONG channels, float* lanes)
+    {
+        for (ULONG i = 0; i < width * channels; ++i) lanes[i] = (float)(i / channels);
+    }
+
+    void ScaleSse2(float* x, ULONG frames, ULONG channels, const float* gains)
+    {
+        DECLSPEC_CACHEALIGN float g[4 * LEYLINE_GAIN_MAX_CHANNELS];
+        LanePattern(4, channels, gains, g);
+
+        const ULONG blocks = frames / 4;
+        for (ULONG b = 0; b < blocks; ++b)
+            for (ULONG k = 0; k < channels; ++k, x += 4)
+                _mm_storeu_ps(x, _mm_mul_ps(_mm_loadu_ps(x), _mm_load_ps(g + 4 * k)));
+
+        ScaleScalar(x, frames - blocks * 4, channels, gains);
+    }
+
+    void RampSse2(float* x, ULONG frames, ULONG channels, const float* start, const float* step)
+    {
+        DECLSPEC_CACHEALIGN float s[4 * LEYLINE_GAIN_MAX_CHANNELS];
+        DECLSPEC_CACHEALIGN float d[4 * LEYLINE_GAIN_MAX_CHANNELS];
+        DECLSPEC_CACHEALIGN float f[4 * LEYLINE_GAIN_MAX_CHANNELS];
+        LanePattern(4, channels, start, s);
+        LanePattern(4, channels, step, d);
+        LaneFrames(4, channels, f);
+
+        const ULONG blocks = frames / 4;
+        for (ULONG b = 0; b < blocks; ++b)
+        {
+            __m128 base = _mm_set1_ps((float)(b * 4));
+            for (ULONG k = 0; k < channels; ++k, x += 4)
+            {
+                __m128 index = _mm_add_ps(_mm_load_ps(f + 4 * k), base);
+                __m128 gain  = _mm_add_ps(_mm_load_ps(s + 4 * k), _mm_mul_ps(_mm_load_ps(d + 4 * k), index));
+                _mm_storeu_ps(x, _mm_mul_ps(_mm_loadu_ps(x), gain));
+            }
+        }
+
+        for (ULONG i = blocks * 4; i < frames; ++i, x += channels)
+            for (ULONG ch = 0; ch < channels; ++ch)
+                x[ch] *= start[ch] + step[ch] * (float)i;
+    }
+
+    LEYLINE_TARGET_AVX2 void ScaleAvx2(float* x, ULONG frames, ULONG channels, const float* gains)
+    {
+        DECLSPEC_CACHEALIGN float g[8 * LEYLINE_GAIN_MAX_CHANNELS];
+        LanePattern(8, channels, gains, g);
+
+        const ULONG blocks = frames / 8;
+        for (ULONG b = 0; b < blocks; ++b)
+            for (ULONG k = 0; k < channels; ++k, x += 8)
+                _mm256_storeu_ps(x, _mm256_mul_ps(_mm256_loadu_ps(x), _mm256_load_ps(g + 8 * k)));
+
+        ScaleScalar(x, frames - blocks * 8, channels, gains);
+    }
+
+    LEYLINE_TARGET_AVX2 void RampAvx2(float* x, ULONG frames, ULONG channels, const float* start, const float* step)
+    {
+        DECLSPEC_CACHEALIGN float s[8 * LEYLINE_GAIN_MAX_CHANNELS];
+        DECLSPEC_CACHEALIGN float d[8 * LEYLINE_GAIN_MAX_CHANNELS];
+        DECLSPEC_CACHEALIGN float f[8 * LEYLINE_GAIN_MAX_CHANNELS];
+        LanePattern(8, channels, start, s);
+        LanePattern(8, channels, step, d);
+        LaneFrames(8, channels, f);
+
+        const ULONG blocks = frames / 8;
+        for (ULONG b = 0; b < blocks; ++b)
+        {
+            __m256 base = _mm256_set1_ps((float)(b * 8));
+            for (ULONG k = 0; k < channels; ++k, x += 8)
+            {
+                __m256 index = _mm256_add_ps(_mm256_load_ps(f + 8 * k), base);
+                __m256 gain  = _mm256_add_ps(_mm256_load_ps(s + 8 * k), _mm256_mul_ps(_mm256_load_ps(d + 8 * k), index));
+                _mm256_storeu_ps(x, _mm256_mul_ps(_mm256_loadu_ps(x), gain));
+            }
+        }
+
+        for (ULONG i = blocks * 8; i < frames; ++i, x += channels)
+            for (ULONG ch = 0; ch < channels; ++ch)
+                x[ch] *= start[ch] + step[ch] * (float)i;
+    }
+
+    const GainStage::ScaleFn kScalers[3] = { ScaleScalar, ScaleSse2, ScaleAvx2 };
+    const GainStage::RampFn  kRamps[3]   = { RampScalar, RampSse2, RampAvx2 };
+}
+
+float DbToLinear(LONG db)
+{
+    if (db <= LEYLINE_VOLUME_MIN_DB) return kDbTable.Linear[0];
+    if (db >= LEYLINE_VOLUME_MAX_DB) return kDbTable.Linear[kTableSize - 1];
+
+    // 16.16 dB to the nearest 1/16 dB step.
+    ULONG offset = (ULONG)(db - LEYLINE_VOLUME_MIN_DB);
+    return kDbTable.Linear[(offset + (0x10000 / kStepsPerDb) / 2) / (0x10000 / kStepsPerDb)];
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GAIN STAGE
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+NTSTATUS GainStage::Init(LeylineSampleFormat format, ULONG channels, ULONG sampleRate, SimdLevel level)
+{
+    if (SampleFormatBytes(format) == 0 || channels == 0 || channels > LEYLINE_GAIN_MAX_CHANNELS ||
+        sampleRate == 0 || level < SimdLevel_Scalar || level > SimdLevel_Avx2)
+        return STATUS_INVALID_PARAMETER;
+
+    if (format != SampleFormat_Float32)
+    {
+        NTSTATUS status = m_Decoder.Init(format, SampleFormat_Float32, 0, level);
+        if (NT_SUCCESS(status))
+            status = m_Encoder.Init(SampleFormat_Float32, format, LEYLINE_CONVERT_DITHER, level);
+        if (!NT_SUCCESS(status)) return status;
+    }
+
+    m_Format        = format;
+    m_Channels      = channels;
+    m_RampFrames    = sampleRate * LEYLINE_GAIN_RAMP_MS / 1000;
+    if (m_RampFrames == 0) m_RampFrames = 1;
+    m_Level         = level;
+    m_Scale         = kScalers[level];
+    m_Ramp          = kRamps[level];
+    m_FallbackScale = kScalers[SimdLevel_Sse2];
+    m_FallbackRamp  = kRamps[SimdLevel_Sse2];
+
+    float unity[LEYLINE_GAIN_MAX_CHANNELS];
+    for (ULONG ch = 0; ch < LEYLINE_GAIN_MAX_CHANNELS; ++ch) unity[ch] = 1.0f;
+    Jump(unity);
+    return STATUS_SUCCESS;
+}
+
+void GainStage::Jump(const float* gains)
+{
+    for (ULONG ch = 0; ch < m_Channels; ++ch) m_Gain[ch] = gains[ch];
+    m_RampPos  = 0;
+    m_RampLeft = 0;
+}
+
+float GainStage::GetGain(ULONG channel) const
+{
+    if (!m_RampLeft) return m_Gain[channel];
+    return m_RampStart[channel] + m_RampStep[channel] * (float)m_RampPos;
+}
+
+BOOLEAN GainStage::IsSilent() const
+{
+    if (m_RampLeft) return FALSE;
+    for (ULONG ch = 0; ch < m_Channels; ++ch)
+        if (m_Gain[ch] != 0.0f) return FALSE;
+    return TRUE;
+}
+
+void GainStage::RampTo(const float* gains)
+{
+    BOOLEAN change = FALSE;
+    for (ULONG ch = 0; ch < m_Channels; ++ch) change |= gains[ch] != m_Gain[ch];
+    if (!change) return;
+
+    for (ULONG ch = 0; ch < m_Channels; ++ch)
+    {
+        float from = GetGain(ch);
+        m_RampStart[ch] = from;
+        m_RampStep[ch]  = (gains[ch] - from) / (float)m_RampFrames;
+    }
+    for (ULONG ch = 0; ch < m_Channels; ++ch) m_Gain[ch] = gains[ch];
+    m_RampPos  = 0;
+    m_RampLeft = m_RampFrames;
+}
+
+// Float frames: the ramp first, then the settled gain for the rest.
+void GainStage::Process(ScaleFn scale, RampFn ramp, float* samples, ULONG frames)
+{
+    if (m_RampLeft)
+    {
+        ULONG n = frames < m_RampLeft ? frames : m_RampLeft;
+        float start[LEYLINE_GAIN_MAX_CHANNELS];
+        for (ULONG ch = 0; ch < m_Channels; ++ch)
+            start[ch] = m_RampStart[ch] + m_RampStep[ch] * (float)m_RampPos;
+        ramp(samples, n, m_Channels, start, m_RampStep);
+
+        m_RampPos  += n;
+        m_RampLeft -= n;
+        samples    += (SIZE_T)n * m_Channels;
+        frames     -= n;
+    }
+    if (frames) scale(samples, frames, m_Channels, m_Gain);
+}
+
+void GainStage::Run(ScaleFn scale, RampFn ramp, void* samples, ULONG frames)
+{
+    if (m_Format == SampleFormat_Float32)
+    {
+        Process(scale, ramp, reinterpret_cast<float*>(samples), frames);
+        return;
+    }
+
+    const ULONG chunk = LEYLINE_CONVERT_CHUNK / m_Channels;
+    const ULONG bytes = SampleFormatBytes(m_Format) * m_Channels;
+    float staging[LEYLINE_CONVERT_CHUNK];
+    for (ULONG pos = 0; pos < frames; )
+    {
+        ULONG  n  = (frames - pos < chunk) ? frames - pos : chunk;
+        PUCHAR at = reinterpret_cast<PUCHAR>(samples) + (SIZE_T)pos * bytes;
+        m_Decoder.Convert(at, staging, (SIZE_T)n * m_Channels);
+        Process(scale, ramp, staging, n);
+        m_Encoder.Convert(staging, at, (SIZE_T)n * m_Channels);
+        pos += n;
+    }
+}
+
+void GainStage::Apply(void* samples, ULONG frames)
+{
+    if (!m_RampLeft)
+    {
+        BOOLEAN unity = TRUE, silent = TRUE;
+        for (ULONG ch = 0; ch < m_Channels; ++ch)
+        {
+            unity  &= m_Gain[ch] == 1.0f;
+            silent &= m_Gain[ch] == 0.0f;
+        }
+        if (unity) return;
+        if (silent)
+        {
+            FillSilence(m_Format, samples, (SIZE_T)frames * m_Channels);
+            return;
+        }
+    }
+
+    if (m_Level != SimdLevel_Avx2)
+    {
+        Run(m_Scale, m_Ramp, samples, frames);
+        return;
+    }
+
+    // YMM state must be saved in kernel mode, as for the other kernels.
+    XSTATE_SAVE state;
+    if (!NT_SUCCESS(KeSaveExtendedProcessorState(XSTATE_MASK_AVX, &state)))
+    {
+        Run(m_FallbackScale, m_FallbackRamp, samples, frames);
+        return;
+    }
+    Run(m_Scale, m_Ramp, samples, frames);
+    KeRestoreExtendedProcessorState(&state);
+}
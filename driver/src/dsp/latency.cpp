@@ -0,0 +1,331 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LATENCY PROBE
+// The marker sequence, the SSE2 correlator, and the bookkeeping that turns a marker
+// found on capture into a latency: which burst it was, and how long after that
+// burst played it could be read.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "leyline_latency.h"
+
+#include <immintrin.h>
+
+namespace
+{
+    const ULONG kMarker = LEYLINE_LATENCY_MARKER_FRAMES;
+
+    float HorizontalSum(__m128 v)
+    {
+        __m128 high = _mm_movehl_ps(v, v);
+        __m128 pair = _mm_add_ps(v, high);
+        __m128 odd  = _mm_shuffle_ps(pair, pair, 0x55);
+        return _mm_cvtss_f32(_mm_add_ss(pair, odd));
+    }
+
+    // Frames of a run at `sampleRate` that `ticks` hold, rounded down, without
+    // overflowing on long runs.
+    ULONGLONG TicksToFrames(ULONGLONG ticks, LONG64 frequency, ULONG sampleRate)
+    {
+        ULONGLONG seconds = ticks / (ULONGLONG)frequency;
+        ULONGLONG partial = ticks % (ULONGLONG)frequency;
+        return seconds * sampleRate + partial * sampleRate / (ULONGLONG)frequency;
+    }
+}
+
+// x^10 + x^7 + 1, a primitive polynomial, as a Fibonacci LFSR from all ones: the
+// register visits every nonzero state once per 1023 steps.
+void GenerateMls(float* chips)
+{
+    ULONG state = 0x3FF;
+    for (ULONG i = 0; i < kMarker; ++i)
+    {
+        chips[i] = (state & 1) ? 1.0f : -1.0f;
+        ULONG feedback = (state ^ (state >> 3)) & 1;
+        state = (state >> 1) | (feedback << 9);
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MARKER DETECTOR
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void MarkerDetector::Reset()
+{
+    RtlZeroMemory(m_Window, sizeof(m_Window));
+    m_Head     = 0;
+    m_Filled   = 0;
+    m_Energy   = 0.0;
+    m_Tracking = 0;
+    m_Holdoff  = 0;
+    m_Best     = 0.0f;
+    m_BestAt   = 0;
+}
+
+// Dot product with the marker over the energy of the window, scaled so the marker
+// itself at any level scores 1. The marker's own energy is kMarker (chips of +/-1).
+float MarkerDetector::Correlate(const float* window, double energy) const
+{
+    __m128 dot0 = _mm_setzero_ps(), dot1 = _mm_setzero_ps();
+    __m128 dot2 = _mm_setzero_ps(), dot3 = _mm_setzero_ps();
+
+    ULONG i = 0;
+    for (; i + 16 <= kMarker; i += 16)
+    {
+        dot0 = _mm_add_ps(dot0, _mm_mul_ps(_mm_loadu_ps(window + i),      _mm_loadu_ps(m_Marker + i)));
+        dot1 = _mm_add_ps(dot1, _mm_mul_ps(_mm_loadu_ps(window + i + 4),  _mm_loadu_ps(m_Marker + i + 4)));
+        dot2 = _mm_add_ps(dot2, _mm_mul_ps(_mm_loadu_ps(window + i + 8),  _mm_loadu_ps(m_Marker + i + 8)));
+        dot3 = _mm_add_ps(dot3, _mm_mul_ps(_mm_loadu_ps(window + i + 12), _mm_loadu_ps(m_Marker + i + 12)));
+    }
+
+    float dot = HorizontalSum(_mm_add_ps(_mm_add_ps(dot0, dot1), _mm_add_ps(dot2, dot3)));
+    for (; i < kMarker; ++i) dot += window[i] * m_Marker[i];
+
+    if (energy <= 1e-12) return 0.0f;
+    return dot / _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss((float)(energy * kMarker))));
+}
+
+// A score over the threshold opens a short search for the peak, since a filtered
+// or resampled marker rises over a few samples; after the peak nothing can start
+// until the rest of that marker has gone by. The window's energy slides with it
+// and is summed afresh once per lap so rounding cannot build up.
+ULONG MarkerDetector::Push(const float* samples, ULONG count, ULONGLONG frame, MarkerHit* hits, ULONG maxHits)
+{
+    ULONG found = 0;
+    for (ULONG i = 0; i < count; ++i)
+    {
+        float leaving = m_Window[m_Head];
+        m_Window[m_Head] = m_Window[m_Head + kMarker] = samples[i];
+        m_Energy += (double)samples[i] * samples[i] - (double)leaving * leaving;
+        if (++m_Head == kMarker)
+        {
+            m_Head   = 0;
+            m_Energy = 0.0;
+            for (ULONG j = 0; j < kMarker; ++j) m_Energy += (double)m_Window[j] * m_Window[j];
+        }
+        if (m_Filled < kMarker) ++m_Filled;
+
+        if (m_Holdoff) { --m_Holdoff; continue; }
+        if (m_Filled < kMarker) continue;
+
+        float     score = Correlate(m_Window + m_Head, m_Energy);
+        ULONGLONG start = frame + i - (kMarker - 1);
+        if (m_Tracking)
+        {
+            if (score > m_Best)
+            {
+                m_Best   = score;
+                m_BestAt = start;
+            }
+            if (--m_Tracking == 0)
+            {
+                if (found < maxHits) hits[found++] = { m_BestAt, m_Best };
+                m_Holdoff = kMarker - LEYLINE_LATENCY_PEAK_FRAMES;
+            }
+        }
+        else if (score >= LEYLINE_LATENCY_DETECT_SCORE)
+        {
+            m_Best     = score;
+            m_BestAt   = start;
+            m_Tracking = LEYLINE_LATENCY_PEAK_FRAMES;
+        }
+    }
+    return found;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LATENCY STATS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+BOOLEAN LatencyStats::Add(ULONGLONG ns)
+{
+    if (m_Count == LEYLINE_LATENCY_MAX_BURSTS) return FALSE;
+
+    ULONG at = m_Count;
+    while (at > 0 && m_Ns[at - 1] > ns)
+    {
+        m_Ns[at] = m_Ns[at - 1];
+        --at;
+    }
+    m_Ns[at] = ns;
+    ++m_Count;
+    m_Sum += ns;
+    return TRUE;
+}
+
+// p99 by nearest rank: the smallest value at least 99% of the results are at or
+// below. Under 100 results that is the maximum.
+void LatencyStats::Summarize(ULONG sampleRate, LeylineLatencyReport* report) const
+{
+    ULONGLONG ns[4] = {};
+    if (m_Count)
+    {
+        ns[0] = m_Ns[0];
+        ns[1] = MeanNs();
+        ns[2] = m_Ns[(99 * m_Count + 99) / 100 - 1];
+        ns[3] = m_Ns[m_Count - 1];
+    }
+
+    ULONG* frames = &report->MinFrames;
+    ULONG* us     = &report->MinUs;
+    for (ULONG i = 0; i < 4; ++i)
+    {
+        frames[i] = (ULONG)((ns[i] * sampleRate + 500000000ULL) / 1000000000ULL);
+        us[i]     = (ULONG)((ns[i] + 500) / 1000);
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LATENCY PROBE
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LONG64 LatencyProbe::FrameQpc(LONG64 startQpc, LONG64 frequency, ULONG sampleRate, ULONGLONG frame)
+{
+    ULONGLONG passed  = frame + 1;
+    ULONGLONG seconds = passed / sampleRate;
+    ULONGLONG partial = passed % sampleRate;
+    return startQpc + (LONG64)(seconds * (ULONGLONG)frequency) +
+           (LONG64)((partial * (ULONGLONG)frequency + sampleRate - 1) / sampleRate);
+}
+
+void LatencyProbe::Arm(ULONG bursts, ULONG intervalMs, BOOLEAN apply)
+{
+    m_Stats.Reset();
+    m_Schedule.Init(0, 0, 0);
+    m_Bursts     = bursts;
+    m_IntervalMs = intervalMs;
+    m_Apply      = apply;
+    m_Injected   = 0;
+    m_NextBurst  = 0;
+    m_StartQpc   = 0;
+    WriteNoFence64(&m_Marked, 0);
+    WriteRelease(&m_State, LatencyProbe_Armed);
+}
+
+void LatencyProbe::Stop(BOOLEAN forget)
+{
+    LatencyProbeState state = GetState();
+    if (state == LatencyProbe_Armed) WriteRelease(&m_State, LatencyProbe_Idle);
+    if (state == LatencyProbe_Running)
+    {
+        WriteRelease(&m_State, LatencyProbe_Done);
+        if (m_Apply && m_Stats.Count()) WriteNoFence(&m_AppliedUs, (LONG)((m_Stats.MeanNs() + 500) / 1000));
+    }
+    if (forget) WriteNoFence(&m_AppliedUs, 0);
+}
+
+void LatencyProbe::GetReport(LeylineLatencyReport* report) const
+{
+    RtlZeroMemory(report, sizeof(*report));
+    report->State      = GetState();
+    report->Bursts     = m_Bursts;
+    report->Injected   = m_Injected;
+    report->Detected   = m_Stats.Count();
+    report->SampleRate = m_SampleRate;
+    report->AppliedUs  = GetAppliedUs();
+    m_Stats.Summarize(m_SampleRate, report);
+}
+
+// The schedule belongs to one owner run; a new run, or a restart of this one,
+// ends the measurement with what it has.
+BOOLEAN LatencyProbe::Begin(ULONGLONG played, LONG64 startQpc, LONG64 frequency, ULONG sampleRate)
+{
+    LatencyProbeState state = GetState();
+    if (state == LatencyProbe_Running && startQpc != m_StartQpc) Stop(FALSE);
+    if (state != LatencyProbe_Armed) return GetState() == LatencyProbe_Running;
+
+    // Bursts at least two markers apart, so neither the owner nor the detector can
+    // run one into the next.
+    ULONG interval = (ULONG)((ULONGLONG)sampleRate * m_IntervalMs / 1000);
+    if (interval < 2 * LEYLINE_LATENCY_MARKER_FRAMES) interval = 2 * LEYLINE_LATENCY_MARKER_FRAMES;
+
+    m_Schedule.Init(played + (ULONGLONG)sampleRate * LEYLINE_LATENCY_LEAD_MS / 1000, interval, m_Bursts);
+    m_StartQpc   = startQpc;
+    m_Frequency  = frequency;
+    m_SampleRate = sampleRate;
+    WriteNoFence64(&m_Marked, (LONG64)played);
+    WriteRelease(&m_State, LatencyProbe_Running);
+    return TRUE;
+}
+
+void LatencyProbe::Advance(ULONGLONG played)
+{
+    if (GetState() != LatencyProbe_Running) return;
+
+    WriteRelease64(&m_Marked, (LONG64)played);
+    m_Injected = m_Schedule.Started(played);
+
+    ULONGLONG interval = m_Schedule.BurstFrame(1) - m_Schedule.BurstFrame(0);
+    if (played >= m_Schedule.End() + interval) Stop(FALSE);
+}
+
+void LatencyProbe::StartCapture(ULONGLONG frames, LONG64 qpc, BOOLEAN continuous)
+{
+    m_Detector.Reset();
+    m_LogCount   = 0;
+    m_Continuous = continuous;
+    Observe(frames, qpc);
+}
+
+void LatencyProbe::Observe(ULONGLONG frames, LONG64 qpc)
+{
+    LogEntry& entry = m_Log[m_LogCount % LEYLINE_LATENCY_LOG_ENTRIES];
+    entry.Frames = frames;
+    entry.Qpc    = qpc;
+    ++m_LogCount;
+}
+
+// When the capture position first passed `frame`: interpolated between the two
+// periods around it when the position runs with the clock, else the period that
+// delivered it. Older than the log reaches: its oldest entry.
+LONG64 LatencyProbe::VisibleAt(ULONGLONG frame) const
+{
+    ULONG held  = m_LogCount < LEYLINE_LATENCY_LOG_ENTRIES ? m_LogCount : LEYLINE_LATENCY_LOG_ENTRIES;
+    ULONG first = m_LogCount - held;
+
+    const LogEntry* previous = nullptr;
+    for (ULONG i = first; i < m_LogCount; ++i)
+    {
+        const LogEntry& entry = m_Log[i % LEYLINE_LATENCY_LOG_ENTRIES];
+        if (entry.Frames > frame)
+        {
+            if (!previous || !m_Continuous || entry.Frames == previous->Frames) return entry.Qpc;
+            return previous->Qpc + (LONG64)((frame + 1 - previous->Frames) * (ULONGLONG)(entry.Qpc - previous->Qpc) /
+                                            (entry.Frames - previous->Frames));
+        }
+        previous = &entry;
+    }
+    return held ? m_Log[(m_LogCount - 1) % LEYLINE_LATENCY_LOG_ENTRIES].Qpc : 0;
+}
+
+ULONG LatencyProbe::Capture(const float* mono, ULONG count, ULONGLONG first, LONG64* seen, ULONG maxSeen)
+{
+    MarkerHit hits[4];
+    ULONG found = m_Detector.Push(mono, count, first, hits, maxSeen < 4 ? maxSeen : 4);
+    for (ULONG i = 0; i < found; ++i) seen[i] = VisibleAt(hits[i].Frame + kMarker - 1);
+    return found;
+}
+
+// The burst whose last frame played most recently before `seen`, each at most
+// once; one already matched, or none within an interval, makes this a stray.
+BOOLEAN LatencyProbe::Match(LONG64 seen)
+{
+    LatencyProbeState state = GetState();
+    if ((state != LatencyProbe_Running && state != LatencyProbe_Done) || !m_Frequency || seen < m_StartQpc)
+        return FALSE;
+
+    ULONGLONG played = TicksToFrames((ULONGLONG)(seen - m_StartQpc), m_Frequency, m_SampleRate);
+    for (ULONG k = m_Schedule.Started(played + 1); k-- > m_NextBurst; )
+    {
+        LONG64 playedAt = FrameQpc(m_StartQpc, m_Frequency, m_SampleRate, m_Schedule.BurstFrame(k) + kMarker - 1);
+        if (playedAt > seen) continue;
+
+        LONG64 ticks = seen - playedAt;
+        if (ticks * 1000 >= (LONG64)m_IntervalMs * m_Frequency) return FALSE;
+
+        m_NextBurst = k + 1;
+        return m_Stats.Add((ULONGLONG)ticks * 1000000000ULL / (ULONGLONG)m_Frequency);
+    }
+    return FALSE;
+}
@@ -0,0 +1,340 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PEAK METER
+// Scalar, SSE2 and AVX2 per-channel reductions, the period ballistics, and the
+// seqlock over LeylineMeterBlock.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "leyline_meter.h"
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#define LEYLINE_TARGET_AVX2
+#else
+#define LEYLINE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+    const double kLn2       = 0.69314718055994530942;
+    const double kLn10Over20 = 0.11512925464970228420;     // ln(10) / 20: dB -> nepers
+
+    // e^x for x <= 0, which is all the ballistics need: x = n ln2 + r with
+    // |r| < ln2, a Taylor series for e^r, and 2^n put straight into the exponent.
+    double Exp(double x)
+    {
+        if (x < -700.0) return 0.0;
+        LONG64 n = (LONG64)(x / kLn2 - 0.5);
+        double r = x - (double)n * kLn2;
+
+        double term = 1.0, sum = 1.0;
+        for (int k = 1; k < 14; ++k)
+        {
+            term *= r / (double)k;
+            sum  += term;
+        }
+
+        union { ULONG64 Bits; double Value; } scale;
+        scale.Bits = (ULONG64)(n + 1023) << 52;
+        return sum * scale.Value;
+    }
+
+    double Sqrt(double x)
+    {
+        return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(x)));
+    }
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // REDUCTIONS
+    // The vector kernels walk blocks of `channels` vectors, i.e. `channels` x width
+    // samples, which always hold whole frames. Accumulator k then sees sample
+    // k * width + lane of every block, always the same channel, (k * width + lane)
+    // % channels; the lanes are folded into channels once at the end and the
+    // remaining frames go through the scalar loop. A NaN never wins a max.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    void ReduceScalar(const float* x, ULONG frames, ULONG channels, float* peak, float* sumSquares, ULONG* clips)
+    {
+        for (ULONG i = 0; i < frames; ++i, x += channels)
+        {
+            for (ULONG ch = 0; ch < channels; ++ch)
+            {
+                float v = x[ch];
+                float a = v < 0.0f ? -v : v;
+                if (a > peak[ch]) peak[ch] = a;
+                sumSquares[ch] += v * v;
+                if (a >= LEYLINE_METER_CLIP_LEVEL) ++clips[ch];
+            }
+        }
+    }
+
+    void FoldLanes(const float* lanePeak, const float* laneSum, const ULONG* laneClips, ULONG lanes,
+                   ULONG channels, float* peak, float* sumSquares, ULONG* clips)
+    {
+        for (ULONG i = 0; i < lanes; ++i)
+        {
+            ULONG ch = i % channels;
+            if (lanePeak[i] > peak[ch]) peak[ch] = lanePeak[i];
+            sumSquares[ch] += laneSum[i];
+            clips[ch]      += laneClips[i];
+        }
+    }
+
+    void ReduceSse2(const float* x, ULONG frames, ULONG channels, float* peak, float* sumSquares, ULONG* clips)
+    {
+        const __m128  absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        const __m128  clip    = _mm_set1_ps(LEYLINE_METER_CLIP_LEVEL);
+        __m128  p[LEYLINE_METER_MAX_CHANNELS], s[LEYLINE_METER_MAX_CHANNELS];
+        __m128i c[LEYLINE_METER_MAX_CHANNELS];
+        for (ULONG k = 0; k < channels; ++k)
+        {
+            p[k] = _mm_setzero_ps();
+            s[k] = _mm_setzero_ps();
+            c[k] = _mm_setzero_si128();
+        }
+
+        const ULONG blocks = frames / 4;
+        for (ULONG b = 0; b < blocks; ++b)
+        {
+            for (ULONG k = 0; k < channels; ++k, x += 4)
+            {
+                __m128 v = _mm_loadu_ps(x);
+                __m128 a = _mm_and_ps(v, absMask);
+                p[k] = _mm_max_ps(a, p[k]);
+                s[k] = _mm_add_ps(s[k], _mm_mul_ps(v, v));
+                c[k] = _mm_sub_epi32(c[k], _mm_castps_si128(_mm_cmpge_ps(a, clip)));
+            }
+        }
+
+        DECLSPEC_CACHEALIGN float lanePeak[4 * LEYLINE_METER_MAX_CHANNELS];
+        DECLSPEC_CACHEALIGN float laneSum[4 * LEYLINE_METER_MAX_CHANNELS];
+        DECLSPEC_CACHEALIGN ULONG laneClips[4 * LEYLINE_METER_MAX_CHANNELS];
+        for (ULONG k = 0; k < channels; ++k)
+        {
+            _mm_store_ps(lanePeak + 4 * k, p[k]);
+            _mm_store_ps(laneSum + 4 * k, s[k]);
+            _mm_store_si128(reinterpret_cast<__m128i*>(laneClips + 4 * k), c[k]);
+        }
+        FoldLanes(lanePeak, laneSum, laneClips, 4 * channels, channels, peak, sumSquares, clips);
+        ReduceScalar(x, frames - blocks * 4, channels, peak, sumSquares, clips);
+    }
+
+    LEYLINE_TARGET_AVX2 void ReduceAvx2(const float* x, ULONG frames, ULONG channels, float* peak, float* sumSquares, ULONG* clips)
+    {
+        const __m256  absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        const __m256  clip    = _mm256_set1_ps(LEYLINE_METER_CLIP_LEVEL);
+        __m256  p[LEYLINE_METER_MAX_CHANNELS], s[LEYLINE_METER_MAX_CHANNELS];
+        __m256i c[LEYLINE_METER_MAX_CHANNELS];
+        for (ULONG k = 0; k < channels; ++k)
+        {
+            p[k] = _mm256_setzero_ps();
+            s[k] = _mm256_setzero_ps();
+            c[k] = _mm256_setzero_si256();
+        }
+
+        const ULONG blocks = frames / 8;
+        for (ULONG b = 0; b < blocks; ++b)
+        {
+            for (ULONG k = 0; k < channels; ++k, x += 8)
+            {
+                __m256 v = _mm256_loadu_ps(x);
+                __m256 a = _mm256_and_ps(v, absMask);
+                p[k] = _mm256_max_ps(a, p[k]);
+                s[k] = _mm256_add_ps(s[k], _mm256_mul_ps(v, v));
+                c[k] = _mm256_sub_epi32(c[k], _mm256_castps_si256(_mm256_cmp_ps(a, clip, _CMP_GE_OQ)));
+            }
+        }
+
+        DECLSPEC_CACHEALIGN float lanePeak[8 * LEYLINE_METER_MAX_CHANNELS];
+        DECLSPEC_CACHEALIGN float laneSum[8 * LEYLINE_METER_MAX_CHANNELS];
+        DECLSPEC_CACHEALIGN ULONG laneClips[8 * LEYLINE_METER_MAX_CHANNELS];
+        for (ULONG k = 0; k < channels; ++k)
+        {
+            _mm256_store_ps(lanePeak + 8 * k, p[k]);
+            _mm256_store_ps(laneSum + 8 * k, s[k]);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(laneClips + 8 * k), c[k]);
+        }
+        FoldLanes(lanePeak, laneSum, laneClips, 8 * channels, channels, peak, sumSquares, clips);
+        ReduceScalar(x, frames - blocks * 8, channels, peak, sumSquares, clips);
+    }
+
+    const PeakMeter::ReduceFn kReducers[3] = { ReduceScalar, ReduceSse2, ReduceAvx2 };
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PEAK METER
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+NTSTATUS PeakMeter::Init(LeylineSampleFormat format, ULONG channels, ULONG sampleRate, SimdLevel level)
+{
+    if (SampleFormatBytes(format) == 0 || channels == 0 || channels > LEYLINE_METER_MAX_CHANNELS ||
+        sampleRate == 0 || level < SimdLevel_Scalar || level > SimdLevel_Avx2)
+        return STATUS_INVALID_PARAMETER;
+
+    if (format != SampleFormat_Float32)
+    {
+        NTSTATUS status = m_Decoder.Init(format, SampleFormat_Float32, 0, level);
+        if (!NT_SUCCESS(status)) return status;
+    }
+
+    m_Format         = format;
+    m_Channels       = channels;
+    m_SampleRate     = sampleRate;
+    m_Level          = level;
+    m_Reduce         = kReducers[level];
+    m_FallbackReduce = kReducers[SimdLevel_Sse2];
+
+    SetBallistics(LEYLINE_METER_DEFAULT_DECAY_DB, LEYLINE_METER_DEFAULT_RMS_MS);
+    Reset();
+    return STATUS_SUCCESS;
+}
+
+void PeakMeter::SetBallistics(ULONG decayDbPerSecond, ULONG rmsWindowMs)
+{
+    m_DecayPerFrame = (double)decayDbPerSecond * kLn10Over20 / (double)m_SampleRate;
+    m_RmsFrames     = (double)rmsWindowMs * (double)m_SampleRate / 1000.0;
+    m_StepFrames    = 0;
+}
+
+void PeakMeter::Reset()
+{
+    m_PeriodFrames = 0;
+    for (ULONG ch = 0; ch < LEYLINE_METER_MAX_CHANNELS; ++ch)
+    {
+        m_PeriodPeak[ch]       = 0.0f;
+        m_PeriodSumSquares[ch] = 0.0;
+        m_Peak[ch]             = 0.0;
+        m_MeanSquare[ch]       = 0.0;
+        m_Clips[ch]            = 0;
+    }
+}
+
+// Float sums are only kept for one block of at most LEYLINE_CONVERT_CHUNK samples
+// before moving into the double period totals.
+void PeakMeter::Reduce(ReduceFn reduce, const float* samples, ULONG frames)
+{
+    const ULONG chunk = LEYLINE_CONVERT_CHUNK / m_Channels;
+    float decoded[LEYLINE_CONVERT_CHUNK];
+
+    for (ULONG pos = 0; pos < frames; )
+    {
+        ULONG n = (frames - pos < chunk) ? frames - pos : chunk;
+        const float* block = samples + (SIZE_T)pos * m_Channels;
+        if (m_Format != SampleFormat_Float32)
+        {
+            const UCHAR* raw = reinterpret_cast<const UCHAR*>(samples) +
+                               (SIZE_T)pos * m_Channels * SampleFormatBytes(m_Format);
+            m_Decoder.Convert(raw, decoded, (SIZE_T)n * m_Channels);
+            block = decoded;
+        }
+
+        float sums[LEYLINE_METER_MAX_CHANNELS] = {};
+        reduce(block, n, m_Channels, m_PeriodPeak, sums, m_Clips);
+        for (ULONG ch = 0; ch < m_Channels; ++ch) m_PeriodSumSquares[ch] += sums[ch];
+        pos += n;
+    }
+    m_PeriodFrames += frames;
+}
+
+void PeakMeter::Accumulate(const void* samples, ULONG frames)
+{
+    const float* in = reinterpret_cast<const float*>(samples);
+    if (m_Level != SimdLevel_Avx2)
+    {
+        Reduce(m_Reduce, in, frames);
+        return;
+    }
+
+    // YMM state must be saved in kernel mode, as for the other kernels.
+    XSTATE_SAVE state;
+    if (!NT_SUCCESS(KeSaveExtendedProcessorState(XSTATE_MASK_AVX, &state)))
+    {
+        Reduce(m_FallbackReduce, in, frames);
+        return;
+    }
+    Reduce(m_Reduce, in, frames);
+    KeRestoreExtendedProcessorState(&state);
+}
+
+// Peak hold falls by e^(-DecayPerFrame * frames); the mean square moves towards
+// the period's by 1 - e^(-frames / RmsFrames), the step of a one-pole average.
+// Periods are nearly always the same length, so both factors are kept for reuse.
+void PeakMeter::EndPeriod()
+{
+    const ULONG frames = m_PeriodFrames;
+    if (frames == 0) return;
+
+    if (frames != m_StepFrames)
+    {
+        m_StepFrames = frames;
+        m_StepFall   = m_DecayPerFrame > 0.0 ? Exp(-m_DecayPerFrame * (double)frames) : 0.0;
+        m_StepAlpha  = m_RmsFrames > 0.0 ? 1.0 - Exp(-(double)frames / m_RmsFrames) : 1.0;
+    }
+    const double fall  = m_StepFall;
+    const double alpha = m_StepAlpha;
+
+    for (ULONG ch = 0; ch < m_Channels; ++ch)
+    {
+        double held = m_Peak[ch] * fall;
+        m_Peak[ch]  = (double)m_PeriodPeak[ch] > held ? (double)m_PeriodPeak[ch] : held;
+
+        // Inf or NaN from a float client would otherwise stick in the average.
+        double meanSquare = m_PeriodSumSquares[ch] / (double)frames;
+        if (!(meanSquare < 1e30)) meanSquare = 0.0;
+        m_MeanSquare[ch] += alpha * (meanSquare - m_MeanSquare[ch]);
+
+        m_PeriodPeak[ch]       = 0.0f;
+        m_PeriodSumSquares[ch] = 0.0;
+    }
+    m_PeriodFrames = 0;
+}
+
+void PeakMeter::Read(MeterReading* reading) const
+{
+    reading->Channels = m_Channels;
+    for (ULONG ch = 0; ch < LEYLINE_METER_MAX_CHANNELS; ++ch)
+    {
+        BOOLEAN used = ch < m_Channels;
+        reading->Peak[ch]  = used ? (float)m_Peak[ch] : 0.0f;
+        reading->Rms[ch]   = used ? (float)Sqrt(m_MeanSquare[ch]) : 0.0f;
+        reading->Clips[ch] = used ? m_Clips[ch] : 0;
+    }
+}
+
+void PeakMeter::Publish(LeylineMeterBlock* block, const MeterReading& reading)
+{
+    volatile LONG* sequence = reinterpret_cast<volatile LONG*>(&block->Sequence);
+    LONG seq = ReadNoFence(sequence);
+    WriteNoFence(sequence, seq + 1);
+    WriteRelease(reinterpret_cast<volatile LONG*>(&block->Channels), (LONG)reading.Channels);
+    for (ULONG ch = 0; ch < LEYLINE_METER_MAX_CHANNELS; ++ch)
+    {
+        WriteRelease(reinterpret_cast<volatile LONG*>(&block->PeakBits[ch]),  (LONG)FloatToBits(reading.Peak[ch]));
+        WriteRelease(reinterpret_cast<volatile LONG*>(&block->RmsBits[ch]),   (LONG)FloatToBits(reading.Rms[ch]));
+        WriteRelease(reinterpret_cast<volatile LONG*>(&block->ClipCount[ch]), (LONG)reading.Clips[ch]);
+    }
+    WriteRelease(sequence, seq + 2);
+}
+
+void PeakMeter::Snapshot(const LeylineMeterBlock* block, MeterReading* reading)
+{
+    const volatile LONG* sequence = reinterpret_cast<const volatile LONG*>(&block->Sequence);
+    for (;;)
+    {
+        LONG seq = ReadAcquire(sequence);
+        if (seq & 1) { YieldProcessor(); continue; }
+
+        reading->Channels = (ULONG)ReadAcquire(reinterpret_cast<const volatile LONG*>(&block->Channels));
+        for (ULONG ch = 0; ch < LEYLINE_METER_MAX_CHANNELS; ++ch)
+        {
+            reading->Peak[ch]  = BitsToFloat((ULONG)ReadAcquire(reinterpret_cast<const volatile LONG*>(&block->PeakBits[ch])));
+            reading->Rms[ch]   = BitsToFloat((ULONG)ReadAcquire(reinterpret_cast<const volatile LONG*>(&block->RmsBits[ch])));
+            reading->Clips[ch] = (ULONG)ReadAcquire(reinterpret_cast<const volatile LONG*>(&block->ClipCount[ch]));
+        }
+
+        if (ReadAcquire(sequence) == seq) return;
+    }
+}
@@ -0,0 +1,416 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MIX BUS
+// Scalar, SSE2 and AVX2 accumulate, saturate and route kernels, the channel
+// router, and the chunked mix.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "leyline_mixer.h"
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#define LEYLINE_TARGET_AVX2
+#else
+#define LEYLINE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // KERNELS
+    // Element-wise, so the vector loops do exactly the scalar operations. The
+    // clamp is written as max-then-min in the operand order of MAXPS/MINPS, which
+    // return the second operand when either is NaN.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    void AccumulateScalar(float* sum, const float* x, SIZE_T count)
+    {
+        for (SIZE_T i = 0; i < count; ++i) sum[i] += x[i];
+    }
+
+    void SaturateScalar(const float* sum, float* out, SIZE_T count)
+    {
+        for (SIZE_T i = 0; i < count; ++i)
+        {
+            float v = sum[i] > -1.0f ? sum[i] : -1.0f;
+            out[i]  = v < 1.0f ? v : 1.0f;
+        }
+    }
+
+    void AccumulateSse2(float* sum, const float* x, SIZE_T count)
+    {
+        SIZE_T i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm_storeu_ps(sum + i,     _mm_add_ps(_mm_loadu_ps(sum + i),     _mm_loadu_ps(x + i)));
+            _mm_storeu_ps(sum + i + 4, _mm_add_ps(_mm_loadu_ps(sum + i + 4), _mm_loadu_ps(x + i + 4)));
+        }
+        AccumulateScalar(sum + i, x + i, count - i);
+    }
+
+    void SaturateSse2(const float* sum, float* out, SIZE_T count)
+    {
+        const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+        SIZE_T i = 0;
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(sum + i), lo), hi));
+        SaturateScalar(sum + i, out + i, count - i);
+    }
+
+    LEYLINE_TARGET_AVX2 void AccumulateAvx2(float* sum, const float* x, SIZE_T count)
+    {
+        SIZE_T i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            _mm256_storeu_ps(sum + i,     _mm256_add_ps(_mm256_loadu_ps(sum + i),     _mm256_loadu_ps(x + i)));
+            _mm256_storeu_ps(sum + i + 8, _mm256_add_ps(_mm256_loadu_ps(sum + i + 8), _mm256_loadu_ps(x + i + 8)));
+        }
+        AccumulateScalar(sum + i, x + i, count - i);
+    }
+
+    LEYLINE_TARGET_AVX2 void SaturateAvx2(const float* sum, float* out, SIZE_T count)
+    {
+        const __m256 lo = _mm256_set1_ps(-1.0f), hi = _mm256_set1_ps(1.0f);
+        SIZE_T i = 0;
+        for (; i + 8 <= count; i += 8)
+            _mm256_storeu_ps(out + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(sum + i), lo), hi));
+        SaturateScalar(sum + i, out + i, count - i);
+    }
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // ROUTE KERNELS
+    // A row is accumulated across a whole block in registers, taps in table
+    // order, then weighted and added into the bus frames by the same scalar code
+    // at every level. The AVX2 kernel below assumes 32-frame blocks.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    const ULONG kBlock = LEYLINE_ROUTE_BLOCK_FRAMES;
+    static_assert(LEYLINE_ROUTE_BLOCK_FRAMES == 32, "RouteAvx2 holds a block in four registers");
+
+    inline void AddRow(const float* acc, float* sum, ULONG stride, ULONG frames, const float* weights)
+    {
+        for (ULONG k = 0; k < frames; ++k) sum[(SIZE_T)k * stride] += acc[k] * weights[k];
+    }
+
+    void RouteScalar(const float* planes, const RouteTap* taps, ULONG count,
+                     float* sum, ULONG stride, ULONG frames, const float* weights)
+    {
+        for (ULONG t = 0; t < count; )
+        {
+            const ULONG output = taps[t].Output;
+            float acc[kBlock] = {};
+            for (; t < count && taps[t].Output == output; ++t)
+            {
+                const float* x = planes + (SIZE_T)taps[t].Input * kBlock;
+                for (ULONG k = 0; k < kBlock; ++k) acc[k] += taps[t].Gain * x[k];
+            }
+            AddRow(acc, sum + output, stride, frames, weights);
+        }
+    }
+
+    void RouteSse2(const float* planes, const RouteTap* taps, ULONG count,
+                   float* sum, ULONG stride, ULONG frames, const float* weights)
+    {
+        for (ULONG t = 0; t < count; )
+        {
+            const ULONG output = taps[t].Output;
+            __m128 a[kBlock / 4];
+            for (ULONG v = 0; v < kBlock / 4; ++v) a[v] = _mm_setzero_ps();
+            for (; t < count && taps[t].Output == output; ++t)
+            {
+                const float* x = planes + (SIZE_T)taps[t].Input * kBlock;
+                const __m128 g = _mm_set1_ps(taps[t].Gain);
+                for (ULONG v = 0; v < kBlock / 4; ++v)
+                    a[v] = _mm_add_ps(a[v], _mm_mul_ps(g, _mm_loadu_ps(x + v * 4)));
+            }
+            float acc[kBlock];
+            for (ULONG v = 0; v < kBlock / 4; ++v) _mm_storeu_ps(acc + v * 4, a[v]);
+            AddRow(acc, sum + output, stride, frames, weights);
+        }
+    }
+
+    LEYLINE_TARGET_AVX2 void RouteAvx2(const float* planes, const RouteTap* taps, ULONG count,
+                                       float* sum, ULONG stride, ULONG frames, const float* weights)
+    {
+        for (ULONG t = 0; t < count; )
+        {
+            const ULONG output = taps[t].Output;
+            __m256 a0 = _mm256_setzero_ps(), a1 = a0, a2 = a0, a3 = a0;
+            for (; t < count && taps[t].Output == output; ++t)
+            {
+                const float* x = planes + (SIZE_T)taps[t].Input * kBlock;
+                const __m256 g = _mm256_set1_ps(taps[t].Gain);
+                a0 = _mm256_add_ps(a0, _mm256_mul_ps(g, _mm256_loadu_ps(x)));
+                a1 = _mm256_add_ps(a1, _mm256_mul_ps(g, _mm256_loadu_ps(x + 8)));
+                a2 = _mm256_add_ps(a2, _mm256_mul_ps(g, _mm256_loadu_ps(x + 16)));
+                a3 = _mm256_add_ps(a3, _mm256_mul_ps(g, _mm256_loadu_ps(x + 24)));
+            }
+            float acc[kBlock];
+            _mm256_storeu_ps(acc,      a0);
+            _mm256_storeu_ps(acc + 8,  a1);
+            _mm256_storeu_ps(acc + 16, a2);
+            _mm256_storeu_ps(acc + 24, a3);
+            AddRow(acc, sum + output, stride, frames, weights);
+        }
+    }
+
+    const MixBus::AccumulateFn kAccumulators[3] = { AccumulateScalar, AccumulateSse2, AccumulateAvx2 };
+    const MixBus::SaturateFn   kSaturators[3]   = { SaturateScalar, SaturateSse2, SaturateAvx2 };
+    const MixBus::RouteFn      kRouters[3]      = { RouteScalar, RouteSse2, RouteAvx2 };
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CHANNEL ROUTER
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+ULONG ChannelRouter::TapCount(const float* gains, ULONG inputs, ULONG outputs)
+{
+    ULONG taps = 0;
+    for (SIZE_T i = 0; i < (SIZE_T)inputs * outputs; ++i)
+    {
+        if (gains[i] != 0.0f) ++taps;
+    }
+    return taps;
+}
+
+NTSTATUS ChannelRouter::Init(const float* gains, ULONG inputs, ULONG outputs, RouteTap* table, SIZE_T tableBytes)
+{
+    if (inputs == 0 || inputs > LEYLINE_ROUTE_MAX_CHANNELS || outputs == 0 || outputs > LEYLINE_ROUTE_MAX_CHANNELS)
+        return STATUS_INVALID_PARAMETER;
+
+    // Written so that NaN fails too.
+    for (SIZE_T i = 0; i < (SIZE_T)inputs * outputs; ++i)
+    {
+        if (!(gains[i] >= -LEYLINE_ROUTE_MAX_GAIN && gains[i] <= LEYLINE_ROUTE_MAX_GAIN))
+            return STATUS_INVALID_PARAMETER;
+    }
+    if (tableBytes < TableBytes(TapCount(gains, inputs, outputs))) return STATUS_BUFFER_TOO_SMALL;
+
+    ULONG     taps = 0;
+    ULONGLONG used = 0;
+    for (ULONG o = 0; o < outputs; ++o)
+    for (ULONG i = 0; i < inputs; ++i)
+    {
+        float gain = gains[(SIZE_T)o * inputs + i];
+        if (gain == 0.0f) continue;
+        table[taps++] = { (USHORT)i, (USHORT)o, gain };
+        used |= 1ull << i;
+    }
+
+    m_Inputs     = inputs;
+    m_Outputs    = outputs;
+    m_TapCount   = taps;
+    m_UsedInputs = used;
+    m_Taps       = table;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS ChannelRouter::InitIdentity(ULONG channels, RouteTap* table, SIZE_T tableBytes)
+{
+    if (channels == 0 || channels > LEYLINE_ROUTE_MAX_CHANNELS) return STATUS_INVALID_PARAMETER;
+    if (tableBytes < TableBytes(channels)) return STATUS_BUFFER_TOO_SMALL;
+
+    for (ULONG c = 0; c < channels; ++c) table[c] = { (USHORT)c, (USHORT)c, 1.0f };
+    m_Inputs     = channels;
+    m_Outputs    = channels;
+    m_TapCount   = channels;
+    m_UsedInputs = channels == 64 ? ~0ull : (1ull << channels) - 1;
+    m_Taps       = table;
+    return STATUS_SUCCESS;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MIX BUS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+NTSTATUS MixBus::Init(LeylineSampleFormat format, ULONG channels, SimdLevel level)
+{
+    if (SampleFormatBytes(format) == 0 || channels == 0 || channels > LEYLINE_ROUTE_MAX_CHANNELS ||
+        level < SimdLevel_Scalar || level > SimdLevel_Avx2)
+        return STATUS_INVALID_PARAMETER;
+
+    for (ULONG f = SampleFormat_Pcm8; f < SampleFormat_Float32; ++f)
+    {
+        NTSTATUS status = m_Decoders[f].Init((LeylineSampleFormat)f, SampleFormat_Float32, 0, level);
+        if (!NT_SUCCESS(status)) return status;
+    }
+    if (format != SampleFormat_Float32)
+    {
+        NTSTATUS status = m_Encoder.Init(SampleFormat_Float32, format, 0, level);
+        if (!NT_SUCCESS(status)) return status;
+    }
+
+    m_Format   = format;
+    m_Channels = channels;
+    m_Level    = level;
+    m_Kernels  = { kAccumulators[level], kSaturators[level], kRouters[level] };
+    m_Fallback = { kAccumulators[SimdLevel_Sse2], kSaturators[SimdLevel_Sse2], kRouters[SimdLevel_Sse2] };
+    return m_Identity.InitIdentity(channels, m_IdentityTaps, sizeof(m_IdentityTaps));
+}
+
+// Adds `count` samples into the sum, or with `first` sets it. Float is read in
+// place; anything else is decoded into the staging block first.
+void MixBus::Load(const void* samples, LeylineSampleFormat format, SIZE_T count, AccumulateFn accumulate,
+                  BOOLEAN first)
+{
+    if (format == SampleFormat_Float32)
+    {
+        const float* x = reinterpret_cast<const float*>(samples);
+        if (first) RtlCopyMemory(m_Sum, x, count * sizeof(float));
+        else       accumulate(m_Sum, x, count);
+        return;
+    }
+
+    if (first)
+    {
+        m_Decoders[format].Convert(samples, m_Sum, count);
+        return;
+    }
+    m_Decoders[format].Convert(samples, m_Staging, count);
+    accumulate(m_Sum, m_Staging, count);
+}
+
+// Adds `frames` frames of a routed input, from its frame `pos`, into the sum.
+void MixBus::LoadRouted(const Kernels& kernels, const MixInput& input, ULONG pos, ULONG frames)
+{
+    float weights[LEYLINE_ROUTE_BLOCK_FRAMES];
+    float fading[LEYLINE_ROUTE_BLOCK_FRAMES];
+
+    const ChannelRouter* route   = input.Route;
+    const ULONG          inputs  = route->GetInputs();
+    const ULONGLONG      used    = route->GetUsedInputs() | (input.FadeFrom ? input.FadeFrom->GetUsedInputs() : 0);
+    const ULONG          bytes   = SampleFormatBytes(input.Format);
+    const UCHAR*         samples = reinterpret_cast<const UCHAR*>(input.Samples);
+
+    for (ULONG k = 0; k < LEYLINE_ROUTE_BLOCK_FRAMES; ++k) weights[k] = 1.0f;
+
+    for (ULONG done = 0; done < frames; )
+    {
+        ULONG  n  = (frames - done < LEYLINE_ROUTE_BLOCK_FRAMES) ? frames - done : LEYLINE_ROUTE_BLOCK_FRAMES;
+        SIZE_T at = (SIZE_T)(pos + done) * inputs;
+
+        const float* x;
+        if (input.Format == SampleFormat_Float32)
+        {
+            x = reinterpret_cast<const float*>(samples + at * bytes);
+        }
+        else
+        {
+            m_Decoders[input.Format].Convert(samples + at * bytes, m_Staging, (SIZE_T)n * inputs);
+            x = m_Staging;
+        }
+
+        // Planes past the last frame are zero so the kernels can run whole blocks.
+        for (ULONG i = 0; i < inputs; ++i)
+        {
+            if (!(used & (1ull << i))) continue;
+            float* plane = m_Planes + (SIZE_T)i * LEYLINE_ROUTE_BLOCK_FRAMES;
+            ULONG  k     = 0;
+            for (; k < n; ++k) plane[k] = x[(SIZE_T)k * inputs + i];
+            for (; k < LEYLINE_ROUTE_BLOCK_FRAMES; ++k) plane[k] = 0.0f;
+        }
+
+        float* out = m_Sum + (SIZE_T)done * m_Channels;
+        if (!input.FadeFrom)
+        {
+            kernels.Route(m_Planes, route->GetTaps(), route->GetTapCount(), out, m_Channels, n, weights);
+        }
+        else
+        {
+            for (ULONG k = 0; k < n; ++k)
+            {
+                fading[k] = input.Fade + (float)(pos + done + k) * input.FadeStep;
+                fading[k] = fading[k] < 1.0f ? fading[k] : 1.0f;
+            }
+            kernels.Route(m_Planes, route->GetTaps(), route->GetTapCount(), out, m_Channels, n, fading);
+            for (ULONG k = 0; k < n; ++k) fading[k] = 1.0f - fading[k];
+            kernels.Route(m_Planes, input.FadeFrom->GetTaps(), input.FadeFrom->GetTapCount(), out, m_Channels, n, fading);
+        }
+        done += n;
+    }
+}
+
+BOOLEAN MixBus::IsLive(const MixInput& input) const
+{
+    if (!input.Samples || SampleFormatBytes(input.Format) == 0) return FALSE;
+    if (!input.Route) return TRUE;
+    if (input.Route->GetOutputs() != m_Channels) return FALSE;
+    return !input.FadeFrom || (input.FadeFrom->GetInputs()  == input.Route->GetInputs() &&
+                               input.FadeFrom->GetOutputs() == m_Channels);
+}
+
+void MixBus::Run(const Kernels& kernels, const MixInput* inputs, ULONG count, UCHAR* out, ULONG frames,
+                 BOOLEAN includeOut)
+{
+    // Whole frames per chunk, so routed inputs line up with the bus frames.
+    const ULONG chunk = LEYLINE_MIX_CHUNK_SAMPLES / m_Channels;
+    const ULONG bytes = SampleFormatBytes(m_Format);
+
+    for (ULONG pos = 0; pos < frames; )
+    {
+        ULONG  n       = (frames - pos < chunk) ? frames - pos : chunk;
+        SIZE_T samples = (SIZE_T)n * m_Channels;
+        UCHAR* at      = out + (SIZE_T)pos * m_Channels * bytes;
+
+        BOOLEAN first = TRUE;
+        if (includeOut)
+        {
+            Load(at, m_Format, samples, kernels.Accumulate, TRUE);
+            first = FALSE;
+        }
+        for (ULONG i = 0; i < count; ++i)
+        {
+            if (!IsLive(inputs[i])) continue;
+            if (inputs[i].Route)
+            {
+                if (first) RtlZeroMemory(m_Sum, samples * sizeof(float));
+                LoadRouted(kernels, inputs[i], pos, n);
+            }
+            else
+            {
+                const UCHAR* in = reinterpret_cast<const UCHAR*>(inputs[i].Samples) +
+                                  (SIZE_T)pos * m_Channels * SampleFormatBytes(inputs[i].Format);
+                Load(in, inputs[i].Format, samples, kernels.Accumulate, first);
+            }
+            first = FALSE;
+        }
+
+        if (m_Format == SampleFormat_Float32) kernels.Saturate(m_Sum, reinterpret_cast<float*>(at), samples);
+        else                                  m_Encoder.Convert(m_Sum, at, samples);
+        pos += n;
+    }
+}
+
+void MixBus::Mix(const MixInput* inputs, ULONG count, void* out, ULONG frames, BOOLEAN includeOut)
+{
+    ULONG live = 0;
+    for (ULONG i = 0; i < count; ++i)
+    {
+        if (IsLive(inputs[i])) ++live;
+    }
+    if (live == 0)
+    {
+        if (!includeOut) FillSilence(m_Format, out, (SIZE_T)frames * m_Channels);
+        return;
+    }
+
+    UCHAR* bus = reinterpret_cast<UCHAR*>(out);
+    if (m_Level != SimdLevel_Avx2)
+    {
+        Run(m_Kernels, inputs, count, bus, frames, includeOut);
+        return;
+    }
+
+    // YMM state must be saved in kernel mode, as for the other kernels.
+    XSTATE_SAVE state;
+    if (!NT_SUCCESS(KeSaveExtendedProcessorState(XSTATE_MASK_AVX, &state)))
+    {
+        Run(m_Fallback, inputs, count, bus, frames, includeOut);
+        return;
+    }
+    Run(m_Kernels, inputs, count, bus, frames, includeOut);
+    KeRestoreExtendedProcessorState(&state);
+}
@@ -0,0 +1,502 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PLANAR AUDIO
+// Scalar, SSE2 and AVX2 interleave/deinterleave, and the planar side ring.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "leyline_planar.h"
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#define LEYLINE_TARGET_AVX2
+#else
+#define LEYLINE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // DEINTERLEAVE
+    // The vector kernels cover whole blocks of frames for the channels they handle
+    // (stereo, or every complete group of four); the scalar loop then fills in the
+    // leftover channels of those blocks and every channel of the last few frames.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    // Channels [ch0, ch1) of frames [f0, f1).
+    void DeinterleaveRange(const float* in, ULONG channels, ULONG ch0, ULONG ch1, ULONG f0, ULONG f1,
+                           float* const* planes)
+    {
+        for (ULONG f = f0; f < f1; ++f)
+        {
+            const float* x = in + (SIZE_T)f * channels;
+            for (ULONG ch = ch0; ch < ch1; ++ch) planes[ch][f] = x[ch];
+        }
+    }
+
+    void DeinterleaveScalar(const float* in, ULONG channels, ULONG frames, float* const* planes)
+    {
+        if (channels == 1)
+        {
+            if (frames == 0) return;    // Either side may be null then
+            RtlCopyMemory(planes[0], in, (SIZE_T)frames * sizeof(float));
+            return;
+        }
+        DeinterleaveRange(in, channels, 0, channels, 0, frames, planes);
+    }
+
+    void DeinterleaveSse2(const float* in, ULONG channels, ULONG frames, float* const* planes)
+    {
+        if (channels == 1) return DeinterleaveScalar(in, channels, frames, planes);
+
+        const ULONG blocked = frames & ~3u;
+        ULONG       covered;
+        if (channels == 2)
+        {
+            for (ULONG f = 0; f < blocked; f += 4)
+            {
+                __m128 a = _mm_loadu_ps(in + 2 * (SIZE_T)f);
+                __m128 b = _mm_loadu_ps(in + 2 * (SIZE_T)f + 4);
+                _mm_storeu_ps(planes[0] + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+                _mm_storeu_ps(planes[1] + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+            }
+            covered = 2;
+        }
+        else
+        {
+            covered = channels & ~3u;
+            for (ULONG f = 0; f < blocked; f += 4)
+            {
+                const float* x = in + (SIZE_T)f * channels;
+                for (ULONG g = 0; g < covered; g += 4)
+                {
+                    __m128 r0 = _mm_loadu_ps(x + g);
+                    __m128 r1 = _mm_loadu_ps(x + g + channels);
+                    __m128 r2 = _mm_loadu_ps(x + g + 2 * channels);
+                    __m128 r3 = _mm_loadu_ps(x + g + 3 * channels);
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    _mm_storeu_ps(planes[g] + f, r0);
+                    _mm_storeu_ps(planes[g + 1] + f, r1);
+                    _mm_storeu_ps(planes[g + 2] + f, r2);
+                    _mm_storeu_ps(planes[g + 3] + f, r3);
+                }
+            }
+        }
+        DeinterleaveRange(in, channels, covered, channels, 0, blocked, planes);
+        DeinterleaveRange(in, channels, 0, channels, blocked, frames, planes);
+    }
+
+    // 4x4 transpose within each 128-bit lane.
+    LEYLINE_TARGET_AVX2 inline void TransposeLanes(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+    {
+        __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+        __m256 t1 = _mm256_unpacklo_ps(r2, r3);
+        __m256 t2 = _mm256_unpackhi_ps(r0, r1);
+        __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+        r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+        r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+        r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    }
+
+    // Frames i and i + 4 of a group share a register, one per lane, so each
+    // transposed register is eight consecutive frames of one channel.
+    LEYLINE_TARGET_AVX2 inline __m256 LoadPair(const float* lo, const float* hi)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+    }
+
+    LEYLINE_TARGET_AVX2 void DeinterleaveAvx2(const float* in, ULONG channels, ULONG frames, float* const* planes)
+    {
+        if (channels == 1) return DeinterleaveScalar(in, channels, frames, planes);
+
+        const ULONG blocked = frames & ~7u;
+        ULONG       covered;
+        if (channels == 2)
+        {
+            for (ULONG f = 0; f < blocked; f += 8)
+            {
+                __m256 a = _mm256_loadu_ps(in + 2 * (SIZE_T)f);         // L0 R0 L1 R1 | L2 R2 L3 R3
+                __m256 b = _mm256_loadu_ps(in + 2 * (SIZE_T)f + 8);     // L4 R4 L5 R5 | L6 R6 L7 R7
+                __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));   // L0 L1 L4 L5 | L2 L3 L6 L7
+                __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+                _mm256_storeu_ps(planes[0] + f, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0))));
+                _mm256_storeu_ps(planes[1] + f, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0))));
+            }
+            covered = 2;
+        }
+        else
+        {
+            covered = channels & ~3u;
+            const SIZE_T four = 4 * (SIZE_T)channels;
+            for (ULONG f = 0; f < blocked; f += 8)
+            {
+                const float* x = in + (SIZE_T)f * channels;
+                for (ULONG g = 0; g < covered; g += 4)
+                {
+                    const float* p = x + g;
+                    __m256 r0 = LoadPair(p, p + four);
+                    __m256 r1 = LoadPair(p + channels, p + channels + four);
+                    __m256 r2 = LoadPair(p + 2 * channels, p + 2 * channels + four);
+                    __m256 r3 = LoadPair(p + 3 * channels, p + 3 * channels + four);
+                    TransposeLanes(r0, r1, r2, r3);
+                    _mm256_storeu_ps(planes[g] + f, r0);
+                    _mm256_storeu_ps(planes[g + 1] + f, r1);
+                    _mm256_storeu_ps(planes[g + 2] + f, r2);
+                    _mm256_storeu_ps(planes[g + 3] + f, r3);
+                }
+            }
+        }
+        DeinterleaveRange(in, channels, covered, channels, 0, blocked, planes);
+        DeinterleaveRange(in, channels, 0, channels, blocked, frames, planes);
+    }
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // INTERLEAVE
+    // The same transposes run backwards.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    void InterleaveRange(const float* const* planes, ULONG channels, ULONG ch0, ULONG ch1, ULONG f0, ULONG f1,
+                         float* out)
+    {
+        for (ULONG f = f0; f < f1; ++f)
+        {
+            float* x = out + (SIZE_T)f * channels;
+            for (ULONG ch = ch0; ch < ch1; ++ch) x[ch] = planes[ch][f];
+        }
+    }
+
+    void InterleaveScalar(const float* const* planes, ULONG channels, ULONG frames, float* out)
+    {
+        if (channels == 1)
+        {
+            if (frames == 0) return;    // Either side may be null then
+            RtlCopyMemory(out, planes[0], (SIZE_T)frames * sizeof(float));
+            return;
+        }
+        InterleaveRange(planes, channels, 0, channels, 0, frames, out);
+    }
+
+    void InterleaveSse2(const float* const* planes, ULONG channels, ULONG frames, float* out)
+    {
+        if (channels == 1) return InterleaveScalar(planes, channels, frames, out);
+
+        const ULONG blocked = frames & ~3u;
+        ULONG       covered;
+        if (channels == 2)
+        {
+            for (ULONG f = 0; f < blocked; f += 4)
+            {
+                __m128 l = _mm_loadu_ps(planes[0] + f);
+                __m128 r = _mm_loadu_ps(planes[1] + f);
+                _mm_storeu_ps(out + 2 * (SIZE_T)f,     _mm_unpacklo_ps(l, r));
+                _mm_storeu_ps(out + 2 * (SIZE_T)f + 4, _mm_unpackhi_ps(l, r));
+            }
+            covered = 2;
+        }
+        else
+        {
+            covered = channels & ~3u;
+            for (ULONG f = 0; f < blocked; f += 4)
+            {
+                float* x = out + (SIZE_T)f * channels;
+                for (ULONG g = 0; g < covered; g += 4)
+                {
+                    __m128 r0 = _mm_loadu_ps(planes[g] + f);
+                    __m128 r1 = _mm_loadu_ps(planes[g + 1] + f);
+                    __m128 r2 = _mm_loadu_ps(planes[g + 2] + f);
+                    __m128 r3 = _mm_loadu_ps(planes[g + 3] + f);
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    _mm_storeu_ps(x + g, r0);
+                    _mm_storeu_ps(x + g + channels, r1);
+                    _mm_storeu_ps(x + g + 2 * channels, r2);
+                    _mm_storeu_ps(x + g + 3 * channels, r3);
+                }
+            }
+        }
+        InterleaveRange(planes, channels, covered, channels, 0, blocked, out);
+        InterleaveRange(planes, channels, 0, channels, blocked, frames, out);
+    }
+
+    LEYLINE_TARGET_AVX2 inline void StorePair(float* lo, float* hi, __m256 v)
+    {
+        _mm_storeu_ps(lo, _mm256_castps256_ps128(v));
+        _mm_storeu_ps(hi, _mm256_extractf128_ps(v, 1));
+    }
+
+    LEYLINE_TARGET_AVX2 void InterleaveAvx2(const float* const* planes, ULONG channels, ULONG frames, float* out)
+    {
+        if (channels == 1) return InterleaveScalar(planes, channels, frames, out);
+
+        const ULONG blocked = frames & ~7u;
+        ULONG       covered;
+        if (channels == 2)
+        {
+            for (ULONG f = 0; f < blocked; f += 8)
+            {
+                __m256 l  = _mm256_loadu_ps(planes[0] + f);
+                __m256 r  = _mm256_loadu_ps(planes[1] + f);
+                __m256 lo = _mm256_unpacklo_ps(l, r);          // L0 R0 L1 R1 | L4 R4 L5 R5
+                __m256 hi = _mm256_unpackhi_ps(l, r);          // L2 R2 L3 R3 | L6 R6 L7 R7
+                _mm256_storeu_ps(out + 2 * (SIZE_T)f,     _mm256_permute2f128_ps(lo, hi, 0x20));
+                _mm256_storeu_ps(out + 2 * (SIZE_T)f + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+            }
+            covered = 2;
+        }
+        else
+        {
+            covered = channels & ~3u;
+            const SIZE_T four = 4 * (SIZE_T)channels;
+            for (ULONG f = 0; f < blocked; f += 8)
+            {
+                float* x = out + (SIZE_T)f * channels;
+                for (ULONG g = 0; g < covered; g += 4)
+                {
+                    __m256 r0 = _mm256_loadu_ps(planes[g] + f);
+                    __m256 r1 = _mm256_loadu_ps(planes[g + 1] + f);
+                    __m256 r2 = _mm256_loadu_ps(planes[g + 2] + f);
+                    __m256 r3 = _mm256_loadu_ps(planes[g + 3] + f);
+                    TransposeLanes(r0, r1, r2, r3);
+                    float* p = x + g;
+                    StorePair(p, p + four, r0);
+                    StorePair(p + channels, p + channels + four, r1);
+                    StorePair(p + 2 * channels, p + 2 * channels + four, r2);
+                    StorePair(p + 3 * channels, p + 3 * channels + four, r3);
+                }
+            }
+        }
+        InterleaveRange(planes, channels, covered, channels, 0, blocked, out);
+        InterleaveRange(planes, channels, 0, channels, blocked, frames, out);
+    }
+
+    const DeinterleaveFn kDeinterleavers[3] = { DeinterleaveScalar, DeinterleaveSse2, DeinterleaveAvx2 };
+    const InterleaveFn   kInterleavers[3]   = { InterleaveScalar, InterleaveSse2, InterleaveAvx2 };
+
+    SimdLevel ValidLevel(SimdLevel level)
+    {
+        return (level < SimdLevel_Scalar || level > SimdLevel_Avx2) ? SimdLevel_Scalar : level;
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// KERNEL ENTRY POINTS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void Deinterleave(const float* in, ULONG channels, ULONG frames, float* const* planes, SimdLevel level)
+{
+    level = ValidLevel(level);
+    if (level != SimdLevel_Avx2)
+    {
+        kDeinterleavers[level](in, channels, frames, planes);
+        return;
+    }
+
+    XSTATE_SAVE state;
+    if (!NT_SUCCESS(KeSaveExtendedProcessorState(XSTATE_MASK_AVX, &state)))
+    {
+        DeinterleaveSse2(in, channels, frames, planes);
+        return;
+    }
+    DeinterleaveAvx2(in, channels, frames, planes);
+    KeRestoreExtendedProcessorState(&state);
+}
+
+void Interleave(const float* const* planes, ULONG channels, ULONG frames, float* out, SimdLevel level)
+{
+    level = ValidLevel(level);
+    if (level != SimdLevel_Avx2)
+    {
+        kInterleavers[level](planes, channels, frames, out);
+        return;
+    }
+
+    XSTATE_SAVE state;
+    if (!NT_SUCCESS(KeSaveExtendedProcessorState(XSTATE_MASK_AVX, &state)))
+    {
+        InterleaveSse2(planes, channels, frames, out);
+        return;
+    }
+    InterleaveAvx2(planes, channels, frames, out);
+    KeRestoreExtendedProcessorState(&state);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PLANAR RING
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+NTSTATUS PlanarRing::Init(LeylineSampleFormat format, ULONG channels, ULONG sampleRate, ULONG frames,
+                          SimdLevel level, PVOID storage, SIZE_T bytes)
+{
+    if (SampleFormatBytes(format) == 0 || channels == 0 || channels > LEYLINE_PLANAR_MAX_CHANNELS ||
+        sampleRate == 0 || frames == 0 || (frames & (frames - 1)) || !storage || bytes < Bytes(channels, frames) ||
+        level < SimdLevel_Scalar || level > SimdLevel_Avx2)
+        return STATUS_INVALID_PARAMETER;
+
+    if (format != SampleFormat_Float32)
+    {
+        NTSTATUS status = m_Decoder.Init(format, SampleFormat_Float32, 0, level);
+        if (!NT_SUCCESS(status)) return status;
+    }
+
+    ULONG_PTR base   = ((ULONG_PTR)storage + SYSTEM_CACHE_ALIGNMENT_SIZE - 1) & ~(ULONG_PTR)(SYSTEM_CACHE_ALIGNMENT_SIZE - 1);
+    ULONG     stride = PlaneStride(frames);
+    for (ULONG ch = 0; ch < LEYLINE_PLANAR_MAX_CHANNELS; ++ch)
+        m_Planes[ch] = ch < channels ? reinterpret_cast<float*>(base) + (SIZE_T)ch * stride : nullptr;
+
+    m_Format     = format;
+    m_Channels   = channels;
+    m_SampleRate = sampleRate;
+    m_Capacity   = frames;
+    m_Level      = level;
+    Reset();
+    return STATUS_SUCCESS;
+}
+
+void PlanarRing::Reset()
+{
+    WriteNoFence64(&m_WritePos, 0);
+    InterlockedExchange64(&m_ReservePos, 0);
+}
+
+// Planes at ring index `at`, splitting at the wrap.
+void PlanarRing::Spread(const float* in, ULONG frames, ULONG at, DeinterleaveFn deinterleave)
+{
+    while (frames)
+    {
+        ULONG n = m_Capacity - at < frames ? m_Capacity - at : frames;
+        float* planes[LEYLINE_PLANAR_MAX_CHANNELS];
+        for (ULONG ch = 0; ch < m_Channels; ++ch) planes[ch] = m_Planes[ch] + at;
+        deinterleave(in, m_Channels, n, planes);
+
+        in     += (SIZE_T)n * m_Channels;
+        frames -= n;
+        at      = 0;
+    }
+}
+
+void PlanarRing::Fill(const UCHAR* in, ULONG frames, LONG64 pos, DeinterleaveFn deinterleave)
+{
+    const ULONG mask = m_Capacity - 1;
+    if (m_Format == SampleFormat_Float32)
+    {
+        Spread(reinterpret_cast<const float*>(in), frames, (ULONG)pos & mask, deinterleave);
+        return;
+    }
+
+    float       decoded[LEYLINE_CONVERT_CHUNK];
+    const ULONG chunk = LEYLINE_CONVERT_CHUNK / m_Channels;
+    const ULONG frameBytes = m_Channels * SampleFormatBytes(m_Format);
+    for (ULONG done = 0; done < frames; )
+    {
+        ULONG n = frames - done < chunk ? frames - done : chunk;
+        m_Decoder.Convert(in + (SIZE_T)done * frameBytes, decoded, (SIZE_T)n * m_Channels);
+        Spread(decoded, n, (ULONG)(pos + done) & mask, deinterleave);
+        done += n;
+    }
+}
+
+void PlanarRing::Write(const void* samples, ULONG frames)
+{
+    if (!m_Capacity || !frames) return;
+
+    // Only the last ring's worth of a longer write could survive it.
+    const UCHAR* in  = static_cast<const UCHAR*>(samples);
+    LONG64       pos = ReadNoFence64(&m_WritePos);
+    if (frames > m_Capacity)
+    {
+        ULONG skip = frames - m_Capacity;
+        in     += (SIZE_T)skip * m_Channels * SampleFormatBytes(m_Format);
+        pos    += skip;
+        frames  = m_Capacity;
+    }
+
+    // Full barrier: the reservation must be visible before any frame is
+    // overwritten, or a reader could keep torn samples.
+    InterlockedExchange64(&m_ReservePos, pos + frames);
+
+    const DeinterleaveFn deinterleave = kDeinterleavers[m_Level];
+    if (m_Level != SimdLevel_Avx2)
+    {
+        Fill(in, frames, pos, deinterleave);
+    }
+    else
+    {
+        XSTATE_SAVE state;
+        if (NT_SUCCESS(KeSaveExtendedProcessorState(XSTATE_MASK_AVX, &state)))
+        {
+            Fill(in, frames, pos, deinterleave);
+            KeRestoreExtendedProcessorState(&state);
+        }
+        else
+        {
+            Fill(in, frames, pos, kDeinterleavers[SimdLevel_Sse2]);
+        }
+    }
+
+    WriteRelease64(&m_WritePos, pos + frames);
+}
+
+// Copies [*from, written) up to `count` frames out of the planes (one channel, or
+// all of them interleaved), then drops the front of whatever the writer reserved
+// while the copy ran.
+ULONG PlanarRing::Read(ULONG channel, ULONGLONG* from, ULONG count, float* out) const
+{
+    if (!m_Capacity) return 0;
+
+    const BOOLEAN all     = channel >= m_Channels;
+    const ULONG   width   = all ? m_Channels : 1;
+    LONG64        written = ReadAcquire64(&m_WritePos);
+    LONG64        oldest  = ReadAcquire64(&m_ReservePos) - (LONG64)m_Capacity;
+    LONG64        start   = (LONG64)*from;
+    if (start < oldest) start = oldest;
+    if (start < 0)      start = 0;
+    if (start >= written)
+    {
+        *from = (ULONGLONG)start;
+        return 0;
+    }
+
+    ULONG n = (ULONGLONG)(written - start) < count ? (ULONG)(written - start) : count;
+    for (ULONG done = 0; done < n; )
+    {
+        ULONG at   = (ULONG)(start + done) & (m_Capacity - 1);
+        ULONG take = m_Capacity - at < n - done ? m_Capacity - at : n - done;
+        if (all)
+        {
+            const float* planes[LEYLINE_PLANAR_MAX_CHANNELS];
+            for (ULONG ch = 0; ch < m_Channels; ++ch) planes[ch] = m_Planes[ch] + at;
+            Interleave(planes, m_Channels, take, out + (SIZE_T)done * width, m_Level);
+        }
+        else
+        {
+            RtlCopyMemory(out + done, m_Planes[channel] + at, (SIZE_T)take * sizeof(float));
+        }
+        done += take;
+    }
+
+    // Order the plane loads above before the reservation check.
+    MemoryBarrier();
+    oldest = ReadNoFence64(&m_ReservePos) - (LONG64)m_Capacity;
+    if (start < oldest)
+    {
+        ULONG lost = (ULONGLONG)(oldest - start) < n ? (ULONG)(oldest - start) : n;
+        RtlMoveMemory(out, out + (SIZE_T)lost * width, (SIZE_T)(n - lost) * width * sizeof(float));
+        start += lost;
+        n     -= lost;
+    }
+    *from = (ULONGLONG)start;
+    return n;
+}
+
+ULONG PlanarRing::ReadPlane(ULONG channel, ULONGLONG* from, ULONG count, float* out) const
+{
+    if (channel >= m_Channels) return 0;
+    return Read(channel, from, count, out);
+}
+
+ULONG PlanarRing::ReadFrames(ULONGLONG* from, ULONG count, float* out) const
+{
+    return Read(LEYLINE_PLANAR_MAX_CHANNELS, from, count, out);
+}
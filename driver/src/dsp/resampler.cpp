@@ -0,0 +1,269 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// POLYPHASE RESAMPLER
+// Filter design (no CRT math: the kernel has none) and the scalar, SSE2 and AVX2
+// per-frame filter kernels.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "leyline_resampler.h"
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#define LEYLINE_TARGET_AVX2
+#else
+#define LEYLINE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+    struct SrcPreset
+    {
+        ULONG  Taps;
+        double Cutoff;          // Passband edge as a fraction of the lower Nyquist
+        double KaiserBeta;
+    };
+
+    const SrcPreset kPresets[] =
+    {
+        { 16, 0.80, 6.0 },      // Low
+        { 32, 0.88, 8.5 },      // Medium
+        { 64, 0.93, 11.0 },     // High
+    };
+
+    const double kPi = 3.14159265358979323846;
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // FILTER DESIGN
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    double Sqrt(double x)
+    {
+        return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(x)));
+    }
+
+    // sin(x) for any x: reduce to [-pi/2, pi/2], then a Taylor series that is
+    // converged to double precision on that interval.
+    double Sin(double x)
+    {
+        double turns = x / (2.0 * kPi);
+        x -= 2.0 * kPi * (double)(LONG64)(turns + (turns >= 0 ? 0.5 : -0.5));
+        if (x > kPi / 2)  x = kPi - x;
+        if (x < -kPi / 2) x = -kPi - x;
+
+        double term = x, sum = x, x2 = x * x;
+        for (int n = 1; n < 12; ++n)
+        {
+            term *= -x2 / (double)((2 * n) * (2 * n + 1));
+            sum  += term;
+        }
+        return sum;
+    }
+
+    // Modified Bessel function of the first kind, order 0.
+    double BesselI0(double x)
+    {
+        double term = 1.0, sum = 1.0, q = x * x / 4.0;
+        for (int k = 1; k < 64 && term > sum * 1e-17; ++k)
+        {
+            term *= q / (double)(k * k);
+            sum  += term;
+        }
+        return sum;
+    }
+
+    ULONG Gcd(ULONG a, ULONG b)
+    {
+        while (b) { ULONG t = a % b; a = b; b = t; }
+        return a;
+    }
+
+    // Coefficient for phase p, tap j (oldest first): the prototype low-pass at
+    // t = (Taps/2 - 1 - j) + p/L input samples from the output instant.
+    void BuildBank(float* bank, ULONG phases, ULONG decimation, const SrcPreset& preset)
+    {
+        const ULONG  taps = preset.Taps;
+        const double half = (double)taps / 2.0;
+        const double ratio = (double)phases / (double)decimation;
+        const double fc   = 0.5 * preset.Cutoff * (ratio < 1.0 ? ratio : 1.0);   // Cycles per input sample
+        const double norm = BesselI0(preset.KaiserBeta);
+
+        for (ULONG p = 0; p < phases; ++p)
+        {
+            float* c   = bank + (SIZE_T)p * taps;
+            double sum = 0;
+            double tmp[LEYLINE_SRC_MAX_TAPS];
+            for (ULONG j = 0; j < taps; ++j)
+            {
+                double t    = (half - 1.0 - (double)j) + (double)p / (double)phases;
+                double sinc = (t == 0.0) ? 2.0 * fc : Sin(2.0 * kPi * fc * t) / (kPi * t);
+                double r    = t / half;
+                double w    = (r >= 1.0 || r <= -1.0) ? 0.0 : BesselI0(preset.KaiserBeta * Sqrt(1.0 - r * r)) / norm;
+                tmp[j] = sinc * w;
+                sum   += tmp[j];
+            }
+            for (ULONG j = 0; j < taps; ++j)
+                c[j] = (float)(tmp[j] / sum);
+        }
+    }
+
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // FILTER KERNELS
+    // Taps is always a multiple of 16.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    void FilterScalar(const float* window, const float* c, ULONG taps, ULONG channels, float* out)
+    {
+        for (ULONG ch = 0; ch < channels; ++ch, window += LEYLINE_SRC_HISTORY_STRIDE)
+        {
+            float sum = 0.0f;
+            for (ULONG i = 0; i < taps; ++i) sum += window[i] * c[i];
+            out[ch] = sum;
+        }
+    }
+
+    inline float HorizontalSum(__m128 s)
+    {
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+
+    void FilterSse2(const float* window, const float* c, ULONG taps, ULONG channels, float* out)
+    {
+        for (ULONG ch = 0; ch < channels; ++ch, window += LEYLINE_SRC_HISTORY_STRIDE)
+        {
+            __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+            for (ULONG i = 0; i < taps; i += 8)
+            {
+                s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(window + i),     _mm_loadu_ps(c + i)));
+                s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(window + i + 4), _mm_loadu_ps(c + i + 4)));
+            }
+            out[ch] = HorizontalSum(_mm_add_ps(s0, s1));
+        }
+    }
+
+    LEYLINE_TARGET_AVX2 void FilterAvx2(const float* window, const float* c, ULONG taps, ULONG channels, float* out)
+    {
+        for (ULONG ch = 0; ch < channels; ++ch, window += LEYLINE_SRC_HISTORY_STRIDE)
+        {
+            __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+            for (ULONG i = 0; i < taps; i += 16)
+            {
+                s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_loadu_ps(window + i),     _mm256_loadu_ps(c + i)));
+                s1 = _mm256_add_ps(s1, _mm256_mul_ps(_mm256_loadu_ps(window + i + 8), _mm256_loadu_ps(c + i + 8)));
+            }
+            __m256 s = _mm256_add_ps(s0, s1);
+            out[ch] = HorizontalSum(_mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)));
+        }
+    }
+
+    const Resampler::FilterFn kFilters[3] = { FilterScalar, FilterSse2, FilterAvx2 };
+
+    BOOLEAN Reduce(ULONG inRate, ULONG outRate, ULONG* interpolation, ULONG* decimation)
+    {
+        if (inRate == 0 || outRate == 0 || inRate > 1000000 || outRate > 1000000) return FALSE;
+        ULONG g = Gcd(inRate, outRate);
+        *interpolation = outRate / g;
+        *decimation    = inRate / g;
+        return *interpolation <= LEYLINE_SRC_MAX_PHASES;
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RESAMPLER
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+SIZE_T Resampler::BankBytes(ULONG inRate, ULONG outRate, SrcQuality quality)
+{
+    ULONG l, m;
+    if (quality < SrcQuality_Low || quality > SrcQuality_High || !Reduce(inRate, outRate, &l, &m)) return 0;
+    return (SIZE_T)l * kPresets[quality].Taps * sizeof(float);
+}
+
+NTSTATUS Resampler::Init(ULONG inRate, ULONG outRate, ULONG channels, SrcQuality quality,
+                         SimdLevel level, float* bank, SIZE_T bankBytes)
+{
+    SIZE_T needed = BankBytes(inRate, outRate, quality);
+    if (needed == 0) return STATUS_NOT_SUPPORTED;
+    if (channels == 0 || channels > LEYLINE_SRC_MAX_CHANNELS ||
+        level < SimdLevel_Scalar || level > SimdLevel_Avx2 || !bank)
+        return STATUS_INVALID_PARAMETER;
+    if (bankBytes < needed) return STATUS_BUFFER_TOO_SMALL;
+
+    Reduce(inRate, outRate, &m_Interpolation, &m_Decimation);
+    m_InputRate      = inRate;
+    m_OutputRate     = outRate;
+    m_Taps           = kPresets[quality].Taps;
+    m_Channels       = channels;
+    m_Level          = level;
+    m_Filter         = kFilters[level];
+    m_FallbackFilter = kFilters[SimdLevel_Sse2];
+    m_Bank           = bank;
+
+    BuildBank(bank, m_Interpolation, m_Decimation, kPresets[quality]);
+    Reset();
+    return STATUS_SUCCESS;
+}
+
+void Resampler::Reset()
+{
+    RtlZeroMemory(m_History, sizeof(m_History));
+    m_Phase = 0;
+    m_Need  = 1;
+    m_Write = 0;
+}
+
+ULONG Resampler::Run(FilterFn filter, const float* in, ULONG inFrames, ULONG* consumed, float* out, ULONG outFrames)
+{
+    const ULONG taps     = m_Taps;
+    const ULONG channels = m_Channels;
+    ULONG taken = 0, produced = 0;
+
+    for (;;)
+    {
+        while (m_Need)
+        {
+            if (taken == inFrames) { *consumed = taken; return produced; }
+            const float* frame = in + (SIZE_T)taken * channels;
+            for (ULONG ch = 0; ch < channels; ++ch)
+            {
+                m_History[ch][m_Write]        = frame[ch];
+                m_History[ch][m_Write + taps] = frame[ch];
+            }
+            m_Write = (m_Write + 1 == taps) ? 0 : m_Write + 1;
+            ++taken;
+            --m_Need;
+        }
+
+        if (produced == outFrames) break;
+
+        filter(&m_History[0][m_Write], m_Bank + (SIZE_T)m_Phase * taps, taps, channels,
+               out + (SIZE_T)produced * channels);
+        ++produced;
+
+        m_Phase += m_Decimation;
+        m_Need   = m_Phase / m_Interpolation;
+        m_Phase %= m_Interpolation;
+    }
+
+    *consumed = taken;
+    return produced;
+}
+
+ULONG Resampler::Process(const float* in, ULONG inFrames, ULONG* consumed, float* out, ULONG outFrames)
+{
+    if (m_Level != SimdLevel_Avx2)
+        return Run(m_Filter, in, inFrames, consumed, out, outFrames);
+
+    // Same rule as the format kernels: YMM state must be saved in kernel mode.
+    XSTATE_SAVE state;
+    if (!NT_SUCCESS(KeSaveExtendedProcessorState(XSTATE_MASK_AVX, &state)))
+        return Run(m_FallbackFilter, in, inFrames, consumed, out, outFrames);
+
+    ULONG produced = Run(m_Filter, in, inFrames, consumed, out, outFrames);
+    KeRestoreExtendedProcessorState(&state);
+    return produced;
+}
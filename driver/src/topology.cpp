@@ -12,11 +12,12 @@
 // CMiniportTopology
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-CMiniportTopology::CMiniportTopology(PUNKNOWN OuterUnknown, BOOLEAN IsCapture)
+CMiniportTopology::CMiniportTopology(PUNKNOWN OuterUnknown, BOOLEAN IsCapture, CableEndpoint* Cable)
     : CUnknown(OuterUnknown)
     , m_IsCapture(IsCapture)
     , m_IsInitialized(FALSE)
     , m_Port(nullptr)
+    , m_Cable(Cable)
 {}
 
 CMiniportTopology::~CMiniportTopology() {}
@@ -37,7 +38,7 @@ STDMETHODIMP CMiniportTopology::GetDescription(PPCFILTER_DESCRIPTOR* Description
 {
     if (!Description) return STATUS_INVALID_PARAMETER;
     DbgPrint("LeylineTopo: GetDescription (capture=%d)\n", (int)m_IsCapture);
-    *Description = const_cast<PPCFILTER_DESCRIPTOR>(m_IsCapture ? &g_TopoCaptureFilterDescriptor : &g_TopoRenderFilterDescriptor);
+    *Description = const_cast<PPCFILTER_DESCRIPTOR>(EndpointFilterDescriptor(m_IsCapture ? EndpointFilter_TopoCapture : EndpointFilter_TopoRender));
     return STATUS_SUCCESS;
 }
 
@@ -57,3 +58,9 @@ STDMETHODIMP CMiniportTopology::Init(PUNKNOWN /*UnknownAdapter*/, PRESOURCELIST
     m_IsInitialized = TRUE;
     return STATUS_SUCCESS;
 }
+
+ChannelControls* CMiniportTopology::GetControls()
+{
+    if (!m_Cable) return nullptr;
+    return m_IsCapture ? &m_Cable->CaptureControls : &m_Cable->RenderControls;
+}
@@ -8,50 +8,159 @@
 
 #include "leyline_miniport.h"
 
+extern TraceProvider g_Trace;
+
+// Whether one of the wave pins' data ranges takes Format.
+static BOOLEAN WaveRangesAdmit(const WaveFormat& Format)
+{
+    return FormatIntersection::Admits(&g_PcmDataRange.DataRange, Format) ||
+           FormatIntersection::Admits(&g_FloatDataRange.DataRange, Format);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // CMiniportWaveRTStream
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-CMiniportWaveRTStream::CMiniportWaveRTStream(PUNKNOWN OuterUnknown, DeviceExtension* DevExt)
+CMiniportWaveRTStream::CMiniportWaveRTStream(PUNKNOWN OuterUnknown, DeviceExtension* DevExt, CableEndpoint* Cable)
     : CUnknown(OuterUnknown)
     , m_State(KSSTATE_STOP)
     , m_Mdl(nullptr)
     , m_Mapping(nullptr)
     , m_IsCapture(FALSE)
     , m_OwnsMdl(FALSE)
+    , m_Pooled(FALSE)
+    , m_OnCable(FALSE)
+    , m_BufferSize(0)
     , m_StartTime(0)
     , m_ByteRate(48000 * 4)
+    , m_BlockAlign(4)
+    , m_SampleRate(48000)
+    , m_Channels(2)
+    , m_SampleFormat(SampleFormat_Pcm16)
     , m_Frequency(0)
+    , m_RegisterMdl(nullptr)
+    , m_RegisterPeriodMs(LEYLINE_DEFAULT_REGISTER_PERIOD_MS)
+    , m_RegisterTimer(nullptr)
+    , m_TimerArmed(FALSE)
+    , m_RegistersInUse(FALSE)
+    , m_CableConvert(FALSE)
+    , m_ConvertedFrames(0)
+    , m_ConvertOrigin(-1)
+    , m_ConvertDelta(0)
+    , m_CableResample(FALSE)
+    , m_ResamplerBank(nullptr)
+    , m_SourceFrames(0)
+    , m_MeterReady(FALSE)
+    , m_Metering(FALSE)
+    , m_GainReady(FALSE)
+    , m_Gaining(FALSE)
+    , m_GainGeneration(0)
+    , m_GainMasterBits(0)
+    , m_PlayedFrames(0)
+    , m_Mix(nullptr)
+    , m_Mixing(FALSE)
+    , m_MixSource(FALSE)
+    , m_MixableFrames(0)
+    , m_SilentFrom(MAXLONG64)
+    , m_MixedFrames(0)
+    , m_MixRoute(nullptr)
+    , m_StreamId(DevExt ? (ULONG)InterlockedIncrement(&DevExt->NextStreamId) : 0)
+    , m_Slot(nullptr)
+    , m_Planar(FALSE)
+    , m_PositionCalls(0)
+    , m_ClientWritten(0)
+    , m_ClientOffset(0)
+    , m_ClientReports(FALSE)
+    , m_Listed(FALSE)
+    , m_Marking(FALSE)
+    , m_Listening(FALSE)
+    , m_Probing(FALSE)
+    , m_ProbeFrames(0)
     , m_DevExt(DevExt)
+    , m_Cable(Cable)
 {
     LARGE_INTEGER freq = {};
     KeQueryPerformanceCounter(&freq);
     m_Frequency = freq.QuadPart;
+
+    m_Registers.Attach(nullptr);
 }
 
 CMiniportWaveRTStream::~CMiniportWaveRTStream()
 {
-    if (m_OwnsMdl && m_Mdl)
+    Unlist();
+    StopRegisterTimer();
+    if (m_RegisterTimer)
+    {
+        ExDeleteTimer(m_RegisterTimer, TRUE, TRUE, nullptr);
+        m_RegisterTimer = nullptr;
+    }
+    StopListening();
+    ReleaseMeter();
+    LeaveMix();
+    if (m_Slot)
+    {
+        SharedParameterBlock::ReleaseStreamSlot(m_Slot);
+        m_Slot = nullptr;
+    }
+    if (m_Mix)
+    {
+        ObjectHeap::Free(m_Mix);
+        m_Mix = nullptr;
+    }
+    if (m_RegisterMdl)
+    {
+        MmUnmapLockedPages(m_Registers.GetPage(), m_RegisterMdl);
+        MmFreePagesFromMdl(m_RegisterMdl);
+        IoFreeMdl(m_RegisterMdl);
+        m_RegisterMdl = nullptr;
+    }
+
+    if (m_Cable && m_OnCable && !m_IsCapture)
     {
-        if (m_Mapping)
-            MmUnmapLockedPages(m_Mapping, m_Mdl);
-        MmFreePagesFromMdl(m_Mdl);
-        IoFreeMdl(m_Mdl);
-        m_Mdl     = nullptr;
-        m_Mapping = nullptr;
+        PublishCableClock(nullptr);
+        m_Cable->Cable.ClearOwnerFormat();
+        InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_Cable->CableOwner), nullptr, this);
     }
+
+    ReleaseAudioBuffer();
 }
 
 NTSTATUS CMiniportWaveRTStream::Init(ULONG /*PinId*/, BOOLEAN Capture, PKSDATAFORMAT Format)
 {
     m_IsCapture = Capture;
-    if (Format)
+    NTSTATUS status = ApplyFormat(Format);
+    if (!NT_SUCCESS(status)) return status;
+
+    // The refresh timer. High resolution, so a period under the system tick is
+    // honoured rather than rounded up to it (about 15.6 ms by default).
+    m_RegisterTimer = ExAllocateTimer(RegisterTimerCallback, this, EX_TIMER_HIGH_RESOLUTION);
+    if (!m_RegisterTimer) return STATUS_INSUFFICIENT_RESOURCES;
+
+    // Register page. Optional: without it GetPositionRegister/GetClockRegister
+    // fail and the audio engine falls back to polling GetPosition.
+    PHYSICAL_ADDRESS low = { 0 }, high = { 0 }, skip = { 0 };
+    high.LowPart = 0xFFFFFFFF;
+    m_RegisterMdl = MmAllocatePagesForMdlEx(low, high, skip, PAGE_SIZE, MmCached, MM_ALLOCATE_FULLY_REQUIRED);
+    if (m_RegisterMdl)
     {
-        auto *wfx = reinterpret_cast<KSDATAFORMAT*>(Format);
-        auto *wave = reinterpret_cast<WAVEFORMATEX*>(wfx + 1);
-        m_ByteRate = wave->nAvgBytesPerSec;
+        PVOID page = MmMapLockedPagesSpecifyCache(m_RegisterMdl, KernelMode, MmCached, nullptr, FALSE, NormalPagePriority);
+        if (page)
+        {
+            RtlZeroMemory(page, PAGE_SIZE);
+            m_Registers.Attach(reinterpret_cast<LeylineStreamRegisters*>(page));
+        }
+        else
+        {
+            MmFreePagesFromMdl(m_RegisterMdl);
+            IoFreeMdl(m_RegisterMdl);
+            m_RegisterMdl = nullptr;
+        }
     }
-    DbgPrint("LeylineWaveRT: Stream Init (capture=%d, byteRate=%u)\n", (int)m_IsCapture, m_ByteRate);
+
+    DbgPrint("LeylineWaveRT: Stream Init (id=%u, capture=%d, byteRate=%u)\n", m_StreamId, (int)m_IsCapture, m_ByteRate);
+    g_Trace.Write(TraceNewStream{ m_StreamId, m_Cable ? m_Cable->Index : 0, m_IsCapture, m_SampleRate, m_Channels,
+                                  m_BlockAlign, (ULONG)m_SampleFormat });
     return STATUS_SUCCESS;
 }
 
@@ -66,21 +175,1218 @@ STDMETHODIMP CMiniportWaveRTStream::NonDelegatingQueryInterface(REFIID riid, PVO
     return STATUS_NOINTERFACE;
 }
 
-STDMETHODIMP CMiniportWaveRTStream::SetFormat(PKSDATAFORMAT /*DataFormat*/)
+// Only between runs and before a buffer is allocated: the buffer, the clock and
+// the cable conversion are all sized from the format.
+STDMETHODIMP CMiniportWaveRTStream::SetFormat(PKSDATAFORMAT DataFormat)
 {
+    if (!DataFormat) return STATUS_INVALID_PARAMETER;
+    if (m_State != KSSTATE_STOP || m_Mdl) return STATUS_INVALID_DEVICE_STATE;
+
+    NTSTATUS status = ApplyFormat(DataFormat);
+    if (!NT_SUCCESS(status)) return status;
+
+    // Republish under the new format.
+    if (m_Slot)
+    {
+        SharedParameterBlock::ReleaseStreamSlot(m_Slot);
+        m_Slot = nullptr;
+    }
+    ClaimSlot();
+    return STATUS_SUCCESS;
+}
+
+// Takes on Format, which must be one the wave pins admit; null keeps the current
+// one. Render streams apply the topology volume/mute, are mixed onto the cable and
+// can feed the SharedParams meter; the mix bus itself waits for the cable owner.
+NTSTATUS CMiniportWaveRTStream::ApplyFormat(PKSDATAFORMAT Format)
+{
+    if (Format)
+    {
+        WaveFormat wave;
+        NTSTATUS status = FormatIntersection::Parse(Format, Format->FormatSize, &wave);
+        if (!NT_SUCCESS(status)) return status;
+        if (!WaveRangesAdmit(wave)) return STATUS_NOT_SUPPORTED;
+
+        m_Channels     = wave.Channels;
+        m_SampleRate   = wave.SampleRate;
+        m_BlockAlign   = wave.Channels * (wave.ContainerBits / 8);
+        m_ByteRate     = wave.SampleRate * m_BlockAlign;
+        m_SampleFormat = SampleFormatFromWave(wave.Float, wave.ContainerBits / 8);
+    }
+
+    m_MeterReady = FALSE;
+    m_GainReady  = FALSE;
+    if (!m_IsCapture && m_SampleFormat != SampleFormat_Unknown)
+    {
+        m_MeterReady = NT_SUCCESS(m_Meter.Init(m_SampleFormat, m_Channels, m_SampleRate, DetectSimdLevel()));
+        m_GainReady  = NT_SUCCESS(m_Gain.Init(m_SampleFormat, m_Channels, m_SampleRate, DetectSimdLevel()));
+    }
     return STATUS_SUCCESS;
 }
 
 STDMETHODIMP CMiniportWaveRTStream::SetState(KSSTATE State)
 {
+    KSSTATE previous = m_State;
+    if (previous == KSSTATE_RUN && State != KSSTATE_RUN)
+    {
+        StopRegisterTimer();
+        StopListening();
+        ReleaseMeter();
+        LeaveMix();
+        m_Gaining   = FALSE;
+        m_Mixing    = FALSE;
+        m_Planar    = FALSE;
+        m_Listening = FALSE;
+
+        // Bursts belong to the run they were placed in; end the measurement on
+        // what it has found rather than leave it waiting for them.
+        if (m_Marking)
+        {
+            KIRQL irql;
+            KeAcquireSpinLock(&m_Cable->ProbeLock, &irql);
+            if (m_Cable->Probe->GetState() == LatencyProbe_Running) m_Cable->Probe->Stop(FALSE);
+            KeReleaseSpinLock(&m_Cable->ProbeLock, irql);
+            m_Marking = FALSE;
+        }
+    }
+
     m_State = State;
+    if (m_Slot) SharedParameterBlock::SetStreamState(m_Slot, (ULONG)State);
     if (State == KSSTATE_STOP)
+    {
         m_StartTime = 0;
+        m_Registers.Reset();
+        WriteRelease64(&m_ConvertedFrames, 0);
+        WriteNoFence64(&m_ClientWritten, 0);
+        m_ClientOffset  = 0;
+        m_ClientReports = FALSE;
+    }
     else if (State == KSSTATE_RUN)
+    {
         m_StartTime = KeQueryPerformanceCounter(nullptr).QuadPart;
+        m_Clock.Start(m_StartTime, m_Frequency, m_SampleRate, m_BlockAlign, m_BufferSize);
+        m_ConvertOrigin = -1;
+        m_PlayedFrames  = 0;
+
+        // Play starts over at offset 0, so what the client has written so far is
+        // everything up to its last reported offset; 0 there is a full buffer.
+        WriteNoFence64(&m_ClientWritten, m_ClientReports ? (m_ClientOffset ? m_ClientOffset : m_BufferSize) : 0);
+        m_Glitches.Restart();
+
+        // Volume and mute start where the controls are now; later changes ramp.
+        if (m_GainReady && m_DevExt && m_Mapping)
+        {
+            UpdateGain(TRUE);
+            m_Gaining = TRUE;
+
+            // The cable owner's pages are the mix bus; every other running render
+            // stream is summed into them.
+            if (m_OnCable) m_Mixing = m_Mix != nullptr;
+            else           JoinMix();
+        }
+
+        // The first running render stream meters; the rest leave the block alone.
+        if (m_MeterReady && m_DevExt && m_DevExt->SharedParams && m_Mapping &&
+            InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_DevExt->MeterOwner), this, nullptr) == nullptr)
+        {
+            m_Meter.SetBallistics((ULONG)ReadNoFence(&m_DevExt->MeterDecayDb), (ULONG)ReadNoFence(&m_DevExt->MeterRmsMs));
+            m_Meter.Reset();
+            m_Metering = TRUE;
+        }
+    }
+
+    // The render stream owning the cable pages drives every capture position.
+    if (m_Cable && m_OnCable && !m_IsCapture)
+    {
+        if (State == KSSTATE_RUN)
+        {
+            // Latency bursts, once armed, go out over what this run plays.
+            m_Marking = m_Cable->Probe && m_Mapping &&
+                        NT_SUCCESS(m_ProbeCodec.Init(SampleFormat_Float32, m_SampleFormat, 0, DetectSimdLevel()));
+
+            // Captures wait for whatever the DPC changes in place.
+            m_Cable->Cable.SetProcessedFrames((m_Gaining || m_Mixing || m_Marking) ? 0 : LEYLINE_CABLE_ALL_FRAMES);
+
+            LoopbackSourceClock clock;
+            clock.StartQpc     = m_StartTime;
+            clock.Frequency    = m_Frequency;
+            clock.ByteRate     = m_ByteRate;
+            clock.BlockAlign   = m_BlockAlign;
+            clock.BufferSize   = m_BufferSize;
+            clock.SampleFormat = m_SampleFormat;
+            clock.Channels     = m_Channels;
+            PublishCableClock(&clock);
+
+            // The planar side ring takes this run's layout; readers hold the lock.
+            if (m_Cable->CablePlanesStorage && m_Mapping)
+            {
+                KIRQL irql;
+                KeAcquireSpinLock(&m_Cable->PlanesLock, &irql);
+                m_Planar = NT_SUCCESS(m_Cable->CablePlanes.Init(
+                    m_SampleFormat, m_Channels, m_SampleRate, LEYLINE_PLANAR_RING_FRAMES, DetectSimdLevel(),
+                    m_Cable->CablePlanesStorage, PlanarRing::Bytes(LEYLINE_PLANAR_MAX_CHANNELS, LEYLINE_PLANAR_RING_FRAMES)));
+                KeReleaseSpinLock(&m_Cable->PlanesLock, irql);
+            }
+        }
+        else if (previous == KSSTATE_RUN)
+        {
+            // Captures keep running on their own clock; give them silence rather
+            // than the last buffer's worth of audio on repeat.
+            PublishCableClock(nullptr);
+            RtlZeroMemory(m_Mapping, m_BufferSize);
+        }
+    }
+
+    // A capture hearing the cable listens for latency markers from its DPC, so a
+    // measurement armed while it runs finds it ready.
+    if (State == KSSTATE_RUN && m_Cable && m_IsCapture && (m_OnCable || m_CableConvert) && m_Cable->Probe && m_Mapping)
+        m_Listening = NT_SUCCESS(m_ProbeCodec.Init(m_SampleFormat, SampleFormat_Float32, 0, DetectSimdLevel()));
+
+    // Arm last, so the first DPC sees the new clock (and, on the cable, the
+    // published source). Registers the audio engine has not asked for need no
+    // refresh, but a converting cable capture needs the timer regardless: its DPC
+    // is what fills the buffer. So do the gain, mix, meter, planar side ring and
+    // latency probe.
+    if (State == KSSTATE_RUN &&
+        (m_RegistersInUse || m_CableConvert || m_Gaining || m_Mixing || m_MixSource || m_Metering || m_Planar ||
+         m_Marking || m_Listening))
+    {
+        StartRegisterTimer(m_StartTime);
+    }
+
+    if (g_Trace.IsEnabled(TraceEvent_SetState))
+    {
+        LONG64 qpc = State == KSSTATE_RUN ? m_StartTime : KeQueryPerformanceCounter(nullptr).QuadPart;
+        g_Trace.Write(TraceSetState{ m_StreamId, (ULONG)previous, (ULONG)State, 0, qpc });
+    }
+    return STATUS_SUCCESS;
+}
+
+// Publishes the registers for `Now` and starts the periodic refresh at the
+// device's register period.
+void CMiniportWaveRTStream::StartRegisterTimer(LONGLONG Now)
+{
+    if (m_TimerArmed || !m_RegisterTimer) return;
+    m_RegisterPeriodMs = m_DevExt ? (ULONG)ReadNoFence(&m_DevExt->RegisterPeriodMs) : 0;
+    if (m_RegisterPeriodMs == 0) m_RegisterPeriodMs = LEYLINE_DEFAULT_REGISTER_PERIOD_MS;
+
+    PublishPosition(Now);
+    EXT_SET_PARAMETERS parameters;
+    ExInitializeSetTimerParameters(&parameters);
+    LONGLONG period = (LONGLONG)m_RegisterPeriodMs * 10000;
+    ExSetTimer(m_RegisterTimer, -period, period, &parameters);
+    m_TimerArmed = TRUE;
+}
+
+// Cancels the refresh timer and waits out a callback that may already be queued.
+void CMiniportWaveRTStream::StopRegisterTimer()
+{
+    if (!m_TimerArmed) return;
+    ExCancelTimer(m_RegisterTimer, nullptr);
+    KeFlushQueuedDpcs();
+    m_TimerArmed = FALSE;
+}
+
+VOID CMiniportWaveRTStream::RegisterTimerCallback(PEX_TIMER /*Timer*/, PVOID Context)
+{
+    CMiniportWaveRTStream* stream = reinterpret_cast<CMiniportWaveRTStream*>(Context);
+    stream->PublishPosition(KeQueryPerformanceCounter(nullptr).QuadPart);
+}
+
+// Frames the stream has advanced at `Now`. On the cable, a capture stream trails
+// the render play cursor by the configured latency and reads the very pages the
+// render client filled; a converting capture has exactly what PumpCable wrote.
+ULONGLONG CMiniportWaveRTStream::CurrentFrames(LONGLONG Now)
+{
+    if (m_CableConvert)
+        return (ULONGLONG)ReadAcquire64(&m_ConvertedFrames);
+
+    if (m_IsCapture && m_OnCable)
+    {
+        LoopbackSourceClock source;
+        if (m_Cable->Cable.GetSource(&source) && source.SampleFormat == (ULONG)m_SampleFormat &&
+            source.BlockAlign == m_BlockAlign && source.ByteRate == m_ByteRate)
+        {
+            return LoopbackCable::CaptureFrames(m_Clock.FramesBetween(source.StartQpc, Now),
+                                                m_Cable->Cable.GetLatencyFrames(),
+                                                m_Cable->Cable.GetProcessedFrames());
+        }
+    }
+    return m_Clock.FramesAt(Now);
+}
+
+// Converting cable capture: brings the private buffer up to date with what the
+// owner has played by `Now`, less the cable latency, converting the format and,
+// with m_CableResample, the rate. Capture frames are counted continuously across
+// source starts and stops; while no compatible source runs, the capture clock
+// keeps going and produces silence.
+void CMiniportWaveRTStream::PumpCable(LONGLONG Now)
+{
+    const ULONG               sourceRate   = m_CableResample ? m_Resampler.GetInputRate() : m_SampleRate;
+    const LeylineSampleFormat sourceFormat = m_CableResample ? m_SourceDecoder.GetSourceFormat()
+                                                             : m_Converter.GetSourceFormat();
+    const ULONG               latency      = m_Cable->Cable.GetLatencyFrames();
+
+    LoopbackSourceClock source;
+    BOOLEAN live = m_Cable->Cable.GetSource(&source) &&
+                   source.SampleFormat == (ULONG)sourceFormat &&
+                   source.Channels == m_Channels &&
+                   source.ByteRate == sourceRate * source.BlockAlign;
+
+    LONG64    origin = live ? source.StartQpc : 0;
+    ULONGLONG done   = (ULONGLONG)ReadNoFence64(&m_ConvertedFrames);
+
+    // A new source (or none) continues from where the capture is now.
+    if (origin != m_ConvertOrigin)
+    {
+        m_ConvertOrigin = origin;
+        if (live)
+        {
+            m_SourceClock.Start(origin, source.Frequency, sourceRate, source.BlockAlign, source.BufferSize);
+            m_SourceFrames = LoopbackCable::CaptureFrames(m_SourceClock.FramesAt(Now), latency,
+                                                          m_Cable->Cable.GetProcessedFrames());
+            if (m_CableResample) m_Resampler.Reset();
+            m_Glitches.Restart();   // Source frames count from the new origin
+        }
+        else
+        {
+            m_ConvertDelta = (LONG64)(done - m_Clock.FramesAt(Now));
+        }
+    }
+
+    if (live)
+    {
+        done = PumpSource(source, LoopbackCable::CaptureFrames(m_SourceClock.FramesAt(Now), latency,
+                                                               m_Cable->Cable.GetProcessedFrames()), done);
+    }
+    else
+    {
+        ULONGLONG target = m_Clock.FramesAt(Now) + (ULONGLONG)m_ConvertDelta;
+        if ((LONG64)(target - done) > 0)
+        {
+            // More than a buffer behind (a very late DPC): the oldest frames would be
+            // overwritten before anyone could read them, so skip them.
+            const ULONG frames = m_BufferSize / m_BlockAlign;
+            if (target - done > frames) done = target - frames;
+            while (done < target)
+            {
+                ULONG     at = (ULONG)(done % frames);
+                ULONGLONG n  = target - done;
+                if (n > frames - at) n = frames - at;
+                FillSilence(m_SampleFormat, reinterpret_cast<PUCHAR>(m_Mapping) + (SIZE_T)at * m_BlockAlign,
+                            (SIZE_T)n * m_Channels);
+                done += n;
+            }
+        }
+    }
+    WriteRelease64(&m_ConvertedFrames, (LONG64)done);
+}
+
+// Takes owner frames [m_SourceFrames, Available) out of the shared pages.
+ULONGLONG CMiniportWaveRTStream::PumpSource(const LoopbackSourceClock& Source, ULONGLONG Available, ULONGLONG Done)
+{
+    if ((LONG64)(Available - m_SourceFrames) <= 0) return Done;
+
+    // The owner only laps us after a DPC stall longer than its whole buffer; the
+    // frames it overwrote are gone.
+    const ULONG sourceFrames = Source.BufferSize / Source.BlockAlign;
+    ULONGLONG lost = m_Glitches.ObserveCapture(Available, m_SourceFrames, sourceFrames);
+    if (lost)
+    {
+        ReportGlitch(TraceGlitch_Overrun, lost, Done);
+        m_SourceFrames = Available - sourceFrames;
+        if (m_Slot) SharedParameterBlock::CountOverrun(m_Slot);
+    }
+
+    while (m_SourceFrames < Available)
+    {
+        ULONG     from = (ULONG)(m_SourceFrames % sourceFrames);
+        ULONGLONG n    = Available - m_SourceFrames;
+        if (n > sourceFrames - from) n = sourceFrames - from;
+
+        const UCHAR* in = m_Cable->LoopbackBuffer + (SIZE_T)from * Source.BlockAlign;
+        Done = m_CableResample ? ResampleFrames(in, Source.BlockAlign, (ULONG)n, Done)
+                               : WriteCaptureFrames(in, Source.BlockAlign, (ULONG)n, Done);
+        m_SourceFrames += n;
+    }
+    return Done;
+}
+
+// Source frames -> float -> resampler -> m_Converter, through two small stack
+// blocks; the resampler keeps its own history between calls.
+ULONGLONG CMiniportWaveRTStream::ResampleFrames(const UCHAR* In, ULONG Stride, ULONG Count, ULONGLONG Done)
+{
+    float decoded[LEYLINE_CONVERT_CHUNK];
+    float resampled[LEYLINE_CONVERT_CHUNK];
+    const ULONG chunk = LEYLINE_CONVERT_CHUNK / m_Channels;
+
+    for (ULONG pos = 0; pos < Count; )
+    {
+        ULONG take = (Count - pos < chunk) ? Count - pos : chunk;
+        m_SourceDecoder.Convert(In + (SIZE_T)pos * Stride, decoded, (SIZE_T)take * m_Channels);
+
+        for (ULONG used = 0; used < take; )
+        {
+            ULONG consumed;
+            ULONG produced = m_Resampler.Process(decoded + (SIZE_T)used * m_Channels, take - used, &consumed,
+                                                 resampled, chunk);
+            Done  = WriteCaptureFrames(reinterpret_cast<const UCHAR*>(resampled), m_Channels * (ULONG)sizeof(float), produced, Done);
+            used += consumed;
+        }
+        pos += take;
+    }
+    return Done;
+}
+
+// Converts `Count` frames into the private buffer at capture frame `Done`,
+// splitting at the buffer wrap.
+ULONGLONG CMiniportWaveRTStream::WriteCaptureFrames(const UCHAR* In, ULONG Stride, ULONG Count, ULONGLONG Done)
+{
+    const ULONG frames = m_BufferSize / m_BlockAlign;
+    PUCHAR      out    = reinterpret_cast<PUCHAR>(m_Mapping);
+    while (Count)
+    {
+        ULONG at = (ULONG)(Done % frames);
+        ULONG n  = (Count < frames - at) ? Count : frames - at;
+        m_Converter.Convert(In, out + (SIZE_T)at * m_BlockAlign, (SIZE_T)n * m_Channels);
+        In    += (SIZE_T)n * Stride;
+        Count -= n;
+        Done  += n;
+    }
+    return Done;
+}
+
+// Sets up the converting path for a capture whose format or rate differs from the
+// cable owner's. Rate conversion needs a filter bank, built here at PASSIVE_LEVEL.
+NTSTATUS CMiniportWaveRTStream::PrepareCableConversion(LeylineSampleFormat OwnerFormat, ULONG OwnerRate)
+{
+    SimdLevel level = DetectSimdLevel();
+    if (OwnerRate == m_SampleRate)
+        return m_Converter.Init(OwnerFormat, m_SampleFormat, LEYLINE_CONVERT_DITHER, level);
+
+    SrcQuality quality = (SrcQuality)ReadNoFence(&m_DevExt->ResamplerQuality);
+    SIZE_T     bytes   = Resampler::BankBytes(OwnerRate, m_SampleRate, quality);
+    if (bytes == 0) return STATUS_NOT_SUPPORTED;
+
+    NTSTATUS status = m_SourceDecoder.Init(OwnerFormat, SampleFormat_Float32, 0, level);
+    if (NT_SUCCESS(status))
+        status = m_Converter.Init(SampleFormat_Float32, m_SampleFormat, LEYLINE_CONVERT_DITHER, level);
+    if (!NT_SUCCESS(status)) return status;
+
+    m_ResamplerBank = static_cast<float*>(m_DevExt->Objects.Allocate(bytes, 'LLSR'));
+    if (!m_ResamplerBank) return STATUS_INSUFFICIENT_RESOURCES;
+
+    status = m_Resampler.Init(OwnerRate, m_SampleRate, m_Channels, quality, level, m_ResamplerBank, bytes);
+    if (!NT_SUCCESS(status))
+    {
+        ObjectHeap::Free(m_ResamplerBank);
+        m_ResamplerBank = nullptr;
+        return status;
+    }
+    m_CableResample = TRUE;
+    return STATUS_SUCCESS;
+}
+
+// Picks up volume/mute and SharedParams master gain changes: a ramp to the new
+// targets, or with `Jump` a straight switch. A NaN master is ignored; anything
+// else is clamped to [0, 1].
+void CMiniportWaveRTStream::UpdateGain(BOOLEAN Jump)
+{
+    LeylineSharedParameters* params = m_DevExt->SharedParams;
+    LONG  generation = m_Cable->RenderControls.GetGeneration();
+    ULONG masterBits = params ? SharedParameterBlock::GetMasterGainBits(params) : FloatToBits(1.0f);
+    if (!Jump && generation == m_GainGeneration && masterBits == m_GainMasterBits) return;
+    m_GainGeneration = generation;
+    m_GainMasterBits = masterBits;
+
+    float master = BitsToFloat(masterBits);
+    if (master != master) master = 1.0f;
+    if (master < 0.0f)    master = 0.0f;
+    if (master > 1.0f)    master = 1.0f;
+
+    float targets[LEYLINE_GAIN_MAX_CHANNELS];
+    m_Cable->RenderControls.GetTargets(targets, m_Gain.GetChannels(), master);
+    if (Jump) m_Gain.Jump(targets);
+    else      m_Gain.RampTo(targets);
+}
+
+// Where frame `Frame` of this run sits in the buffer, and how many frames follow
+// it there before the wrap.
+PUCHAR CMiniportWaveRTStream::FrameAt(ULONGLONG Frame, ULONG* Contiguous) const
+{
+    ULONG at    = m_Clock.BufferOffset(Frame) / m_BlockAlign;
+    *Contiguous = m_BufferSize / m_BlockAlign - at;
+    return reinterpret_cast<PUCHAR>(m_Mapping) + (SIZE_T)at * m_BlockAlign;
+}
+
+// Runs the frames played since the last period through the gain stage, in place
+// (what the cable captures then read); on the cable owner, adds in the other
+// render streams and lays any latency bursts over the lot; and folds the result
+// into the meter, which so reads post-gain, post-mix levels. If the DPC fell more
+// than a buffer behind, only the last buffer's worth is still there.
+void CMiniportWaveRTStream::ProcessPlayed(ULONGLONG Frames)
+{
+    const ULONG bufferFrames = m_BufferSize / m_BlockAlign;
+    if (bufferFrames == 0) return;
+
+    if (m_Gaining) UpdateGain(FALSE);
+
+    ULONGLONG from = m_PlayedFrames;
+    if (Frames - from > bufferFrames) from = Frames - bufferFrames;
+    m_PlayedFrames = Frames;
+
+    for (ULONGLONG f = from; m_Gaining && f < Frames; )
+    {
+        ULONG  n;
+        PUCHAR frames = FrameAt(f, &n);
+        if (n > Frames - f) n = (ULONG)(Frames - f);
+        m_Gain.Apply(frames, n);
+        f += n;
+    }
+
+    if (m_Mixing)  MixSources(from, Frames);
+    if (m_Marking) MarkPlayed(from, Frames);
+    if (m_Cable && m_OnCable && (m_Gaining || m_Mixing || m_Marking))
+        m_Cable->Cable.SetProcessedFrames(Frames);
+
+    // What the captures hear, spread into one plane per channel.
+    for (ULONGLONG f = from; m_Planar && f < Frames; )
+    {
+        ULONG  n;
+        PUCHAR frames = FrameAt(f, &n);
+        if (n > Frames - f) n = (ULONG)(Frames - f);
+        m_Cable->CablePlanes.Write(frames, n);
+        f += n;
+    }
+
+    // What the owner's DPC may now mix. The silence mark goes first, so a reader
+    // that sees the new count sees it too.
+    if (m_MixSource)
+    {
+        if (!m_Gaining || !m_Gain.IsSilent())
+            WriteNoFence64(&m_SilentFrom, MAXLONG64);
+        else if (ReadNoFence64(&m_SilentFrom) == MAXLONG64)
+            WriteNoFence64(&m_SilentFrom, (LONG64)Frames);
+        WriteRelease64(&m_MixableFrames, (LONG64)Frames);
+    }
+
+    if (!m_Metering) return;
+    for (ULONGLONG f = from; f < Frames; )
+    {
+        ULONG  n;
+        PUCHAR frames = FrameAt(f, &n);
+        if (n > Frames - f) n = (ULONG)(Frames - f);
+        m_Meter.Accumulate(frames, n);
+        f += n;
+    }
+    m_Meter.EndPeriod();
+
+    MeterReading reading;
+    m_Meter.Read(&reading);
+    LeylineSharedParameters* params = m_DevExt->SharedParams;
+    PeakMeter::Publish(&params->Meter, reading);
+    PeakMeter::Publish(&params->Legacy.Meter, reading);
+
+    // The original two fields; mono shows on both.
+    WriteNoFence(reinterpret_cast<volatile LONG*>(&params->Legacy.PeakLBits), (LONG)FloatToBits(reading.Peak[0]));
+    WriteNoFence(reinterpret_cast<volatile LONG*>(&params->Legacy.PeakRBits),
+                 (LONG)FloatToBits(reading.Peak[reading.Channels > 1 ? 1 : 0]));
+}
+
+// Under MixLock. Nonpaged, so the last reference may go at DISPATCH_LEVEL.
+static void ReleaseRoute(MixRoute* Route)
+{
+    if (--Route->Refs == 0) ObjectHeap::Free(Route);
+}
+
+// Under PlanesLock, so a cable owner starting its run cannot change the layout
+// mid-copy; the owner's DPC keeps writing, which the ring itself copes with.
+NTSTATUS ReadCablePlanes(CableEndpoint* Cable, const LeylinePlaneRequest& Request,
+                         PVOID Output, ULONG OutputLength, ULONG_PTR* Written)
+{
+    LeylinePlaneHeader* header = static_cast<LeylinePlaneHeader*>(Output);
+    float*              out    = reinterpret_cast<float*>(header + 1);
+    RtlZeroMemory(header, sizeof(*header));
+
+    KIRQL irql;
+    KeAcquireSpinLock(&Cable->PlanesLock, &irql);
+    PlanarRing& ring     = Cable->CablePlanes;
+    ULONG       channels = ring.GetChannels();
+    NTSTATUS    status   = STATUS_SUCCESS;
+    if (channels && Request.Channel != LEYLINE_PLANES_ALL_CHANNELS && Request.Channel >= channels)
+    {
+        status = STATUS_INVALID_PARAMETER;
+    }
+    else if (channels)
+    {
+        ULONG     width = Request.Channel == LEYLINE_PLANES_ALL_CHANNELS ? channels : 1;
+        ULONG     count = (ULONG)((OutputLength - sizeof(*header)) / (width * sizeof(float)));
+        ULONGLONG from  = Request.Frame;
+        if (count > ring.GetCapacity()) count = ring.GetCapacity();
+
+        header->Frames     = width == 1 ? ring.ReadPlane(Request.Channel, &from, count, out)
+                                        : ring.ReadFrames(&from, count, out);
+        header->Frame      = from;
+        header->Written    = ring.GetWritten();
+        header->Channels   = channels;
+        header->SampleRate = ring.GetSampleRate();
+        header->Capacity   = ring.GetCapacity();
+        *Written = sizeof(*header) + (SIZE_T)header->Frames * width * sizeof(float);
+    }
+    KeReleaseSpinLock(&Cable->PlanesLock, irql);
+
+    if (!channels) *Written = sizeof(*header);
+    return status;
+}
+
+// Builds the new matrix outside the lock, then swaps it into the stream's slot
+// (or a free one). Streams still mixed through the old matrix keep it alive until
+// the owner's next period moves them over.
+NTSTATUS SetMixRoute(DeviceExtension* DevExt, const LeylineRouteConfig* Config, const float* Gains)
+{
+    MixRoute* route = nullptr;
+    if (Config->Inputs)
+    {
+        ULONG  taps  = ChannelRouter::TapCount(Gains, Config->Inputs, Config->Outputs);
+        SIZE_T bytes = sizeof(MixRoute) + ChannelRouter::TableBytes(taps);
+        route = static_cast<MixRoute*>(DevExt->Objects.Allocate(bytes, 'LLRT'));
+        if (!route) return STATUS_INSUFFICIENT_RESOURCES;
+
+        route->Refs     = 1;
+        route->StreamId = Config->StreamId;
+        NTSTATUS status = route->Router.Init(Gains, Config->Inputs, Config->Outputs,
+                                             reinterpret_cast<RouteTap*>(route + 1), bytes - sizeof(MixRoute));
+        if (!NT_SUCCESS(status))
+        {
+            ObjectHeap::Free(route);
+            return status;
+        }
+    }
+
+    KIRQL irql;
+    KeAcquireSpinLock(&DevExt->MixLock, &irql);
+    ULONG at = LEYLINE_ROUTE_SLOTS, unused = LEYLINE_ROUTE_SLOTS;
+    for (ULONG i = 0; i < LEYLINE_ROUTE_SLOTS; ++i)
+    {
+        MixRoute* held = DevExt->Routes[i];
+        if (held && held->StreamId == Config->StreamId) at = i;
+        else if (!held && unused == LEYLINE_ROUTE_SLOTS) unused = i;
+    }
+    if (at == LEYLINE_ROUTE_SLOTS) at = unused;
+    if (at != LEYLINE_ROUTE_SLOTS)
+    {
+        MixRoute* old = DevExt->Routes[at];
+        DevExt->Routes[at] = route;
+        if (old) ReleaseRoute(old);
+        route = nullptr;
+    }
+    KeReleaseSpinLock(&DevExt->MixLock, irql);
+
+    // Every slot taken by another stream.
+    if (route)
+    {
+        ObjectHeap::Free(route);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    return STATUS_SUCCESS;
+}
+
+// Each listed stream's counters, under StreamsLock so none is deleted mid-read.
+// A short buffer still gets the header, with the full count in Streams.
+NTSTATUS ReadGlitchStats(DeviceExtension* DevExt, PVOID Output, ULONG OutputLength, ULONG_PTR* Written)
+{
+    LeylineGlitchReport* report = static_cast<LeylineGlitchReport*>(Output);
+    LeylineGlitchStats*  out    = reinterpret_cast<LeylineGlitchStats*>(report + 1);
+    ULONG                room   = (ULONG)((OutputLength - sizeof(*report)) / sizeof(*out));
+    RtlZeroMemory(report, sizeof(*report));
+
+    KIRQL irql;
+    KeAcquireSpinLock(&DevExt->StreamsLock, &irql);
+    for (ULONG i = 0; i < LEYLINE_MAX_LIVE_STREAMS; ++i)
+    {
+        CMiniportWaveRTStream* stream = DevExt->Streams[i];
+        if (!stream) continue;
+        if (report->Returned < room) stream->GetGlitchStats(&out[report->Returned++]);
+        ++report->Streams;
+    }
+    KeReleaseSpinLock(&DevExt->StreamsLock, irql);
+
+    *Written = sizeof(*report) + (SIZE_T)report->Returned * sizeof(*out);
     return STATUS_SUCCESS;
 }
 
+// The device section, the pool counters, then every listed stream, written in
+// place; the streams' positions are all taken against one QPC reading.
+NTSTATUS ReadSnapshot(DeviceExtension* DevExt, PVOID Output, ULONG OutputLength, ULONG_PTR* Written)
+{
+    LARGE_INTEGER frequency;
+    LONGLONG      now = KeQueryPerformanceCounter(&frequency).QuadPart;
+
+    SnapshotWriter writer;
+    writer.Begin(Output, OutputLength, now, frequency.QuadPart);
+    if (LeylineSnapshotDevice* device = writer.Device())
+    {
+        device->CableCount       = DevExt->CableCount;
+        device->RegisterPeriodMs = (ULONG)ReadNoFence(&DevExt->RegisterPeriodMs);
+        device->ResamplerQuality = (ULONG)ReadNoFence(&DevExt->ResamplerQuality);
+        device->MeterDecayDb     = (ULONG)ReadNoFence(&DevExt->MeterDecayDb);
+        device->MeterRmsMs       = (ULONG)ReadNoFence(&DevExt->MeterRmsMs);
+        device->StreamsCreated   = (ULONG)ReadNoFence(&DevExt->NextStreamId);
+        for (ULONG i = 0; i < DevExt->CableCount; ++i)
+        {
+            CableEndpoint* cable = DevExt->Cables[i];
+            if (!cable) continue;
+            if (cable->Cable.IsEnabled()) device->LoopbackEnabled |= 1u << i;
+            device->LatencyFrames[i] = cable->Cable.GetLatencyFrames();
+        }
+    }
+    if (LeylineBufferPoolStats* pool = writer.Pool()) DevExt->AudioBuffers.GetStats(pool);
+
+    KIRQL irql;
+    KeAcquireSpinLock(&DevExt->StreamsLock, &irql);
+    for (ULONG i = 0; i < LEYLINE_MAX_LIVE_STREAMS; ++i)
+    {
+        CMiniportWaveRTStream* stream = DevExt->Streams[i];
+        if (!stream) continue;
+        if (LeylineSnapshotStream* out = writer.AddStream()) stream->GetSnapshot(out, now);
+    }
+    KeReleaseSpinLock(&DevExt->StreamsLock, irql);
+
+    *Written = writer.Finish();
+    return STATUS_SUCCESS;
+}
+
+// Arms the cable's probe, or with no bursts stops it and drops the applied
+// result. The owner's next period places the bursts.
+NTSTATUS MeasureLatency(CableEndpoint* Cable, const LeylineLatencyConfig& Config)
+{
+    if (!Cable->Probe) return STATUS_DEVICE_NOT_READY;
+
+    KIRQL irql;
+    KeAcquireSpinLock(&Cable->ProbeLock, &irql);
+    if (Config.Bursts) Cable->Probe->Arm(Config.Bursts, Config.IntervalMs, (Config.Flags & LEYLINE_LATENCY_APPLY) != 0);
+    else               Cable->Probe->Stop(TRUE);
+    KeReleaseSpinLock(&Cable->ProbeLock, irql);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS ReadLatency(CableEndpoint* Cable, LeylineLatencyReport* Report)
+{
+    if (!Cable->Probe) return STATUS_DEVICE_NOT_READY;
+
+    KIRQL irql;
+    KeAcquireSpinLock(&Cable->ProbeLock, &irql);
+    Cable->Probe->GetReport(Report);
+    KeReleaseSpinLock(&Cable->ProbeLock, irql);
+    return STATUS_SUCCESS;
+}
+
+// Lists a running render stream that is not on the cable for the owner's DPC to
+// mix. Full list: the stream stays out of the mix.
+void CMiniportWaveRTStream::JoinMix()
+{
+    WriteNoFence64(&m_MixableFrames, 0);
+    WriteNoFence64(&m_SilentFrom, MAXLONG64);
+
+    KIRQL irql;
+    KeAcquireSpinLock(&m_DevExt->MixLock, &irql);
+    if (m_Cable->MixSourceCount < LEYLINE_MIX_MAX_INPUTS)
+    {
+        m_MixedFrames = 0;
+        m_Cable->MixSources[m_Cable->MixSourceCount++] = this;
+        m_MixSource = TRUE;
+    }
+    KeReleaseSpinLock(&m_DevExt->MixLock, irql);
+}
+
+// Once this returns the owner's DPC no longer reads this stream's buffer. Also
+// drops the route the stream was mixed through; the owner calls this with its
+// DPC stopped, for its own.
+void CMiniportWaveRTStream::LeaveMix()
+{
+    if (!m_MixSource && !m_MixRoute) return;
+
+    KIRQL irql;
+    KeAcquireSpinLock(&m_DevExt->MixLock, &irql);
+    for (ULONG i = 0; m_MixSource && i < m_Cable->MixSourceCount; ++i)
+    {
+        if (m_Cable->MixSources[i] != this) continue;
+        m_Cable->MixSources[i] = m_Cable->MixSources[--m_Cable->MixSourceCount];
+        break;
+    }
+    if (m_MixRoute)
+    {
+        ReleaseRoute(m_MixRoute);
+        m_MixRoute = nullptr;
+    }
+    KeReleaseSpinLock(&m_DevExt->MixLock, irql);
+    m_MixSource = FALSE;
+}
+
+// Cable owner: allocated once the stream holds the cable pages. PASSIVE_LEVEL.
+void CMiniportWaveRTStream::PrepareMixBus()
+{
+    if (!m_GainReady || m_Mix) return;
+
+    m_Mix = static_cast<MixBus*>(m_DevExt->Objects.Allocate(sizeof(MixBus), 'LLMX'));
+    if (m_Mix && !NT_SUCCESS(m_Mix->Init(m_SampleFormat, m_Channels, DetectSimdLevel())))
+    {
+        ObjectHeap::Free(m_Mix);
+        m_Mix = nullptr;
+    }
+}
+
+// Cable owner, under MixLock: the route `Stream` goes through into this bus, its
+// own or else the one for every stream, of the right shape; or null.
+MixRoute* CMiniportWaveRTStream::FindRoute(const CMiniportWaveRTStream* Stream) const
+{
+    MixRoute* shared = nullptr;
+    for (ULONG i = 0; i < LEYLINE_ROUTE_SLOTS; ++i)
+    {
+        MixRoute* route = m_DevExt->Routes[i];
+        if (!route || route->Router.GetInputs() != Stream->m_Channels || route->Router.GetOutputs() != m_Channels)
+            continue;
+        if (route->StreamId == Stream->m_StreamId)        return route;
+        if (route->StreamId == LEYLINE_ROUTE_ALL_STREAMS) shared = route;
+    }
+    return shared;
+}
+
+// Cable owner, under MixLock: moves `Stream` onto `Route` for this period and
+// fills in how `Input` is routed. A change crossfades over the `Count` frames
+// from the route last used, where the identity stands for none; with `Fade`
+// clear (a stream's first period) it just switches.
+void CMiniportWaveRTStream::SwitchRoute(CMiniportWaveRTStream* Stream, MixRoute* Route, ULONG Count,
+                                        BOOLEAN Fade, MixInput* Input)
+{
+    MixRoute*            previous = Stream->m_MixRoute;
+    const ChannelRouter* identity = Stream->m_Channels == m_Channels ? m_Mix->GetIdentity() : nullptr;
+
+    Input->Route = Route ? &Route->Router : nullptr;
+    if (Route == previous) return;
+
+    const ChannelRouter* from = previous ? &previous->Router : identity;
+    const ChannelRouter* to   = Route    ? &Route->Router    : identity;
+    if (Fade && from && to)
+    {
+        Input->Route    = to;
+        Input->FadeFrom = from;
+        Input->FadeStep = 1.0f / Count;
+    }
+
+    if (Route) ++Route->Refs;
+    if (previous) ReleaseRoute(previous);
+    Stream->m_MixRoute = Route;
+}
+
+// Cable owner: adds the listed render streams into [From, To) of its own run,
+// which it has just played. Each source gives the same number of frames, taken
+// from where the last period left off and only from what its own DPC has been
+// through (so its gain is in). A source less than a period ahead waits for the
+// next one; one more than half its buffer behind skips ahead. Streams at another
+// rate, or at another channel count without a route, and stretches muted
+// throughout, are left out. The owner's own frames are re-read only when they
+// have a route.
+void CMiniportWaveRTStream::MixSources(ULONGLONG From, ULONGLONG To)
+{
+    const ULONG count = (ULONG)(To - From);
+    if (count == 0) return;
+
+    // Slot 0 is the owner itself.
+    CMiniportWaveRTStream* streams[LEYLINE_MIX_MAX_INPUTS + 1];
+    ULONGLONG              next[LEYLINE_MIX_MAX_INPUTS + 1];
+    MixInput               inputs[LEYLINE_MIX_MAX_INPUTS + 1];
+    ULONG                  live = 1;
+
+    // Held across the mix: a source cannot leave, and so free its buffer, nor a
+    // route be freed, until this is done reading them.
+    KIRQL irql;
+    KeAcquireSpinLock(&m_DevExt->MixLock, &irql);
+
+    inputs[0]        = {};
+    inputs[0].Format = m_SampleFormat;
+    SwitchRoute(this, FindRoute(this), count, TRUE, &inputs[0]);
+    const ULONG base = inputs[0].Route ? 0 : 1;
+
+    for (ULONG i = 0; i < m_Cable->MixSourceCount; ++i)
+    {
+        CMiniportWaveRTStream* s = m_Cable->MixSources[i];
+        if (s->m_SampleRate != m_SampleRate) continue;
+
+        MixRoute* route = FindRoute(s);
+        if (!route && s->m_Channels != m_Channels) continue;
+
+        ULONGLONG ready  = (ULONGLONG)ReadAcquire64(&s->m_MixableFrames);
+        ULONGLONG silent = (ULONGLONG)ReadNoFence64(&s->m_SilentFrom);
+        ULONGLONG slack  = s->m_BufferSize / s->m_BlockAlign / 2;
+        BOOLEAN   fade   = s->m_MixedFrames != 0;
+        if (ready - s->m_MixedFrames > slack + count)
+        {
+            s->ReportGlitch(TraceGlitch_Overrun, ready - count - s->m_MixedFrames, s->m_MixedFrames);
+            s->m_Glitches.Record(GlitchKind_Overrun, ready - count - s->m_MixedFrames, s->m_MixedFrames);
+            s->m_MixedFrames = ready - count;
+            if (s->m_Slot) SharedParameterBlock::CountOverrun(s->m_Slot);
+        }
+        if (ready - s->m_MixedFrames < count)
+        {
+            // Short after it has been mixed before: the source fell behind the bus.
+            if (fade)
+            {
+                s->ReportGlitch(TraceGlitch_Underrun, count - (ready - s->m_MixedFrames), s->m_MixedFrames);
+                s->m_Glitches.Record(GlitchKind_Underrun, count - (ready - s->m_MixedFrames), s->m_MixedFrames);
+                if (s->m_Slot) SharedParameterBlock::CountUnderrun(s->m_Slot);
+            }
+            continue;
+        }
+
+        inputs[live]        = {};
+        inputs[live].Format = s->m_SampleFormat;
+        SwitchRoute(s, route, count, fade, &inputs[live]);
+
+        ULONGLONG at = s->m_MixedFrames;
+        s->m_MixedFrames += count;
+        if (at >= silent) continue;
+
+        streams[live] = s;
+        next[live]    = at;
+        ++live;
+    }
+
+    for (ULONGLONG f = From; live > base && f < To; )
+    {
+        ULONG  n;
+        PUCHAR bus = FrameAt(f, &n);
+        if (n > To - f) n = (ULONG)(To - f);
+
+        inputs[0].Samples = bus;
+        for (ULONG i = 1; i < live; ++i)
+        {
+            ULONG contiguous;
+            inputs[i].Samples = streams[i]->FrameAt(next[i], &contiguous);
+            if (n > contiguous) n = contiguous;
+        }
+        for (ULONG i = base; i < live; ++i) inputs[i].Fade = (float)(f - From) * inputs[i].FadeStep;
+
+        m_Mix->Mix(inputs + base, live - base, bus, n, base != 0);
+
+        for (ULONG i = 1; i < live; ++i) next[i] += n;
+        f += n;
+    }
+    KeReleaseSpinLock(&m_DevExt->MixLock, irql);
+}
+
+// Lists the stream in the shared block's telemetry slots from NewStream on. With
+// every slot taken the stream just goes unlisted.
+void CMiniportWaveRTStream::ClaimSlot()
+{
+    if (!m_DevExt || !m_DevExt->SharedParams) return;
+
+    LeylineStreamInfo info = {};
+    info.StreamId     = m_StreamId;
+    info.Direction    = m_IsCapture ? LEYLINE_STREAM_CAPTURE : LEYLINE_STREAM_RENDER;
+    info.SampleFormat = (ULONG)m_SampleFormat;
+    info.Channels     = m_Channels;
+    info.SampleRate   = m_SampleRate;
+    m_Slot = SharedParameterBlock::ClaimStreamSlot(m_DevExt->SharedParams, info);
+}
+
+// Lists the stream for IOCTL_LEYLINE_GET_GLITCH_STATS, from NewStream until it is
+// deleted. With every entry taken the stream just goes unreported.
+void CMiniportWaveRTStream::List()
+{
+    if (!m_DevExt) return;
+
+    KIRQL irql;
+    KeAcquireSpinLock(&m_DevExt->StreamsLock, &irql);
+    for (ULONG i = 0; i < LEYLINE_MAX_LIVE_STREAMS; ++i)
+    {
+        if (m_DevExt->Streams[i]) continue;
+        m_DevExt->Streams[i] = this;
+        m_Listed = TRUE;
+        break;
+    }
+    KeReleaseSpinLock(&m_DevExt->StreamsLock, irql);
+}
+
+// Once this returns no IOCTL reader holds the stream.
+void CMiniportWaveRTStream::Unlist()
+{
+    if (!m_Listed) return;
+
+    KIRQL irql;
+    KeAcquireSpinLock(&m_DevExt->StreamsLock, &irql);
+    for (ULONG i = 0; i < LEYLINE_MAX_LIVE_STREAMS; ++i)
+    {
+        if (m_DevExt->Streams[i] == this) m_DevExt->Streams[i] = nullptr;
+    }
+    KeReleaseSpinLock(&m_DevExt->StreamsLock, irql);
+    m_Listed = FALSE;
+}
+
+void CMiniportWaveRTStream::GetGlitchStats(LeylineGlitchStats* Stats) const
+{
+    RtlZeroMemory(Stats, sizeof(*Stats));
+    m_Glitches.GetStats(Stats);
+    Stats->StreamId   = m_StreamId;
+    Stats->Direction  = m_IsCapture ? LEYLINE_STREAM_CAPTURE : LEYLINE_STREAM_RENDER;
+    Stats->SampleRate = m_SampleRate;
+}
+
+// Each field the stream's own threads change is read once, not all from one
+// instant: a stream changing state mid-snapshot may show its old position.
+void CMiniportWaveRTStream::GetSnapshot(LeylineSnapshotStream* Snapshot, LONGLONG Now)
+{
+    LeylineGlitchStats glitches;
+    GetGlitchStats(&glitches);
+
+    KSSTATE  state     = m_State;
+    LONGLONG startTime = m_StartTime;
+    ULONG    flags     = 0;
+    if (m_OnCable)                 flags |= LEYLINE_SNAPSHOT_ON_CABLE;
+    if (m_OnCable && !m_IsCapture) flags |= LEYLINE_SNAPSHOT_CABLE_OWNER;
+    if (m_CableConvert)            flags |= LEYLINE_SNAPSHOT_CONVERTING;
+    if (m_CableResample)           flags |= LEYLINE_SNAPSHOT_RESAMPLING;
+    if (m_Gaining)                 flags |= LEYLINE_SNAPSHOT_GAIN;
+    if (m_Mixing)                  flags |= LEYLINE_SNAPSHOT_MIXING;
+    if (m_MixSource)               flags |= LEYLINE_SNAPSHOT_MIX_SOURCE;
+    if (m_Metering)                flags |= LEYLINE_SNAPSHOT_METERING;
+    if (m_RegistersInUse)          flags |= LEYLINE_SNAPSHOT_REGISTERS;
+    if (m_ClientReports)           flags |= LEYLINE_SNAPSHOT_CLIENT_WRITES;
+
+    Snapshot->StreamId     = m_StreamId;
+    Snapshot->Direction    = glitches.Direction;
+    Snapshot->Cable        = m_Cable ? m_Cable->Index : 0;
+    Snapshot->State        = (ULONG)state;
+    Snapshot->Flags        = flags;
+    Snapshot->SampleFormat = (ULONG)m_SampleFormat;
+    Snapshot->SampleRate   = m_SampleRate;
+    Snapshot->Channels     = m_Channels;
+    Snapshot->BlockAlign   = m_BlockAlign;
+    Snapshot->BufferSize   = m_BufferSize;
+    Snapshot->Underruns    = glitches.Underruns;
+    Snapshot->Overruns     = glitches.Overruns;
+    Snapshot->GlitchFrames = glitches.GlitchFrames;
+    Snapshot->Periods      = glitches.Periods;
+    if (state == KSSTATE_RUN && startTime && m_BufferSize)
+    {
+        ULONGLONG frames   = CurrentFrames(Now);
+        Snapshot->Frames   = frames;
+        Snapshot->Position = m_Clock.BufferOffset(frames);
+        Snapshot->StartQpc = startTime;
+    }
+}
+
+// The offset is where the client's data ends, so it only moves forward and wraps;
+// a report at the offset last seen means nothing new. The audio engine sends one
+// per period, well inside a buffer's worth.
+NTSTATUS CMiniportWaveRTStream::SetClientWritePosition(ULONG Offset)
+{
+    if (m_IsCapture) return STATUS_INVALID_DEVICE_REQUEST;
+    if (Offset >= m_BufferSize || Offset % m_BlockAlign) return STATUS_INVALID_PARAMETER;
+
+    ULONG advance = Offset >= m_ClientOffset ? Offset - m_ClientOffset : m_BufferSize - m_ClientOffset + Offset;
+    m_ClientOffset  = Offset;
+    m_ClientReports = TRUE;
+    if (m_State == KSSTATE_RUN) WriteRelease64(&m_ClientWritten, ReadNoFence64(&m_ClientWritten) + advance);
+    return STATUS_SUCCESS;
+}
+
+// Render DPC: has the device played past what the client wrote? Only once the
+// client reports, which the audio engine does outside packet mode on request.
+void CMiniportWaveRTStream::ObserveClient(ULONGLONG Frames)
+{
+    if (m_IsCapture || !m_ClientReports) return;
+
+    GlitchKind before  = m_Glitches.Active();
+    ULONGLONG  written = (ULONGLONG)ReadAcquire64(&m_ClientWritten) / m_BlockAlign;
+    ULONGLONG  starved = m_Glitches.ObserveRender(Frames, written);
+    if (!starved) return;
+
+    ReportGlitch(TraceGlitch_Underrun, starved, Frames - starved);
+    if (before != GlitchKind_Underrun && m_Slot) SharedParameterBlock::CountUnderrun(m_Slot);
+}
+
+// Clears the published levels and lets another render stream meter. Only called
+// with the timer stopped.
+void CMiniportWaveRTStream::ReleaseMeter()
+{
+    if (!m_Metering) return;
+    m_Metering = FALSE;
+
+    MeterReading silent = {};
+    LeylineSharedParameters* params = m_DevExt->SharedParams;
+    PeakMeter::Publish(&params->Meter, silent);
+    PeakMeter::Publish(&params->Legacy.Meter, silent);
+    WriteNoFence(reinterpret_cast<volatile LONG*>(&params->Legacy.PeakLBits), 0);
+    WriteNoFence(reinterpret_cast<volatile LONG*>(&params->Legacy.PeakRBits), 0);
+    InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_DevExt->MeterOwner), nullptr, this);
+}
+
+// Cable owner: lays the probe's bursts over frames [From, To), the same chip on
+// every channel, after the mix so every capture hears them whole. Encoded through
+// a small stack block like the cable conversion.
+void CMiniportWaveRTStream::MarkPlayed(ULONGLONG From, ULONGLONG To)
+{
+    LatencyProbe*     probe = m_Cable->Probe;
+    LatencyProbeState state = probe->GetState();
+    if (state != LatencyProbe_Armed && state != LatencyProbe_Running) return;
+
+    float       chips[LEYLINE_CONVERT_CHUNK];
+    const ULONG chunk = LEYLINE_CONVERT_CHUNK / m_Channels;
+
+    KIRQL irql;
+    KeAcquireSpinLock(&m_Cable->ProbeLock, &irql);
+    if (probe->Begin(From, m_StartTime, m_Frequency, m_SampleRate))
+    {
+        LatencyBurst burst;
+        for (ULONGLONG f = From; probe->NextBurst(f, To, &burst); f = burst.Frame + burst.Frames)
+        {
+            for (ULONG done = 0; done < burst.Frames; )
+            {
+                ULONG  n;
+                PUCHAR out = FrameAt(burst.Frame + done, &n);
+                if (n > burst.Frames - done) n = burst.Frames - done;
+                if (n > chunk) n = chunk;
+
+                const float* marker = probe->GetMarker() + burst.Chip + done;
+                for (ULONG i = 0; i < n; ++i)
+                    for (ULONG c = 0; c < m_Channels; ++c)
+                        chips[i * m_Channels + c] = LEYLINE_LATENCY_MARKER_LEVEL * marker[i];
+                m_ProbeCodec.Convert(chips, out, (SIZE_T)n * m_Channels);
+                done += n;
+            }
+        }
+        probe->Advance(To);
+    }
+    KeReleaseSpinLock(&m_Cable->ProbeLock, irql);
+}
+
+// Cable capture DPC: the first capture running once a measurement starts claims
+// the probe and feeds it channel 0 of what it delivers from then on. Reading the
+// owner's pages directly, it stops at what the owner has marked; frames past that
+// may still have a burst laid over them.
+void CMiniportWaveRTStream::ListenForMarkers(ULONGLONG Frames, LONGLONG Now)
+{
+    LatencyProbe* probe = m_Cable->Probe;
+    if (probe->GetState() != LatencyProbe_Running)
+    {
+        StopListening();
+        return;
+    }
+
+    const BOOLEAN direct = !m_CableConvert;
+    if (direct && Frames > probe->GetMarked()) Frames = probe->GetMarked();
+
+    if (!m_Probing)
+    {
+        if (InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_Cable->ProbeListener), this, nullptr) != nullptr)
+            return;
+        m_Probing     = TRUE;
+        m_ProbeFrames = Frames;
+        probe->StartCapture(Frames, Now, direct);
+        return;
+    }
+
+    // Positions that went back (a new owner run under a direct capture) start over.
+    if (Frames < m_ProbeFrames)
+    {
+        m_ProbeFrames = Frames;
+        probe->StartCapture(Frames, Now, direct);
+        return;
+    }
+
+    probe->Observe(Frames, Now);
+    const ULONG bufferFrames = m_BufferSize / m_BlockAlign;
+    if (Frames - m_ProbeFrames > bufferFrames) m_ProbeFrames = Frames - bufferFrames;
+
+    float       decoded[LEYLINE_CONVERT_CHUNK];
+    const ULONG chunk = LEYLINE_CONVERT_CHUNK / m_Channels;
+    while (m_ProbeFrames < Frames)
+    {
+        ULONG        n;
+        const UCHAR* in = FrameAt(m_ProbeFrames, &n);
+        if (n > Frames - m_ProbeFrames) n = (ULONG)(Frames - m_ProbeFrames);
+        if (n > chunk) n = chunk;
+
+        // Channel 0, packed down in place.
+        m_ProbeCodec.Convert(in, decoded, (SIZE_T)n * m_Channels);
+        for (ULONG i = 1; i < n; ++i) decoded[i] = decoded[i * m_Channels];
+
+        LONG64 seen[4];
+        ULONG  found = probe->Capture(decoded, n, m_ProbeFrames, seen, sizeof(seen) / sizeof(seen[0]));
+        m_ProbeFrames += n;
+        if (!found) continue;
+
+        KIRQL irql;
+        KeAcquireSpinLock(&m_Cable->ProbeLock, &irql);
+        for (ULONG i = 0; i < found; ++i) probe->Match(seen[i]);
+        KeReleaseSpinLock(&m_Cable->ProbeLock, irql);
+    }
+}
+
+// Lets another capture time the next measurement. From the DPC, or with the
+// timer stopped.
+void CMiniportWaveRTStream::StopListening()
+{
+    if (!m_Probing) return;
+    m_Probing = FALSE;
+    InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_Cable->ProbeListener), nullptr, this);
+}
+
+// For trace sessions listening for glitches; the SharedParams slot keeps the counts.
+void CMiniportWaveRTStream::ReportGlitch(TraceGlitchKind Kind, ULONGLONG Frames, ULONGLONG AtFrame) const
+{
+    g_Trace.Write(TraceGlitch{ m_StreamId, Kind, Frames > MAXULONG ? MAXULONG : (ULONG)Frames, 0, AtFrame });
+}
+
+// Refreshes the register page, the tool-facing SharedParams cursor and, for
+// render streams, the gain and levels of what was played; cable captures listen
+// for latency markers in what they delivered.
+void CMiniportWaveRTStream::PublishPosition(LONGLONG Now)
+{
+    if (m_CableConvert) PumpCable(Now);
+
+    ULONGLONG frames = CurrentFrames(Now);
+    ULONG     pos    = m_Clock.BufferOffset(frames);
+
+    m_Registers.Publish(Now, frames, pos);
+    if (m_Gaining || m_Mixing || m_MixSource || m_Metering || m_Planar || m_Marking) ProcessPlayed(frames);
+    ObserveClient(frames);
+    if (m_Listening) ListenForMarkers(frames, Now);
+
+    PublishSharedPosition(pos, frames, Now);
+}
+
+// The cable owner's clock, or none. Capture DPCs read it under its sequence and
+// spin while it is odd, so the update must not be preempted on this processor.
+void CMiniportWaveRTStream::PublishCableClock(const LoopbackSourceClock* Clock)
+{
+    KIRQL irql;
+    KeRaiseIrql(DISPATCH_LEVEL, &irql);
+    if (Clock) m_Cable->Cable.PublishSource(*Clock);
+    else       m_Cable->Cable.RetractSource();
+    KeLowerIrql(irql);
+}
+
+// The v2 position line and this stream's slot under their sequences, then the v1
+// field. Raised to DISPATCH_LEVEL so a GetPosition caller cannot be preempted
+// halfway and leave readers spinning.
+void CMiniportWaveRTStream::PublishSharedPosition(ULONG Position, ULONGLONG Frames, LONGLONG Now)
+{
+    LeylineSharedParameters* params = m_DevExt ? m_DevExt->SharedParams : nullptr;
+    if (!params) return;
+
+    LeylinePosition position = { Position, m_BufferSize, m_ByteRate, m_StartTime, Now };
+    KIRQL irql;
+    KeRaiseIrql(DISPATCH_LEVEL, &irql);
+    SharedParameterBlock::PublishPosition(m_IsCapture ? &params->Capture : &params->Render, position);
+    if (m_Slot) SharedParameterBlock::PublishStreamProgress(m_Slot, Position, Frames, Now);
+    KeLowerIrql(irql);
+
+    if (!m_IsCapture) params->Legacy.WritePos = Position;
+    else params->Legacy.ReadPos = Position;
+}
+
 STDMETHODIMP CMiniportWaveRTStream::GetPosition(PKSAUDIO_POSITION Position)
 {
     if (!Position) return STATUS_INVALID_PARAMETER;
@@ -92,21 +1398,17 @@ STDMETHODIMP CMiniportWaveRTStream::GetPosition(PKSAUDIO_POSITION Position)
         return STATUS_SUCCESS;
     }
 
-    LONGLONG now     = KeQueryPerformanceCounter(nullptr).QuadPart;
-    LONGLONG elapsed = now - m_StartTime;
-    ULONGLONG bytes  = WaveRTMath::TicksToBytes(elapsed, m_ByteRate, m_Frequency);
+    LONGLONG  now    = KeQueryPerformanceCounter(nullptr).QuadPart;
+    ULONGLONG frames = CurrentFrames(now);
+    ULONG     pos    = m_Clock.BufferOffset(frames);
 
-    SIZE_T size = m_Buffer.GetSize();
-    ULONGLONG pos = (size > 0) ? (bytes % (ULONGLONG)size) : 0;
-    
     Position->PlayOffset = pos;
     Position->WriteOffset = pos;
 
-    if (m_DevExt && m_DevExt->SharedParams)
-    {
-        if (!m_IsCapture) m_DevExt->SharedParams->WritePos = (ULONG)pos;
-        else m_DevExt->SharedParams->ReadPos = (ULONG)pos;
-    }
+    PublishSharedPosition(pos, frames, now);
+
+    if (g_Trace.IsEnabled(TraceEvent_Position) && TraceProvider::Sample(&m_PositionCalls, LEYLINE_TRACE_POSITION_SAMPLE))
+        g_Trace.Write(TracePosition{ m_StreamId, pos, frames, now });
 
     return STATUS_SUCCESS;
 }
@@ -116,42 +1418,129 @@ STDMETHODIMP CMiniportWaveRTStream::AllocateAudioBuffer(
     ULONG* ActualSize, ULONG* OffsetFromFirstPage,
     MEMORY_CACHING_TYPE* CacheType)
 {
-    if (m_Mdl) return STATUS_ALREADY_COMMITTED;
+    if (!g_Trace.IsEnabled(TraceEvent_AllocateBuffer))
+        return AssignAudioBuffer(RequestedSize, AudioBufferMdl, ActualSize, OffsetFromFirstPage, CacheType);
 
-    PHYSICAL_ADDRESS low  = { 0 }, high = { 0 }, skip = { 0 };
-    high.LowPart = 0xFFFFFFFF;
+    LONGLONG start  = KeQueryPerformanceCounter(nullptr).QuadPart;
+    NTSTATUS status = AssignAudioBuffer(RequestedSize, AudioBufferMdl, ActualSize, OffsetFromFirstPage, CacheType);
+    LONGLONG ticks  = KeQueryPerformanceCounter(nullptr).QuadPart - start;
 
-    PMDL mdl = MmAllocatePagesForMdlEx(low, high, skip, RequestedSize, MmCached, MM_ALLOCATE_FULLY_REQUIRED);
-    if (!mdl)
+    TraceAllocateBuffer event = {};
+    event.StreamId       = m_StreamId;
+    event.Status         = status;
+    event.RequestedBytes = RequestedSize;
+    if (NT_SUCCESS(status))
     {
-        if (m_DevExt && m_DevExt->LoopbackMdl)
+        event.ActualBytes = m_BufferSize;
+        event.BufferUs    = (ULONG)((ULONGLONG)m_BufferSize * 1000000 / m_ByteRate);
+        event.Flags       = (m_OwnsMdl ? 0 : LEYLINE_TRACE_BUFFER_CABLE) |
+                            (m_Pooled ? LEYLINE_TRACE_BUFFER_POOLED : 0) |
+                            (m_CableConvert ? LEYLINE_TRACE_BUFFER_CONVERT : 0);
+    }
+    event.ElapsedNs = m_Frequency ? (ULONG64)ticks * 1000000000ull / (ULONG64)m_Frequency : 0;
+    g_Trace.Write(event);
+    return status;
+}
+
+// The allocation itself; AllocateAudioBuffer wraps it in the trace event.
+NTSTATUS CMiniportWaveRTStream::AssignAudioBuffer(
+    ULONG RequestedSize, PMDL* AudioBufferMdl,
+    ULONG* ActualSize, ULONG* OffsetFromFirstPage,
+    MEMORY_CACHING_TYPE* CacheType)
+{
+    if (m_Mdl) return STATUS_ALREADY_COMMITTED;
+
+    // Virtual-cable mode: the first render stream and every capture stream map
+    // the shared loopback pages, so capture reads what was rendered with no copy.
+    // A capture whose format or rate differs from the owner's gets its own buffer
+    // and a converter (and resampler) instead.
+    if (m_Cable && m_Cable->LoopbackMdl && m_Cable->Cable.IsEnabled())
+    {
+        // An owner reallocating after FreeAudioBuffer still holds the cable.
+        PVOID   owner   = m_IsCapture ? nullptr :
+            InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_Cable->CableOwner), this, nullptr);
+        BOOLEAN claimed = m_IsCapture || owner == nullptr || owner == this;
+        if (claimed)
         {
-            m_Mdl     = m_DevExt->LoopbackMdl;
-            m_Mapping = m_DevExt->LoopbackBuffer;
-            m_Buffer.Init(m_DevExt->LoopbackBuffer, m_DevExt->LoopbackSize);
-            m_OwnsMdl = FALSE;
-            if (AudioBufferMdl)     *AudioBufferMdl     = m_Mdl;
-            if (ActualSize)         *ActualSize         = (ULONG)m_DevExt->LoopbackSize;
-            if (OffsetFromFirstPage) *OffsetFromFirstPage = 0;
-            if (CacheType)          *CacheType          = MmCached;
-            return STATUS_SUCCESS;
+            m_OnCable = TRUE;
+            if (!m_IsCapture)
+            {
+                m_Cable->Cable.SetOwnerFormat(m_SampleFormat, m_Channels, m_SampleRate);
+                PrepareMixBus();
+            }
+
+            LeylineSampleFormat ownerFormat;
+            ULONG ownerChannels, ownerRate;
+            if (m_IsCapture && m_Cable->Cable.GetOwnerFormat(&ownerFormat, &ownerChannels, &ownerRate) &&
+                (ownerFormat != m_SampleFormat || ownerRate != m_SampleRate) && ownerChannels == m_Channels &&
+                NT_SUCCESS(PrepareCableConversion(ownerFormat, ownerRate)))
+            {
+                m_CableConvert = TRUE;
+            }
+            else
+            {
+                return UseSharedBuffer(AudioBufferMdl, ActualSize, OffsetFromFirstPage, CacheType);
+            }
         }
-        return STATUS_INSUFFICIENT_RESOURCES;
     }
 
-    m_Mapping = MmMapLockedPagesSpecifyCache(mdl, KernelMode, MmCached, nullptr, FALSE, NormalPagePriority);
-    if (!m_Mapping)
+    // A reserved block when the device has one to spare; the MDL may cover more
+    // than the buffer, which only ever uses ActualSize bytes of it.
+    m_Pooled = m_DevExt && m_DevExt->AudioBuffers.IsReady();
+    NTSTATUS status;
+    if (m_Pooled)
+    {
+        status = m_DevExt->AudioBuffers.Acquire(RequestedSize, &m_Pages);
+    }
+    else
+    {
+        LockedPageSource pages;
+        m_Pages.Class = LEYLINE_POOL_UNPOOLED;
+        status = pages.Allocate(RequestedSize, &m_Pages.Block);
+    }
+    if (!NT_SUCCESS(status))
     {
-        IoFreeMdl(mdl);
+        // The shared pages hold the owner's format, not ours.
+        if (m_CableConvert) return STATUS_INSUFFICIENT_RESOURCES;
+        if (m_Cable && m_Cable->LoopbackMdl)
+            return UseSharedBuffer(AudioBufferMdl, ActualSize, OffsetFromFirstPage, CacheType);
         return STATUS_INSUFFICIENT_RESOURCES;
     }
 
-    m_Mdl     = mdl;
+    // The cable pump converts whole frames, so its buffer is trimmed like the
+    // shared one.
+    ULONG size = m_CableConvert ? RequestedSize - RequestedSize % m_BlockAlign : RequestedSize;
+
+    m_Mdl     = static_cast<PMDL>(m_Pages.Block.Handle);
+    m_Mapping = m_Pages.Block.Address;
     m_OwnsMdl = TRUE;
-    m_Buffer.Init(reinterpret_cast<PUCHAR>(m_Mapping), RequestedSize);
+    m_BufferSize = size;
+
+    // Fresh pages come zeroed; a recycled block still holds its last stream's audio.
+    if (m_CableConvert)  FillSilence(m_SampleFormat, m_Mapping, size / m_BlockAlign * m_Channels);
+    else if (m_Pooled)   RtlZeroMemory(m_Mapping, size);
+
+    if (AudioBufferMdl)      *AudioBufferMdl      = m_Mdl;
+    if (ActualSize)          *ActualSize          = size;
+    if (OffsetFromFirstPage) *OffsetFromFirstPage = 0;
+    if (CacheType)           *CacheType           = MmCached;
+    return STATUS_SUCCESS;
+}
+
+// Hands out the device-wide loopback pages, trimmed to a whole number of frames.
+NTSTATUS CMiniportWaveRTStream::UseSharedBuffer(PMDL* AudioBufferMdl, ULONG* ActualSize,
+                                                ULONG* OffsetFromFirstPage, MEMORY_CACHING_TYPE* CacheType)
+{
+    ULONG size = (ULONG)m_Cable->LoopbackSize;
+    size -= size % m_BlockAlign;
+
+    m_Mdl        = m_Cable->LoopbackMdl;
+    m_Mapping    = m_Cable->LoopbackBuffer;
+    m_OwnsMdl    = FALSE;
+    m_BufferSize = size;
 
     if (AudioBufferMdl)      *AudioBufferMdl      = m_Mdl;
-    if (ActualSize)          *ActualSize          = RequestedSize;
+    if (ActualSize)          *ActualSize          = size;
     if (OffsetFromFirstPage) *OffsetFromFirstPage = 0;
     if (CacheType)           *CacheType           = MmCached;
     return STATUS_SUCCESS;
@@ -159,39 +1548,109 @@ STDMETHODIMP CMiniportWaveRTStream::AllocateAudioBuffer(
 
 STDMETHODIMP_(void) CMiniportWaveRTStream::FreeAudioBuffer(PMDL /*AudioBufferMdl*/, ULONG /*BufferSize*/)
 {
-    return;
+    ReleaseAudioBuffer();
+}
+
+// Gives private pages back (to the pool, when they came from it) and lets go of
+// the shared ones, so AllocateAudioBuffer can run again. The stream is stopped.
+// Cable ownership stays with the stream until it is destroyed.
+void CMiniportWaveRTStream::ReleaseAudioBuffer()
+{
+    if (m_ResamplerBank)
+    {
+        ObjectHeap::Free(m_ResamplerBank);
+        m_ResamplerBank = nullptr;
+    }
+    m_CableConvert  = FALSE;
+    m_CableResample = FALSE;
+
+    if (m_OwnsMdl && m_Mdl)
+    {
+        if (m_Pooled)
+        {
+            m_DevExt->AudioBuffers.Release(m_Pages);
+        }
+        else
+        {
+            LockedPageSource pages;
+            pages.Free(m_Pages.Block);
+        }
+    }
+    m_Mdl        = nullptr;
+    m_Mapping    = nullptr;
+    m_OwnsMdl    = FALSE;
+    m_Pooled     = FALSE;
+    m_BufferSize = 0;
 }
 
+// No hardware FIFO or codec; a cable capture reports the latency measured through
+// IOCTL_LEYLINE_MEASURE_LATENCY with LEYLINE_LATENCY_APPLY, in 100 ns units.
 STDMETHODIMP_(void) CMiniportWaveRTStream::GetHWLatency(KSRTAUDIO_HWLATENCY* Latency)
 {
     if (Latency)
     {
+        ULONG measuredUs = (m_IsCapture && m_Cable && m_Cable->Probe) ? m_Cable->Probe->GetAppliedUs() : 0;
         Latency->FifoSize     = 0;
         Latency->ChipsetDelay = 0;
-        Latency->CodecDelay   = 0;
+        Latency->CodecDelay   = measuredUs * 10;
     }
 }
 
-STDMETHODIMP CMiniportWaveRTStream::GetPositionRegister(KSRTAUDIO_HWREGISTER* /*Register*/)
+// From the first register handed out the page is kept fresh on every run; a
+// stream already running starts its timer now. PortCls serializes these calls
+// with SetState.
+void CMiniportWaveRTStream::UseRegisters()
+{
+    m_RegistersInUse = TRUE;
+    if (m_State == KSSTATE_RUN) StartRegisterTimer(KeQueryPerformanceCounter(nullptr).QuadPart);
+}
+
+// Both registers live on the stream's register page; PortCls maps that page into
+// the client and the client polls it instead of issuing KSPROPERTY_AUDIO_POSITION.
+STDMETHODIMP CMiniportWaveRTStream::GetPositionRegister(KSRTAUDIO_HWREGISTER* Register)
 {
-    return STATUS_UNSUCCESSFUL;
+    LeylineStreamRegisters* page = m_Registers.GetPage();
+    if (!Register || !page) return STATUS_UNSUCCESSFUL;
+    UseRegisters();
+
+    Register->Register    = const_cast<ULONG*>(&page->Position);
+    Register->Width       = 32;
+    Register->Numerator   = 0;
+    Register->Denominator = 0;
+    Register->Accuracy    = StreamRegisterWriter::AccuracyBytes(m_RegisterPeriodMs, m_SampleRate, m_BlockAlign);
+    return STATUS_SUCCESS;
 }
 
-STDMETHODIMP CMiniportWaveRTStream::GetClockRegister(KSRTAUDIO_HWREGISTER* /*Register*/)
+// Clock register: a 64-bit frame counter, i.e. a clock ticking at the sample rate.
+STDMETHODIMP CMiniportWaveRTStream::GetClockRegister(KSRTAUDIO_HWREGISTER* Register)
 {
-    return STATUS_UNSUCCESSFUL;
+    LeylineStreamRegisters* page = m_Registers.GetPage();
+    if (!Register || !page) return STATUS_UNSUCCESSFUL;
+    UseRegisters();
+
+    Register->Register    = const_cast<ULONG64*>(&page->Frames);
+    Register->Width       = 64;
+    Register->Numerator   = m_SampleRate;
+    Register->Denominator = 1;
+    Register->Accuracy    = StreamRegisterWriter::AccuracyBytes(m_RegisterPeriodMs, m_SampleRate, 1);
+    return STATUS_SUCCESS;
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // CMiniportWaveRT
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-CMiniportWaveRT::CMiniportWaveRT(PUNKNOWN OuterUnknown, BOOLEAN IsCapture, DeviceExtension* DevExt)
+CMiniportWaveRT::CMiniportWaveRT(PUNKNOWN OuterUnknown, BOOLEAN IsCapture, DeviceExtension* DevExt, CableEndpoint* Cable)
     : CUnknown(OuterUnknown)
     , m_IsCapture(IsCapture)
     , m_IsInitialized(FALSE)
     , m_DevExt(DevExt)
-{}
+    , m_Cable(Cable)
+    , m_Proposed()
+    , m_HasProposed(FALSE)
+{
+    KeInitializeSpinLock(&m_FormatLock);
+}
 
 CMiniportWaveRT::~CMiniportWaveRT() {}
 
@@ -210,72 +1669,60 @@ STDMETHODIMP CMiniportWaveRT::NonDelegatingQueryInterface(REFIID riid, PVOID* pp
 STDMETHODIMP CMiniportWaveRT::GetDescription(PPCFILTER_DESCRIPTOR* Description)
 {
     if (!Description) return STATUS_INVALID_PARAMETER;
-    *Description = const_cast<PPCFILTER_DESCRIPTOR>(m_IsCapture ? &g_WaveCaptureFilterDescriptor : &g_WaveRenderFilterDescriptor);
+    *Description = const_cast<PPCFILTER_DESCRIPTOR>(EndpointFilterDescriptor(m_IsCapture ? EndpointFilter_WaveCapture : EndpointFilter_WaveRender));
     return STATUS_SUCCESS;
 }
 
+// The pin's range (MatchingDataRange, else the one of the request's sample type)
+// against the client's, leaning towards the proposed format. The answer is a
+// WAVEFORMATEXTENSIBLE when the client asked for one or the format needs it.
 STDMETHODIMP CMiniportWaveRT::DataRangeIntersection(
-    ULONG PinId, PKSDATARANGE DataRange, PKSDATARANGE /*MatchingDataRange*/,
+    ULONG PinId, PKSDATARANGE DataRange, PKSDATARANGE MatchingDataRange,
     ULONG DataFormatSize, PVOID DataFormat, PULONG ResultantFormatSize)
 {
     UNREFERENCED_PARAMETER(PinId);
     if (!DataRange) return STATUS_INVALID_PARAMETER;
 
-    if (!IsEqualGUID(DataRange->MajorFormat, KSDATAFORMAT_TYPE_AUDIO))
-        return STATUS_NO_MATCH;
-
-    BOOLEAN isEx      = !!IsEqualGUID(DataRange->Specifier, KSDATAFORMAT_SPECIFIER_WAVEFORMATEX);
-    BOOLEAN isExt     = !!IsEqualGUID(DataRange->Specifier, KSDATAFORMAT_SPECIFIER_WAVEFORMATEXTENSIBLE);
-    if (!isEx && !isExt) return STATUS_NO_MATCH;
-
-    BOOLEAN isPCM   = !!IsEqualGUID(DataRange->SubFormat, KSDATAFORMAT_SUBTYPE_PCM);
-    BOOLEAN isFloat = !!IsEqualGUID(DataRange->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
-    if (!isPCM && !isFloat) return STATUS_NO_MATCH;
-
-    ULONG fmtSize = isExt ? sizeof(KSDATAFORMAT_WAVEFORMATEXTENSIBLE) : sizeof(KSDATAFORMAT_WAVEFORMATEX);
-
-    if (DataFormatSize == 0) { if (ResultantFormatSize) *ResultantFormatSize = fmtSize; return STATUS_BUFFER_TOO_SMALL; }
-    if (DataFormatSize < fmtSize) return STATUS_BUFFER_TOO_SMALL;
-
-    if (isExt)
-    {
-        auto *r = reinterpret_cast<KSDATAFORMAT_WAVEFORMATEXTENSIBLE*>(DataFormat);
-        r->DataFormat.FormatSize  = fmtSize;
-        r->DataFormat.Flags       = 0;
-        r->DataFormat.MajorFormat = KSDATAFORMAT_TYPE_AUDIO;
-        r->DataFormat.SubFormat   = DataRange->SubFormat;
-        r->DataFormat.Specifier   = KSDATAFORMAT_SPECIFIER_WAVEFORMATEXTENSIBLE;
-        r->WaveFormatExt.Format.wFormatTag      = WAVE_FORMAT_EXTENSIBLE;
-        r->WaveFormatExt.Format.nChannels       = 2;
-        r->WaveFormatExt.Format.nSamplesPerSec  = 48000;
-        r->WaveFormatExt.Format.wBitsPerSample  = isPCM ? 16 : 32;
-        r->WaveFormatExt.Format.nBlockAlign     = r->WaveFormatExt.Format.nChannels * r->WaveFormatExt.Format.wBitsPerSample / 8;
-        r->WaveFormatExt.Format.nAvgBytesPerSec = r->WaveFormatExt.Format.nSamplesPerSec * r->WaveFormatExt.Format.nBlockAlign;
-        r->WaveFormatExt.Format.cbSize          = 22;
-        r->WaveFormatExt.Samples.wValidBitsPerSample = r->WaveFormatExt.Format.wBitsPerSample;
-        r->WaveFormatExt.dwChannelMask          = KSAUDIO_SPEAKER_STEREO;
-        r->WaveFormatExt.SubFormat              = DataRange->SubFormat;
-        r->DataFormat.SampleSize                = r->WaveFormatExt.Format.nBlockAlign;
-    }
-    else
-    {
-        auto *r = reinterpret_cast<KSDATAFORMAT_WAVEFORMATEX*>(DataFormat);
-        r->DataFormat.FormatSize  = fmtSize;
-        r->DataFormat.Flags       = 0;
-        r->DataFormat.MajorFormat = KSDATAFORMAT_TYPE_AUDIO;
-        r->DataFormat.SubFormat   = DataRange->SubFormat;
-        r->DataFormat.Specifier   = KSDATAFORMAT_SPECIFIER_WAVEFORMATEX;
-        r->WaveFormatEx.wFormatTag      = isPCM ? WAVE_FORMAT_PCM : WAVE_FORMAT_IEEE_FLOAT;
-        r->WaveFormatEx.nChannels       = 2;
-        r->WaveFormatEx.nSamplesPerSec  = 48000;
-        r->WaveFormatEx.wBitsPerSample  = isPCM ? 16 : 32;
-        r->WaveFormatEx.nBlockAlign     = r->WaveFormatEx.nChannels * r->WaveFormatEx.wBitsPerSample / 8;
-        r->WaveFormatEx.nAvgBytesPerSec = r->WaveFormatEx.nSamplesPerSec * r->WaveFormatEx.nBlockAlign;
-        r->WaveFormatEx.cbSize          = 0;
-        r->DataFormat.SampleSize        = r->WaveFormatEx.nBlockAlign;
-    }
+    const KSDATARANGE* pinRange = MatchingDataRange;
+    if (!pinRange)
+        pinRange = IsEqualGUID(DataRange->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) ? &g_FloatDataRange.DataRange
+                                                                                     : &g_PcmDataRange.DataRange;
+
+    WaveFormat proposed, format;
+    BOOLEAN    hasProposed = GetProposedFormat(&proposed);
+    NTSTATUS   status      = FormatIntersection::Intersect(pinRange, DataRange, hasProposed ? &proposed : nullptr, &format);
+    if (!NT_SUCCESS(status)) return status;
 
+    BOOLEAN extensible = FormatIntersection::WantsExtensible(DataRange, format);
+    ULONG   fmtSize    = FormatIntersection::FormatSize(extensible);
     if (ResultantFormatSize) *ResultantFormatSize = fmtSize;
+
+    if (DataFormatSize == 0) return STATUS_BUFFER_OVERFLOW;
+    if (DataFormatSize < fmtSize || !DataFormat) return STATUS_BUFFER_TOO_SMALL;
+
+    FormatIntersection::Build(format, extensible, DataRange->Specifier, DataFormat);
+    return STATUS_SUCCESS;
+}
+
+BOOLEAN CMiniportWaveRT::GetProposedFormat(WaveFormat* Format)
+{
+    KIRQL irql;
+    KeAcquireSpinLock(&m_FormatLock, &irql);
+    BOOLEAN has = m_HasProposed;
+    if (has) *Format = m_Proposed;
+    KeReleaseSpinLock(&m_FormatLock, irql);
+    return has;
+}
+
+NTSTATUS CMiniportWaveRT::SetProposedFormat(const WaveFormat& Format)
+{
+    if (!WaveRangesAdmit(Format)) return STATUS_NOT_SUPPORTED;
+
+    KIRQL irql;
+    KeAcquireSpinLock(&m_FormatLock, &irql);
+    m_Proposed    = Format;
+    m_HasProposed = TRUE;
+    KeReleaseSpinLock(&m_FormatLock, irql);
     return STATUS_SUCCESS;
 }
 
@@ -297,11 +1744,13 @@ STDMETHODIMP CMiniportWaveRT::NewStream(
     if (!Stream) return STATUS_INVALID_PARAMETER;
     if (!m_IsInitialized) return STATUS_DEVICE_NOT_READY;
 
-    CMiniportWaveRTStream *stream = new (NonPagedPool, 'LLWS') CMiniportWaveRTStream(nullptr, m_DevExt);
+    CMiniportWaveRTStream *stream = new (m_DevExt->Objects, 'LLWS') CMiniportWaveRTStream(nullptr, m_DevExt, m_Cable);
     if (!stream) return STATUS_INSUFFICIENT_RESOURCES;
 
     NTSTATUS status = stream->Init(PinId, Capture, DataFormat);
     if (!NT_SUCCESS(status)) { delete stream; return status; }
+    stream->ClaimSlot();
+    stream->List();
 
     stream->AddRef();
     *Stream = stream;
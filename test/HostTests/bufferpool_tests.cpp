@@ -0,0 +1,289 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BUFFER POOL TESTS
+// The size-class pool over a host PageSource: class selection, spill-over, misses,
+// recycling and the counters, plus concurrent acquire/release. The benchmark puts
+// a stream buffer allocate/free cycle against malloc and mmap.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_bufferpool.h"
+
+#include <atomic>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <thread>
+#include <vector>
+
+// Plain heap memory, counting what is out, and failing once `Budget` blocks have
+// been handed out (unlimited when negative).
+class HostPageSource : public PageSource
+{
+public:
+    HostPageSource() : Live(0), Allocations(0), Budget(-1) {}
+
+    NTSTATUS Allocate(SIZE_T bytes, PoolBlock* block) override
+    {
+        if (Budget >= 0 && Allocations.load() >= Budget) return STATUS_INSUFFICIENT_RESOURCES;
+        block->Address = aligned_alloc(4096, (bytes + 4095) & ~(SIZE_T)4095);
+        if (!block->Address) return STATUS_INSUFFICIENT_RESOURCES;
+        block->Handle = block->Address;
+        block->Bytes  = bytes;
+        Live++;
+        Allocations++;
+        return STATUS_SUCCESS;
+    }
+
+    void Free(const PoolBlock& block) override
+    {
+        free(block.Address);
+        Live--;
+    }
+
+    std::atomic<int> Live;
+    std::atomic<int> Allocations;
+    int              Budget;
+};
+
+static const BufferPoolClass kClasses[] =
+{
+    {  16 * 1024, 4 },
+    {  64 * 1024, 2 },
+    { 256 * 1024, 1 },
+};
+
+HOST_TEST(BufferPool_HandsOutTheSmallestClassThatFits)
+{
+    HostPageSource source;
+    BufferPool pool;
+    CHECK_EQ(pool.Reserve(&source, kClasses, 3), STATUS_SUCCESS);
+    CHECK_EQ(source.Live.load(), 7);
+    CHECK(pool.GetSource() == &source);
+
+    PoolBuffer a, b, c;
+    CHECK_EQ(pool.Acquire(1920, &a), STATUS_SUCCESS);
+    CHECK_EQ(pool.Acquire(16 * 1024 + 1, &b), STATUS_SUCCESS);
+    CHECK_EQ(pool.Acquire(200 * 1024, &c), STATUS_SUCCESS);
+    CHECK_EQ(a.Class, (ULONG)0);
+    CHECK_EQ(b.Class, (ULONG)1);
+    CHECK_EQ(c.Class, (ULONG)2);
+    CHECK(a.Block.Bytes >= 1920 && b.Block.Bytes >= 16 * 1024 + 1 && c.Block.Bytes >= 200 * 1024);
+    CHECK_EQ(source.Live.load(), 7);    // Nothing new from the source
+
+    pool.Release(a);
+    pool.Release(b);
+    pool.Release(c);
+    pool.Shutdown();
+    CHECK_EQ(source.Live.load(), 0);
+    CHECK(pool.GetSource() == nullptr);
+}
+
+// A full class spills into the next one up, and only a request nothing can hold
+// goes to the source, counted as a miss and handed back to it on release.
+HOST_TEST(BufferPool_SpillsUpThenMisses)
+{
+    HostPageSource source;
+    BufferPool pool;
+    CHECK_EQ(pool.Reserve(&source, kClasses, 3), STATUS_SUCCESS);
+
+    PoolBuffer held[8];
+    for (int i = 0; i < 7; ++i) CHECK_EQ(pool.Acquire(4096, &held[i]), STATUS_SUCCESS);
+    CHECK_EQ(held[3].Class, (ULONG)0);
+    CHECK_EQ(held[4].Class, (ULONG)1);
+    CHECK_EQ(held[6].Class, (ULONG)2);
+
+    CHECK_EQ(pool.Acquire(4096, &held[7]), STATUS_SUCCESS);
+    CHECK_EQ(held[7].Class, (ULONG)LEYLINE_POOL_UNPOOLED);
+    CHECK_EQ(source.Live.load(), 8);
+
+    LeylineBufferPoolStats stats;
+    pool.GetStats(&stats);
+    CHECK_EQ(stats.Hits, (ULONG)7);
+    CHECK_EQ(stats.Misses, (ULONG)1);
+    CHECK_EQ(stats.Unpooled, (ULONG)1);
+
+    // Too big for any class: a miss even with the pool idle.
+    for (int i = 0; i < 8; ++i) pool.Release(held[i]);
+    CHECK_EQ(source.Live.load(), 7);
+    PoolBuffer huge;
+    CHECK_EQ(pool.Acquire(1024 * 1024, &huge), STATUS_SUCCESS);
+    CHECK_EQ(huge.Class, (ULONG)LEYLINE_POOL_UNPOOLED);
+    pool.Release(huge);
+
+    pool.GetStats(&stats);
+    CHECK_EQ(stats.Misses, (ULONG)2);
+    CHECK_EQ(stats.Unpooled, (ULONG)0);
+    pool.Shutdown();
+}
+
+// A released block is the next one handed out, and the high-water mark remembers
+// the peak after use drops.
+HOST_TEST(BufferPool_RecyclesAndTracksHighWater)
+{
+    HostPageSource source;
+    BufferPool pool;
+    CHECK_EQ(pool.Reserve(&source, kClasses, 3), STATUS_SUCCESS);
+
+    PoolBuffer a, b, c;
+    CHECK_EQ(pool.Acquire(1000, &a), STATUS_SUCCESS);
+    CHECK_EQ(pool.Acquire(1000, &b), STATUS_SUCCESS);
+    CHECK_EQ(pool.Acquire(1000, &c), STATUS_SUCCESS);
+    PVOID second = b.Block.Address;
+    pool.Release(b);
+    CHECK_EQ(pool.Acquire(1000, &b), STATUS_SUCCESS);
+    CHECK(b.Block.Address == second);
+
+    pool.Release(a);
+    pool.Release(b);
+    pool.Release(c);
+
+    LeylineBufferPoolStats stats;
+    pool.GetStats(&stats);
+    CHECK_EQ(stats.Classes, (ULONG)3);
+    CHECK_EQ(stats.Class[0].BlockBytes, (ULONG)(16 * 1024));
+    CHECK_EQ(stats.Class[0].Blocks, (ULONG)4);
+    CHECK_EQ(stats.Class[0].InUse, (ULONG)0);
+    CHECK_EQ(stats.Class[0].HighWater, (ULONG)3);
+    CHECK_EQ(stats.Class[1].HighWater, (ULONG)0);
+    pool.Shutdown();
+}
+
+// Short on memory at StartDevice: the pool keeps what it got; with nothing at all
+// it reports failure and holds nothing.
+HOST_TEST(BufferPool_ReservesWhatMemoryAllows)
+{
+    HostPageSource source;
+    source.Budget = 5;
+    BufferPool pool;
+    CHECK_EQ(pool.Reserve(&source, kClasses, 3), STATUS_SUCCESS);
+    LeylineBufferPoolStats stats;
+    pool.GetStats(&stats);
+    CHECK_EQ(stats.Class[0].Blocks, (ULONG)4);
+    CHECK_EQ(stats.Class[1].Blocks, (ULONG)1);
+    CHECK_EQ(stats.Class[2].Blocks, (ULONG)0);
+    pool.Shutdown();
+
+    HostPageSource empty;
+    empty.Budget = 0;
+    BufferPool none;
+    CHECK(none.Reserve(&empty, kClasses, 3) == STATUS_INSUFFICIENT_RESOURCES);
+    CHECK(!none.IsReady());
+    CHECK_EQ(empty.Live.load(), 0);
+
+    const BufferPoolClass unsorted[] = { { 64 * 1024, 1 }, { 16 * 1024, 1 } };
+    const BufferPoolClass tooMany[]  = { { 16 * 1024, LEYLINE_POOL_MAX_BLOCKS + 1 } };
+    CHECK(none.Reserve(&source, unsorted, 2) == STATUS_INVALID_PARAMETER);
+    CHECK(none.Reserve(&source, tooMany, 1) == STATUS_INVALID_PARAMETER);
+}
+
+// Streams opening and closing on several threads: no block is ever out twice, and
+// everything comes back.
+HOST_TEST(BufferPool_ConcurrentAcquireRelease)
+{
+    HostPageSource source;
+    BufferPool pool;
+    const BufferPoolClass classes[] = { { 16 * 1024, 32 } };
+    CHECK_EQ(pool.Reserve(&source, classes, 1), STATUS_SUCCESS);
+
+    static std::atomic<int> owners[LEYLINE_POOL_MAX_BLOCKS];
+    for (std::atomic<int>& o : owners) o = 0;
+    std::atomic<int> doubled(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 50000; ++i)
+            {
+                PoolBuffer held[3];
+                for (PoolBuffer& b : held)
+                {
+                    pool.Acquire(4096, &b);
+                    if (b.Class == 0 && owners[b.Index].fetch_add(1) != 0) doubled++;
+                }
+                for (PoolBuffer& b : held)
+                {
+                    if (b.Class == 0) owners[b.Index].fetch_sub(1);
+                    pool.Release(b);
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+
+    LeylineBufferPoolStats stats;
+    pool.GetStats(&stats);
+    CHECK_EQ(doubled.load(), 0);
+    CHECK_EQ(stats.Class[0].InUse, (ULONG)0);
+    CHECK_EQ(stats.Unpooled, (ULONG)0);
+    CHECK(stats.Class[0].HighWater <= 24);
+    CHECK_EQ(stats.Hits + stats.Misses, (ULONG)(8 * 50000 * 3));
+    pool.Shutdown();
+    CHECK_EQ(source.Live.load(), 0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARKS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// One stream's buffer life: get it, make it silent, give it back. The pool zeroes
+// a recycled block; malloc gets the same memset; mmap with MAP_POPULATE is the
+// host's nearest thing to fresh locked pages, which arrive zeroed.
+HOST_BENCH(BufferPool_AllocateFreeVsMallocMmap)
+{
+    HostPageSource source;
+    BufferPool pool;
+    const BufferPoolClass classes[] = { { 16 * 1024, 16 }, { 64 * 1024, 8 } };
+    pool.Reserve(&source, classes, 2);
+
+    for (SIZE_T bytes : { (SIZE_T)3840, (SIZE_T)(48 * 1024) })
+    {
+        const int iterations = 20000;
+        char name[64];
+        double poolNs, mallocNs, mmapNs;
+
+        uint64_t t0 = HostTest::NowNs();
+        for (int i = 0; i < iterations; ++i)
+        {
+            PoolBuffer b;
+            pool.Acquire(bytes, &b);
+            RtlZeroMemory(b.Block.Address, bytes);
+            pool.Release(b);
+        }
+        poolNs = (double)(HostTest::NowNs() - t0) / iterations;
+
+        t0 = HostTest::NowNs();
+        for (int i = 0; i < iterations; ++i)
+        {
+            void* p = malloc(bytes);
+            RtlZeroMemory(p, bytes);
+            asm volatile("" : : "r"(p) : "memory");     // Keep the pair from being elided
+            free(p);
+        }
+        mallocNs = (double)(HostTest::NowNs() - t0) / iterations;
+
+        t0 = HostTest::NowNs();
+        for (int i = 0; i < iterations; ++i)
+        {
+            void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+            munmap(p, bytes);
+        }
+        mmapNs = (double)(HostTest::NowNs() - t0) / iterations;
+
+        snprintf(name, sizeof(name), "BufferPool_%zuB_pool", bytes);
+        HostTest::Report(name, poolNs, 0);
+        snprintf(name, sizeof(name), "BufferPool_%zuB_malloc", bytes);
+        HostTest::Report(name, mallocNs, 0);
+        snprintf(name, sizeof(name), "BufferPool_%zuB_mmap", bytes);
+        HostTest::Report(name, mmapNs, 0);
+
+        CHECK(poolNs < mmapNs);
+    }
+
+    LeylineBufferPoolStats stats;
+    pool.GetStats(&stats);
+    CHECK_EQ(stats.Misses, (ULONG)0);
+    pool.Shutdown();
+}
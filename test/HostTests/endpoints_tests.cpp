@@ -0,0 +1,272 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ENDPOINT GRAPH TESTS
+// The generated filter descriptors against what the four hand-written ones used to
+// say, and the subdevice graph for every cable count from 1 to LEYLINE_MAX_CABLES:
+// names, links and link pins as the descriptors see them.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_endpoints.h"
+
+#include <initializer_list>
+#include <stdio.h>
+#include <string.h>
+
+// Stand-ins for the tables descriptors/ feeds the generator; only addresses and
+// counts matter here.
+static const GUID        g_TestGuids[8] = {};
+static const KSIDENTIFIER g_TestInterfaces[1] = {};
+static const KSDATARANGE g_TestRange = {};
+static const PKSDATARANGE g_TestWaveRanges[2]   = { (PKSDATARANGE)&g_TestRange, (PKSDATARANGE)&g_TestRange };
+static const PKSDATARANGE g_TestBridgeRanges[1] = { (PKSDATARANGE)&g_TestRange };
+static const PCNODE_DESCRIPTOR g_TestNodes[2]   = {};
+
+struct TestTables
+{
+    static constexpr const PCAUTOMATION_TABLE* PinAutomation        = nullptr;
+    static constexpr const PCAUTOMATION_TABLE* WaveFilterAutomation = nullptr;
+    static constexpr const PCAUTOMATION_TABLE* TopoFilterAutomation = nullptr;
+
+    static constexpr const KSPIN_INTERFACE* Interfaces     = g_TestInterfaces;
+    static constexpr ULONG                  InterfaceCount = 1;
+    static constexpr const PKSDATARANGE*    WaveRanges     = g_TestWaveRanges;
+    static constexpr ULONG                  WaveRangeCount = 2;
+    static constexpr const PKSDATARANGE*    BridgeRanges   = g_TestBridgeRanges;
+    static constexpr ULONG                  BridgeRangeCount = 1;
+
+    static constexpr const PCNODE_DESCRIPTOR* Nodes     = g_TestNodes;
+    static constexpr ULONG                    NodeCount = 2;
+
+    static constexpr const GUID* AudioCategory      = &g_TestGuids[0];
+    static constexpr const GUID* SpeakerCategory    = &g_TestGuids[1];
+    static constexpr const GUID* MicrophoneCategory = &g_TestGuids[2];
+
+    static constexpr const GUID* WaveRenderCategories     = &g_TestGuids[3];
+    static constexpr ULONG       WaveRenderCategoryCount  = 3;
+    static constexpr const GUID* WaveCaptureCategories    = &g_TestGuids[4];
+    static constexpr ULONG       WaveCaptureCategoryCount = 3;
+    static constexpr const GUID* TopologyCategories       = &g_TestGuids[5];
+    static constexpr ULONG       TopologyCategoryCount    = 2;
+};
+
+static const PCFILTER_DESCRIPTOR* Descriptor(EndpointFilterKind kind)
+{
+    switch (kind)
+    {
+    case EndpointFilter_WaveRender:  return &EndpointFilter<TestTables, EndpointFilter_WaveRender>::Descriptor;
+    case EndpointFilter_WaveCapture: return &EndpointFilter<TestTables, EndpointFilter_WaveCapture>::Descriptor;
+    case EndpointFilter_TopoRender:  return &EndpointFilter<TestTables, EndpointFilter_TopoRender>::Descriptor;
+    default:                         return &EndpointFilter<TestTables, EndpointFilter_TopoCapture>::Descriptor;
+    }
+}
+
+static bool SameConnection(const PCCONNECTION_DESCRIPTOR& c, ULONG fromNode, ULONG fromPin, ULONG toNode, ULONG toPin)
+{
+    return c.FromNode == fromNode && c.FromNodePin == fromPin && c.ToNode == toNode && c.ToNodePin == toPin;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// FILTER DESCRIPTORS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_TEST(Endpoints_WavePinsMatchTheOriginalTables)
+{
+    for (int k = EndpointFilter_WaveRender; k <= EndpointFilter_WaveCapture; ++k)
+    {
+        const PCFILTER_DESCRIPTOR* d = Descriptor((EndpointFilterKind)k);
+        const BOOLEAN capture = k == EndpointFilter_WaveCapture;
+
+        CHECK_EQ(d->PinCount, 2u);
+        CHECK_EQ(d->PinSize, (ULONG)sizeof(PCPIN_DESCRIPTOR));
+        CHECK_EQ(d->NodeCount, 0u);
+        CHECK(d->Nodes == nullptr);
+        CHECK(d->Categories == (capture ? TestTables::WaveCaptureCategories : TestTables::WaveRenderCategories));
+
+        const PCPIN_DESCRIPTOR& sink   = d->Pins[KSPIN_WAVE_SINK];
+        const PCPIN_DESCRIPTOR& bridge = d->Pins[KSPIN_WAVE_BRIDGE];
+        CHECK_EQ(sink.MaxGlobalInstanceCount, (ULONG)LEYLINE_STREAMING_PIN_INSTANCES);
+        CHECK_EQ(sink.MaxFilterInstanceCount, (ULONG)LEYLINE_STREAMING_PIN_INSTANCES);
+        CHECK_EQ(sink.KsPinDescriptor.Communication, KSPIN_COMMUNICATION_SINK);
+        CHECK_EQ(sink.KsPinDescriptor.DataFlow, capture ? KSPIN_DATAFLOW_OUT : KSPIN_DATAFLOW_IN);
+        CHECK(sink.KsPinDescriptor.Interfaces == TestTables::Interfaces);
+        CHECK(sink.KsPinDescriptor.DataRanges == TestTables::WaveRanges);
+        CHECK_EQ(sink.KsPinDescriptor.DataRangesCount, 2u);
+
+        CHECK_EQ(bridge.MaxFilterInstanceCount, 1u);
+        CHECK_EQ(bridge.KsPinDescriptor.Communication, KSPIN_COMMUNICATION_NONE);
+        CHECK_EQ(bridge.KsPinDescriptor.DataFlow, capture ? KSPIN_DATAFLOW_IN : KSPIN_DATAFLOW_OUT);
+        CHECK_EQ(bridge.KsPinDescriptor.InterfacesCount, 0u);
+        CHECK(bridge.KsPinDescriptor.DataRanges == TestTables::BridgeRanges);
+        CHECK(bridge.KsPinDescriptor.Category == TestTables::AudioCategory);
+
+        CHECK_EQ(d->ConnectionCount, 1u);
+        CHECK(capture ? SameConnection(d->Connections[0], PCFILTER_NODE, KSPIN_WAVE_BRIDGE, PCFILTER_NODE, KSPIN_WAVE_SINK)
+                      : SameConnection(d->Connections[0], PCFILTER_NODE, KSPIN_WAVE_SINK, PCFILTER_NODE, KSPIN_WAVE_BRIDGE));
+    }
+}
+
+HOST_TEST(Endpoints_TopologyJacksCarryTheirCategory)
+{
+    const PCFILTER_DESCRIPTOR* render  = Descriptor(EndpointFilter_TopoRender);
+    const PCFILTER_DESCRIPTOR* capture = Descriptor(EndpointFilter_TopoCapture);
+
+    CHECK(render->Pins[KSPIN_TOPO_BRIDGE].KsPinDescriptor.Category  == TestTables::AudioCategory);
+    CHECK(render->Pins[KSPIN_TOPO_LINEOUT].KsPinDescriptor.Category == TestTables::SpeakerCategory);
+    CHECK(capture->Pins[KSPIN_TOPO_BRIDGE].KsPinDescriptor.Category  == TestTables::MicrophoneCategory);
+    CHECK(capture->Pins[KSPIN_TOPO_LINEOUT].KsPinDescriptor.Category == TestTables::AudioCategory);
+
+    for (const PCFILTER_DESCRIPTOR* d : { render, capture })
+    {
+        CHECK_EQ(d->Pins[KSPIN_TOPO_BRIDGE].KsPinDescriptor.DataFlow, KSPIN_DATAFLOW_IN);
+        CHECK_EQ(d->Pins[KSPIN_TOPO_LINEOUT].KsPinDescriptor.DataFlow, KSPIN_DATAFLOW_OUT);
+        CHECK_EQ(d->NodeCount, TestTables::NodeCount);
+        CHECK(d->Nodes == TestTables::Nodes);
+        CHECK_EQ(d->NodeSize, (ULONG)sizeof(PCNODE_DESCRIPTOR));
+        CHECK(d->Categories == TestTables::TopologyCategories);
+    }
+}
+
+// Render runs bridge -> volume -> mute -> line out, node pins numbered as
+// KSNODEPIN_STANDARD_IN/OUT; capture goes straight through.
+HOST_TEST(Endpoints_TopologyConnectionsChainThroughTheNodes)
+{
+    const PCFILTER_DESCRIPTOR* render = Descriptor(EndpointFilter_TopoRender);
+    CHECK_EQ(render->ConnectionCount, 3u);
+    CHECK(SameConnection(render->Connections[0], PCFILTER_NODE, KSPIN_TOPO_BRIDGE, 0, LEYLINE_NODE_PIN_IN));
+    CHECK(SameConnection(render->Connections[1], 0, LEYLINE_NODE_PIN_OUT, 1, LEYLINE_NODE_PIN_IN));
+    CHECK(SameConnection(render->Connections[2], 1, LEYLINE_NODE_PIN_OUT, PCFILTER_NODE, KSPIN_TOPO_LINEOUT));
+
+    const PCFILTER_DESCRIPTOR* capture = Descriptor(EndpointFilter_TopoCapture);
+    CHECK_EQ(capture->ConnectionCount, 1u);
+    CHECK(SameConnection(capture->Connections[0], PCFILTER_NODE, KSPIN_TOPO_BRIDGE, PCFILTER_NODE, KSPIN_TOPO_LINEOUT));
+}
+
+// Every filter's connections run from an input pin to an output pin, each
+// intermediate node entered once and left once.
+HOST_TEST(Endpoints_ConnectionsRunInputToOutput)
+{
+    for (int k = 0; k < EndpointFilter_Count; ++k)
+    {
+        const PCFILTER_DESCRIPTOR* d = Descriptor((EndpointFilterKind)k);
+        const PCCONNECTION_DESCRIPTOR& first = d->Connections[0];
+        const PCCONNECTION_DESCRIPTOR& last  = d->Connections[d->ConnectionCount - 1];
+
+        CHECK_EQ(first.FromNode, PCFILTER_NODE);
+        CHECK_EQ(d->Pins[first.FromNodePin].KsPinDescriptor.DataFlow, KSPIN_DATAFLOW_IN);
+        CHECK_EQ(last.ToNode, PCFILTER_NODE);
+        CHECK_EQ(d->Pins[last.ToNodePin].KsPinDescriptor.DataFlow, KSPIN_DATAFLOW_OUT);
+
+        for (ULONG i = 0; i + 1 < d->ConnectionCount; ++i)
+        {
+            CHECK(d->Connections[i].ToNode < d->NodeCount);
+            CHECK_EQ(d->Connections[i].ToNode, d->Connections[i + 1].FromNode);
+        }
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SUBDEVICE GRAPHS
+// Each graph is built at compile time, the same way StartDevice's is.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static constexpr EndpointGraph<LEYLINE_MAX_CABLES> g_Largest;
+
+static bool SameName(const WCHAR* name, const char* expected)
+{
+    ULONG i = 0;
+    for (; expected[i]; ++i)
+        if (name[i] != (WCHAR)expected[i]) return false;
+    return name[i] == 0;
+}
+
+template <ULONG Cables>
+static bool GraphHolds()
+{
+    static constexpr EndpointGraph<Cables> graph;
+    static_assert(graph.IsConsistent(), "endpoint graph is inconsistent");
+
+    for (ULONG i = 0; i < graph.SubdeviceCount; ++i)
+    {
+        const EndpointSubdevice& s = graph.Subdevices[i];
+
+        // A prefix of the largest graph, so growing CablePairs never renames or
+        // reorders what is already registered.
+        if (s.Kind != g_Largest.Subdevices[i].Kind || s.Cable != g_Largest.Subdevices[i].Cable ||
+            memcmp(s.Name, g_Largest.Subdevices[i].Name, sizeof(s.Name)) != 0)
+            return false;
+
+        for (ULONG j = 0; j < i; ++j)
+            if (memcmp(s.Name, graph.Subdevices[j].Name, sizeof(s.Name)) == 0) return false;
+
+        const char* base = EndpointBaseName(s.Kind);
+        char expected[64] = {};
+        if (s.Cable == 0) strcpy(expected, base);
+        else              snprintf(expected, sizeof(expected), "%s%lu", base, (unsigned long)(s.Cable + 1));
+        if (!SameName(s.Name, expected)) return false;
+    }
+
+    for (ULONG i = 0; i < graph.LinkCount; ++i)
+    {
+        const EndpointLink& l = graph.Links[i];
+        if (memcmp(&l, &g_Largest.Links[i], sizeof(l)) != 0) return false;
+
+        const PCFILTER_DESCRIPTOR* from = Descriptor(graph.Subdevices[l.FromSubdevice].Kind);
+        const PCFILTER_DESCRIPTOR* to   = Descriptor(graph.Subdevices[l.ToSubdevice].Kind);
+        if (l.FromPin >= from->PinCount || l.ToPin >= to->PinCount) return false;
+        if (from->Pins[l.FromPin].KsPinDescriptor.DataFlow != KSPIN_DATAFLOW_OUT ||
+            to->Pins[l.ToPin].KsPinDescriptor.DataFlow != KSPIN_DATAFLOW_IN)
+            return false;
+        if (from->Pins[l.FromPin].KsPinDescriptor.Communication != KSPIN_COMMUNICATION_NONE ||
+            to->Pins[l.ToPin].KsPinDescriptor.Communication != KSPIN_COMMUNICATION_NONE)
+            return false;
+    }
+    return true;
+}
+
+template <ULONG Cables>
+static ULONG GraphsHoldUpTo()
+{
+    ULONG held = GraphsHoldUpTo<Cables - 1>();
+    return held + (GraphHolds<Cables>() ? 1 : 0);
+}
+
+template <>
+ULONG GraphsHoldUpTo<0>() { return 0; }
+
+HOST_TEST(Endpoints_GraphsHoldForEveryCableCount)
+{
+    CHECK_EQ(GraphsHoldUpTo<LEYLINE_MAX_CABLES>(), (ULONG)LEYLINE_MAX_CABLES);
+}
+
+HOST_TEST(Endpoints_FirstCableKeepsTheOriginalNames)
+{
+    constexpr EndpointGraph<2> graph;
+    CHECK(SameName(graph.Subdevices[0].Name, "WaveRender"));
+    CHECK(SameName(graph.Subdevices[1].Name, "WaveCapture"));
+    CHECK(SameName(graph.Subdevices[2].Name, "TopologyRender"));
+    CHECK(SameName(graph.Subdevices[3].Name, "TopologyCapture"));
+    CHECK(SameName(graph.Subdevices[4].Name, "WaveRender2"));
+    CHECK(SameName(g_Largest.Subdevices[LEYLINE_MAX_CABLES * 4 - 1].Name, "TopologyCapture32"));
+
+    // The original physical connections: wave render bridge into topology, and
+    // topology capture line out into the wave capture bridge.
+    CHECK_EQ(graph.Links[0].FromSubdevice, 0u);
+    CHECK_EQ(graph.Links[0].FromPin, (ULONG)KSPIN_WAVE_BRIDGE);
+    CHECK_EQ(graph.Links[0].ToSubdevice, 2u);
+    CHECK_EQ(graph.Links[0].ToPin, (ULONG)KSPIN_TOPO_BRIDGE);
+    CHECK_EQ(graph.Links[1].FromSubdevice, 3u);
+    CHECK_EQ(graph.Links[1].FromPin, (ULONG)KSPIN_TOPO_LINEOUT);
+    CHECK_EQ(graph.Links[1].ToSubdevice, 1u);
+    CHECK_EQ(graph.Links[1].ToPin, (ULONG)KSPIN_WAVE_BRIDGE);
+}
+
+HOST_TEST(Endpoints_LongestNameFits)
+{
+    const WCHAR* name = g_Largest.Subdevices[LEYLINE_MAX_CABLES * 4 - 1].Name;
+    ULONG length = 0;
+    while (name[length]) ++length;
+    CHECK(length < LEYLINE_SUBDEVICE_NAME_CHARS);
+}
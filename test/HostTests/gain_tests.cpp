@@ -0,0 +1,366 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GAIN TESTS
+// The dB table, the volume/mute property requests through a stand-in for
+// PCPROPERTY_REQUEST, ramp smoothness, mute to digital silence, integer formats
+// and the SIMD kernels against scalar. The benchmarks report the cost of a timer
+// period's gain and of one volume/mute property request.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_gain.h"
+
+#include <math.h>
+#include <random>
+#include <string.h>
+#include <vector>
+
+static const ULONG kRate = 48000;
+
+// The PCPROPERTY_REQUEST fields HandleChannelProperty reads and writes.
+struct PropertyShim
+{
+    ULONG   Verb;
+    ULONG   InstanceSize;
+    PVOID   Instance;
+    ULONG   ValueSize;
+    PVOID   Value;
+};
+
+static NTSTATUS Property(ChannelControls* controls, ChannelProperty property, ULONG verb,
+                         ULONG channel, LONG* value, ULONG valueSize = sizeof(LONG), ULONG* sizeOut = nullptr)
+{
+    PropertyShim request = { verb, sizeof(ULONG), &channel, valueSize, value };
+    NTSTATUS status = HandleChannelProperty(controls, &request, property);
+    if (sizeOut) *sizeOut = request.ValueSize;
+    return status;
+}
+
+static std::vector<float> Noise(ULONG samples, ULONG seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> v(samples);
+    for (float& x : v) x = dist(rng);
+    return v;
+}
+
+HOST_TEST(Gain_TableMatchesPowAcrossRange)
+{
+    double worst = 0;
+    for (LONG db = LEYLINE_VOLUME_MIN_DB; db <= LEYLINE_VOLUME_MAX_DB; db += 0x1000)    // 1/16 dB
+    {
+        double expected = pow(10.0, (db / 65536.0) / 20.0);
+        double error    = fabs(DbToLinear(db) - expected) / expected;
+        if (error > worst) worst = error;
+    }
+    CHECK(worst < 1e-6);
+
+    CHECK_EQ(DbToLinear(0), 1.0f);
+    CHECK_EQ(DbToLinear(6 * 0x10000), 1.0f);                                // Clamped
+    CHECK_EQ(DbToLinear(-200 * 0x10000), DbToLinear(LEYLINE_VOLUME_MIN_DB));
+    CHECK(fabs(DbToLinear(-6 * 0x10000) - 0.501187) < 1e-5);
+}
+
+HOST_TEST(Gain_PropertySizingAndValidation)
+{
+    ChannelControls controls = {};
+    LONG  value = 0;
+    ULONG size  = 0;
+
+    // A zero-length value asks for the size.
+    CHECK_EQ(Property(&controls, ChannelProperty_Volume, KSPROPERTY_TYPE_GET, 0, &value, 0, &size),
+             STATUS_BUFFER_OVERFLOW);
+    CHECK_EQ(size, (ULONG)sizeof(LONG));
+    CHECK_EQ(Property(&controls, ChannelProperty_Volume, KSPROPERTY_TYPE_GET, 0, &value, 2), STATUS_BUFFER_TOO_SMALL);
+
+    CHECK_EQ(Property(&controls, ChannelProperty_Mute, KSPROPERTY_TYPE_GET, LEYLINE_GAIN_MAX_CHANNELS, &value),
+             STATUS_INVALID_PARAMETER);
+    CHECK_EQ(Property(nullptr, ChannelProperty_Mute, KSPROPERTY_TYPE_GET, 0, &value), STATUS_INVALID_DEVICE_REQUEST);
+    CHECK_EQ(Property(&controls, ChannelProperty_Mute, KSPROPERTY_TYPE_BASICSUPPORT, 0, &value),
+             STATUS_INVALID_DEVICE_REQUEST);
+
+    // Zeroed controls are 0 dB and unmuted.
+    value = -1;
+    CHECK_EQ(Property(&controls, ChannelProperty_Volume, KSPROPERTY_TYPE_GET, 3, &value), STATUS_SUCCESS);
+    CHECK_EQ(value, 0);
+    value = -1;
+    CHECK_EQ(Property(&controls, ChannelProperty_Mute, KSPROPERTY_TYPE_GET, 3, &value), STATUS_SUCCESS);
+    CHECK_EQ(value, 0);
+}
+
+HOST_TEST(Gain_PropertySetsChannelsAndMaster)
+{
+    ChannelControls controls = {};
+    LONG generation = controls.GetGeneration();
+
+    LONG value = -12 * 0x10000;
+    CHECK_EQ(Property(&controls, ChannelProperty_Volume, KSPROPERTY_TYPE_SET, 1, &value), STATUS_SUCCESS);
+    CHECK(controls.GetGeneration() != generation);
+    CHECK_EQ(controls.GetVolume(0), 0);
+    CHECK_EQ(controls.GetVolume(1), -12 * 0x10000);
+
+    // Out of range is clamped, not refused.
+    value = 10 * 0x10000;
+    CHECK_EQ(Property(&controls, ChannelProperty_Volume, KSPROPERTY_TYPE_SET, 0, &value), STATUS_SUCCESS);
+    CHECK_EQ(controls.GetVolume(0), LEYLINE_VOLUME_MAX_DB);
+    value = -1000 * 0x10000;
+    CHECK_EQ(Property(&controls, ChannelProperty_Volume, KSPROPERTY_TYPE_SET, 0, &value), STATUS_SUCCESS);
+    CHECK_EQ(controls.GetVolume(0), LEYLINE_VOLUME_MIN_DB);
+
+    // The master channel sets all of them; GET on it reports channel 0.
+    value = -3 * 0x10000;
+    CHECK_EQ(Property(&controls, ChannelProperty_Volume, KSPROPERTY_TYPE_SET, LEYLINE_MASTER_CHANNEL, &value),
+             STATUS_SUCCESS);
+    for (ULONG ch = 0; ch < LEYLINE_GAIN_MAX_CHANNELS; ++ch) CHECK_EQ(controls.GetVolume(ch), -3 * 0x10000);
+    value = 0;
+    CHECK_EQ(Property(&controls, ChannelProperty_Volume, KSPROPERTY_TYPE_GET, LEYLINE_MASTER_CHANNEL, &value),
+             STATUS_SUCCESS);
+    CHECK_EQ(value, -3 * 0x10000);
+
+    value = 1;
+    CHECK_EQ(Property(&controls, ChannelProperty_Mute, KSPROPERTY_TYPE_SET, 2, &value), STATUS_SUCCESS);
+    CHECK(controls.GetMute(2));
+    CHECK(!controls.GetMute(1));
+
+    float gains[4];
+    controls.GetTargets(gains, 4, 0.5f);
+    CHECK_EQ(gains[2], 0.0f);
+    CHECK_EQ(gains[0], DbToLinear(-3 * 0x10000) * 0.5f);
+}
+
+HOST_TEST(Gain_UnityLeavesSamplesUntouched)
+{
+    std::vector<float> in = Noise(480 * 2, 1), out = in;
+    GainStage gain;
+    CHECK_EQ(gain.Init(SampleFormat_Float32, 2, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+    gain.Apply(out.data(), 480);
+    CHECK(memcmp(in.data(), out.data(), in.size() * sizeof(float)) == 0);
+}
+
+HOST_TEST(Gain_RampIsSmoothAndSettles)
+{
+    const ULONG channels = 2, ramp = kRate * LEYLINE_GAIN_RAMP_MS / 1000;
+    GainStage gain;
+    CHECK_EQ(gain.Init(SampleFormat_Float32, channels, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+
+    // A DC input shows the gain curve itself; apply it in uneven periods.
+    std::vector<float> dc((size_t)ramp * 2 * channels, 1.0f);
+    const float target[] = { 0.0f, 0.25f };
+    gain.RampTo(target);
+    CHECK(gain.IsRamping());
+
+    ULONG pos = 0;
+    for (ULONG period : { 7u, 100u, 33u, 1000u })
+    {
+        ULONG n = ramp * 2 - pos < period ? ramp * 2 - pos : period;
+        gain.Apply(dc.data() + (size_t)pos * channels, n);
+        pos += n;
+    }
+    CHECK(!gain.IsRamping());
+
+    for (ULONG ch = 0; ch < channels; ++ch)
+    {
+        const float maxStep = (1.0f - target[ch]) / ramp * 1.001f;
+        CHECK(fabs(dc[ch] - 1.0f) <= maxStep);
+        for (ULONG i = 1; i < ramp * 2; ++i)
+        {
+            float prev = dc[(size_t)(i - 1) * channels + ch], cur = dc[(size_t)i * channels + ch];
+            CHECK(cur <= prev);                                             // Monotonic
+            CHECK(prev - cur <= maxStep);                                   // No jump
+        }
+        CHECK(fabs(dc[(size_t)(ramp - 1) * channels + ch] - target[ch]) <= maxStep);
+        CHECK_EQ(dc[(size_t)(ramp * 2 - 1) * channels + ch], target[ch]);
+    }
+}
+
+HOST_TEST(Gain_RetargetMidRampStartsFromCurrentGain)
+{
+    GainStage gain;
+    CHECK_EQ(gain.Init(SampleFormat_Float32, 1, kRate, SimdLevel_Scalar), STATUS_SUCCESS);
+
+    const float down[] = { 0.0f }, up[] = { 1.0f };
+    std::vector<float> dc(kRate / 100, 1.0f);
+    gain.RampTo(down);
+    gain.Apply(dc.data(), 100);
+    float reached = gain.GetGain(0);
+    CHECK(reached < 1.0f && reached > 0.0f);
+
+    gain.RampTo(up);
+    gain.Apply(dc.data() + 100, 1);
+    CHECK(fabs(dc[100] - reached) < 1e-6f);
+}
+
+HOST_TEST(Gain_MuteEndsInDigitalSilence)
+{
+    for (LeylineSampleFormat format : { SampleFormat_Pcm8, SampleFormat_Pcm16, SampleFormat_Pcm24, SampleFormat_Float32 })
+    {
+        const ULONG channels = 2, frames = 960, bytes = SampleFormatBytes(format) * channels;
+        std::vector<UCHAR> buffer((size_t)frames * bytes);
+        for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = (UCHAR)(i * 37 + 11);
+        if (format == SampleFormat_Float32)
+        {
+            std::vector<float> n = Noise(frames * channels, 2);
+            memcpy(buffer.data(), n.data(), buffer.size());
+        }
+
+        ChannelControls controls = {};
+        controls.SetMute(LEYLINE_MASTER_CHANNEL, TRUE);
+        float targets[2];
+        controls.GetTargets(targets, channels, 1.0f);
+
+        GainStage gain;
+        CHECK_EQ(gain.Init(format, channels, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+        gain.RampTo(targets);
+        CHECK(!gain.IsSilent());
+        gain.Apply(buffer.data(), frames / 2);                              // 10 ms > the ramp
+        CHECK(gain.IsSilent());                                             // What the mixer skips on
+        gain.Apply(buffer.data() + (size_t)(frames / 2) * bytes, frames / 2);
+
+        std::vector<UCHAR> silence((size_t)(frames / 2) * bytes);
+        FillSilence(format, silence.data(), (SIZE_T)(frames / 2) * channels);
+        CHECK(memcmp(buffer.data() + (size_t)(frames / 2) * bytes, silence.data(), silence.size()) == 0);
+    }
+}
+
+HOST_TEST(Gain_Pcm16ScalesThroughFloat)
+{
+    const ULONG channels = 2, frames = 1000;
+    std::vector<SHORT> pcm((size_t)frames * channels);
+    for (size_t i = 0; i < pcm.size(); ++i) pcm[i] = (SHORT)((i * 7919) % 60000 - 30000);
+    std::vector<SHORT> orig = pcm;
+
+    GainStage gain;
+    CHECK_EQ(gain.Init(SampleFormat_Pcm16, channels, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+    const float half[] = { 0.5f, 0.25f };
+    gain.Jump(half);
+    gain.Apply(pcm.data(), frames);
+
+    for (size_t i = 0; i < pcm.size(); ++i)
+        CHECK(abs(pcm[i] - orig[i] * half[i % channels]) <= 1.5);          // +/-1 LSB dither
+}
+
+HOST_TEST(Gain_SimdMatchesScalar)
+{
+    const SimdLevel best = DetectSimdLevel();
+    for (ULONG channels = 1; channels <= LEYLINE_GAIN_MAX_CHANNELS; ++channels)
+    {
+        const ULONG frames = 1237;                                          // Not a multiple of 8
+        std::vector<float> in = Noise(frames * channels, channels);
+        float targets[LEYLINE_GAIN_MAX_CHANNELS], start[LEYLINE_GAIN_MAX_CHANNELS];
+        for (ULONG ch = 0; ch < channels; ++ch)
+        {
+            targets[ch] = 0.1f * (ch + 1);
+            start[ch]   = 1.0f - 0.05f * ch;
+        }
+
+        std::vector<float> reference;
+        for (SimdLevel level : { SimdLevel_Scalar, SimdLevel_Sse2, best })
+        {
+            GainStage gain;
+            CHECK_EQ(gain.Init(SampleFormat_Float32, channels, kRate, level), STATUS_SUCCESS);
+            gain.Jump(start);
+            gain.RampTo(targets);
+
+            std::vector<float> out = in;
+            ULONG pos = 0;
+            for (ULONG period : { 13u, 77u, 480u, 667u })                  // Ramp ends mid-period
+            {
+                gain.Apply(out.data() + (size_t)pos * channels, period);
+                pos += period;
+            }
+            if (level == SimdLevel_Scalar) reference = out;
+            else CHECK(memcmp(reference.data(), out.data(), out.size() * sizeof(float)) == 0);
+        }
+    }
+}
+
+HOST_TEST(Gain_RejectsBadInit)
+{
+    GainStage gain;
+    CHECK_EQ(gain.Init(SampleFormat_Unknown, 2, kRate, SimdLevel_Scalar), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(gain.Init(SampleFormat_Float32, 0, kRate, SimdLevel_Scalar), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(gain.Init(SampleFormat_Float32, LEYLINE_GAIN_MAX_CHANNELS + 1, kRate, SimdLevel_Scalar),
+             STATUS_INVALID_PARAMETER);
+    CHECK_EQ(gain.Init(SampleFormat_Float32, 2, 0, SimdLevel_Scalar), STATUS_INVALID_PARAMETER);
+}
+
+HOST_BENCH(Gain_CostPerPeriod)
+{
+    const ULONG channels = 2, streams = 8;
+    std::vector<float> f = Noise(kRate / 100 * channels, 3);
+    std::vector<SHORT> pcm(f.size());
+    for (size_t i = 0; i < f.size(); ++i) pcm[i] = (SHORT)(f[i] * 16000.0f);
+    std::vector<UCHAR> work(f.size() * sizeof(float));
+
+    for (ULONG periodMs : { 1u, 10u })
+    for (LeylineSampleFormat format : { SampleFormat_Pcm16, SampleFormat_Float32 })
+    for (SimdLevel level : { SimdLevel_Scalar, SimdLevel_Sse2, DetectSimdLevel() })
+    {
+        const ULONG frames = kRate / 1000 * periodMs;
+        const void* in     = format == SampleFormat_Float32 ? (const void*)f.data() : (const void*)pcm.data();
+        const SIZE_T bytes = (SIZE_T)frames * channels * SampleFormatBytes(format);
+
+        // Alternate targets so every period is half ramp, half settled. Each period
+        // starts from fresh input, as the DPC's does; re-attenuating one buffer
+        // would sink into denormals.
+        GainStage gain;
+        gain.Init(format, channels, kRate, level);
+        const float a[] = { 0.9f, 0.8f }, b[] = { 0.8f, 0.9f };
+
+        const int iterations = 200000 / periodMs;
+        uint64_t t0 = HostTest::NowNs();
+        for (int i = 0; i < iterations; ++i)
+        {
+            memcpy(work.data(), in, bytes);
+            if (i % 2 == 0) gain.RampTo((i / 2) % 2 ? a : b);
+            gain.Apply(work.data(), frames);
+        }
+        double ns   = (double)(HostTest::NowNs() - t0) / iterations;
+        double core = 100.0 * streams * ns / (periodMs * 1e6);
+
+        char name[64];
+        snprintf(name, sizeof(name), "gain_%ums_%s_%s_per_period", periodMs,
+                 format == SampleFormat_Float32 ? "f32" : "pcm16",
+                 level == SimdLevel_Avx2 ? "avx2" : level == SimdLevel_Sse2 ? "sse2" : "scalar");
+        HostTest::Report(name, ns, bytes * 1e9 / ns);
+        printf("    %-48s %11.4f %% of a core, 8 streams\n", "", core);
+        CHECK(core < 2.0);
+    }
+}
+
+HOST_BENCH(Gain_PropertyDispatchCost)
+{
+    // What the topology miniport does per KSPROPERTY_AUDIO_VOLUMELEVEL/MUTE: the
+    // shim stands in for the PCPROPERTY_REQUEST PortCls hands the handler.
+    ChannelControls controls = {};
+
+    struct Scenario { const char* Name; ChannelProperty Property; ULONG Verb; };
+    const Scenario scenarios[] =
+    {
+        { "property_volume_get",    ChannelProperty_Volume, KSPROPERTY_TYPE_GET },
+        { "property_volume_set",    ChannelProperty_Volume, KSPROPERTY_TYPE_SET },
+        { "property_mute_set",      ChannelProperty_Mute,   KSPROPERTY_TYPE_SET },
+        { "property_mute_get",      ChannelProperty_Mute,   KSPROPERTY_TYPE_GET },
+    };
+
+    const int iterations = 2000000;
+    for (const Scenario& s : scenarios)
+    {
+        volatile ULONG sink   = 0;
+        NTSTATUS       status = STATUS_SUCCESS;
+        uint64_t t0 = HostTest::NowNs();
+        for (int i = 0; i < iterations && NT_SUCCESS(status); ++i)
+        {
+            LONG value = s.Property == ChannelProperty_Mute ? (i & 1) : -(LONG)(i & 0xFFFF);
+            status = Property(&controls, s.Property, s.Verb, (ULONG)i % 2, &value);
+            sink = sink + (ULONG)value;
+        }
+        double ns = (double)(HostTest::NowNs() - t0) / iterations;
+
+        HostTest::Report(s.Name, ns, 0);
+        CHECK(NT_SUCCESS(status));
+    }
+}
@@ -0,0 +1,312 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GLITCH DETECTOR TESTS
+// Hand-worked render and capture cases, then a simulated client with scheduling
+// jitter and injected stalls: the detector, sampling once per DPC period, against
+// the glitches a frame-accurate model of the same run actually had. The benchmark
+// reports the per-period cost.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_glitch.h"
+
+#include <random>
+#include <vector>
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CLASSIFICATION
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_TEST(Glitch_RenderStarvationIsOneGlitchAcrossPeriods)
+{
+    GlitchDetector d = {};
+    LeylineGlitchStats s = {};
+
+    // Client ahead: nothing.
+    CHECK_EQ(d.ObserveRender(480, 960), (ULONGLONG)0);
+    CHECK_EQ(d.ObserveRender(960, 960), (ULONGLONG)0);
+
+    // Falls 100 frames behind mid-period, stays behind for two more periods.
+    CHECK_EQ(d.ObserveRender(1440, 1340), (ULONGLONG)100);
+    CHECK_EQ(d.Active(), GlitchKind_Underrun);
+    CHECK_EQ(d.ObserveRender(1920, 1340), (ULONGLONG)480);
+    CHECK_EQ(d.ObserveRender(2400, 1340), (ULONGLONG)480);
+
+    // Catches up.
+    CHECK_EQ(d.ObserveRender(2880, 3840), (ULONGLONG)0);
+    CHECK_EQ(d.Active(), GlitchKind_None);
+
+    d.GetStats(&s);
+    CHECK_EQ(s.Underruns, (ULONG)1);
+    CHECK_EQ(s.Overruns, (ULONG)0);
+    CHECK_EQ(s.GlitchFrames, (ULONGLONG)1060);
+    CHECK_EQ(s.LongestGlitchFrames, (ULONGLONG)1060);
+    CHECK_EQ(s.LastGlitchFrame, (ULONGLONG)1340);
+    CHECK_EQ(s.Periods, (ULONGLONG)6);
+
+    // A second, shorter one counts separately and leaves the longest alone.
+    CHECK_EQ(d.ObserveRender(3360, 3300), (ULONGLONG)60);
+    CHECK_EQ(d.ObserveRender(3840, 4800), (ULONGLONG)0);
+    d.GetStats(&s);
+    CHECK_EQ(s.Underruns, (ULONG)2);
+    CHECK_EQ(s.GlitchFrames, (ULONGLONG)1120);
+    CHECK_EQ(s.LongestGlitchFrames, (ULONGLONG)1060);
+    CHECK_EQ(s.LastGlitchFrame, (ULONGLONG)3300);
+}
+
+HOST_TEST(Glitch_CaptureOverrunCountsEachLostFrameOnce)
+{
+    GlitchDetector d = {};
+    LeylineGlitchStats s = {};
+    const ULONGLONG buffer = 960;
+
+    CHECK_EQ(d.ObserveCapture(480, 0, buffer), (ULONGLONG)0);
+    CHECK_EQ(d.ObserveCapture(960, 0, buffer), (ULONGLONG)0);      // Full, nothing lost yet
+
+    // The reader stalls: every period overwrites another 480 unread frames.
+    CHECK_EQ(d.ObserveCapture(1440, 0, buffer), (ULONGLONG)480);
+    CHECK_EQ(d.ObserveCapture(1920, 0, buffer), (ULONGLONG)480);
+    CHECK_EQ(d.Active(), GlitchKind_Overrun);
+
+    // It wakes and reads from the oldest frame still there.
+    CHECK_EQ(d.ObserveCapture(2400, 2400, buffer), (ULONGLONG)0);
+    CHECK_EQ(d.Active(), GlitchKind_None);
+
+    d.GetStats(&s);
+    CHECK_EQ(s.Overruns, (ULONG)1);
+    CHECK_EQ(s.Underruns, (ULONG)0);
+    CHECK_EQ(s.GlitchFrames, (ULONGLONG)960);
+    CHECK_EQ(s.LastGlitchFrame, (ULONGLONG)0);
+
+    // Lapped again with the reader partly through: only the unread part is lost.
+    CHECK_EQ(d.ObserveCapture(3600, 2500, buffer), (ULONGLONG)140);
+    d.GetStats(&s);
+    CHECK_EQ(s.Overruns, (ULONG)2);
+    CHECK_EQ(s.GlitchFrames, (ULONGLONG)1100);
+    CHECK_EQ(s.LastGlitchFrame, (ULONGLONG)2500);
+}
+
+HOST_TEST(Glitch_RecordAndRestart)
+{
+    GlitchDetector d = {};
+    LeylineGlitchStats s = {};
+
+    d.Record(GlitchKind_Underrun, 48, 1000);
+    d.Record(GlitchKind_Overrun, 5000, 2000);
+    d.Record(GlitchKind_None, 1, 1);
+    d.GetStats(&s);
+    CHECK_EQ(s.Underruns, (ULONG)1);
+    CHECK_EQ(s.Overruns, (ULONG)1);
+    CHECK_EQ(s.GlitchFrames, (ULONGLONG)5048);
+    CHECK_EQ(s.LongestGlitchFrames, (ULONGLONG)5000);
+    CHECK_EQ(s.LastGlitchFrame, (ULONGLONG)2000);
+
+    // A new run starts its positions from zero but keeps the counts.
+    d.ObserveRender(9600, 0);
+    d.Restart();
+    CHECK_EQ(d.Active(), GlitchKind_None);
+    CHECK_EQ(d.ObserveRender(480, 960), (ULONGLONG)0);
+    d.GetStats(&s);
+    CHECK_EQ(s.Underruns, (ULONG)2);
+
+    d.ResetCounters();
+    d.GetStats(&s);
+    CHECK_EQ(s.Underruns + s.Overruns, (ULONG)0);
+    CHECK_EQ(s.GlitchFrames + s.Periods, (ULONGLONG)0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// JITTER SIMULATION
+// 48 kHz in 0.25 ms ticks. The client wakes every 10 ms plus up to `jitter`, and
+// stalls (skips its wakes) for the given spans. The detector observes once per
+// 1 ms DPC period, itself up to a tick late. The reference model checks every tick.
+// A glitch that starts and ends between two observations can't be seen, and the
+// last partial period of one that does end can't be counted, so frames may come
+// up short by a period per glitch; glitches a period or longer must all be found.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static const ULONG kTickFrames   = 12;
+static const ULONG kTicksPerMs   = 4;
+static const ULONG kDpcTicks     = kTicksPerMs;
+static const ULONG kWakeTicks    = 10 * kTicksPerMs;
+static const ULONG kBufferFrames = 960;             // 20 ms
+
+struct Stall { ULONG StartMs, LengthMs; };
+
+struct SimResult
+{
+    ULONG     Glitches;         // Reference: all of them
+    ULONG     LongGlitches;     // Reference: a DPC period or longer
+    ULONGLONG Frames;
+    LeylineGlitchStats Detected;
+};
+
+static bool Stalled(const std::vector<Stall>& stalls, ULONG tick)
+{
+    for (const Stall& s : stalls)
+    {
+        if (tick >= s.StartMs * kTicksPerMs && tick < (s.StartMs + s.LengthMs) * kTicksPerMs) return true;
+    }
+    return false;
+}
+
+static SimResult Simulate(bool capture, ULONG seconds, ULONG jitterMs, const std::vector<Stall>& stalls, ULONG seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<ULONG> wakeJitter(0, jitterMs * kTicksPerMs);
+    std::uniform_int_distribution<ULONG> dpcJitter(0, 1);
+
+    SimResult r = {};
+    GlitchDetector d = {};
+
+    ULONGLONG device = 0, client = 0, through = 0, episode = 0;
+    bool      glitching = false;
+    ULONG     nextWake = wakeJitter(rng), nextDpc = kDpcTicks + dpcJitter(rng);
+    auto closeEpisode = [&]()
+    {
+        if (glitching && episode >= kDpcTicks * kTickFrames) ++r.LongGlitches;
+        glitching = false;
+        episode   = 0;
+    };
+
+    // Render starts with a full buffer; capture starts empty.
+    if (!capture) client = kBufferFrames;
+
+    const ULONG ticks = seconds * 1000 * kTicksPerMs;
+    for (ULONG t = 1; t <= ticks; ++t)
+    {
+        ULONGLONG before = device;
+        device += kTickFrames;
+
+        // Reference model, frame-accurate at tick granularity.
+        ULONGLONG lost = 0;
+        if (!capture && device > client)
+        {
+            ULONGLONG from = client > before ? client : before;
+            lost = device - from;
+        }
+        if (capture && device - client > kBufferFrames)
+        {
+            ULONGLONG oldest = device - kBufferFrames;
+            ULONGLONG from   = client > through ? client : through;
+            lost    = oldest > from ? oldest - from : 0;
+            through = oldest > through ? oldest : through;
+        }
+        if (lost)
+        {
+            if (!glitching) ++r.Glitches;
+            glitching = true;
+            episode  += lost;
+            r.Frames += lost;
+        }
+
+        if (t >= nextWake)
+        {
+            if (!Stalled(stalls, t))
+            {
+                // Render tops the buffer up; capture reads all there is.
+                client = capture ? device : device + kBufferFrames;
+                closeEpisode();
+            }
+            nextWake += kWakeTicks + wakeJitter(rng) - (nextWake % kWakeTicks);
+        }
+
+        if (t >= nextDpc)
+        {
+            if (capture) d.ObserveCapture(device, client, kBufferFrames);
+            else         d.ObserveRender(device, client);
+            nextDpc = (t / kDpcTicks + 1) * kDpcTicks + dpcJitter(rng);
+        }
+    }
+    closeEpisode();
+    d.GetStats(&r.Detected);
+    return r;
+}
+
+static bool CheckSimulation(bool capture, const SimResult& r)
+{
+    ULONG detected = capture ? r.Detected.Overruns : r.Detected.Underruns;
+    ULONG other    = capture ? r.Detected.Underruns : r.Detected.Overruns;
+    printf("    %s: reference %u glitches (%u >= 1 period), %llu frames; detected %u, %llu frames\n",
+           capture ? "capture" : "render", r.Glitches, r.LongGlitches, (unsigned long long)r.Frames,
+           detected, (unsigned long long)r.Detected.GlitchFrames);
+
+    if (other != 0) return false;
+    if (detected < r.LongGlitches || detected > r.Glitches) return false;
+    if (r.Detected.GlitchFrames > r.Frames) return false;
+    return r.Frames - r.Detected.GlitchFrames <= (ULONGLONG)r.Glitches * (kDpcTicks + 1) * kTickFrames;
+}
+
+HOST_TEST(Glitch_JitterAloneIsNotAGlitch)
+{
+    // 8 ms of jitter on a 10 ms wake against 20 ms of buffer never runs dry.
+    for (int capture = 0; capture < 2; ++capture)
+    {
+        SimResult r = Simulate(capture != 0, 60, 8, {}, 1234 + capture);
+        CHECK_EQ(r.Glitches, (ULONG)0);
+        CHECK(CheckSimulation(capture != 0, r));
+        CHECK(r.Detected.Periods + 1 >= (ULONGLONG)60 * 1000);  // The last may fall past the end
+    }
+}
+
+HOST_TEST(Glitch_InjectedStallsAreFoundAndSized)
+{
+    const std::vector<Stall> stalls =
+    {
+        { 1000, 12 },   // Absorbed by the buffer on a good wake, a short glitch on a late one
+        { 3000, 25 },
+        { 5000, 40 },
+        { 7000, 100 },
+        { 9000, 500 },
+        { 11000, 30 }, { 11100, 30 },  // Two close together stay two
+    };
+
+    for (int capture = 0; capture < 2; ++capture)
+    {
+        for (ULONG seed = 1; seed <= 8; ++seed)
+        {
+            SimResult r = Simulate(capture != 0, 13, 8, stalls, seed * 977 + capture);
+            CHECK(r.Glitches >= 6);
+            CHECK(CheckSimulation(capture != 0, r));
+        }
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARK
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_BENCH(Glitch_ObserveCostPerPeriod)
+{
+    const int iterations = 10000000;
+    for (int capture = 0; capture < 2; ++capture)
+    {
+        for (int starving = 0; starving < 2; ++starving)
+        {
+            GlitchDetector d = {};
+            ULONGLONG device = 0, client = starving ? 0 : kBufferFrames;
+
+            uint64_t t0 = HostTest::NowNs();
+            for (int i = 0; i < iterations; ++i)
+            {
+                device += 48;
+                if (!starving) client += 48;
+                if (capture) d.ObserveCapture(device, starving ? 0 : device, kBufferFrames);
+                else         d.ObserveRender(device, client);
+            }
+            double ns = (double)(HostTest::NowNs() - t0) / iterations;
+
+            char name[64];
+            snprintf(name, sizeof(name), "glitch_observe_%s_%s", capture ? "capture" : "render",
+                     starving ? "in_glitch" : "clean");
+            HostTest::Report(name, ns, 0);
+
+            LeylineGlitchStats s;
+            d.GetStats(&s);
+            CHECK_EQ(s.Periods, (ULONGLONG)iterations);
+            CHECK_EQ(s.Underruns + s.Overruns, (ULONG)(starving ? 1 : 0));
+        }
+    }
+}
@@ -0,0 +1,200 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// HOST TEST RUNNER
+// Usage: leyline_host_tests [--bench] [--json <path>] [--thresholds <path>] [filter]
+//
+// --json writes every Report() line as {"bench", "name", "ns_per_op",
+// "bytes_per_sec"} for tooling that tracks results across runs. --thresholds reads
+// "<name> <max ns/op>" lines ('#' starts a comment); a Report() over its ceiling
+// fails the benchmark that made it, so a regression fails `make bench`.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+
+#include <string.h>
+#include <time.h>
+
+namespace HostTest
+{
+    static Case* s_Head      = nullptr;
+    static Case* s_Tail      = nullptr;
+    static Case* s_Current   = nullptr;
+    static bool  s_Failed    = false;
+
+    struct Result
+    {
+        const char* Bench;
+        char        Name[64];
+        double      NsPerOp;
+        double      BytesPerSec;
+    };
+
+    struct Threshold
+    {
+        char   Name[64];
+        double MaxNsPerOp;
+        bool   Seen;
+    };
+
+    static Result    s_Results[512];
+    static int       s_ResultCount    = 0;
+    static Threshold s_Thresholds[256];
+    static int       s_ThresholdCount = 0;
+
+    Registrar::Registrar(const char* name, CaseFn fn, bool isBench)
+    {
+        static Case storage[256];
+        static int  used = 0;
+        if (used >= (int)(sizeof(storage) / sizeof(storage[0]))) return;
+
+        Case* c = &storage[used++];
+        c->Name    = name;
+        c->Fn      = fn;
+        c->IsBench = isBench;
+        c->Next    = nullptr;
+        if (s_Tail) s_Tail->Next = c; else s_Head = c;
+        s_Tail = c;
+    }
+
+    void Fail(const char* file, int line, const char* expr)
+    {
+        fprintf(stderr, "    %s:%d: CHECK failed: %s\n", file, line, expr);
+        s_Failed = true;
+    }
+
+    uint64_t NowNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    void Report(const char* name, double nsPerOp, double bytesPerSec)
+    {
+        if (bytesPerSec > 0)
+            printf("    %-48s %12.2f ns/op %12.2f MB/s\n", name, nsPerOp, bytesPerSec / 1e6);
+        else
+            printf("    %-48s %12.2f ns/op\n", name, nsPerOp);
+
+        if (s_ResultCount < (int)(sizeof(s_Results) / sizeof(s_Results[0])))
+        {
+            Result& r = s_Results[s_ResultCount++];
+            r.Bench       = s_Current ? s_Current->Name : "";
+            snprintf(r.Name, sizeof(r.Name), "%s", name);
+            r.NsPerOp     = nsPerOp;
+            r.BytesPerSec = bytesPerSec;
+        }
+
+        for (int i = 0; i < s_ThresholdCount; ++i)
+        {
+            Threshold& t = s_Thresholds[i];
+            if (strcmp(t.Name, name) != 0) continue;
+            t.Seen = true;
+            if (nsPerOp > t.MaxNsPerOp)
+            {
+                fprintf(stderr, "    %s: %.2f ns/op is over its %.2f ns/op ceiling\n", name, nsPerOp, t.MaxNsPerOp);
+                s_Failed = true;
+            }
+        }
+    }
+
+    static bool LoadThresholds(const char* path)
+    {
+        FILE* f = fopen(path, "r");
+        if (!f) { fprintf(stderr, "cannot open %s\n", path); return false; }
+
+        char line[256];
+        int  number = 0;
+        bool ok     = true;
+        while (fgets(line, sizeof(line), f))
+        {
+            ++number;
+            if (char* hash = strchr(line, '#')) *hash = 0;
+
+            char   name[64];
+            double ceiling;
+            char   extra;
+            int    fields = sscanf(line, "%63s %lf %c", name, &ceiling, &extra);
+            if (fields <= 0) continue;
+            if (fields != 2 || ceiling <= 0)
+            {
+                fprintf(stderr, "%s:%d: expected \"<name> <max ns/op>\"\n", path, number);
+                ok = false;
+                continue;
+            }
+            if (s_ThresholdCount >= (int)(sizeof(s_Thresholds) / sizeof(s_Thresholds[0]))) break;
+
+            Threshold& t = s_Thresholds[s_ThresholdCount++];
+            snprintf(t.Name, sizeof(t.Name), "%s", name);
+            t.MaxNsPerOp = ceiling;
+            t.Seen       = false;
+        }
+        fclose(f);
+        return ok;
+    }
+
+    static bool WriteJson(const char* path)
+    {
+        FILE* f = fopen(path, "w");
+        if (!f) { fprintf(stderr, "cannot write %s\n", path); return false; }
+
+        // Names are C identifiers plus '_'; nothing needs escaping.
+        fprintf(f, "{\n  \"results\": [");
+        for (int i = 0; i < s_ResultCount; ++i)
+        {
+            const Result& r = s_Results[i];
+            fprintf(f, "%s\n    { \"bench\": \"%s\", \"name\": \"%s\", \"ns_per_op\": %.3f, \"bytes_per_sec\": %.0f }",
+                    i ? "," : "", r.Bench, r.Name, r.NsPerOp, r.BytesPerSec);
+        }
+        fprintf(f, "\n  ]\n}\n");
+        return fclose(f) == 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool        bench      = false;
+    const char* filter     = nullptr;
+    const char* json       = nullptr;
+    const char* thresholds = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--bench") == 0) bench = true;
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) json = argv[++i];
+        else if (strcmp(argv[i], "--thresholds") == 0 && i + 1 < argc) thresholds = argv[++i];
+        else filter = argv[i];
+    }
+    if (thresholds && !HostTest::LoadThresholds(thresholds)) return 2;
+
+    int run = 0, failed = 0;
+    for (HostTest::Case* c = HostTest::s_Head; c; c = c->Next)
+    {
+        if (c->IsBench != bench) continue;
+        if (filter && !strstr(c->Name, filter)) continue;
+
+        printf("[ RUN  ] %s\n", c->Name);
+        fflush(stdout);
+        HostTest::s_Failed  = false;
+        HostTest::s_Current = c;
+        c->Fn();
+        HostTest::s_Current = nullptr;
+        ++run;
+        if (HostTest::s_Failed) { ++failed; printf("[ FAIL ] %s\n", c->Name); }
+        else printf("[  OK  ] %s\n", c->Name);
+    }
+
+    printf("%d %s, %d failed\n", run, bench ? "benchmarks" : "tests", failed);
+
+    // A ceiling nothing reported against is a renamed or deleted result; say so
+    // rather than silently stop guarding it. Filtered runs skip most of them.
+    for (int i = 0; i < HostTest::s_ThresholdCount && !filter; ++i)
+    {
+        if (!HostTest::s_Thresholds[i].Seen)
+            printf("warning: no result named %s for its threshold\n", HostTest::s_Thresholds[i].Name);
+    }
+
+    if (json && !HostTest::WriteJson(json)) return 2;
+    return failed ? 1 : 0;
+}
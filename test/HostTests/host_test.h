@@ -0,0 +1,54 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// HOST TEST HARNESS
+// Minimal self-registering test and benchmark runner for the portable driver core.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+namespace HostTest
+{
+    typedef void (*CaseFn)();
+
+    struct Case
+    {
+        const char* Name;
+        CaseFn      Fn;
+        bool        IsBench;
+        Case*       Next;
+    };
+
+    struct Registrar
+    {
+        Registrar(const char* name, CaseFn fn, bool isBench);
+    };
+
+    // Marks the running test as failed; the CHECK macros return afterwards.
+    void Fail(const char* file, int line, const char* expr);
+
+    // Monotonic wall clock in nanoseconds.
+    uint64_t NowNs();
+
+    // One benchmark result line. `bytesPerSec` may be 0 when not meaningful.
+    void Report(const char* name, double nsPerOp, double bytesPerSec);
+}
+
+#define HOST_TEST(name)                                                         \
+    static void name();                                                         \
+    static HostTest::Registrar name##_Registrar(#name, name, false);            \
+    static void name()
+
+#define HOST_BENCH(name)                                                        \
+    static void name();                                                         \
+    static HostTest::Registrar name##_Registrar(#name, name, true);             \
+    static void name()
+
+#define CHECK(expr)                                                             \
+    do { if (!(expr)) { HostTest::Fail(__FILE__, __LINE__, #expr); return; } } while (0)
+
+#define CHECK_EQ(a, b)  CHECK((a) == (b))
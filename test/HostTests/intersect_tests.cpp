@@ -0,0 +1,350 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// FORMAT INTERSECTION TESTS
+// Client ranges and concrete formats against the driver's PCM and float pin
+// ranges, table by table; the proposed-format preference; Build/Parse round trips
+// and when the answer has to be EXTENSIBLE.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_intersect.h"
+
+#include <stdio.h>
+
+// The wave pins' ranges, as in descriptors/common.cpp.
+static KSDATARANGE_AUDIO PinRange(BOOLEAN isFloat)
+{
+    KSDATARANGE_AUDIO r = {};
+    r.DataRange.FormatSize  = sizeof(KSDATARANGE_AUDIO);
+    r.DataRange.MajorFormat = KSDATAFORMAT_TYPE_AUDIO;
+    r.DataRange.SubFormat   = isFloat ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT : KSDATAFORMAT_SUBTYPE_PCM;
+    r.DataRange.Specifier   = KSDATAFORMAT_SPECIFIER_WAVEFORMATEX;
+    r.MaximumChannels        = LEYLINE_WAVE_MAX_CHANNELS;
+    r.MinimumBitsPerSample   = 8;
+    r.MaximumBitsPerSample   = 32;
+    r.MinimumSampleFrequency = 8000;
+    r.MaximumSampleFrequency = 192000;
+    return r;
+}
+
+static KSDATARANGE_AUDIO ClientRange(BOOLEAN isFloat, ULONG channels, ULONG minBits, ULONG maxBits, ULONG minRate, ULONG maxRate)
+{
+    KSDATARANGE_AUDIO r = PinRange(isFloat);
+    r.MaximumChannels        = channels;
+    r.MinimumBitsPerSample   = minBits;
+    r.MaximumBitsPerSample   = maxBits;
+    r.MinimumSampleFrequency = minRate;
+    r.MaximumSampleFrequency = maxRate;
+    return r;
+}
+
+static WaveFormat Format(BOOLEAN isFloat, ULONG channels, ULONG rate, ULONG bits, ULONG valid, ULONG mask)
+{
+    WaveFormat f = { isFloat, channels, rate, bits, valid, mask };
+    return f;
+}
+
+static bool Same(const WaveFormat& a, const WaveFormat& b)
+{
+    return a.Float == b.Float && a.Channels == b.Channels && a.SampleRate == b.SampleRate &&
+           a.ContainerBits == b.ContainerBits && a.ValidBits == b.ValidBits && a.ChannelMask == b.ChannelMask;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CLIENT RANGES
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct RangeCase
+{
+    const char* Name;
+    BOOLEAN     Float;
+    ULONG       Channels, MinBits, MaxBits, MinRate, MaxRate;
+    NTSTATUS    Status;
+    ULONG       OutChannels, OutRate, OutBits;
+};
+
+static const RangeCase kRangeCases[] =
+{
+    { "open PCM",               FALSE, 2,  8, 32,   8000, 192000, STATUS_SUCCESS,  2,  48000, 16 },
+    { "96k 24-bit pinned",      FALSE, 2, 24, 24,  96000,  96000, STATUS_SUCCESS,  2,  96000, 24 },
+    { "mono",                   FALSE, 1,  8, 32,   8000, 192000, STATUS_SUCCESS,  1,  48000, 16 },
+    { "wants 8 channels",       FALSE, 8, 16, 16,  48000,  48000, STATUS_SUCCESS,  2,  48000, 16 },
+    { "20..32 bits rounds up",  FALSE, 2, 20, 32,  48000,  48000, STATUS_SUCCESS,  2,  48000, 24 },
+    { "32-bit only",            FALSE, 2, 32, 32,  48000,  48000, STATUS_SUCCESS,  2,  48000, 32 },
+    { "8-bit only",             FALSE, 2,  8,  8,  22050,  22050, STATUS_SUCCESS,  2,  22050,  8 },
+    { "below preferred rate",   FALSE, 2, 16, 16,   8000,  44100, STATUS_SUCCESS,  2,  44100, 16 },
+    { "above preferred rate",   FALSE, 2, 16, 16,  88200, 384000, STATUS_SUCCESS,  2,  88200, 16 },
+    { "no whole container",     FALSE, 2, 17, 23,  48000,  48000, STATUS_NO_MATCH, 0,      0,  0 },
+    { "rates past the pin",     FALSE, 2, 16, 16, 200000, 384000, STATUS_NO_MATCH, 0,      0,  0 },
+    { "no channels",            FALSE, 0, 16, 16,  48000,  48000, STATUS_NO_MATCH, 0,      0,  0 },
+    { "inverted rates",         FALSE, 2, 16, 16,  48000,  44100, STATUS_NO_MATCH, 0,      0,  0 },
+    { "open float",             TRUE,  2,  8, 32,   8000, 192000, STATUS_SUCCESS,  2,  48000, 32 },
+    { "float 96k mono",         TRUE,  1, 32, 32,  96000,  96000, STATUS_SUCCESS,  1,  96000, 32 },
+    { "float without 32 bits",  TRUE,  2,  8, 24,  48000,  48000, STATUS_NO_MATCH, 0,      0,  0 },
+};
+
+HOST_TEST(Intersect_ClientRangesTable)
+{
+    for (const RangeCase& c : kRangeCases)
+    {
+        KSDATARANGE_AUDIO pin    = PinRange(c.Float);
+        KSDATARANGE_AUDIO client = ClientRange(c.Float, c.Channels, c.MinBits, c.MaxBits, c.MinRate, c.MaxRate);
+        WaveFormat        out    = {};
+        NTSTATUS status = FormatIntersection::Intersect(&pin.DataRange, &client.DataRange, nullptr, &out);
+        if (status != c.Status) printf("    case: %s\n", c.Name);
+        CHECK_EQ(status, c.Status);
+        if (!NT_SUCCESS(status)) continue;
+
+        if (out.Channels != c.OutChannels || out.SampleRate != c.OutRate || out.ContainerBits != c.OutBits)
+            printf("    case: %s\n", c.Name);
+        CHECK_EQ(out.Float, c.Float);
+        CHECK_EQ(out.Channels, c.OutChannels);
+        CHECK_EQ(out.SampleRate, c.OutRate);
+        CHECK_EQ(out.ContainerBits, c.OutBits);
+        CHECK_EQ(out.ValidBits, c.OutBits);
+        CHECK_EQ(out.ChannelMask, FormatIntersection::DefaultChannelMask(c.OutChannels));
+    }
+}
+
+HOST_TEST(Intersect_MultichannelProposalKeepsItsLayout)
+{
+    KSDATARANGE_AUDIO pin      = PinRange(TRUE);
+    KSDATARANGE_AUDIO client   = PinRange(TRUE);
+    WaveFormat        proposed = Format(TRUE, 12, 48000, 32, 32, KSAUDIO_SPEAKER_7POINT1POINT4);
+    WaveFormat        out;
+
+    CHECK_EQ(FormatIntersection::Intersect(&pin.DataRange, &client.DataRange, &proposed, &out), STATUS_SUCCESS);
+    CHECK(Same(out, proposed));
+
+    // A client that stops at 7.1 gets 7.1, not the proposal's top speakers.
+    client.MaximumChannels = 8;
+    CHECK_EQ(FormatIntersection::Intersect(&pin.DataRange, &client.DataRange, &proposed, &out), STATUS_SUCCESS);
+    CHECK(Same(out, Format(TRUE, 8, 48000, 32, 32, KSAUDIO_SPEAKER_7POINT1_SURROUND)));
+
+    CHECK_EQ(FormatIntersection::DefaultChannelMask(10), (ULONG)KSAUDIO_SPEAKER_5POINT1POINT4);
+    CHECK_EQ(FormatIntersection::DefaultChannelMask(16), (ULONG)KSAUDIO_SPEAKER_DIRECTOUT);
+}
+
+HOST_TEST(Intersect_BareRangeGetsThePreferredFormat)
+{
+    KSDATARANGE_AUDIO pin    = PinRange(FALSE);
+    KSDATARANGE       client = pin.DataRange;
+    client.FormatSize = sizeof(KSDATARANGE);
+
+    WaveFormat out;
+    CHECK_EQ(FormatIntersection::Intersect(&pin.DataRange, &client, nullptr, &out), STATUS_SUCCESS);
+    CHECK(Same(out, FormatIntersection::Preferred(FALSE)));
+}
+
+HOST_TEST(Intersect_RejectsOtherTypesAndSpecifiers)
+{
+    KSDATARANGE_AUDIO pin = PinRange(FALSE);
+    WaveFormat out;
+
+    KSDATARANGE_AUDIO client = PinRange(TRUE);       // Float against the PCM pin
+    CHECK_EQ(FormatIntersection::Intersect(&pin.DataRange, &client.DataRange, nullptr, &out), STATUS_NO_MATCH);
+
+    client = PinRange(FALSE);
+    client.DataRange.MajorFormat = GUID_NULL;
+    CHECK_EQ(FormatIntersection::Intersect(&pin.DataRange, &client.DataRange, nullptr, &out), STATUS_NO_MATCH);
+
+    client = PinRange(FALSE);
+    client.DataRange.Specifier = GUID_NULL;
+    CHECK_EQ(FormatIntersection::Intersect(&pin.DataRange, &client.DataRange, nullptr, &out), STATUS_NO_MATCH);
+
+    client = PinRange(FALSE);
+    client.DataRange.Specifier = KSDATAFORMAT_SPECIFIER_WAVEFORMATEXTENSIBLE;
+    CHECK_EQ(FormatIntersection::Intersect(&pin.DataRange, &client.DataRange, nullptr, &out), STATUS_SUCCESS);
+
+    // A pin range that is not an audio range (the bridge pin's) matches nothing.
+    KSDATARANGE bridge = pin.DataRange;
+    bridge.FormatSize = sizeof(KSDATARANGE);
+    CHECK_EQ(FormatIntersection::Intersect(&bridge, &client.DataRange, nullptr, &out), STATUS_NO_MATCH);
+}
+
+HOST_TEST(Intersect_OpenChoicesFollowTheProposedFormat)
+{
+    KSDATARANGE_AUDIO pin    = PinRange(FALSE);
+    KSDATARANGE_AUDIO client = PinRange(FALSE);
+    WaveFormat proposed = Format(FALSE, 2, 96000, 32, 24, KSAUDIO_SPEAKER_STEREO);
+    WaveFormat out;
+
+    CHECK_EQ(FormatIntersection::Intersect(&pin.DataRange, &client.DataRange, &proposed, &out), STATUS_SUCCESS);
+    CHECK(Same(out, proposed));
+
+    // The client's limits still win; what survives of the proposal is kept.
+    client = ClientRange(FALSE, 1, 16, 16, 8000, 48000);
+    CHECK_EQ(FormatIntersection::Intersect(&pin.DataRange, &client.DataRange, &proposed, &out), STATUS_SUCCESS);
+    CHECK(Same(out, Format(FALSE, 1, 48000, 16, 16, KSAUDIO_SPEAKER_MONO)));
+
+    // A PCM proposal says nothing about float.
+    KSDATARANGE_AUDIO floatPin = PinRange(TRUE);
+    client = PinRange(TRUE);
+    CHECK_EQ(FormatIntersection::Intersect(&floatPin.DataRange, &client.DataRange, &proposed, &out), STATUS_SUCCESS);
+    CHECK(Same(out, FormatIntersection::Preferred(TRUE)));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CONCRETE FORMATS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct FormatCase
+{
+    const char* Name;
+    WaveFormat  Format;
+    BOOLEAN     Extensible;
+    NTSTATUS    Status;
+};
+
+static const FormatCase kFormatCases[] =
+{
+    { "PCM16 48k",              { FALSE, 2,  48000, 16, 16, KSAUDIO_SPEAKER_STEREO }, FALSE, STATUS_SUCCESS },
+    { "PCM24 96k",              { FALSE, 2,  96000, 24, 24, KSAUDIO_SPEAKER_STEREO }, TRUE,  STATUS_SUCCESS },
+    { "24 valid in 32",         { FALSE, 2,  96000, 32, 24, KSAUDIO_SPEAKER_STEREO }, TRUE,  STATUS_SUCCESS },
+    { "20 valid in 24",         { FALSE, 2,  48000, 24, 20, KSAUDIO_SPEAKER_STEREO }, TRUE,  STATUS_SUCCESS },
+    { "mono at 44.1k",          { FALSE, 1,  44100, 16, 16, KSAUDIO_SPEAKER_MONO },   FALSE, STATUS_SUCCESS },
+    { "direct-out stereo",      { FALSE, 2,  48000, 16, 16, KSAUDIO_SPEAKER_DIRECTOUT }, TRUE, STATUS_SUCCESS },
+    { "PCM8 8k",                { FALSE, 2,   8000,  8,  8, KSAUDIO_SPEAKER_STEREO }, FALSE, STATUS_SUCCESS },
+    { "float 192k",             { TRUE,  2, 192000, 32, 32, KSAUDIO_SPEAKER_STEREO }, TRUE,  STATUS_SUCCESS },
+    { "5.1",                    { FALSE, 6,  48000, 16, 16, KSAUDIO_SPEAKER_5POINT1 }, TRUE, STATUS_SUCCESS },
+    { "7.1.4 float",            { TRUE, 12,  48000, 32, 32, KSAUDIO_SPEAKER_7POINT1POINT4 }, TRUE, STATUS_SUCCESS },
+    { "16 direct-out",          { FALSE, 16, 48000, 24, 24, KSAUDIO_SPEAKER_DIRECTOUT }, TRUE, STATUS_SUCCESS },
+    { "18 past the pin",        { FALSE, 18, 48000, 16, 16, KSAUDIO_SPEAKER_DIRECTOUT }, TRUE, STATUS_NO_MATCH },
+    { "384k past the pin",      { FALSE, 2, 384000, 16, 16, KSAUDIO_SPEAKER_STEREO }, FALSE, STATUS_NO_MATCH },
+    { "4k below the pin",       { FALSE, 2,   4000, 16, 16, KSAUDIO_SPEAKER_STEREO }, FALSE, STATUS_NO_MATCH },
+    { "valid over container",   { FALSE, 2,  48000, 16, 24, KSAUDIO_SPEAKER_STEREO }, TRUE,  STATUS_NO_MATCH },
+    { "20-bit container",       { FALSE, 2,  48000, 20, 20, KSAUDIO_SPEAKER_STEREO }, TRUE,  STATUS_NO_MATCH },
+    { "16-bit float",           { TRUE,  2,  48000, 16, 16, KSAUDIO_SPEAKER_STEREO }, TRUE,  STATUS_NO_MATCH },
+};
+
+HOST_TEST(Intersect_ConcreteFormatsTable)
+{
+    for (const FormatCase& c : kFormatCases)
+    {
+        KSDATARANGE_AUDIO pin = PinRange(c.Format.Float);
+        KSDATAFORMAT_WAVEFORMATEXTENSIBLE request;
+        FormatIntersection::Build(c.Format, c.Extensible, KSDATAFORMAT_SPECIFIER_WAVEFORMATEX, &request);
+
+        WaveFormat out = {};
+        NTSTATUS status = FormatIntersection::Intersect(&pin.DataRange, &request.DataFormat, nullptr, &out);
+        if (status != c.Status || (NT_SUCCESS(status) && !Same(out, c.Format))) printf("    case: %s\n", c.Name);
+        CHECK_EQ(status, c.Status);
+        if (!NT_SUCCESS(status)) continue;
+
+        CHECK(Same(out, c.Format));                                             // Verbatim
+        CHECK_EQ(FormatIntersection::WantsExtensible(&request.DataFormat, out), c.Extensible);
+    }
+}
+
+HOST_TEST(Intersect_ParseRejectsMalformedFormats)
+{
+    KSDATAFORMAT_WAVEFORMATEXTENSIBLE f;
+    WaveFormat out;
+    FormatIntersection::Build(Format(FALSE, 2, 48000, 16, 16, KSAUDIO_SPEAKER_STEREO), TRUE,
+                              KSDATAFORMAT_SPECIFIER_WAVEFORMATEX, &f);
+    CHECK_EQ(FormatIntersection::Parse(&f.DataFormat, sizeof(f), &out), STATUS_SUCCESS);
+
+    KSDATAFORMAT_WAVEFORMATEXTENSIBLE bad = f;
+    bad.WaveFormatExt.Format.nBlockAlign = 6;
+    CHECK_EQ(FormatIntersection::Parse(&bad.DataFormat, sizeof(bad), &out), STATUS_NOT_SUPPORTED);
+
+    bad = f;
+    bad.WaveFormatExt.Format.cbSize = 0;
+    CHECK_EQ(FormatIntersection::Parse(&bad.DataFormat, sizeof(bad), &out), STATUS_INVALID_PARAMETER);
+
+    bad = f;
+    bad.WaveFormatExt.SubFormat = GUID_NULL;
+    CHECK_EQ(FormatIntersection::Parse(&bad.DataFormat, sizeof(bad), &out), STATUS_NOT_SUPPORTED);
+
+    bad = f;
+    bad.WaveFormatExt.Format.wFormatTag = 0x0055;     // MP3
+    CHECK_EQ(FormatIntersection::Parse(&bad.DataFormat, sizeof(bad), &out), STATUS_NOT_SUPPORTED);
+
+    CHECK_EQ(FormatIntersection::Parse(&f.DataFormat, sizeof(KSDATAFORMAT_WAVEFORMATEX) - 1, &out), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(FormatIntersection::Parse(&f.DataFormat, sizeof(KSDATAFORMAT_WAVEFORMATEX), &out), STATUS_INVALID_PARAMETER);
+
+    // Zero valid bits means all of them.
+    bad = f;
+    bad.WaveFormatExt.Samples.wValidBitsPerSample = 0;
+    CHECK_EQ(FormatIntersection::Parse(&bad.DataFormat, sizeof(bad), &out), STATUS_SUCCESS);
+    CHECK_EQ(out.ValidBits, (ULONG)16);
+}
+
+HOST_TEST(Intersect_BuildRoundTripsThroughParse)
+{
+    const WaveFormat formats[] =
+    {
+        Format(FALSE, 2, 48000, 16, 16, KSAUDIO_SPEAKER_STEREO),
+        Format(FALSE, 1, 22050,  8,  8, KSAUDIO_SPEAKER_MONO),
+        Format(TRUE,  2, 96000, 32, 32, KSAUDIO_SPEAKER_STEREO),
+        Format(FALSE, 2, 96000, 32, 24, KSAUDIO_SPEAKER_STEREO),
+    };
+    for (const WaveFormat& f : formats)
+    {
+        for (int e = 0; e < 2; ++e)
+        {
+            BOOLEAN extensible = (BOOLEAN)e;
+            if (!extensible && f.ValidBits != f.ContainerBits) continue;
+
+            KSDATAFORMAT_WAVEFORMATEXTENSIBLE built;
+            FormatIntersection::Build(f, extensible, KSDATAFORMAT_SPECIFIER_WAVEFORMATEX, &built);
+            CHECK_EQ(built.DataFormat.FormatSize, FormatIntersection::FormatSize(extensible));
+            CHECK_EQ(built.DataFormat.SampleSize, f.Channels * f.ContainerBits / 8);
+            CHECK_EQ(built.WaveFormatExt.Format.nAvgBytesPerSec, f.SampleRate * built.DataFormat.SampleSize);
+            CHECK(IsEqualGUID(built.DataFormat.Specifier, KSDATAFORMAT_SPECIFIER_WAVEFORMATEX));
+
+            WaveFormat back;
+            CHECK_EQ(FormatIntersection::Parse(&built.DataFormat, built.DataFormat.FormatSize, &back), STATUS_SUCCESS);
+            CHECK(Same(back, f));
+        }
+    }
+}
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARK
+// One KSPROPERTY_PIN_DATAINTERSECTION's worth of work per op: intersect, decide on
+// EXTENSIBLE, build the answer. Runs at stream open, so it only has to stay cheap
+// next to a buffer allocation.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_BENCH(Intersect_NegotiationCost)
+{
+    const KSDATARANGE_AUDIO pin      = PinRange(FALSE);
+    const KSDATARANGE_AUDIO client   = ClientRange(FALSE, 2, 16, 24, 44100, 48000);
+    const WaveFormat        proposed = Format(FALSE, 2, 48000, 24, 24, KSAUDIO_SPEAKER_STEREO);
+
+    KSDATAFORMAT_WAVEFORMATEXTENSIBLE concrete;
+    FormatIntersection::Build(Format(FALSE, 6, 48000, 16, 16, KSAUDIO_SPEAKER_5POINT1), TRUE,
+                              KSDATAFORMAT_SPECIFIER_WAVEFORMATEX, &concrete);
+
+    struct Scenario { const char* Name; const KSDATARANGE* Client; const WaveFormat* Proposed; };
+    const Scenario scenarios[] =
+    {
+        { "intersect_client_range",          &client.DataRange,   nullptr },
+        { "intersect_client_range_proposed", &client.DataRange,   &proposed },
+        { "intersect_concrete_format",       &concrete.DataFormat, nullptr },
+    };
+
+    const int iterations = 1000000;
+    for (const Scenario& s : scenarios)
+    {
+        KSDATAFORMAT_WAVEFORMATEXTENSIBLE answer;
+        ULONG sink = 0;
+        uint64_t t0 = HostTest::NowNs();
+        for (int i = 0; i < iterations; ++i)
+        {
+            WaveFormat out;
+            if (!NT_SUCCESS(FormatIntersection::Intersect(&pin.DataRange, s.Client, s.Proposed, &out))) { sink = 0; break; }
+            BOOLEAN extensible = FormatIntersection::WantsExtensible(s.Client, out);
+            FormatIntersection::Build(out, extensible, KSDATAFORMAT_SPECIFIER_WAVEFORMATEX, &answer);
+            sink += answer.DataFormat.FormatSize;
+        }
+        double ns = (double)(HostTest::NowNs() - t0) / iterations;
+
+        HostTest::Report(s.Name, ns, 0);
+        CHECK(sink != 0);
+    }
+}
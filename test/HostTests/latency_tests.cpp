@@ -0,0 +1,378 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LATENCY PROBE TESTS
+// The marker's sequence properties, the correlator on synthetic delayed signals
+// (scaled, noisy, filtered, split across any chunking), the burst schedule and
+// percentile maths, and whole measurements: an owner injecting into a simulated
+// cable and a capture reading it back a known delay later, both on DPC periods.
+// The benchmark reports the correlator's cost per captured sample.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_latency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+static const ULONG kMarker = LEYLINE_LATENCY_MARKER_FRAMES;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MARKER
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_TEST(Latency_MlsIsMaximalLength)
+{
+    std::vector<float> chips(kMarker);
+    GenerateMls(chips.data());
+
+    // 512 ones and 511 minus ones...
+    int sum = 0;
+    for (float c : chips)
+    {
+        CHECK(c == 1.0f || c == -1.0f);
+        sum += (int)c;
+    }
+    CHECK_EQ(sum, 1);
+
+    // ...and a two-valued circular autocorrelation.
+    for (ULONG lag = 0; lag < kMarker; ++lag)
+    {
+        int r = 0;
+        for (ULONG i = 0; i < kMarker; ++i) r += (int)(chips[i] * chips[(i + lag) % kMarker]);
+        CHECK_EQ(r, lag == 0 ? (int)kMarker : -1);
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DETECTOR
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// `total` samples of noise at `noise`, with the marker at `scale` added at each of
+// `at`, then through an optional FIR.
+static std::vector<float> Signal(const float* marker, ULONG total, const std::vector<ULONG>& at, float scale,
+                                 float noise, const std::vector<float>& fir, ULONG seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+
+    std::vector<float> x(total);
+    for (float& s : x) s = noise * gauss(rng);
+    for (ULONG a : at)
+        for (ULONG i = 0; i < kMarker && a + i < total; ++i) x[a + i] += scale * marker[i];
+
+    if (fir.empty()) return x;
+    std::vector<float> y(total, 0.0f);
+    for (ULONG n = 0; n < total; ++n)
+        for (ULONG k = 0; k < fir.size() && k <= n; ++k) y[n] += fir[k] * x[n - k];
+    return y;
+}
+
+// Feeds `x` in chunks of `chunk`, the first sample being frame `base`.
+static std::vector<MarkerHit> Detect(const float* marker, const std::vector<float>& x, ULONG chunk, ULONGLONG base)
+{
+    std::unique_ptr<MarkerDetector> d(new MarkerDetector());
+    d->Init(marker);
+
+    std::vector<MarkerHit> all;
+    for (ULONG i = 0; i < x.size(); i += chunk)
+    {
+        ULONG     n = (ULONG)x.size() - i < chunk ? (ULONG)x.size() - i : chunk;
+        MarkerHit hits[4];
+        ULONG     found = d->Push(x.data() + i, n, base + i, hits, 4);
+        all.insert(all.end(), hits, hits + found);
+    }
+    return all;
+}
+
+HOST_TEST(Latency_DetectorFindsDelayedMarkersExactly)
+{
+    std::vector<float> marker(kMarker);
+    GenerateMls(marker.data());
+
+    const std::vector<ULONG> at = { 1500, 7000, 7000 + 2 * kMarker + 5, 20000 };
+    const ULONG chunks[] = { 1, 7, 48, 480, 30000 };
+    for (ULONG chunk : chunks)
+    {
+        // Quiet and clean, then small and buried in noise at 0 dB SNR per sample.
+        for (int noisy = 0; noisy < 2; ++noisy)
+        {
+            std::vector<float> x = Signal(marker.data(), 30000, at, noisy ? 0.05f : 0.5f, noisy ? 0.05f : 0.0f,
+                                          {}, 17 + chunk);
+            std::vector<MarkerHit> hits = Detect(marker.data(), x, chunk, 1000000);
+            CHECK_EQ(hits.size(), at.size());
+            for (size_t i = 0; i < at.size(); ++i)
+            {
+                CHECK_EQ(hits[i].Frame, (ULONGLONG)(1000000 + at[i]));
+                CHECK(hits[i].Score > (noisy ? 0.6f : 0.999f));
+            }
+        }
+    }
+}
+
+HOST_TEST(Latency_DetectorFollowsAFilteredMarker)
+{
+    std::vector<float> marker(kMarker);
+    GenerateMls(marker.data());
+
+    // A symmetric low-pass of 9 taps: 4 frames of group delay, and a smeared peak.
+    const std::vector<float> fir = { 0.02f, 0.06f, 0.12f, 0.18f, 0.24f, 0.18f, 0.12f, 0.06f, 0.02f };
+    std::vector<float> x = Signal(marker.data(), 12000, { 3000, 8000 }, 0.5f, 0.01f, fir, 5);
+    std::vector<MarkerHit> hits = Detect(marker.data(), x, 48, 0);
+    CHECK_EQ(hits.size(), (size_t)2);
+    CHECK_EQ(hits[0].Frame, (ULONGLONG)3004);
+    CHECK_EQ(hits[1].Frame, (ULONGLONG)8004);
+}
+
+HOST_TEST(Latency_DetectorIgnoresProgramMaterial)
+{
+    std::vector<float> marker(kMarker);
+    GenerateMls(marker.data());
+
+    // Loud noise, a full-scale sine, square waves, and silence: nothing scores.
+    std::vector<float> x = Signal(marker.data(), 48000, {}, 0.0f, 0.3f, {}, 99);
+    for (ULONG i = 12000; i < 24000; ++i) x[i] = sinf(2.0f * 3.14159265f * 1000.0f * i / 48000.0f);
+    for (ULONG i = 24000; i < 36000; ++i) x[i] = ((i / 24) & 1) ? 0.8f : -0.8f;
+    for (ULONG i = 36000; i < 48000; ++i) x[i] = 0.0f;
+    CHECK_EQ(Detect(marker.data(), x, 480, 0).size(), (size_t)0);
+
+    // Nor does the marker upside down.
+    std::vector<float> inverted = Signal(marker.data(), 6000, { 1000 }, -0.5f, 0.0f, {}, 1);
+    CHECK_EQ(Detect(marker.data(), inverted, 480, 0).size(), (size_t)0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SCHEDULE AND STATS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_TEST(Latency_ScheduleCoversEachBurstOnce)
+{
+    BurstSchedule s;
+    s.Init(5000, 4800, 3);
+    CHECK_EQ(s.End(), (ULONGLONG)(5000 + 2 * 4800 + kMarker));
+
+    // Walk the run in odd-sized periods; every marker frame is visited once, in order.
+    std::vector<ULONG> chips;
+    std::vector<ULONGLONG> frames;
+    for (ULONGLONG from = 0; from < 20000; from += 37)
+    {
+        ULONGLONG to = from + 37;
+        LatencyBurst b;
+        for (ULONGLONG f = from; s.Next(f, to, &b); f = b.Frame + b.Frames)
+        {
+            CHECK(b.Frame >= f && b.Frame + b.Frames <= to);
+            for (ULONG i = 0; i < b.Frames; ++i)
+            {
+                chips.push_back(b.Chip + i);
+                frames.push_back(b.Frame + i);
+            }
+        }
+    }
+    CHECK_EQ(chips.size(), (size_t)(3 * kMarker));
+    for (size_t i = 0; i < chips.size(); ++i)
+    {
+        ULONG burst = (ULONG)(i / kMarker);
+        CHECK_EQ(chips[i], (ULONG)(i % kMarker));
+        CHECK_EQ(frames[i], s.BurstFrame(burst) + i % kMarker);
+    }
+
+    CHECK_EQ(s.Started(5000), (ULONG)0);
+    CHECK_EQ(s.Started(5001), (ULONG)1);
+    CHECK_EQ(s.Started(9801), (ULONG)2);
+    CHECK_EQ(s.Started(100000), (ULONG)3);
+}
+
+HOST_TEST(Latency_StatsPercentiles)
+{
+    std::unique_ptr<LatencyStats> stats(new LatencyStats());
+    stats->Reset();
+
+    // 200 results of 1..200 ms in shuffled order.
+    std::vector<ULONG> order(200);
+    for (ULONG i = 0; i < 200; ++i) order[i] = i + 1;
+    std::shuffle(order.begin(), order.end(), std::mt19937(3));
+    for (ULONG ms : order) CHECK(stats->Add((ULONGLONG)ms * 1000000));
+
+    LeylineLatencyReport r = {};
+    stats->Summarize(48000, &r);
+    CHECK_EQ(r.MinUs, (ULONG)1000);
+    CHECK_EQ(r.MeanUs, (ULONG)100500);
+    CHECK_EQ(r.P99Us, (ULONG)198000);
+    CHECK_EQ(r.MaxUs, (ULONG)200000);
+    CHECK_EQ(r.MinFrames, (ULONG)48);
+    CHECK_EQ(r.P99Frames, (ULONG)9504);
+    CHECK_EQ(r.MaxFrames, (ULONG)9600);
+
+    // Full: the rest are turned away.
+    for (ULONG i = 200; i < LEYLINE_LATENCY_MAX_BURSTS; ++i) CHECK(stats->Add(1));
+    CHECK(!stats->Add(1));
+    CHECK_EQ(stats->Count(), (ULONG)LEYLINE_LATENCY_MAX_BURSTS);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// WHOLE MEASUREMENTS
+// 48 kHz owner on a 10 MHz QPC. The owner marks what it played each 1 ms period
+// (which wobbles by up to `jitterUs`); the capture delivers frame c of the cable
+// `delay` frames after the owner played it, either continuously (a capture on the
+// owner's pages) or in steps at its own periods (a converting capture).
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static const LONG64 kFrequency = 10000000;
+static const ULONG  kRate      = 48000;
+
+static ULONGLONG FramesAt(LONG64 qpc) { return (ULONGLONG)qpc * kRate / kFrequency; }
+
+static LeylineLatencyReport Measure(ULONG delay, BOOLEAN continuous, ULONG jitterUs, ULONG bursts, ULONG seed)
+{
+    std::unique_ptr<LatencyProbe> probe(new LatencyProbe());
+    *probe = {};
+    probe->Init();
+    probe->Arm(bursts, 100, TRUE);
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<ULONG> wobble(0, jitterUs);
+    std::normal_distribution<float> gauss(0.0f, 0.1f);
+
+    const ULONG seconds = bursts / 10 + 2;
+    std::vector<float> cable(seconds * kRate + kRate);
+    for (float& s : cable) s = gauss(rng);          // The client's program
+
+    ULONGLONG marked = 0, captured = 0;
+    bool listening = false;
+    for (LONG64 ms = 1; ms <= seconds * 1000; ++ms)
+    {
+        // Owner period.
+        LONG64    now    = ms * 10000 + (LONG64)wobble(rng) * 10;
+        ULONGLONG played = FramesAt(now);
+        if (probe->Begin(marked, 0, kFrequency, kRate))
+        {
+            LatencyBurst b;
+            for (ULONGLONG f = marked; probe->NextBurst(f, played, &b); f = b.Frame + b.Frames)
+                for (ULONG i = 0; i < b.Frames; ++i)
+                    cable[b.Frame + i] = LEYLINE_LATENCY_MARKER_LEVEL * probe->GetMarker()[b.Chip + i];
+            probe->Advance(played);
+        }
+        marked = played;
+
+        // Capture period, a little later.
+        LONG64    then   = now + 2000 + (LONG64)wobble(rng) * 10;
+        ULONGLONG frames = FramesAt(then) > delay ? FramesAt(then) - delay : 0;
+        if (frames > marked) frames = marked;
+        if (!listening)
+        {
+            probe->StartCapture(frames, then, continuous);
+            captured  = frames;
+            listening = true;
+            continue;
+        }
+        probe->Observe(frames, then);
+
+        LONG64 seen[4];
+        ULONG  found = probe->Capture(cable.data() + captured, (ULONG)(frames - captured), captured, seen, 4);
+        for (ULONG i = 0; i < found; ++i) probe->Match(seen[i]);
+        captured = frames;
+    }
+
+    LeylineLatencyReport r;
+    probe->GetReport(&r);
+    return r;
+}
+
+HOST_TEST(Latency_MeasuresACableDelayExactly)
+{
+    // A capture running with the owner's clock sees its delay to the frame, once
+    // the delay is longer than the owner's period (shorter, and the capture is held
+    // back to what the owner has marked).
+    const ULONG delays[] = { 96, 97, 480, 3600 };
+    for (ULONG delay : delays)
+    {
+        LeylineLatencyReport r = Measure(delay, TRUE, 0, 20, delay + 1);
+        printf("    delay %u: %u/%u found, min %u mean %u p99 %u max %u frames (%u..%u us)\n", delay,
+               r.Detected, r.Bursts, r.MinFrames, r.MeanFrames, r.P99Frames, r.MaxFrames, r.MinUs, r.MaxUs);
+        CHECK_EQ(r.State, (ULONG)LatencyProbe_Done);
+        CHECK_EQ(r.Injected, (ULONG)20);
+        CHECK_EQ(r.Detected, (ULONG)20);
+        CHECK_EQ(r.SampleRate, kRate);
+        // Positions are whole frames, so an edge is placed to within one.
+        CHECK(r.MinFrames >= delay && r.MaxFrames <= delay + 1);
+        CHECK(r.MeanFrames >= delay && r.MeanFrames <= delay + 1);
+        CHECK(r.MeanUs >= delay * 1000000ULL / kRate && r.MeanUs <= (delay + 1) * 1000000ULL / kRate);
+        CHECK_EQ(r.AppliedUs, r.MeanUs);
+    }
+}
+
+HOST_TEST(Latency_MeasuresSteppedDeliveryWithinAPeriod)
+{
+    // A converting capture only hands frames over on its periods: each marker is
+    // late by up to one period on top of the delay, and the spread shows it.
+    LeylineLatencyReport r = Measure(960, FALSE, 300, 40, 11);
+    printf("    stepped: %u/%u found, min %u mean %u p99 %u max %u frames\n",
+           r.Detected, r.Bursts, r.MinFrames, r.MeanFrames, r.P99Frames, r.MaxFrames);
+    CHECK_EQ(r.Detected, (ULONG)40);
+    CHECK(r.MinFrames >= 960);
+    CHECK(r.MaxFrames <= 960 + 48 + 30);   // A period, and the wobble on both ends of it
+    CHECK(r.MinFrames <= r.MeanFrames && r.MeanFrames <= r.P99Frames && r.P99Frames <= r.MaxFrames);
+}
+
+HOST_TEST(Latency_StopAndRestart)
+{
+    std::unique_ptr<LatencyProbe> probe(new LatencyProbe());
+    *probe = {};
+    probe->Init();
+
+    LeylineLatencyReport r;
+    probe->GetReport(&r);
+    CHECK_EQ(r.State, (ULONG)LatencyProbe_Idle);
+
+    // Armed but never picked up: stopping forgets it.
+    probe->Arm(4, 100, FALSE);
+    CHECK_EQ(probe->GetState(), LatencyProbe_Armed);
+    probe->Stop(FALSE);
+    CHECK_EQ(probe->GetState(), LatencyProbe_Idle);
+
+    // A new owner run ends the one the schedule was placed in.
+    probe->Arm(4, 100, FALSE);
+    CHECK(probe->Begin(0, 1000, kFrequency, kRate));
+    CHECK(probe->Begin(480, 1000, kFrequency, kRate));
+    CHECK(!probe->Begin(0, 2000, kFrequency, kRate));
+    CHECK_EQ(probe->GetState(), LatencyProbe_Done);
+
+    // A stray marker with no burst behind it is not a result.
+    CHECK(!probe->Match(1000 + kFrequency));
+    probe->GetReport(&r);
+    CHECK_EQ(r.Detected, (ULONG)0);
+    CHECK_EQ(r.AppliedUs, (ULONG)0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARK
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_BENCH(Latency_CorrelatorCost)
+{
+    std::vector<float> marker(kMarker);
+    GenerateMls(marker.data());
+    std::vector<float> x = Signal(marker.data(), 48000, {}, 0.0f, 0.1f, {}, 8);
+
+    std::unique_ptr<MarkerDetector> d(new MarkerDetector());
+    d->Init(marker.data());
+
+    const int seconds = 4;
+    ULONG     found   = 0;
+    uint64_t  t0      = HostTest::NowNs();
+    for (int s = 0; s < seconds; ++s)
+    {
+        for (ULONG i = 0; i < 48000; i += 48)
+        {
+            MarkerHit hits[4];
+            found += d->Push(x.data() + i, 48, (ULONGLONG)s * 48000 + i, hits, 4);
+        }
+    }
+    double ns = (double)(HostTest::NowNs() - t0) / (seconds * 48000.0);
+    HostTest::Report("latency_correlate_per_sample", ns, 4.0 * 1e9 / ns);
+    CHECK_EQ(found, (ULONG)0);
+}
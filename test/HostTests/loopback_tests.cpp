@@ -0,0 +1,278 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LOOPBACK CABLE TESTS
+// Simulates a render and a capture CMiniportWaveRTStream mapped onto the same pages,
+// with a fake QPC, and checks what a capture client actually reads back.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_loopback.h"
+#include "leyline_wavertmath.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+
+static const LONG64 kQpcFrequency = 10000000;   // 10 MHz, as on current Windows
+static const ULONG  kSampleRate   = 48000;
+static const ULONG  kBlockAlign   = 4;          // 16-bit stereo
+static const ULONG  kByteRate     = kSampleRate * kBlockAlign;
+
+// The parts of CMiniportWaveRTStream that matter on the cable: UseSharedBuffer,
+// SetState and GetPosition, reduced to plain members.
+struct SimStream
+{
+    LoopbackCable* Cable;
+    BOOLEAN        IsCapture;
+    PUCHAR         Mapping;
+    ULONG          BufferSize;
+    LONG64         StartTime;
+    WaveRTMath::StreamClock Clock;
+
+    SimStream(LoopbackCable* cable, BOOLEAN capture, PUCHAR pages, ULONG pagesSize)
+        : Cable(cable), IsCapture(capture), Mapping(pages)
+        , BufferSize(pagesSize - pagesSize % kBlockAlign), StartTime(0) {}
+
+    void Run(LONG64 now)
+    {
+        StartTime = now;
+        Clock.Start(now, kQpcFrequency, kSampleRate, kBlockAlign, BufferSize);
+        if (!IsCapture)
+        {
+            LoopbackSourceClock clock = { now, kQpcFrequency, kByteRate, kBlockAlign, BufferSize, SampleFormat_Pcm16, 2 };
+            Cable->SetProcessedFrames(LEYLINE_CABLE_ALL_FRAMES);
+            Cable->PublishSource(clock);
+        }
+    }
+
+    void Stop()
+    {
+        StartTime = 0;
+        if (!IsCapture)
+        {
+            Cable->RetractSource();
+            RtlZeroMemory(Mapping, BufferSize);
+        }
+    }
+
+    ULONG GetPosition(LONG64 now) const
+    {
+        ULONGLONG frames = Clock.FramesAt(now);
+        LoopbackSourceClock source;
+        if (IsCapture && Cable->GetSource(&source) && source.BlockAlign == kBlockAlign && source.ByteRate == kByteRate)
+            frames = LoopbackCable::CaptureFrames(Clock.FramesBetween(source.StartQpc, now), Cable->GetLatencyFrames(),
+                                                  Cable->GetProcessedFrames());
+        return Clock.BufferOffset(frames);
+    }
+};
+
+// One frame = one 32-bit word holding the frame's index (+1, so silence is distinct).
+static void RenderFrames(const SimStream& render, ULONGLONG firstFrame, ULONGLONG count)
+{
+    ULONG frames = render.BufferSize / kBlockAlign;
+    ULONG* words = reinterpret_cast<ULONG*>(render.Mapping);
+    for (ULONGLONG f = firstFrame; f < firstFrame + count; ++f)
+        words[f % frames] = (ULONG)(f + 1);
+}
+
+HOST_TEST(Loopback_CaptureReceivesEveryRenderedFrameAtConfiguredLatency)
+{
+    static UCHAR pages[128 * 1024];
+    RtlZeroMemory(pages, sizeof(pages));
+
+    const ULONG latencyFrames = 240;
+    LoopbackCable cable = {};
+    cable.Configure(TRUE, latencyFrames);
+
+    SimStream render(&cable, FALSE, pages, sizeof(pages));
+    SimStream capture(&cable, TRUE, pages, sizeof(pages));
+    CHECK(render.Mapping == capture.Mapping);
+
+    const ULONG frames    = render.BufferSize / kBlockAlign;
+    const ULONG leadFrames = 960;                   // Render client stays 20 ms ahead
+
+    LONG64 now = 1234567;
+    RenderFrames(render, 0, leadFrames);
+    render.Run(now);
+    capture.Run(now + 3333);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<LONG64> step(2000, 40000);   // 0.2 .. 4 ms, jittered
+
+    ULONGLONG rendered = leadFrames, captured = 0;
+    ULONG lastRender = 0, lastCapture = 0;
+    ULONGLONG playBytes = 0;
+    int mismatches = 0;
+
+    for (int i = 0; i < 200000; ++i)
+    {
+        now += step(rng);
+
+        // Render client: advance by the play-cursor delta, then refill up to the lead.
+        ULONG renderPos = render.GetPosition(now);
+        playBytes += (renderPos + render.BufferSize - lastRender) % render.BufferSize;
+        lastRender = renderPos;
+        ULONGLONG playFrames = playBytes / kBlockAlign;
+        if (playFrames + leadFrames > rendered)
+        {
+            RenderFrames(render, rendered, playFrames + leadFrames - rendered);
+            rendered = playFrames + leadFrames;
+        }
+
+        // Capture client: consume everything between its last and current position
+        // straight out of the shared pages.
+        ULONG capturePos = capture.GetPosition(now);
+        ULONG available  = (capturePos + capture.BufferSize - lastCapture) % capture.BufferSize;
+        const ULONG* words = reinterpret_cast<const ULONG*>(capture.Mapping);
+        for (ULONG b = 0; b < available; b += kBlockAlign, ++captured)
+        {
+            ULONG got = words[(lastCapture / kBlockAlign + b / kBlockAlign) % frames];
+            if (got != (ULONG)(captured + 1)) ++mismatches;
+        }
+        lastCapture = capturePos;
+
+        // End-to-end latency is exact at every observation once the cable has filled.
+        if (playFrames > latencyFrames)
+            CHECK_EQ(playFrames - captured, (ULONGLONG)latencyFrames);
+        else
+            CHECK_EQ(captured, (ULONGLONG)0);
+    }
+
+    CHECK_EQ(mismatches, 0);
+    CHECK(captured > 48000ull * 60);                // Well over a minute of audio
+}
+
+HOST_TEST(Loopback_LatencyChangeAppliesOnNextPosition)
+{
+    static UCHAR pages[65536];
+    LoopbackCable cable = {};
+    cable.Configure(TRUE, 480);
+
+    SimStream render(&cable, FALSE, pages, sizeof(pages));
+    SimStream capture(&cable, TRUE, pages, sizeof(pages));
+    render.Run(1000);
+    capture.Run(1000);
+
+    // One second in: 48000 frames played, wrapped into a 16384-frame buffer.
+    LONG64 oneSecond = 1000 + kQpcFrequency;
+    CHECK_EQ(render.GetPosition(oneSecond), (ULONG)((48000 % 16384) * kBlockAlign));
+    CHECK_EQ(capture.GetPosition(oneSecond), (ULONG)(((48000 - 480) % 16384) * kBlockAlign));
+
+    cable.Configure(TRUE, 64);
+    CHECK_EQ(capture.GetPosition(oneSecond), (ULONG)(((48000 - 64) % 16384) * kBlockAlign));
+
+    CHECK_EQ(LoopbackCable::CaptureFrames(100, 480, LEYLINE_CABLE_ALL_FRAMES), (ULONGLONG)0);
+}
+
+// An owner that processes its pages in place holds captures at the last frame it
+// has finished, however short the latency.
+HOST_TEST(Loopback_CaptureStopsAtTheOwnersProcessedFrames)
+{
+    static UCHAR renderPages[16384 * kBlockAlign];
+    LoopbackCable cable = {};
+    cable.Configure(TRUE, 0);
+
+    SimStream render(&cable, FALSE, renderPages, sizeof(renderPages));
+    SimStream capture(&cable, TRUE, renderPages, sizeof(renderPages));
+    render.Run(1000);
+    capture.Run(1000);
+    cable.SetProcessedFrames(0);
+
+    LONG64 tenMs = 1000 + kQpcFrequency / 100;
+    CHECK_EQ(capture.GetPosition(tenMs), (ULONG)0);
+
+    cable.SetProcessedFrames(240);
+    CHECK_EQ(capture.GetPosition(tenMs), (ULONG)(240 * kBlockAlign));
+
+    // Processed past the latency-held position: the latency governs again.
+    cable.SetProcessedFrames(480);
+    cable.Configure(TRUE, 64);
+    CHECK_EQ(capture.GetPosition(tenMs), (ULONG)((480 - 64) * kBlockAlign));
+
+    CHECK_EQ(LoopbackCable::CaptureFrames(1000, 0, 600), (ULONGLONG)600);
+    CHECK_EQ(LoopbackCable::CaptureFrames(1000, 480, 600), (ULONGLONG)520);
+}
+
+HOST_TEST(Loopback_StoppedSourceLeavesSilenceAndNoClock)
+{
+    static UCHAR pages[4096];
+    LoopbackCable cable = {};
+    cable.Configure(TRUE, 0);
+
+    SimStream render(&cable, FALSE, pages, sizeof(pages));
+    RenderFrames(render, 0, render.BufferSize / kBlockAlign);
+    render.Run(500);
+
+    LoopbackSourceClock source;
+    CHECK(cable.GetSource(&source));
+    CHECK_EQ(source.StartQpc, 500);
+
+    render.Stop();
+    CHECK(!cable.GetSource(&source));
+    for (ULONG i = 0; i < render.BufferSize; ++i)
+        if (pages[i] != 0) { CHECK_EQ(pages[i], 0); break; }
+}
+
+// A reader spinning on GetSource against a publisher that keeps republishing must
+// only ever see field sets that were published together.
+HOST_TEST(Loopback_SourceSnapshotIsNeverTorn)
+{
+    LoopbackCable cable = {};
+    cable.Configure(TRUE, 0);
+    std::atomic<bool> done(false);
+    std::atomic<int>  torn(0), seen(0);
+
+    std::thread reader([&] {
+        while (!done.load())
+        {
+            LoopbackSourceClock c;
+            if (!cable.GetSource(&c)) continue;
+            // Every published set is { n, n * 10, n * 4, 4, n * 8 } for some n.
+            LONG64 n = c.StartQpc;
+            if (c.Frequency != n * 10 || c.ByteRate != (ULONG)(n * 4) || c.BufferSize != (ULONG)(n * 8))
+                torn++;
+            seen++;
+        }
+    });
+
+    for (LONG64 n = 1; n < 2000000; ++n)
+    {
+        LoopbackSourceClock c = { n, n * 10, (ULONG)(n * 4), kBlockAlign, (ULONG)(n * 8), SampleFormat_Pcm16, 2 };
+        cable.PublishSource(c);
+    }
+    done = true;
+    reader.join();
+
+    CHECK_EQ(torn.load(), 0);
+    CHECK(seen.load() > 0);
+}
+
+// A capture stream decides at allocation time whether it can share the pages, so
+// the owner's format must be readable before the owner runs, and go away with it.
+HOST_TEST(Loopback_OwnerFormatIsKnownBeforeRun)
+{
+    LoopbackCable cable = {};
+    cable.Configure(TRUE, 0);
+
+    LeylineSampleFormat format;
+    ULONG channels, rate;
+    CHECK(!cable.GetOwnerFormat(&format, &channels, &rate));
+
+    cable.SetOwnerFormat(SampleFormat_Float32, 8, 192000);
+    CHECK(cable.GetOwnerFormat(&format, &channels, &rate));
+    CHECK_EQ(format, SampleFormat_Float32);
+    CHECK_EQ(channels, (ULONG)8);
+    CHECK_EQ(rate, (ULONG)192000);
+
+    LoopbackSourceClock clock = { 100, kQpcFrequency, 192000 * 32, 32, 32 * 480, SampleFormat_Float32, 8 };
+    cable.PublishSource(clock);
+    LoopbackSourceClock seen;
+    CHECK(cable.GetSource(&seen));
+    CHECK_EQ(seen.SampleFormat, (ULONG)SampleFormat_Float32);
+    CHECK_EQ(seen.Channels, (ULONG)8);
+
+    cable.ClearOwnerFormat();
+    CHECK(!cable.GetOwnerFormat(&format, &channels, &rate));
+}
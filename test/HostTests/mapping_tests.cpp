@@ -0,0 +1,224 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// USER MAPPING TESTS
+// The per-handle mapping table over a host MappingSource that hands out fake
+// user addresses and checks every unmap against what it mapped: repeat calls,
+// one entry per key, pages replaced under a key, a full table, a failed map,
+// callers other than the owner, and the release the driver does at cleanup.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_mapping.h"
+
+#include <map>
+
+// A pretend address space: each map gets a fresh page-aligned address. Unmaps of
+// an address that is not mapped, or with other pages than it was mapped from,
+// are counted as Bad. Fails once `Budget` maps have been made (unlimited when
+// negative).
+class HostMappingSource : public MappingSource
+{
+public:
+    NTSTATUS Map(PVOID pages, PVOID* address) override
+    {
+        if (Budget >= 0 && Maps >= Budget) return STATUS_INSUFFICIENT_RESOURCES;
+        m_Next += 0x10000;
+        *address = reinterpret_cast<PVOID>(m_Next);
+        m_Live[*address] = pages;
+        ++Maps;
+        return STATUS_SUCCESS;
+    }
+
+    void Unmap(PVOID pages, PVOID address) override
+    {
+        auto live = m_Live.find(address);
+        if (live == m_Live.end() || live->second != pages) { ++Bad; return; }
+        m_Live.erase(live);
+        ++Unmaps;
+    }
+
+    int Live() const { return (int)m_Live.size(); }
+
+    int Maps   = 0;
+    int Unmaps = 0;
+    int Bad    = 0;
+    int Budget = -1;
+
+private:
+    ULONG_PTR              m_Next = 0x7FF000000000;
+    std::map<PVOID, PVOID> m_Live;
+};
+
+static int  s_Process[2];
+static char s_Pages[LEYLINE_MAX_USER_MAPPINGS + 2];
+
+static PVOID Owner()        { return &s_Process[0]; }
+static PVOID Stranger()     { return &s_Process[1]; }
+static PVOID Pages(ULONG n) { return &s_Pages[n]; }
+
+HOST_TEST(Mapping_RepeatCallsReturnTheSameAddress)
+{
+    HostMappingSource source;
+    UserMappings mappings;
+    mappings.Init(Owner());
+
+    PVOID first = nullptr, again = nullptr;
+    CHECK_EQ(mappings.Map(&source, Owner(), 0, Pages(0), &first), STATUS_SUCCESS);
+    for (int i = 0; i < 100; ++i)
+    {
+        CHECK_EQ(mappings.Map(&source, Owner(), 0, Pages(0), &again), STATUS_SUCCESS);
+        CHECK_EQ(again, first);
+    }
+    CHECK_EQ(source.Maps, 1);
+    CHECK_EQ(source.Live(), 1);
+    CHECK_EQ(mappings.GetCount(), (ULONG)1);
+
+    CHECK_EQ(mappings.Release(&source), (ULONG)1);
+    CHECK_EQ(source.Live(), 0);
+    CHECK_EQ(source.Bad, 0);
+}
+
+HOST_TEST(Mapping_ParamsAndCablesAreSeparateEntries)
+{
+    HostMappingSource source;
+    UserMappings mappings;
+    mappings.Init(Owner());
+
+    PVOID params = nullptr, cable0 = nullptr, cable1 = nullptr, again = nullptr;
+    CHECK_EQ(mappings.Map(&source, Owner(), LEYLINE_MAPPING_PARAMS, Pages(0), &params), STATUS_SUCCESS);
+    CHECK_EQ(mappings.Map(&source, Owner(), 0, Pages(1), &cable0), STATUS_SUCCESS);
+    CHECK_EQ(mappings.Map(&source, Owner(), 1, Pages(2), &cable1), STATUS_SUCCESS);
+    CHECK(params != cable0 && cable0 != cable1 && params != cable1);
+    CHECK_EQ(mappings.GetCount(), (ULONG)3);
+
+    CHECK_EQ(mappings.Map(&source, Owner(), 0, Pages(1), &again), STATUS_SUCCESS);
+    CHECK_EQ(again, cable0);
+    CHECK_EQ(mappings.Map(&source, Owner(), LEYLINE_MAPPING_PARAMS, Pages(0), &again), STATUS_SUCCESS);
+    CHECK_EQ(again, params);
+    CHECK_EQ(source.Maps, 3);
+
+    CHECK_EQ(mappings.Release(&source), (ULONG)3);
+    CHECK_EQ(source.Live(), 0);
+    CHECK_EQ(source.Bad, 0);
+}
+
+HOST_TEST(Mapping_NewPagesUnderAKeyReplaceTheOldMapping)
+{
+    HostMappingSource source;
+    UserMappings mappings;
+    mappings.Init(Owner());
+
+    PVOID other = nullptr, before = nullptr, after = nullptr, again = nullptr;
+    CHECK_EQ(mappings.Map(&source, Owner(), 1, Pages(1), &other), STATUS_SUCCESS);
+    CHECK_EQ(mappings.Map(&source, Owner(), 0, Pages(0), &before), STATUS_SUCCESS);
+    CHECK_EQ(mappings.Map(&source, Owner(), 0, Pages(2), &after), STATUS_SUCCESS);
+    CHECK(after != before);
+    CHECK_EQ(source.Unmaps, 1);
+    CHECK_EQ(source.Live(), 2);
+    CHECK_EQ(mappings.GetCount(), (ULONG)2);
+
+    // The entry that was moved to fill the gap is still found.
+    CHECK_EQ(mappings.Map(&source, Owner(), 1, Pages(1), &again), STATUS_SUCCESS);
+    CHECK_EQ(again, other);
+    CHECK_EQ(source.Maps, 3);
+
+    mappings.Release(&source);
+    CHECK_EQ(source.Live(), 0);
+    CHECK_EQ(source.Bad, 0);
+}
+
+HOST_TEST(Mapping_FullTableMapsNothingMore)
+{
+    HostMappingSource source;
+    UserMappings mappings;
+    mappings.Init(Owner());
+
+    PVOID address = nullptr;
+    for (ULONG k = 0; k < LEYLINE_MAX_USER_MAPPINGS; ++k)
+        CHECK_EQ(mappings.Map(&source, Owner(), k, Pages(k), &address), STATUS_SUCCESS);
+    CHECK_EQ(mappings.Map(&source, Owner(), LEYLINE_MAX_USER_MAPPINGS, Pages(LEYLINE_MAX_USER_MAPPINGS), &address),
+             STATUS_INSUFFICIENT_RESOURCES);
+    CHECK_EQ(source.Maps, (int)LEYLINE_MAX_USER_MAPPINGS);
+
+    // What is already there is still served.
+    CHECK_EQ(mappings.Map(&source, Owner(), 3, Pages(3), &address), STATUS_SUCCESS);
+    CHECK_EQ(source.Maps, (int)LEYLINE_MAX_USER_MAPPINGS);
+
+    CHECK_EQ(mappings.Release(&source), (ULONG)LEYLINE_MAX_USER_MAPPINGS);
+    CHECK_EQ(source.Live(), 0);
+    CHECK_EQ(source.Bad, 0);
+}
+
+HOST_TEST(Mapping_FailedMapLeavesNoEntry)
+{
+    HostMappingSource source;
+    source.Budget = 1;
+    UserMappings mappings;
+    mappings.Init(Owner());
+
+    PVOID address = nullptr, kept = nullptr;
+    CHECK_EQ(mappings.Map(&source, Owner(), 0, Pages(0), &kept), STATUS_SUCCESS);
+    address = reinterpret_cast<PVOID>(1);
+    CHECK_EQ(mappings.Map(&source, Owner(), 1, Pages(1), &address), STATUS_INSUFFICIENT_RESOURCES);
+    CHECK_EQ(address, reinterpret_cast<PVOID>(1));
+    CHECK_EQ(mappings.GetCount(), (ULONG)1);
+
+    source.Budget = -1;
+    CHECK_EQ(mappings.Map(&source, Owner(), 1, Pages(1), &address), STATUS_SUCCESS);
+    CHECK(address != kept);
+    CHECK_EQ(mappings.GetCount(), (ULONG)2);
+
+    mappings.Release(&source);
+    CHECK_EQ(source.Live(), 0);
+    CHECK_EQ(source.Bad, 0);
+}
+
+HOST_TEST(Mapping_OnlyTheOwnerMaps)
+{
+    HostMappingSource source;
+    UserMappings mappings;
+    mappings.Init(Owner());
+
+    PVOID address = nullptr;
+    CHECK_EQ(mappings.Map(&source, Stranger(), 0, Pages(0), &address), STATUS_ACCESS_DENIED);
+    CHECK_EQ(source.Maps, 0);
+
+    // Not even what the owner already mapped.
+    CHECK_EQ(mappings.Map(&source, Owner(), 0, Pages(0), &address), STATUS_SUCCESS);
+    address = nullptr;
+    CHECK_EQ(mappings.Map(&source, Stranger(), 0, Pages(0), &address), STATUS_ACCESS_DENIED);
+    CHECK_EQ(address, (PVOID)nullptr);
+    CHECK_EQ(mappings.Owner(), Owner());
+
+    mappings.Release(&source);
+    CHECK_EQ(source.Live(), 0);
+}
+
+HOST_TEST(Mapping_ReleaseUnmapsEverythingOnce)
+{
+    HostMappingSource source;
+    UserMappings mappings;
+    mappings.Init(Owner());
+
+    PVOID address = nullptr;
+    CHECK_EQ(mappings.Map(&source, Owner(), LEYLINE_MAPPING_PARAMS, Pages(0), &address), STATUS_SUCCESS);
+    for (ULONG k = 0; k < 4; ++k)
+        CHECK_EQ(mappings.Map(&source, Owner(), k, Pages(k + 1), &address), STATUS_SUCCESS);
+    CHECK_EQ(source.Live(), 5);
+
+    // Cleanup, then close: the second release finds nothing left.
+    CHECK_EQ(mappings.Release(&source), (ULONG)5);
+    CHECK_EQ(mappings.Release(&source), (ULONG)0);
+    CHECK_EQ(source.Unmaps, 5);
+    CHECK_EQ(source.Live(), 0);
+    CHECK_EQ(source.Bad, 0);
+    CHECK_EQ(mappings.GetCount(), (ULONG)0);
+
+    // The handle is still usable until it closes.
+    CHECK_EQ(mappings.Map(&source, Owner(), 0, Pages(1), &address), STATUS_SUCCESS);
+    CHECK_EQ(source.Maps, 6);
+    mappings.Release(&source);
+    CHECK_EQ(source.Live(), 0);
+}
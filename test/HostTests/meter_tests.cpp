@@ -0,0 +1,315 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// METER TESTS
+// Levels of known signals, the ballistics, clip counting, the SIMD reductions
+// against scalar, and a reader hammering the published block while it is being
+// rewritten. The benchmark reports the cost of a timer period's metering.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_meter.h"
+
+#include <atomic>
+#include <math.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+static const ULONG kRate = 48000;
+
+static std::vector<float> Sine(double hz, ULONG frames, ULONG channels, const double* amplitude)
+{
+    std::vector<float> v((size_t)frames * channels);
+    for (ULONG i = 0; i < frames; ++i)
+        for (ULONG ch = 0; ch < channels; ++ch)
+            v[(size_t)i * channels + ch] = (float)(amplitude[ch] * sin(2.0 * M_PI * hz * i / kRate));
+    return v;
+}
+
+// Feeds `frames` through the meter one timer period at a time, like the DPC.
+static void Play(PeakMeter& meter, const float* samples, ULONG frames, ULONG period)
+{
+    for (ULONG pos = 0; pos < frames; pos += period)
+    {
+        ULONG n = frames - pos < period ? frames - pos : period;
+        meter.Accumulate(samples + (size_t)pos * meter.GetChannels(), n);
+        meter.EndPeriod();
+    }
+}
+
+static bool Near(double a, double b, double tolerance) { return fabs(a - b) <= tolerance; }
+
+HOST_TEST(Meter_ReadsPeakAndRmsOfSines)
+{
+    const double amplitude[] = { 0.5, 0.25 };
+    std::vector<float> in = Sine(1000, kRate, 2, amplitude);      // 48 frames = one cycle
+
+    PeakMeter meter;
+    CHECK_EQ(meter.Init(SampleFormat_Float32, 2, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+    meter.SetBallistics(LEYLINE_METER_DEFAULT_DECAY_DB, 0);
+    Play(meter, in.data(), kRate, 48);
+
+    MeterReading r;
+    meter.Read(&r);
+    CHECK_EQ(r.Channels, (ULONG)2);
+    CHECK(Near(r.Peak[0], 0.5, 1e-6));
+    CHECK(Near(r.Peak[1], 0.25, 1e-6));
+    CHECK(Near(r.Rms[0], 0.5 / sqrt(2.0), 1e-5));
+    CHECK(Near(r.Rms[1], 0.25 / sqrt(2.0), 1e-5));
+    CHECK_EQ(r.Clips[0] + r.Clips[1], (ULONG)0);
+    CHECK_EQ(r.Peak[2], 0.0f);
+}
+
+HOST_TEST(Meter_PeakFallsAtConfiguredRate)
+{
+    const ULONG channels = 1;
+    std::vector<float> burst(480, 0.8f), silence(kRate, 0.0f);
+
+    for (ULONG period : { 48u, 480u })
+    {
+        PeakMeter meter;
+        CHECK_EQ(meter.Init(SampleFormat_Float32, channels, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+        meter.SetBallistics(20, LEYLINE_METER_DEFAULT_RMS_MS);
+        Play(meter, burst.data(), 480, period);
+        Play(meter, silence.data(), kRate, period);
+
+        MeterReading r;
+        meter.Read(&r);
+        CHECK(Near(r.Peak[0], 0.08, 0.08 * 1e-4));                  // 20 dB down after 1 s
+    }
+
+    // No hold: a silent period reads silence.
+    PeakMeter meter;
+    CHECK_EQ(meter.Init(SampleFormat_Float32, channels, kRate, SimdLevel_Scalar), STATUS_SUCCESS);
+    meter.SetBallistics(0, 0);
+    Play(meter, burst.data(), 480, 480);
+    Play(meter, silence.data(), 48, 48);
+    MeterReading r;
+    meter.Read(&r);
+    CHECK_EQ(r.Peak[0], 0.0f);
+    CHECK_EQ(r.Rms[0], 0.0f);
+}
+
+// A step to DC 0.5: after one time constant the mean square is 0.25 * (1 - 1/e),
+// whatever the period length.
+HOST_TEST(Meter_RmsFollowsTimeConstant)
+{
+    std::vector<float> step((size_t)kRate * 3 / 10, 0.5f);         // 300 ms
+    const double expected = sqrt(0.25 * (1.0 - exp(-1.0)));
+
+    for (ULONG period : { 48u, 441u, 480u })
+    {
+        PeakMeter meter;
+        CHECK_EQ(meter.Init(SampleFormat_Float32, 1, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+        meter.SetBallistics(LEYLINE_METER_DEFAULT_DECAY_DB, 300);
+        Play(meter, step.data(), (ULONG)step.size(), period);
+
+        MeterReading r;
+        meter.Read(&r);
+        CHECK(Near(r.Rms[0], expected, 1e-5));
+    }
+}
+
+HOST_TEST(Meter_CountsClipsPerChannel)
+{
+    const float frames[] = { 1.0f, 0.5f,  -1.5f, 0.99f,  0.0f, INFINITY,  -1.0f, NAN };
+    PeakMeter meter;
+    CHECK_EQ(meter.Init(SampleFormat_Float32, 2, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+    meter.Accumulate(frames, 4);
+    meter.Accumulate(frames, 4);
+    meter.EndPeriod();
+
+    MeterReading r;
+    meter.Read(&r);
+    CHECK_EQ(r.Clips[0], (ULONG)6);
+    CHECK_EQ(r.Clips[1], (ULONG)2);
+    CHECK_EQ(r.Peak[0], 1.5f);
+    CHECK(isinf(r.Peak[1]));
+    CHECK_EQ(r.Rms[1], 0.0f);                                       // NaN does not stick
+
+    // Full-scale 16-bit clips in both directions.
+    const SHORT pcm[] = { 32767, -32768, 32766, 0 };
+    PeakMeter meter16;
+    CHECK_EQ(meter16.Init(SampleFormat_Pcm16, 1, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+    meter16.Accumulate(pcm, 4);
+    meter16.EndPeriod();
+    meter16.Read(&r);
+    CHECK_EQ(r.Clips[0], (ULONG)2);
+    CHECK_EQ(r.Peak[0], 1.0f);
+
+    meter16.Reset();
+    meter16.Read(&r);
+    CHECK_EQ(r.Clips[0], (ULONG)0);
+    CHECK_EQ(r.Peak[0], 0.0f);
+}
+
+HOST_TEST(Meter_DecodesIntegerFormats)
+{
+    std::mt19937 rng(3);
+    std::vector<SHORT> pcm((size_t)1000 * 6);
+    std::vector<float> f(pcm.size());
+    for (size_t i = 0; i < pcm.size(); ++i)
+    {
+        pcm[i] = (SHORT)rng();
+        f[i]   = (float)pcm[i] / 32768.0f;
+    }
+
+    PeakMeter a, b;
+    CHECK_EQ(a.Init(SampleFormat_Pcm16, 6, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+    CHECK_EQ(b.Init(SampleFormat_Float32, 6, kRate, DetectSimdLevel()), STATUS_SUCCESS);
+    a.Accumulate(pcm.data(), 1000);
+    b.Accumulate(f.data(), 1000);
+    a.EndPeriod();
+    b.EndPeriod();
+
+    MeterReading ra, rb;
+    a.Read(&ra);
+    b.Read(&rb);
+    for (ULONG ch = 0; ch < 6; ++ch)
+    {
+        CHECK_EQ(ra.Peak[ch], rb.Peak[ch]);
+        CHECK_EQ(ra.Rms[ch], rb.Rms[ch]);
+        CHECK_EQ(ra.Clips[ch], rb.Clips[ch]);
+    }
+
+    PeakMeter bad;
+    CHECK_EQ(bad.Init(SampleFormat_Unknown, 2, kRate, SimdLevel_Scalar), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(bad.Init(SampleFormat_Pcm16, 9, kRate, SimdLevel_Scalar), STATUS_INVALID_PARAMETER);
+}
+
+// Every channel count, and frame counts that leave every possible tail.
+HOST_TEST(Meter_SimdMatchesScalar)
+{
+    static const float special[] = { NAN, INFINITY, -INFINITY, 1.0f, -1.0f, LEYLINE_METER_CLIP_LEVEL, 0.0f, -0.0f };
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-1.2f, 1.2f);
+
+    for (ULONG channels = 1; channels <= LEYLINE_METER_MAX_CHANNELS; ++channels)
+    for (ULONG frames = 1; frames <= 80; frames += 3)
+    {
+        std::vector<float> in((size_t)frames * channels);
+        for (float& v : in) v = (rng() % 9 == 0) ? special[rng() % 8] : dist(rng);
+
+        PeakMeter reference;
+        CHECK_EQ(reference.Init(SampleFormat_Float32, channels, kRate, SimdLevel_Scalar), STATUS_SUCCESS);
+        reference.SetBallistics(0, 0);
+        reference.Accumulate(in.data(), frames);
+        reference.EndPeriod();
+        MeterReading expected;
+        reference.Read(&expected);
+
+        for (SimdLevel level : { SimdLevel_Sse2, DetectSimdLevel() })
+        {
+            PeakMeter meter;
+            CHECK_EQ(meter.Init(SampleFormat_Float32, channels, kRate, level), STATUS_SUCCESS);
+            meter.SetBallistics(0, 0);
+            meter.Accumulate(in.data(), frames);
+            meter.EndPeriod();
+            MeterReading got;
+            meter.Read(&got);
+
+            for (ULONG ch = 0; ch < channels; ++ch)
+            {
+                CHECK(got.Peak[ch] == expected.Peak[ch] || (isinf(got.Peak[ch]) && isinf(expected.Peak[ch])));
+                CHECK_EQ(got.Clips[ch], expected.Clips[ch]);
+                CHECK(Near(got.Rms[ch], expected.Rms[ch], 1e-5 * (1.0 + expected.Rms[ch])));   // Summation order only
+            }
+        }
+    }
+}
+
+// The writer publishes readings whose every field derives from one counter; a
+// reader that ever sees two counters mixed has seen a torn update.
+HOST_TEST(Meter_SnapshotNeverTears)
+{
+    LeylineMeterBlock block = {};
+    std::atomic<bool> done(false);
+    std::atomic<ULONG> torn(0), reads(0);
+
+    std::thread reader([&] {
+        ULONG last = 0;
+        while (!done.load(std::memory_order_relaxed))
+        {
+            MeterReading r;
+            PeakMeter::Snapshot(&block, &r);
+            ULONG n = r.Clips[0];
+            if (n == 0) continue;       // Nothing published yet: the zeroed block
+            bool ok = n >= last && r.Channels == (n % LEYLINE_METER_MAX_CHANNELS) + 1;
+            for (ULONG ch = 0; ch < LEYLINE_METER_MAX_CHANNELS; ++ch)
+                ok = ok && r.Clips[ch] == n + ch && r.Peak[ch] == (float)(n + ch) && r.Rms[ch] == (float)n;
+            if (!ok) torn.fetch_add(1);
+            last = n;
+            reads.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    for (ULONG n = 1; n <= 2000000; ++n)
+    {
+        MeterReading r;
+        r.Channels = (n % LEYLINE_METER_MAX_CHANNELS) + 1;
+        for (ULONG ch = 0; ch < LEYLINE_METER_MAX_CHANNELS; ++ch)
+        {
+            r.Peak[ch]  = (float)(n + ch);
+            r.Rms[ch]   = (float)n;
+            r.Clips[ch] = n + ch;
+        }
+        PeakMeter::Publish(&block, r);
+    }
+    done = true;
+    reader.join();
+
+    printf("    %u snapshots, %u torn\n", reads.load(), torn.load());
+    CHECK_EQ(torn.load(), (ULONG)0);
+    CHECK_EQ(block.Sequence & 1, (ULONG)0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARKS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Everything one stream's DPC does per period: meter the frames played, apply the
+// ballistics, publish. Reported as the share of one core eight 48 kHz stereo
+// streams would take, which has to stay under 1%.
+HOST_BENCH(Meter_CostPerPeriod)
+{
+    const ULONG channels = 2, streams = 8;
+    const double amplitude[] = { 0.5, 0.7 };
+    std::vector<float> f = Sine(997, 480, channels, amplitude);
+    std::vector<SHORT> pcm(f.size());
+    for (size_t i = 0; i < f.size(); ++i) pcm[i] = (SHORT)(f[i] * 32767.0f);
+
+    for (ULONG periodMs : { 1u, 10u })
+    for (LeylineSampleFormat format : { SampleFormat_Pcm16, SampleFormat_Float32 })
+    for (SimdLevel level : { SimdLevel_Scalar, SimdLevel_Sse2, DetectSimdLevel() })
+    {
+        const ULONG frames = kRate / 1000 * periodMs;
+        const void* in     = format == SampleFormat_Float32 ? (const void*)f.data() : (const void*)pcm.data();
+
+        PeakMeter meter;
+        meter.Init(format, channels, kRate, level);
+        LeylineMeterBlock block = {};
+
+        const int iterations = 200000 / periodMs;
+        uint64_t t0 = HostTest::NowNs();
+        for (int i = 0; i < iterations; ++i)
+        {
+            meter.Accumulate(in, frames);
+            meter.EndPeriod();
+            MeterReading r;
+            meter.Read(&r);
+            PeakMeter::Publish(&block, r);
+        }
+        double ns   = (double)(HostTest::NowNs() - t0) / iterations;
+        double core = 100.0 * streams * ns / (periodMs * 1e6);
+
+        char name[64];
+        snprintf(name, sizeof(name), "meter_%ums_%s_%s_per_period", periodMs,
+                 format == SampleFormat_Float32 ? "f32" : "pcm16",
+                 level == SimdLevel_Avx2 ? "avx2" : level == SimdLevel_Sse2 ? "sse2" : "scalar");
+        HostTest::Report(name, ns, 0);
+        printf("    %-48s %11.4f %% of a core, 8 streams\n", "", core);
+        CHECK(core < 1.0);
+    }
+}
@@ -0,0 +1,429 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MIXER TESTS
+// Sums of known inputs in every format, saturation on the way back to the bus
+// format, skipped inputs, channel routes and their crossfade, and the SIMD
+// kernels against scalar. The benchmarks report a period's mix for 1 to 64
+// streams at 48 and 192 kHz, and a 64 x 64 route at densities from 1 to 100%.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_mixer.h"
+
+#include <limits>
+#include <math.h>
+#include <random>
+#include <string.h>
+#include <vector>
+
+static std::vector<float> Noise(SIZE_T samples, ULONG seed, float scale)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-scale, scale);
+    std::vector<float> v(samples);
+    for (float& x : v) x = dist(rng);
+    return v;
+}
+
+HOST_TEST(Mixer_SumsFloatInputsOntoTheBus)
+{
+    const ULONG channels = 2, frames = 1001;
+    std::vector<float> a = Noise(frames * channels, 1, 0.25f), b = Noise(frames * channels, 2, 0.25f);
+    std::vector<float> bus = Noise(frames * channels, 3, 0.25f), expected(bus.size());
+    for (size_t i = 0; i < bus.size(); ++i) expected[i] = (bus[i] + a[i]) + b[i];
+
+    MixBus mix;
+    CHECK_EQ(mix.Init(SampleFormat_Float32, channels, DetectSimdLevel()), STATUS_SUCCESS);
+    MixInput inputs[] = { { a.data(), SampleFormat_Float32 }, { b.data(), SampleFormat_Float32 } };
+    mix.Mix(inputs, 2, bus.data(), frames, TRUE);
+    CHECK(memcmp(bus.data(), expected.data(), bus.size() * sizeof(float)) == 0);
+
+    // Without the bus's own frames, the first input starts the sum.
+    for (size_t i = 0; i < bus.size(); ++i) expected[i] = a[i] + b[i];
+    mix.Mix(inputs, 2, bus.data(), frames, FALSE);
+    CHECK(memcmp(bus.data(), expected.data(), bus.size() * sizeof(float)) == 0);
+}
+
+HOST_TEST(Mixer_IntegerInputsSumExactly)
+{
+    const ULONG channels = 2, frames = 700;
+    std::vector<SHORT> bus((size_t)frames * channels), a(bus.size()), orig;
+    std::vector<LONG>  b32(bus.size());
+    std::vector<UCHAR> c8(bus.size());
+    for (size_t i = 0; i < bus.size(); ++i)
+    {
+        bus[i] = (SHORT)((i * 131) % 8000 - 4000);
+        a[i]   = (SHORT)((i * 71) % 6000 - 3000);
+        b32[i] = (LONG)(((i * 17) % 2000) - 1000) * 65536;      // 16-bit values in a 32-bit container
+        c8[i]  = (UCHAR)(128 + i % 32 - 16);
+    }
+    orig = bus;
+
+    MixBus mix;
+    CHECK_EQ(mix.Init(SampleFormat_Pcm16, channels, DetectSimdLevel()), STATUS_SUCCESS);
+    MixInput inputs[] = { { a.data(), SampleFormat_Pcm16 }, { b32.data(), SampleFormat_Pcm32 },
+                          { c8.data(), SampleFormat_Pcm8 } };
+    mix.Mix(inputs, 3, bus.data(), frames, TRUE);
+
+    for (size_t i = 0; i < bus.size(); ++i)
+        CHECK_EQ((LONG)bus[i], (LONG)orig[i] + a[i] + (b32[i] >> 16) + ((LONG)c8[i] - 128) * 256);
+}
+
+HOST_TEST(Mixer_SaturatesToBusFormat)
+{
+    const ULONG channels = 1, frames = 64;
+
+    std::vector<SHORT> bus(frames, 30000), loud(frames, 30000), quiet(frames, -30000);
+    MixBus pcm;
+    CHECK_EQ(pcm.Init(SampleFormat_Pcm16, channels, DetectSimdLevel()), STATUS_SUCCESS);
+    MixInput up[] = { { loud.data(), SampleFormat_Pcm16 } };
+    pcm.Mix(up, 1, bus.data(), frames, TRUE);
+    for (SHORT s : bus) CHECK_EQ(s, (SHORT)32767);
+
+    MixInput down[] = { { quiet.data(), SampleFormat_Pcm16 }, { quiet.data(), SampleFormat_Pcm16 } };
+    pcm.Mix(down, 2, bus.data(), frames, FALSE);
+    for (SHORT s : bus) CHECK_EQ(s, (SHORT)-32768);
+
+    std::vector<float> fbus(frames, 0.75f), fin(frames, 0.5f), nan(frames, std::numeric_limits<float>::quiet_NaN());
+    MixBus flt;
+    CHECK_EQ(flt.Init(SampleFormat_Float32, channels, DetectSimdLevel()), STATUS_SUCCESS);
+    MixInput over[] = { { fin.data(), SampleFormat_Float32 } };
+    flt.Mix(over, 1, fbus.data(), frames, TRUE);
+    for (float s : fbus) CHECK_EQ(s, 1.0f);
+
+    MixInput bad[] = { { nan.data(), SampleFormat_Float32 } };
+    flt.Mix(bad, 1, fbus.data(), frames, FALSE);
+    for (float s : fbus) CHECK_EQ(s, -1.0f);
+}
+
+HOST_TEST(Mixer_SkipsAbsentInputs)
+{
+    const ULONG channels = 2, frames = 100;
+    std::vector<SHORT> bus((size_t)frames * channels, 1234), orig = bus;
+    std::vector<SHORT> a(bus.size(), 10);
+
+    MixBus mix;
+    CHECK_EQ(mix.Init(SampleFormat_Pcm16, channels, SimdLevel_Scalar), STATUS_SUCCESS);
+
+    // Nothing to add: the bus is left as it is, not re-encoded.
+    MixInput none[] = { { nullptr, SampleFormat_Pcm16 }, { a.data(), SampleFormat_Unknown } };
+    mix.Mix(none, 2, bus.data(), frames, TRUE);
+    CHECK(bus == orig);
+
+    MixInput some[] = { { nullptr, SampleFormat_Pcm16 }, { a.data(), SampleFormat_Pcm16 } };
+    mix.Mix(some, 2, bus.data(), frames, TRUE);
+    for (SHORT s : bus) CHECK_EQ(s, (SHORT)1244);
+
+    // Without the bus's own frames and no inputs, the bus goes silent.
+    std::vector<UCHAR> bus8((size_t)frames * channels, 0x11);
+    MixBus mix8;
+    CHECK_EQ(mix8.Init(SampleFormat_Pcm8, channels, SimdLevel_Scalar), STATUS_SUCCESS);
+    mix8.Mix(none, 2, bus8.data(), frames, FALSE);
+    for (UCHAR s : bus8) CHECK_EQ(s, (UCHAR)0x80);
+}
+
+HOST_TEST(Mixer_SimdMatchesScalar)
+{
+    const SimdLevel best = DetectSimdLevel();
+    for (LeylineSampleFormat format : { SampleFormat_Float32, SampleFormat_Pcm24, SampleFormat_Pcm16 })
+    for (ULONG channels : { 1u, 2u, 6u })
+    {
+        const ULONG frames = 1237, inputs = 5;
+        const SIZE_T samples = (SIZE_T)frames * channels;
+
+        // Loud enough that the sum clips now and then.
+        std::vector<std::vector<float>> sources;
+        std::vector<MixInput> list;
+        for (ULONG i = 0; i < inputs; ++i)
+        {
+            sources.push_back(Noise(samples, 10 + i, 0.4f));
+            list.push_back({ sources.back().data(), SampleFormat_Float32 });
+        }
+        std::vector<float> start = Noise(samples, 99, 0.4f);
+        std::vector<UCHAR> seed(samples * SampleFormatBytes(format));
+        FormatConverter encode;
+        encode.Init(SampleFormat_Float32, format, 0, SimdLevel_Scalar);
+        encode.Convert(start.data(), seed.data(), samples);
+
+        std::vector<UCHAR> reference;
+        for (SimdLevel level : { SimdLevel_Scalar, SimdLevel_Sse2, best })
+        {
+            MixBus mix;
+            CHECK_EQ(mix.Init(format, channels, level), STATUS_SUCCESS);
+            std::vector<UCHAR> bus = seed;
+            mix.Mix(list.data(), inputs, bus.data(), frames, TRUE);
+            if (level == SimdLevel_Scalar) reference = bus;
+            else CHECK(bus == reference);
+        }
+    }
+}
+
+// A route's table, sized for any matrix.
+struct RouteTable
+{
+    ChannelRouter router;
+    RouteTap      taps[LEYLINE_ROUTE_MAX_CHANNELS * LEYLINE_ROUTE_MAX_CHANNELS];
+
+    NTSTATUS Init(const std::vector<float>& gains, ULONG inputs, ULONG outputs)
+    {
+        return router.Init(gains.data(), inputs, outputs, taps, sizeof(taps));
+    }
+};
+
+HOST_TEST(Mixer_RouteBuildsOnlyNonzeroTaps)
+{
+    // 3 inputs -> 2 outputs; input 1 goes nowhere.
+    std::vector<float> gains = { 0.5f, 0.0f, 0.0f,
+                                 0.0f, 0.0f, -1.0f };
+    CHECK_EQ(ChannelRouter::TapCount(gains.data(), 3, 2), 2u);
+
+    RouteTable t;
+    CHECK_EQ(t.Init(gains, 3, 2), STATUS_SUCCESS);
+    CHECK_EQ(t.router.GetTapCount(), 2u);
+    CHECK_EQ(t.router.GetUsedInputs(), 0x5ull);
+    CHECK_EQ(t.router.GetTaps()[0].Input, 0);
+    CHECK_EQ(t.router.GetTaps()[0].Output, 0);
+    CHECK_EQ(t.router.GetTaps()[1].Input, 2);
+    CHECK_EQ(t.router.GetTaps()[1].Output, 1);
+
+    ChannelRouter r;
+    RouteTap      one[1];
+    CHECK_EQ(r.Init(gains.data(), 3, 2, one, sizeof(one)), STATUS_BUFFER_TOO_SMALL);
+    CHECK_EQ(r.Init(gains.data(), 0, 2, one, sizeof(one)), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(r.Init(gains.data(), 3, LEYLINE_ROUTE_MAX_CHANNELS + 1, one, sizeof(one)), STATUS_INVALID_PARAMETER);
+
+    for (float bad : { std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+                       LEYLINE_ROUTE_MAX_GAIN * 2 })
+    {
+        std::vector<float> g = gains;
+        g[4] = bad;
+        CHECK_EQ(t.Init(g, 3, 2), STATUS_INVALID_PARAMETER);
+    }
+
+    // All zero is a route that mutes the stream.
+    std::vector<float> none(6, 0.0f);
+    CHECK_EQ(r.Init(none.data(), 3, 2, nullptr, 0), STATUS_SUCCESS);
+    CHECK_EQ(r.GetTapCount(), 0u);
+}
+
+HOST_TEST(Mixer_RoutesChannelsThroughTheMatrix)
+{
+    // A mono voice to the left, stereo music to the right, onto a float stereo bus.
+    const ULONG frames = 301;
+    std::vector<float> voice = Noise(frames, 1, 0.3f), music = Noise(frames * 2, 2, 0.3f);
+    std::vector<float> bus = Noise(frames * 2, 3, 0.3f), expected = bus;
+
+    RouteTable left, right;
+    CHECK_EQ(left.Init({ 1.0f,
+                         0.0f }, 1, 2), STATUS_SUCCESS);
+    CHECK_EQ(right.Init({ 0.0f,  0.0f,
+                          0.5f,  0.5f }, 2, 2), STATUS_SUCCESS);
+
+    MixBus mix;
+    CHECK_EQ(mix.Init(SampleFormat_Float32, 2, DetectSimdLevel()), STATUS_SUCCESS);
+    MixInput inputs[2] = {};
+    inputs[0] = { voice.data(), SampleFormat_Float32, &left.router };
+    inputs[1] = { music.data(), SampleFormat_Float32, &right.router };
+    mix.Mix(inputs, 2, bus.data(), frames, TRUE);
+
+    for (ULONG k = 0; k < frames; ++k)
+    {
+        expected[k * 2]     += 1.0f * voice[k] * 1.0f;
+        expected[k * 2 + 1] += (0.5f * music[k * 2] + 0.5f * music[k * 2 + 1]) * 1.0f;
+    }
+    CHECK(memcmp(bus.data(), expected.data(), bus.size() * sizeof(float)) == 0);
+
+    // A route whose outputs are not the bus channels is skipped.
+    RouteTable wide;
+    CHECK_EQ(wide.Init(std::vector<float>(4, 1.0f), 1, 4), STATUS_SUCCESS);
+    MixInput wrong[1] = {};
+    wrong[0] = { voice.data(), SampleFormat_Float32, &wide.router };
+    std::vector<float> before = bus;
+    mix.Mix(wrong, 1, bus.data(), frames, TRUE);
+    CHECK(bus == before);
+}
+
+HOST_TEST(Mixer_RouteChangeCrossfades)
+{
+    // A steady mono tone moved from left to right over one 480-frame period,
+    // mixed in two uneven pieces as the driver does at a buffer wrap.
+    const ULONG frames = 480, split = 137;
+    std::vector<float> tone(frames, 0.5f), bus(frames * 2, 0.0f);
+
+    RouteTable left, right;
+    CHECK_EQ(left.Init({ 1.0f, 0.0f }, 1, 2), STATUS_SUCCESS);
+    CHECK_EQ(right.Init({ 0.0f, 1.0f }, 1, 2), STATUS_SUCCESS);
+
+    MixBus mix;
+    CHECK_EQ(mix.Init(SampleFormat_Float32, 2, DetectSimdLevel()), STATUS_SUCCESS);
+    const float step = 1.0f / frames;
+    MixInput in[1] = {};
+    in[0] = { tone.data(), SampleFormat_Float32, &right.router, &left.router, 0.0f, step };
+    mix.Mix(in, 1, bus.data(), split, FALSE);
+    in[0] = { tone.data() + split, SampleFormat_Float32, &right.router, &left.router, split * step, step };
+    mix.Mix(in, 1, bus.data() + split * 2, frames - split, FALSE);
+
+    CHECK_EQ(bus[0], 0.5f);
+    CHECK_EQ(bus[1], 0.0f);
+    for (ULONG k = 1; k < frames; ++k)
+    {
+        CHECK(bus[k * 2] <= bus[(k - 1) * 2]);                  // Left only falls...
+        CHECK(bus[k * 2 + 1] >= bus[(k - 1) * 2 + 1]);          // ...right only rises
+        CHECK(fabsf(bus[k * 2] + bus[k * 2 + 1] - 0.5f) < 1e-6f);
+        CHECK(fabsf(bus[k * 2 + 1] - bus[(k - 1) * 2 + 1]) < 0.5f * step * 1.01f);
+    }
+
+    // To and from the bus's own layout, through the identity route.
+    std::vector<float> stereo = Noise(frames * 2, 4, 0.5f), out(frames * 2);
+    in[0] = { stereo.data(), SampleFormat_Float32, mix.GetIdentity(), mix.GetIdentity(), 0.25f, 0.0f };
+    mix.Mix(in, 1, out.data(), frames, FALSE);
+    for (size_t i = 0; i < out.size(); ++i) CHECK(fabsf(out[i] - stereo[i]) < 1e-6f);
+}
+
+HOST_TEST(Mixer_RouteSimdMatchesScalar)
+{
+    const SimdLevel best = DetectSimdLevel();
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> gain(-1.0f, 1.0f), pick(0.0f, 1.0f);
+
+    for (ULONG inputs : { 1u, 6u, 64u })
+    for (ULONG outputs : { 2u, 8u, 64u })
+    {
+        std::vector<float> gains((size_t)inputs * outputs), faded(gains.size());
+        for (float& g : gains) g = pick(rng) < 0.2f ? gain(rng) : 0.0f;
+        for (float& g : faded) g = pick(rng) < 0.2f ? gain(rng) : 0.0f;
+        RouteTable route, from;
+        CHECK_EQ(route.Init(gains, inputs, outputs), STATUS_SUCCESS);
+        CHECK_EQ(from.Init(faded, inputs, outputs), STATUS_SUCCESS);
+
+        const ULONG frames = 203;
+        std::vector<float> f = Noise((SIZE_T)frames * inputs, inputs + outputs, 0.2f);
+        std::vector<SHORT> pcm(f.size());
+        FormatConverter encode;
+        encode.Init(SampleFormat_Float32, SampleFormat_Pcm16, 0, SimdLevel_Scalar);
+        encode.Convert(f.data(), pcm.data(), f.size());
+
+        std::vector<float> reference;
+        for (SimdLevel level : { SimdLevel_Scalar, SimdLevel_Sse2, best })
+        {
+            MixBus mix;
+            CHECK_EQ(mix.Init(SampleFormat_Float32, outputs, level), STATUS_SUCCESS);
+            std::vector<float> bus = Noise((SIZE_T)frames * outputs, 5, 0.2f);
+            MixInput in[2] = {};
+            in[0] = { f.data(), SampleFormat_Float32, &route.router };
+            in[1] = { pcm.data(), SampleFormat_Pcm16, &route.router, &from.router, 0.1f, 1.0f / frames };
+            mix.Mix(in, 2, bus.data(), frames, TRUE);
+            if (level == SimdLevel_Scalar) reference = bus;
+            else CHECK(bus == reference);
+        }
+    }
+}
+
+HOST_TEST(Mixer_RejectsBadInit)
+{
+    MixBus mix;
+    CHECK_EQ(mix.Init(SampleFormat_Unknown, 2, SimdLevel_Scalar), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(mix.Init(SampleFormat_Pcm16, 0, SimdLevel_Scalar), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(mix.Init(SampleFormat_Pcm16, LEYLINE_ROUTE_MAX_CHANNELS + 1, SimdLevel_Scalar), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(mix.Init(SampleFormat_Pcm16, 2, (SimdLevel)7), STATUS_INVALID_PARAMETER);
+}
+
+HOST_BENCH(Mixer_CostPerPeriod)
+{
+    const ULONG channels = 2, periodMs = 10;
+    const SimdLevel best = DetectSimdLevel();
+
+    for (ULONG rate : { 48000u, 192000u })
+    for (LeylineSampleFormat format : { SampleFormat_Pcm16, SampleFormat_Float32 })
+    {
+        const ULONG  frames  = rate / 1000 * periodMs;
+        const SIZE_T samples = (SIZE_T)frames * channels;
+        const SIZE_T bytes   = samples * SampleFormatBytes(format);
+
+        // Every stream its own buffer, as in the driver.
+        std::vector<std::vector<UCHAR>> streams(LEYLINE_MIX_MAX_INPUTS, std::vector<UCHAR>(bytes));
+        FormatConverter encode;
+        encode.Init(SampleFormat_Float32, format, 0, SimdLevel_Scalar);
+        for (ULONG i = 0; i < LEYLINE_MIX_MAX_INPUTS; ++i)
+        {
+            std::vector<float> f = Noise(samples, i, 1.0f / LEYLINE_MIX_MAX_INPUTS);
+            encode.Convert(f.data(), streams[i].data(), samples);
+        }
+        std::vector<UCHAR> bus(bytes);
+
+        double perStream1 = 0;
+        for (ULONG count : { 1u, 4u, 16u, 64u })
+        {
+            MixBus mix;
+            mix.Init(format, channels, best);
+            std::vector<MixInput> inputs(count);
+            for (ULONG i = 0; i < count; ++i) inputs[i] = { streams[i].data(), format };
+
+            const int iterations = (int)(2000000 / (frames * count)) + 10;
+            uint64_t t0 = HostTest::NowNs();
+            for (int i = 0; i < iterations; ++i)
+                mix.Mix(inputs.data(), count, bus.data(), frames, FALSE);
+            double ns = (double)(HostTest::NowNs() - t0) / iterations;
+
+            char name[64];
+            snprintf(name, sizeof(name), "mix_%ukhz_%s_%u_streams_per_%ums", rate / 1000,
+                     format == SampleFormat_Float32 ? "f32" : "pcm16", count, periodMs);
+            HostTest::Report(name, ns, (double)bytes * count * 1e9 / ns);
+            printf("    %-48s %11.2f ns per stream, %.4f %% of the period\n", "", ns / count,
+                   100.0 * ns / (periodMs * 1e6));
+
+            // Linear in the stream count: the per-stream cost must not grow.
+            if (count == 1) perStream1 = ns;
+            else CHECK(ns / count < perStream1 * 2.0);
+            CHECK(ns < periodMs * 1e6 * 0.05);
+        }
+    }
+}
+
+HOST_BENCH(Mixer_RouteMatrix64x64)
+{
+    const ULONG channels = LEYLINE_ROUTE_MAX_CHANNELS, rate = 48000, periodMs = 10;
+    const ULONG frames   = rate / 1000 * periodMs;
+    const SimdLevel best = DetectSimdLevel();
+
+    std::vector<float> in  = Noise((SIZE_T)frames * channels, 1, 0.01f);
+    std::vector<float> bus((SIZE_T)frames * channels);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> pick(0.0f, 1.0f);
+
+    double dense = 0;
+    for (int percent : { 100, 50, 10, 1 })
+    {
+        std::vector<float> gains((size_t)channels * channels);
+        for (float& g : gains) g = pick(rng) * 100.0f < percent ? 0.5f : 0.0f;
+        RouteTable route;
+        CHECK_EQ(route.Init(gains, channels, channels), STATUS_SUCCESS);
+
+        for (SimdLevel level : { SimdLevel_Scalar, best })
+        {
+            MixBus mix;
+            mix.Init(SampleFormat_Float32, channels, level);
+            MixInput inputs[1] = {};
+            inputs[0] = { in.data(), SampleFormat_Float32, &route.router };
+
+            const int iterations = 20;
+            uint64_t t0 = HostTest::NowNs();
+            for (int i = 0; i < iterations; ++i) mix.Mix(inputs, 1, bus.data(), frames, FALSE);
+            double ns = (double)(HostTest::NowNs() - t0) / iterations;
+
+            char name[64];
+            snprintf(name, sizeof(name), "route_64x64_%d%%_%s_per_%ums", percent,
+                     level == SimdLevel_Scalar ? "scalar" : "simd", periodMs);
+            HostTest::Report(name, ns, (double)frames * channels * sizeof(float) * 1e9 / ns);
+            printf("    %-48s %11u taps, %.4f %% of the period\n", "", route.router.GetTapCount(),
+                   100.0 * ns / (periodMs * 1e6));
+
+            if (level != best) continue;
+            if (percent == 100) dense = ns;
+            CHECK(ns < periodMs * 1e6 * 0.05);
+            if (percent == 1) CHECK(ns < dense * 0.5);      // Zero coefficients are skipped
+        }
+    }
+}
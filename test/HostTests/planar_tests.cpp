@@ -0,0 +1,269 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PLANAR TESTS
+// Interleave/deinterleave at every SIMD level against the scalar kernels, the side
+// ring's wrap, overrun and decode behaviour, a racing reader, and the cost of
+// strided against planar single-channel access.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_planar.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static std::vector<SimdLevel> AvailableLevels()
+{
+    std::vector<SimdLevel> levels = { SimdLevel_Scalar, SimdLevel_Sse2 };
+    if (DetectSimdLevel() == SimdLevel_Avx2) levels.push_back(SimdLevel_Avx2);
+    return levels;
+}
+
+// Sample value that says which frame and channel it came from.
+static float Tag(ULONGLONG frame, ULONG channel)
+{
+    return (float)(frame % 100000) + (float)channel / 32.0f;
+}
+
+static std::vector<float> Interleaved(ULONG channels, ULONG frames, ULONGLONG first = 0)
+{
+    std::vector<float> v((size_t)channels * frames);
+    for (ULONG f = 0; f < frames; ++f)
+        for (ULONG ch = 0; ch < channels; ++ch) v[(size_t)f * channels + ch] = Tag(first + f, ch);
+    return v;
+}
+
+struct Ring
+{
+    std::vector<UCHAR> Storage;
+    PlanarRing         Planes;
+
+    Ring(LeylineSampleFormat format, ULONG channels, ULONG frames, SimdLevel level)
+        : Storage(PlanarRing::Bytes(channels, frames))
+    {
+        memset(&Planes, 0, sizeof(Planes));
+        CHECK_EQ(Planes.Init(format, channels, 48000, frames, level, Storage.data(), Storage.size()), STATUS_SUCCESS);
+    }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// KERNELS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_TEST(Planar_KernelsMatchScalarAtEveryWidth)
+{
+    for (ULONG channels = 1; channels <= LEYLINE_PLANAR_MAX_CHANNELS; ++channels)
+    for (ULONG frames : { 0u, 1u, 7u, 8u, 37u, 256u })
+    {
+        std::vector<float> in = Interleaved(channels, frames);
+        for (SimdLevel level : AvailableLevels())
+        {
+            std::vector<std::vector<float>> planes(channels, std::vector<float>(frames + 1, -1.0f));
+            float* p[LEYLINE_PLANAR_MAX_CHANNELS];
+            for (ULONG ch = 0; ch < channels; ++ch) p[ch] = planes[ch].data();
+
+            Deinterleave(in.data(), channels, frames, p, level);
+            bool ok = true;
+            for (ULONG ch = 0; ch < channels; ++ch)
+            {
+                for (ULONG f = 0; f < frames; ++f) ok = ok && planes[ch][f] == Tag(f, ch);
+                ok = ok && planes[ch][frames] == -1.0f;                 // Nothing past the end
+            }
+            if (!ok) printf("    deinterleave: %u channels, %u frames, level %d\n", channels, frames, (int)level);
+            CHECK(ok);
+
+            std::vector<float> back(in.size() + 1, -1.0f);
+            const float* cp[LEYLINE_PLANAR_MAX_CHANNELS];
+            for (ULONG ch = 0; ch < channels; ++ch) cp[ch] = planes[ch].data();
+            Interleave(cp, channels, frames, back.data(), level);
+            const bool same = in.empty() || memcmp(back.data(), in.data(), in.size() * sizeof(float)) == 0;
+            if (!same || back[in.size()] != -1.0f)
+                printf("    interleave: %u channels, %u frames, level %d\n", channels, frames, (int)level);
+            CHECK(same);
+            CHECK(back[in.size()] == -1.0f);
+        }
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RING
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_TEST(Planar_RingRejectsBadParameters)
+{
+    std::vector<UCHAR> storage(PlanarRing::Bytes(LEYLINE_PLANAR_MAX_CHANNELS, 64));
+    PlanarRing ring;
+    memset(&ring, 0, sizeof(ring));
+    CHECK_EQ(ring.Init(SampleFormat_Float32, 0, 48000, 64, SimdLevel_Scalar, storage.data(), storage.size()), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(ring.Init(SampleFormat_Float32, LEYLINE_PLANAR_MAX_CHANNELS + 1, 48000, 64, SimdLevel_Scalar, storage.data(), storage.size()), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(ring.Init(SampleFormat_Float32, 2, 48000, 48, SimdLevel_Scalar, storage.data(), storage.size()), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(ring.Init(SampleFormat_Float32, 2, 48000, 64, SimdLevel_Scalar, nullptr, storage.size()), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(ring.Init(SampleFormat_Float32, 2, 48000, 64, SimdLevel_Scalar, storage.data(), 64), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(ring.Init(SampleFormat_Unknown, 2, 48000, 64, SimdLevel_Scalar, storage.data(), storage.size()), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(ring.Init(SampleFormat_Float32, LEYLINE_PLANAR_MAX_CHANNELS, 48000, 64, SimdLevel_Scalar, storage.data(), storage.size()), STATUS_SUCCESS);
+
+    // Every plane starts on its own cache line.
+    for (ULONG ch = 0; ch < LEYLINE_PLANAR_MAX_CHANNELS; ++ch)
+        CHECK_EQ((ULONG_PTR)ring.GetPlane(ch) % SYSTEM_CACHE_ALIGNMENT_SIZE, (ULONG_PTR)0);
+}
+
+HOST_TEST(Planar_RingKeepsEachChannelContiguousAcrossTheWrap)
+{
+    const ULONG channels = 12, capacity = 64;          // 7.1.4
+    for (SimdLevel level : AvailableLevels())
+    {
+        Ring r(SampleFormat_Float32, channels, capacity, level);
+        ULONGLONG written = 0;
+        for (ULONG n : { 40u, 13u, 30u, 5u })
+        {
+            std::vector<float> in = Interleaved(channels, n, written);
+            r.Planes.Write(in.data(), n);
+            written += n;
+        }
+        CHECK_EQ(r.Planes.GetWritten(), written);
+
+        // Oldest intact frame on: the last `capacity` frames, split at the wrap.
+        for (ULONG ch = 0; ch < channels; ++ch)
+        {
+            float out[capacity];
+            ULONGLONG from = 0;
+            ULONG n = r.Planes.ReadPlane(ch, &from, capacity, out);
+            CHECK_EQ(n, capacity);
+            CHECK_EQ(from, written - capacity);
+            bool ok = true;
+            for (ULONG i = 0; i < n; ++i) ok = ok && out[i] == Tag(from + i, ch);
+            CHECK(ok);
+        }
+
+        std::vector<float> frames((size_t)channels * 16);
+        ULONGLONG from = written - 16;
+        CHECK_EQ(r.Planes.ReadFrames(&from, 16, frames.data()), (ULONG)16);
+        CHECK(frames == Interleaved(channels, 16, written - 16));
+
+        // Nothing past the write position.
+        from = written;
+        CHECK_EQ(r.Planes.ReadPlane(0, &from, 16, frames.data()), (ULONG)0);
+        CHECK_EQ(r.Planes.ReadPlane(channels, &from, 16, frames.data()), (ULONG)0);
+    }
+}
+
+HOST_TEST(Planar_RingDecodesPcmAndSkipsOverlongWrites)
+{
+    const ULONG channels = 8, capacity = 32;
+    Ring r(SampleFormat_Pcm16, channels, capacity, DetectSimdLevel());
+
+    std::vector<SHORT> pcm((size_t)channels * 100);
+    for (size_t i = 0; i < pcm.size(); ++i) pcm[i] = (SHORT)((i / channels) * 64 + (i % channels));
+    r.Planes.Write(pcm.data(), 100);
+    CHECK_EQ(r.Planes.GetWritten(), (ULONGLONG)100);
+
+    float out[capacity];
+    ULONGLONG from = 0;
+    CHECK_EQ(r.Planes.ReadPlane(5, &from, capacity, out), capacity);
+    CHECK_EQ(from, (ULONGLONG)(100 - capacity));
+    for (ULONG i = 0; i < capacity; ++i)
+        CHECK_EQ(out[i], (float)((from + i) * 64 + 5) / 32768.0f);
+}
+
+// A reader chasing the writer gets frames that are either correct or reported
+// lost, never a mix: every sample it is handed must carry its own frame index.
+HOST_TEST(Planar_RacingReaderNeverSeesTornFrames)
+{
+    const ULONG channels = 16, capacity = 256, chunk = 48;
+    Ring r(SampleFormat_Float32, channels, capacity, DetectSimdLevel());
+    std::atomic<bool> done(false);
+    std::atomic<ULONG> bad(0), reads(0);
+
+    std::thread reader([&] {
+        std::vector<float> out((size_t)channels * capacity);
+        ULONGLONG from = 0;
+        while (!done.load())
+        {
+            ULONG n = r.Planes.ReadFrames(&from, capacity, out.data());
+            for (ULONG i = 0; i < n; ++i)
+                for (ULONG ch = 0; ch < channels; ++ch)
+                    if (out[(size_t)i * channels + ch] != Tag(from + i, ch)) bad.fetch_add(1);
+            from += n;
+            reads.fetch_add(1);
+            std::this_thread::yield();
+        }
+    });
+
+    ULONGLONG written = 0;
+    for (int i = 0; i < 4000; ++i)
+    {
+        std::vector<float> in = Interleaved(channels, chunk, written);
+        r.Planes.Write(in.data(), chunk);
+        written += chunk;
+        if (i % 8 == 0) std::this_thread::yield();
+    }
+    done = true;
+    reader.join();
+    CHECK_EQ(bad.load(), (ULONG)0);
+    CHECK(reads.load() > 0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARKS
+// One channel's energy out of 16-channel audio: striding through the interleaved
+// frames, deinterleaving then walking the plane, and walking a plane the side ring
+// already holds.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static float Energy(const float* x, ULONG frames, ULONG stride)
+{
+    float sum = 0.0f;
+    for (ULONG i = 0; i < frames; ++i, x += stride) sum += *x * *x;
+    return sum;
+}
+
+HOST_BENCH(Planar_StridedVersusPlanar)
+{
+    const ULONG channels = 16, frames = 4800;          // 100 ms at 48 kHz
+    const int   iterations = 2000;
+    std::vector<float> in = Interleaved(channels, frames);
+    std::vector<std::vector<float>> planes(channels, std::vector<float>(frames));
+    float* p[LEYLINE_PLANAR_MAX_CHANNELS];
+    for (ULONG ch = 0; ch < channels; ++ch) p[ch] = planes[ch].data();
+
+    volatile float sink = 0.0f;
+    uint64_t t0 = HostTest::NowNs();
+    for (int i = 0; i < iterations; ++i)
+        for (ULONG ch = 0; ch < channels; ++ch) sink = sink + Energy(in.data() + ch, frames, channels);
+    double strided = (double)(HostTest::NowNs() - t0) / iterations;
+
+    t0 = HostTest::NowNs();
+    for (int i = 0; i < iterations; ++i)
+    {
+        Deinterleave(in.data(), channels, frames, p, DetectSimdLevel());
+        for (ULONG ch = 0; ch < channels; ++ch) sink = sink + Energy(p[ch], frames, 1);
+    }
+    double deinterleaved = (double)(HostTest::NowNs() - t0) / iterations;
+
+    t0 = HostTest::NowNs();
+    for (int i = 0; i < iterations; ++i)
+        for (ULONG ch = 0; ch < channels; ++ch) sink = sink + Energy(p[ch], frames, 1);
+    double planar = (double)(HostTest::NowNs() - t0) / iterations;
+
+    const double bytes = (double)frames * channels * sizeof(float);
+    HostTest::Report("planar_16ch_100ms_strided", strided, bytes * 1e9 / strided);
+    HostTest::Report("planar_16ch_100ms_deinterleave_then_planar", deinterleaved, bytes * 1e9 / deinterleaved);
+    HostTest::Report("planar_16ch_100ms_planar", planar, bytes * 1e9 / planar);
+
+    for (SimdLevel level : AvailableLevels())
+    {
+        t0 = HostTest::NowNs();
+        for (int i = 0; i < iterations; ++i) Deinterleave(in.data(), channels, frames, p, level);
+        double ns = (double)(HostTest::NowNs() - t0) / iterations;
+
+        char name[64];
+        snprintf(name, sizeof(name), "planar_deinterleave_16ch_%s",
+                 level == SimdLevel_Avx2 ? "avx2" : level == SimdLevel_Sse2 ? "sse2" : "scalar");
+        HostTest::Report(name, ns, bytes * 1e9 / ns);
+    }
+}
@@ -0,0 +1,216 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// STREAM REGISTER TESTS
+// Drives StreamRegisterWriter from a simulated periodic timer, the way the stream's
+// KDPC does, and polls the page the way the audio engine does.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_registers.h"
+#include "leyline_wavertmath.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+
+static const LONG64 kQpcFrequency = 10000000;
+static const ULONG  kSampleRate   = 48000;
+static const ULONG  kBlockAlign   = 8;                  // 32-bit float stereo
+static const ULONG  kBufferSize   = 480 * kBlockAlign * 4;
+
+// The stream's timer: fires every `periodMs`, each expiry delivered late by a
+// random DPC latency, and occasionally much later (a long ISR on that core).
+struct SimTimer
+{
+    std::mt19937_64 Rng;
+    LONG64          PeriodQpc;
+    LONG64          NextDue;
+
+    SimTimer(ULONG periodMs, LONG64 start, unsigned seed)
+        : Rng(seed), PeriodQpc(kQpcFrequency * periodMs / 1000), NextDue(start + PeriodQpc) {}
+
+    // QPC at which the next DPC runs; the period itself does not drift.
+    LONG64 NextFire()
+    {
+        LONG64 late = (LONG64)(Rng() % 1500);               // up to 150 us
+        if (Rng() % 500 == 0) late += PeriodQpc / 2;        // rare long stall
+        LONG64 fire = NextDue + late;
+        NextDue += PeriodQpc;
+        return fire;
+    }
+};
+
+HOST_TEST(Registers_PublishedPositionMatchesClockAtPublishQpc)
+{
+    LeylineStreamRegisters page = {};
+    StreamRegisterWriter writer;
+    writer.Attach(&page);
+
+    WaveRTMath::StreamClock clock;
+    clock.Start(1000, kQpcFrequency, kSampleRate, kBlockAlign, kBufferSize);
+
+    LONG64 now = 1000 + kQpcFrequency / 10;                 // 100 ms = 4800 frames
+    ULONGLONG frames = clock.FramesAt(now);
+    writer.Publish(now, frames, clock.BufferOffset(frames));
+
+    CHECK_EQ(page.Frames, (ULONG64)4800);
+    CHECK_EQ(page.Position, (ULONG)((4800 % 1920) * kBlockAlign));
+    CHECK_EQ(page.Qpc, now);
+    CHECK_EQ(page.Sequence & 1, (ULONG)0);
+
+    writer.Reset();
+    CHECK_EQ(page.Position, (ULONG)0);
+    CHECK_EQ(page.Frames, (ULONG64)0);
+}
+
+HOST_TEST(Registers_AccuracyCoversOnePeriod)
+{
+    CHECK_EQ(StreamRegisterWriter::AccuracyBytes(1, 48000, 8), (ULONG)(48 * 8));
+    CHECK_EQ(StreamRegisterWriter::AccuracyBytes(1, 44100, 4), (ULONG)(45 * 4));
+    CHECK_EQ(StreamRegisterWriter::AccuracyBytes(10, 44100, 1), (ULONG)441);
+}
+
+// Ten simulated minutes at each period: a client polling at random instants sees a
+// register that lags the true position by no more than the reported accuracy while
+// the last DPC is less than a period old, and using the Qpc stamp to extrapolate
+// recovers the exact position no matter how late the DPC was.
+HOST_TEST(Registers_PolledPositionStaysWithinAccuracy)
+{
+    const ULONG periods[] = { 1, 2, 5, 10 };
+    for (ULONG periodMs : periods)
+    {
+        LeylineStreamRegisters page = {};
+        StreamRegisterWriter writer;
+        writer.Attach(&page);
+
+        const LONG64 start = 77777;
+        WaveRTMath::StreamClock clock;
+        clock.Start(start, kQpcFrequency, kSampleRate, kBlockAlign, kBufferSize);
+        writer.Publish(start, 0, 0);
+
+        SimTimer timer(periodMs, start, periodMs);
+        std::mt19937_64 rng(1000 + periodMs);
+
+        const ULONG  accuracyFrames = StreamRegisterWriter::AccuracyBytes(periodMs, kSampleRate, kBlockAlign) / kBlockAlign;
+        const LONG64 end            = start + kQpcFrequency * 600;
+
+        LONG64    fire        = timer.NextFire();
+        LONG64    lastPublish = start;
+        ULONGLONG worstLag    = 0;
+        int       beyondAccuracy = 0, mismatched = 0, extrapolationErrors = 0, polls = 0;
+
+        for (LONG64 now = start; now < end; now += (LONG64)(rng() % 20000) + 1)
+        {
+            while (fire <= now)
+            {
+                ULONGLONG frames = clock.FramesAt(fire);
+                writer.Publish(fire, frames, clock.BufferOffset(frames));
+                lastPublish = fire;
+                fire = timer.NextFire();
+            }
+
+            ULONG position; ULONGLONG frames; LONG64 qpc;
+            StreamRegisterWriter::Snapshot(&page, &position, &frames, &qpc);
+            ++polls;
+
+            ULONGLONG truth = clock.FramesAt(now);
+            ULONGLONG lag   = truth - frames;
+            if (lag > worstLag) worstLag = lag;
+            if (position != clock.BufferOffset(frames)) ++mismatched;
+
+            // A poll within one period of the last update is within the advertised
+            // accuracy; DPC latency only stretches how long a value stays current.
+            if (now - lastPublish <= timer.PeriodQpc && lag > accuracyFrames)
+                ++beyondAccuracy;
+
+            // floor(a) + floor(b) is floor(a + b) or one less.
+            LONG64 residual = (LONG64)(truth - (frames + clock.FramesBetween(qpc, now)));
+            if (residual < 0 || residual > 1) ++extrapolationErrors;
+        }
+
+        CHECK_EQ(beyondAccuracy, 0);
+        CHECK_EQ(mismatched, 0);
+        CHECK_EQ(extrapolationErrors, 0);
+        printf("    period=%2u ms polls=%d accuracy=%u frames worst lag=%llu frames\n",
+               periodMs, polls, accuracyFrames, (unsigned long long)worstLag);
+    }
+}
+
+// The audio engine reads Position alone; a tool reads the whole triple. Neither may
+// see a mix of two updates.
+HOST_TEST(Registers_SnapshotIsConsistentUnderConcurrentUpdates)
+{
+    static LeylineStreamRegisters page = {};
+    StreamRegisterWriter writer;
+    writer.Attach(&page);
+
+    std::atomic<bool> done(false);
+    std::atomic<int>  torn(0), reads(0);
+
+    std::thread poller([&] {
+        while (!done.load())
+        {
+            ULONG position; ULONGLONG frames; LONG64 qpc;
+            StreamRegisterWriter::Snapshot(&page, &position, &frames, &qpc);
+            if ((LONG64)frames * 3 != qpc || position != (ULONG)(frames % 1000)) torn++;
+            reads++;
+        }
+    });
+
+    for (ULONGLONG n = 0; n < 3000000; ++n)
+        writer.Publish((LONG64)n * 3, n, (ULONG)(n % 1000));
+    done = true;
+    poller.join();
+
+    CHECK_EQ(torn.load(), 0);
+    CHECK(reads.load() > 0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARKS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Cost of one timer DPC body (clock evaluation + register publish), and of one
+// client poll of the position register versus a full snapshot.
+HOST_BENCH(Registers_UpdateAndPollCost)
+{
+    static LeylineStreamRegisters page = {};
+    StreamRegisterWriter writer;
+    writer.Attach(&page);
+
+    volatile LONG64 vFreq = kQpcFrequency;
+    WaveRTMath::StreamClock clock;
+    clock.Start(0, vFreq, kSampleRate, kBlockAlign, kBufferSize);
+
+    const uint64_t iterations = 20ull * 1000 * 1000;
+
+    uint64_t t0 = HostTest::NowNs();
+    LONG64 now = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        now += 10000;
+        ULONGLONG frames = clock.FramesAt(now);
+        writer.Publish(now, frames, clock.BufferOffset(frames));
+    }
+    HostTest::Report("register_dpc_update", (double)(HostTest::NowNs() - t0) / (double)iterations, 0);
+
+    ULONGLONG acc = 0;
+    t0 = HostTest::NowNs();
+    for (uint64_t i = 0; i < iterations; ++i)
+        acc += page.Position;
+    HostTest::Report("register_poll_position", (double)(HostTest::NowNs() - t0) / (double)iterations, 0);
+
+    t0 = HostTest::NowNs();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        ULONG position; ULONGLONG frames; LONG64 qpc;
+        StreamRegisterWriter::Snapshot(&page, &position, &frames, &qpc);
+        acc += frames;
+    }
+    HostTest::Report("register_poll_snapshot", (double)(HostTest::NowNs() - t0) / (double)iterations, 0);
+
+    volatile ULONGLONG sink = acc;
+    (void)sink;
+}
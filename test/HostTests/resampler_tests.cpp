@@ -0,0 +1,235 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RESAMPLER TESTS
+// THD+N and stopband rejection per preset, streaming invariance, and the SIMD
+// kernels against scalar. The benchmark reports cycles per output frame.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_resampler.h"
+
+#include <math.h>
+#include <random>
+#include <vector>
+#include <x86intrin.h>
+
+static const char* kPresetNames[] = { "low", "medium", "high" };
+
+// A resampler together with the bank storage the driver would allocate for it.
+struct SrcUnderTest
+{
+    std::vector<float> Bank;
+    Resampler          Src;
+
+    NTSTATUS Init(ULONG inRate, ULONG outRate, ULONG channels, SrcQuality quality, SimdLevel level)
+    {
+        Bank.assign(Resampler::BankBytes(inRate, outRate, quality) / sizeof(float) + 1, 0.0f);
+        return Src.Init(inRate, outRate, channels, quality, level, Bank.data(), Bank.size() * sizeof(float));
+    }
+
+    // Feeds everything through in one go.
+    std::vector<float> Run(const std::vector<float>& in, ULONG channels)
+    {
+        ULONG inFrames = (ULONG)(in.size() / channels);
+        std::vector<float> out((size_t)Src.MaxOutputFrames(inFrames) * channels);
+        ULONG consumed = 0;
+        ULONG produced = Src.Process(in.data(), inFrames, &consumed, out.data(), Src.MaxOutputFrames(inFrames));
+        out.resize((size_t)produced * channels);
+        return out;
+    }
+};
+
+static std::vector<float> Sine(double hz, ULONG rate, ULONG frames, ULONG channels, double amplitude)
+{
+    std::vector<float> v((size_t)frames * channels);
+    for (ULONG i = 0; i < frames; ++i)
+        for (ULONG ch = 0; ch < channels; ++ch)
+            v[(size_t)i * channels + ch] = (float)(amplitude * sin(2.0 * M_PI * hz * i / rate + ch));
+    return v;
+}
+
+// THD+N of channel 0 in dB: least-squares fit of a sine at the expected frequency,
+// everything else counts as distortion plus noise. The filter's start-up transient
+// and tail are excluded.
+static double ThdN(const std::vector<float>& y, ULONG channels, double hz, ULONG rate, ULONG skip)
+{
+    double w = 2.0 * M_PI * hz / rate;
+    double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0;
+    size_t frames = y.size() / channels;
+    for (size_t k = skip; k + skip < frames; ++k)
+    {
+        double s = sin(w * k), c = cos(w * k), v = y[k * channels];
+        ss += s * s; cc += c * c; sc += s * c; ys += v * s; yc += v * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+
+    double signal = 0, residual = 0;
+    for (size_t k = skip; k + skip < frames; ++k)
+    {
+        double fit = a * sin(w * k) + b * cos(w * k);
+        double e   = y[k * channels] - fit;
+        signal   += fit * fit;
+        residual += e * e;
+    }
+    return 10.0 * log10(residual / signal);
+}
+
+static double RmsDb(const std::vector<float>& y, ULONG channels, ULONG skip)
+{
+    double sum = 0;
+    size_t frames = y.size() / channels, n = 0;
+    for (size_t k = skip; k + skip < frames; ++k, ++n) sum += (double)y[k * channels] * y[k * channels];
+    return 10.0 * log10(sum / (double)n + 1e-30);
+}
+
+HOST_TEST(Resampler_ThdNMeetsPresetTargets)
+{
+    struct Case { ULONG In, Out; double Hz; };
+    const Case cases[] = { { 44100, 48000, 997 }, { 48000, 44100, 997 }, { 44100, 48000, 15013 }, { 48000, 44100, 15013 } };
+    const double limitDb[] = { -65.0, -95.0, -118.0 };
+
+    for (int q = SrcQuality_Low; q <= SrcQuality_High; ++q)
+    for (const Case& c : cases)
+    {
+        SrcUnderTest t;
+        CHECK_EQ(t.Init(c.In, c.Out, 2, (SrcQuality)q, DetectSimdLevel()), STATUS_SUCCESS);
+        std::vector<float> out = t.Run(Sine(c.Hz, c.In, c.In, 2, 0.5), 2);
+
+        double db = ThdN(out, 2, c.Hz, c.Out, 2 * t.Src.GetTaps());
+        printf("    %-6s %6u -> %6u  %5.0f Hz  THD+N %7.1f dB\n", kPresetNames[q], c.In, c.Out, c.Hz, db);
+        CHECK(db < limitDb[q]);
+    }
+}
+
+// 48 -> 44.1 kHz: a tone above the new Nyquist must be filtered out rather than
+// folded back into the audible band.
+HOST_TEST(Resampler_RejectsContentAboveOutputNyquist)
+{
+    const double limitDb[] = { -60.0, -80.0, -100.0 };
+    for (int q = SrcQuality_Low; q <= SrcQuality_High; ++q)
+    {
+        SrcUnderTest t;
+        CHECK_EQ(t.Init(48000, 44100, 1, (SrcQuality)q, DetectSimdLevel()), STATUS_SUCCESS);
+        std::vector<float> out = t.Run(Sine(23500, 48000, 48000, 1, 1.0), 1);
+        double db = RmsDb(out, 1, 2 * t.Src.GetTaps()) + 3.0;   // Relative to a full-scale sine
+        printf("    %-6s 23.5 kHz alias %7.1f dB\n", kPresetNames[q], db);
+        CHECK(db < limitDb[q]);
+    }
+}
+
+// The driver feeds whatever one timer period delivered; the result must not depend
+// on how the input and output were split across calls.
+HOST_TEST(Resampler_ChunkedStreamingMatchesOneShot)
+{
+    const ULONG channels = 2;
+    std::vector<float> in = Sine(440, 44100, 44100, channels, 0.7);
+
+    SrcUnderTest whole, chunked;
+    CHECK_EQ(whole.Init(44100, 48000, channels, SrcQuality_Medium, DetectSimdLevel()), STATUS_SUCCESS);
+    CHECK_EQ(chunked.Init(44100, 48000, channels, SrcQuality_Medium, DetectSimdLevel()), STATUS_SUCCESS);
+    std::vector<float> expected = whole.Run(in, channels);
+
+    std::mt19937 rng(5);
+    std::vector<float> got;
+    float staging[64 * channels];
+    ULONG fed = 0, total = 44100;
+    while (fed < total)
+    {
+        ULONG offer = 1 + rng() % 300;
+        if (offer > total - fed) offer = total - fed;
+        ULONG room = 1 + rng() % 64, consumed = 0;
+        ULONG produced = chunked.Src.Process(&in[(size_t)fed * channels], offer, &consumed, staging, room);
+        got.insert(got.end(), staging, staging + produced * channels);
+        fed += consumed;
+    }
+
+    CHECK_EQ(got.size(), expected.size());
+    CHECK(got == expected);
+
+    // 44.1 -> 48 kHz is L/M = 160/147; one second in is one second out.
+    CHECK_EQ(whole.Src.GetInterpolation(), (ULONG)160);
+    CHECK_EQ(whole.Src.GetDecimation(), (ULONG)147);
+    LONG drift = (LONG)(expected.size() / channels) - 48000;
+    CHECK(drift >= -1 && drift <= 1);
+}
+
+HOST_TEST(Resampler_SimdMatchesScalar)
+{
+    const ULONG channels = 6;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> in((size_t)9000 * channels);
+    for (float& v : in) v = dist(rng);
+
+    for (int q = SrcQuality_Low; q <= SrcQuality_High; ++q)
+    {
+        SrcUnderTest reference;
+        CHECK_EQ(reference.Init(48000, 44100, channels, (SrcQuality)q, SimdLevel_Scalar), STATUS_SUCCESS);
+        std::vector<float> expected = reference.Run(in, channels);
+
+        for (SimdLevel level : { SimdLevel_Sse2, DetectSimdLevel() })
+        {
+            SrcUnderTest t;
+            CHECK_EQ(t.Init(48000, 44100, channels, (SrcQuality)q, level), STATUS_SUCCESS);
+            std::vector<float> got = t.Run(in, channels);
+            CHECK_EQ(got.size(), expected.size());
+            for (size_t i = 0; i < got.size(); ++i)
+                CHECK(fabsf(got[i] - expected[i]) < 1e-5f);     // Only the summation order differs
+        }
+    }
+}
+
+HOST_TEST(Resampler_RejectsUnsupportedRatios)
+{
+    CHECK(Resampler::BankBytes(44100, 48000, SrcQuality_High) == 160 * 64 * sizeof(float));
+    CHECK(Resampler::BankBytes(11025, 192000, SrcQuality_Low) == 0);      // 2560 phases
+    CHECK(Resampler::BankBytes(0, 48000, SrcQuality_Low) == 0);
+
+    Resampler src;
+    float bank[16];
+    CHECK_EQ(src.Init(11025, 192000, 2, SrcQuality_Low, SimdLevel_Scalar, bank, sizeof(bank)), STATUS_NOT_SUPPORTED);
+    CHECK_EQ(src.Init(44100, 48000, 2, SrcQuality_Low, SimdLevel_Scalar, bank, sizeof(bank)), STATUS_BUFFER_TOO_SMALL);
+    CHECK_EQ(src.Init(44100, 48000, LEYLINE_SRC_MAX_CHANNELS + 1, SrcQuality_Low, SimdLevel_Scalar, bank, sizeof(bank)), STATUS_INVALID_PARAMETER);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARKS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Stereo, fed one 10 ms period at a time the way the cable DPC does. Cycles are TSC
+// ticks, so they track wall time rather than core clock under frequency scaling.
+HOST_BENCH(Resampler_CyclesPerFrame)
+{
+    const ULONG channels = 2, period = 441;
+    std::vector<float> in = Sine(997, 44100, period, channels, 0.5);
+    std::vector<float> out((size_t)(period + 64) * channels);
+
+    for (int q = SrcQuality_Low; q <= SrcQuality_High; ++q)
+    for (SimdLevel level : { SimdLevel_Scalar, SimdLevel_Sse2, DetectSimdLevel() })
+    {
+        SrcUnderTest t;
+        t.Init(44100, 48000, channels, (SrcQuality)q, level);
+
+        const int iterations = 4000;
+        ULONGLONG frames = 0;
+        uint64_t  t0 = HostTest::NowNs();
+        ULONGLONG c0 = __rdtsc();
+        for (int i = 0; i < iterations; ++i)
+        {
+            ULONG consumed;
+            frames += t.Src.Process(in.data(), period, &consumed, out.data(), period + 64);
+        }
+        ULONGLONG cycles = __rdtsc() - c0;
+        double ns = (double)(HostTest::NowNs() - t0);
+
+        char name[64];
+        snprintf(name, sizeof(name), "src_44k1_48k_%s_%s_per_frame", kPresetNames[q],
+                 level == SimdLevel_Avx2 ? "avx2" : level == SimdLevel_Sse2 ? "sse2" : "scalar");
+        HostTest::Report(name, ns / (double)frames, 0);
+        printf("    %-48s %12.2f cycles/frame\n", "", (double)cycles / (double)frames);
+    }
+}
@@ -0,0 +1,262 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RING BUFFER TESTS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_ringbuffer.h"
+
+#include <thread>
+#include <vector>
+
+HOST_TEST(RingBuffer_RejectsSizesThatAreNotAPowerOfTwo)
+{
+    static UCHAR storage[3000];
+    RingBuffer ring;
+    CHECK_EQ(ring.Init(storage, sizeof(storage)), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(ring.GetSize(), (SIZE_T)0);
+    CHECK_EQ(ring.AvailableWrite(), (SIZE_T)0);
+    CHECK_EQ(ring.Write(storage, 16), (SIZE_T)0);
+    CHECK_EQ(ring.Init(nullptr, 2048), STATUS_INVALID_PARAMETER);
+
+    CHECK_EQ(ring.Init(storage, 2048), STATUS_SUCCESS);
+    CHECK_EQ(ring.GetSize(), (SIZE_T)2048);
+    CHECK_EQ(ring.AvailableWrite(), (SIZE_T)2048);
+    CHECK_EQ(ring.AvailableRead(), (SIZE_T)0);
+}
+
+HOST_TEST(RingBuffer_UsesFullCapacityAndWraps)
+{
+    static UCHAR storage[64];
+    RingBuffer ring;
+    ring.Init(storage, sizeof(storage));
+
+    UCHAR in[48], out[48];
+    for (int i = 0; i < 48; ++i) in[i] = (UCHAR)i;
+
+    CHECK_EQ(ring.Write(in, 48), (SIZE_T)48);
+    CHECK_EQ(ring.Read(out, 40), (SIZE_T)40);
+
+    // 8 bytes left at the tail; the next 48 wrap around the end.
+    CHECK_EQ(ring.Write(in, 48), (SIZE_T)48);
+    CHECK_EQ(ring.AvailableWrite(), (SIZE_T)8);
+    CHECK_EQ(ring.Write(in, 48), (SIZE_T)8);
+    CHECK_EQ(ring.AvailableWrite(), (SIZE_T)0);
+
+    CHECK_EQ(ring.Read(out, 8), (SIZE_T)8);
+    CHECK_EQ(out[0], 40);
+    CHECK_EQ(ring.Read(out, 48), (SIZE_T)48);
+    for (int i = 0; i < 48; ++i) CHECK_EQ(out[i], (UCHAR)i);
+}
+
+HOST_TEST(RingBuffer_TwoThreadStressPreservesOrder)
+{
+    static UCHAR storage[4096];
+    RingBuffer ring;
+    ring.Init(storage, sizeof(storage));
+
+    const uint64_t total = 16ull * 1024 * 1024;
+    bool ok = true;
+
+    std::thread producer([&] {
+        UCHAR chunk[509];
+        uint64_t sent = 0;
+        while (sent < total)
+        {
+            SIZE_T len = (SIZE_T)((sent % 7) * 61 + 13);
+            if (len > sizeof(chunk)) len = sizeof(chunk);
+            if (len > total - sent) len = (SIZE_T)(total - sent);
+            for (SIZE_T i = 0; i < len; ++i) chunk[i] = (UCHAR)((sent + i) * 31);
+            SIZE_T done = 0;
+            while (done < len)
+            {
+                SIZE_T n = ring.Write(chunk + done, len - done);
+                if (n == 0) std::this_thread::yield();
+                done += n;
+            }
+            sent += len;
+        }
+    });
+
+    UCHAR chunk[733];
+    uint64_t received = 0;
+    while (received < total)
+    {
+        SIZE_T n = ring.Read(chunk, sizeof(chunk));
+        if (n == 0) { std::this_thread::yield(); continue; }
+        for (SIZE_T i = 0; i < n; ++i)
+            if (chunk[i] != (UCHAR)((received + i) * 31)) ok = false;
+        received += n;
+    }
+    producer.join();
+
+    CHECK(ok);
+    CHECK_EQ(received, total);
+    CHECK_EQ(ring.AvailableRead(), (SIZE_T)0);
+}
+
+HOST_TEST(RingBuffer_SpansSplitAtWrapAndCommitInPlace)
+{
+    static UCHAR storage[64];
+    RingBuffer ring;
+    ring.Init(storage, sizeof(storage));
+
+    UCHAR scratch[56];
+    CHECK_EQ(ring.Write(scratch, 56), (SIZE_T)56);
+    CHECK_EQ(ring.Read(scratch, 56), (SIZE_T)56);
+
+    // Write cursor sits at offset 56: a 20-byte acquire wraps after 8 bytes.
+    RingSpans spans;
+    CHECK_EQ(ring.AcquireWrite(20, &spans), (SIZE_T)20);
+    CHECK(spans.First.Data == storage + 56);
+    CHECK_EQ(spans.First.Length, (SIZE_T)8);
+    CHECK(spans.Second.Data == storage);
+    CHECK_EQ(spans.Second.Length, (SIZE_T)12);
+
+    for (SIZE_T i = 0; i < spans.First.Length; ++i)  spans.First.Data[i]  = (UCHAR)(100 + i);
+    for (SIZE_T i = 0; i < spans.Second.Length; ++i) spans.Second.Data[i] = (UCHAR)(108 + i);
+
+    // Nothing is visible until the commit.
+    CHECK_EQ(ring.AvailableRead(), (SIZE_T)0);
+    ring.CommitWrite(20);
+
+    CHECK_EQ(ring.PeekRead(64, &spans), (SIZE_T)20);
+    CHECK_EQ(spans.First.Length, (SIZE_T)8);
+    CHECK_EQ(spans.First.Data[0], 100);
+    CHECK_EQ(spans.Second.Data[11], 119);
+
+    // Partial release keeps the remainder readable.
+    ring.ReleaseRead(10);
+    CHECK_EQ(ring.PeekRead(64, &spans), (SIZE_T)10);
+    CHECK_EQ(spans.First.Data[0], 110);
+    CHECK_EQ(spans.Second.Length, (SIZE_T)0);
+    ring.ReleaseRead(10);
+    CHECK_EQ(ring.AvailableWrite(), (SIZE_T)64);
+}
+
+HOST_TEST(RingBuffer_SpanAcquireIsBoundedByFreeSpace)
+{
+    static UCHAR storage[32];
+    RingBuffer ring;
+    ring.Init(storage, sizeof(storage));
+
+    RingSpans spans;
+    CHECK_EQ(ring.AcquireWrite(24, &spans), (SIZE_T)24);
+    ring.CommitWrite(24);
+    CHECK_EQ(ring.AcquireWrite(24, &spans), (SIZE_T)8);
+    CHECK_EQ(spans.First.Length + spans.Second.Length, (SIZE_T)8);
+    ring.CommitWrite(0);
+    CHECK_EQ(ring.AvailableRead(), (SIZE_T)24);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARKS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Two-thread throughput at render-period sized chunks (stereo float frames).
+HOST_BENCH(RingBuffer_TwoThreadThroughput)
+{
+    static UCHAR storage[64 * 1024];
+    const SIZE_T periodBytes[] = { 32 * 8, 128 * 8, 480 * 8, 1024 * 8 };
+
+    for (SIZE_T chunkBytes : periodBytes)
+    {
+        RingBuffer ring;
+        ring.Init(storage, sizeof(storage));
+        const uint64_t total = 256ull * 1024 * 1024;
+
+        std::vector<UCHAR> src(chunkBytes, 0x5A), dst(chunkBytes);
+        uint64_t start = HostTest::NowNs();
+
+        std::thread producer([&] {
+            uint64_t sent = 0;
+            while (sent < total)
+            {
+                SIZE_T n = ring.Write(src.data(), chunkBytes);
+                if (n == 0) { std::this_thread::yield(); continue; }
+                sent += n;
+            }
+        });
+
+        uint64_t received = 0, ops = 0;
+        while (received < total)
+        {
+            SIZE_T n = ring.Read(dst.data(), chunkBytes);
+            if (n == 0) { std::this_thread::yield(); continue; }
+            received += n;
+            ++ops;
+        }
+        producer.join();
+
+        double ns = (double)(HostTest::NowNs() - start);
+        char name[64];
+        snprintf(name, sizeof(name), "ring_spsc_%zuB", chunkBytes);
+        HostTest::Report(name, ns / (double)ops, (double)total * 1e9 / ns);
+    }
+}
+
+// Copy mode stages every period through a caller buffer; span mode generates and
+// consumes samples directly in the ring. Both touch each sample exactly twice.
+HOST_BENCH(RingBuffer_CopyVersusSpanMode)
+{
+    const SIZE_T frameBytes = 2 * sizeof(float);
+    const SIZE_T periods[]  = { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    static UCHAR storage[256 * 1024];
+
+    for (SIZE_T frames : periods)
+    {
+        const SIZE_T   bytes      = frames * frameBytes;
+        const uint64_t iterations = (512ull * 1024 * 1024) / bytes;
+        std::vector<float> staging(frames * 2);
+        volatile float sink = 0;
+
+        for (int mode = 0; mode < 2; ++mode)
+        {
+            RingBuffer ring;
+            ring.Init(storage, sizeof(storage));
+            float acc = 0;
+
+            uint64_t start = HostTest::NowNs();
+            for (uint64_t it = 0; it < iterations; ++it)
+            {
+                if (mode == 0)
+                {
+                    for (SIZE_T i = 0; i < frames * 2; ++i) staging[i] = (float)i;
+                    ring.Write(reinterpret_cast<const UCHAR*>(staging.data()), bytes);
+                    ring.Read(reinterpret_cast<PUCHAR>(staging.data()), bytes);
+                    for (SIZE_T i = 0; i < frames * 2; ++i) acc += staging[i];
+                }
+                else
+                {
+                    RingSpans spans;
+                    ring.AcquireWrite(bytes, &spans);
+                    RingSpan parts[2] = { spans.First, spans.Second };
+                    for (const RingSpan& part : parts)
+                    {
+                        float* f = reinterpret_cast<float*>(part.Data);
+                        for (SIZE_T i = 0; i < part.Length / sizeof(float); ++i) f[i] = (float)i;
+                    }
+                    ring.CommitWrite(bytes);
+
+                    ring.PeekRead(bytes, &spans);
+                    parts[0] = spans.First; parts[1] = spans.Second;
+                    for (const RingSpan& part : parts)
+                    {
+                        const float* f = reinterpret_cast<const float*>(part.Data);
+                        for (SIZE_T i = 0; i < part.Length / sizeof(float); ++i) acc += f[i];
+                    }
+                    ring.ReleaseRead(bytes);
+                }
+            }
+            double ns = (double)(HostTest::NowNs() - start);
+            sink = acc;
+
+            char name[64];
+            snprintf(name, sizeof(name), "ring_%s_%zu_frames", mode == 0 ? "copy" : "span", frames);
+            HostTest::Report(name, ns / (double)iterations, (double)(iterations * bytes) * 1e9 / ns);
+        }
+        (void)sink;
+    }
+}
@@ -0,0 +1,421 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SHARED PARAMETER TESTS
+// The v2 layout and its v1 compatibility, the position seqlock under several
+// writers and readers the way the timer DPC, GetPosition and the APO/HSA hit it,
+// and the per-stream slots under streams coming and going.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_shared.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Every field of a published position derives from one counter, with the 64-bit
+// ones spread over both halves so a torn QPC shows too.
+static LeylinePosition PositionFor(ULONG n)
+{
+    LeylinePosition p;
+    p.Position   = n;
+    p.BufferSize = n * 3 + 1;
+    p.ByteRate   = ~n;
+    p.StartQpc   = ((LONG64)n << 32) | n;
+    p.UpdateQpc  = ((LONG64)~n << 32) | (n * 5);
+    return p;
+}
+
+static bool IsConsistent(const LeylinePosition& p)
+{
+    LeylinePosition expected = PositionFor(p.Position);
+    return p.BufferSize == expected.BufferSize && p.ByteRate == expected.ByteRate &&
+           p.StartQpc == expected.StartQpc && p.UpdateQpc == expected.UpdateQpc;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LAYOUT
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// v1 readers hard-code these offsets; they must never move.
+HOST_TEST(Shared_V1LayoutIsUnchanged)
+{
+    CHECK_EQ(offsetof(LeylineSharedParameters, Legacy), (size_t)0);
+    CHECK_EQ(offsetof(LeylineSharedParametersV1, QpcFrequency), (size_t)12);
+    CHECK_EQ(offsetof(LeylineSharedParametersV1, BufferSize), (size_t)36);
+    CHECK_EQ(offsetof(LeylineSharedParametersV1, WritePos), (size_t)44);
+    CHECK_EQ(offsetof(LeylineSharedParametersV1, ReadPos), (size_t)48);
+    CHECK_EQ(offsetof(LeylineSharedParametersV1, Meter), (size_t)52);
+}
+
+// Each writer's fields start a line, no two writers share one, and the 64-bit
+// fields are naturally aligned.
+HOST_TEST(Shared_V2GroupsWritersOnSeparateLines)
+{
+    const size_t line = SYSTEM_CACHE_ALIGNMENT_SIZE;
+    const size_t starts[] = {
+        offsetof(LeylineSharedParameters, Header),
+        offsetof(LeylineSharedParameters, Control),
+        offsetof(LeylineSharedParameters, Render),
+        offsetof(LeylineSharedParameters, Capture),
+        offsetof(LeylineSharedParameters, Meter),
+        offsetof(LeylineSharedParameters, Streams),
+        sizeof(LeylineSharedParameters),
+    };
+    CHECK(starts[0] >= sizeof(LeylineSharedParametersV1));
+    for (size_t i = 0; i + 1 < sizeof(starts) / sizeof(starts[0]); ++i)
+    {
+        CHECK_EQ(starts[i] % line, (size_t)0);
+        CHECK(starts[i + 1] > starts[i]);
+    }
+
+    CHECK_EQ(offsetof(LeylinePositionBlock, StartQpc) % 8, (size_t)0);
+    CHECK_EQ(offsetof(LeylinePositionBlock, UpdateQpc) % 8, (size_t)0);
+    CHECK_EQ(offsetof(LeylineSharedHeader, QpcFrequency) % 8, (size_t)0);
+    CHECK_EQ(sizeof(LeylineStreamSlot), line);
+    CHECK_EQ(offsetof(LeylineStreamSlot, Frames) % 8, (size_t)0);
+}
+
+HOST_TEST(Shared_InitFillsBothVersions)
+{
+    static LeylineSharedParameters params;
+    RtlZeroMemory(&params, sizeof(params));
+    CHECK_EQ(SharedParameterBlock::GetVersion(&params), (ULONG)1);  // As an older driver leaves it
+
+    SharedParameterBlock::Init(&params, 10000000, 128 * 1024, 192000);
+    CHECK_EQ(SharedParameterBlock::GetVersion(&params), (ULONG)LEYLINE_SHARED_PARAMS_VERSION);
+    CHECK_EQ(params.Header.Size, (ULONG)sizeof(LeylineSharedParameters));
+    CHECK_EQ(params.Header.QpcFrequency, (LONG64)10000000);
+    CHECK_EQ(params.Legacy.QpcFrequency, (LONGLONG)10000000);
+    CHECK_EQ(params.Legacy.BufferSize, (ULONG)(128 * 1024));
+    CHECK_EQ(params.Legacy.ByteRate, (ULONG)192000);
+    CHECK_EQ(BitsToFloat(SharedParameterBlock::GetMasterGainBits(&params)), 1.0f);
+}
+
+// A v1 client writes the legacy field and is heard until a v2 client takes over
+// through the control line.
+HOST_TEST(Shared_MasterGainFollowsV1UntilV2Writes)
+{
+    static LeylineSharedParameters params;
+    RtlZeroMemory(&params, sizeof(params));
+    SharedParameterBlock::Init(&params, 10000000, 4096, 192000);
+
+    params.Legacy.MasterGainBits = FloatToBits(0.25f);
+    CHECK_EQ(BitsToFloat(SharedParameterBlock::GetMasterGainBits(&params)), 0.25f);
+
+    params.Control.MasterGainBits = FloatToBits(0.5f);
+    CHECK_EQ(BitsToFloat(SharedParameterBlock::GetMasterGainBits(&params)), 0.5f);
+
+    params.Legacy.MasterGainBits = FloatToBits(0.75f);
+    CHECK_EQ(BitsToFloat(SharedParameterBlock::GetMasterGainBits(&params)), 0.5f);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SEQLOCK
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// A writer that finds the block held drops its update rather than waiting.
+HOST_TEST(Shared_ContendedPublishIsDropped)
+{
+    LeylinePositionBlock block = {};
+    CHECK(SharedParameterBlock::PublishPosition(&block, PositionFor(1)));
+
+    block.Sequence |= 1;    // Another writer mid-update
+    CHECK(!SharedParameterBlock::PublishPosition(&block, PositionFor(2)));
+    block.Sequence += 1;
+
+    LeylinePosition p;
+    SharedParameterBlock::ReadPosition(&block, &p);
+    CHECK_EQ(p.Position, (ULONG)1);
+    CHECK(SharedParameterBlock::PublishPosition(&block, PositionFor(3)));
+    SharedParameterBlock::ReadPosition(&block, &p);
+    CHECK_EQ(p.Position, (ULONG)3);
+    CHECK_EQ(block.Sequence & 1, 0);
+}
+
+// Three writers (two streams' DPCs and a GetPosition) and four readers on one
+// position line. No reader may ever see fields from two different updates, and
+// each writer's counter only moves forward as a reader sees it.
+HOST_TEST(Shared_PositionTortureNeverTears)
+{
+    const int writers = 3, readers = 4;
+    const ULONG perWriter = 400000;
+    LeylinePositionBlock block = {};
+    SharedParameterBlock::PublishPosition(&block, PositionFor(0));
+
+    std::atomic<bool>      done(false);
+    std::atomic<ULONG>     torn(0), backwards(0);
+    std::atomic<ULONGLONG> reads(0), published(0);
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&] {
+            ULONG last[writers] = {};
+            ULONGLONG n = 0;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                LeylinePosition p;
+                SharedParameterBlock::ReadPosition(&block, &p);
+                if (!IsConsistent(p)) torn.fetch_add(1);
+                // Writer w publishes w + writers * k.
+                ULONG w = p.Position % writers;
+                if (p.Position < last[w]) backwards.fetch_add(1);
+                last[w] = p.Position;
+                ++n;
+            }
+            reads.fetch_add(n);
+        });
+    }
+
+    std::vector<std::thread> producers;
+    for (int w = 0; w < writers; ++w)
+    {
+        producers.emplace_back([&, w] {
+            ULONGLONG n = 0;
+            for (ULONG k = 1; k <= perWriter; ++k)
+                n += SharedParameterBlock::PublishPosition(&block, PositionFor(w + writers * k));
+            published.fetch_add(n);
+        });
+    }
+    for (std::thread& t : producers) t.join();
+    done = true;
+    for (std::thread& t : threads) t.join();
+
+    printf("    %llu published, %llu dropped, %llu reads\n", (unsigned long long)published.load(),
+           (unsigned long long)(writers * perWriter - published.load()), (unsigned long long)reads.load());
+    CHECK_EQ(torn.load(), (ULONG)0);
+    CHECK_EQ(backwards.load(), (ULONG)0);
+    CHECK(published.load() > 0);
+    CHECK(reads.load() > 0);
+    CHECK_EQ(block.Sequence & 1, 0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// STREAM SLOTS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// What a stream with id `id` publishes: the format from the id, the position from
+// the frame count, so a reader can tell any mix of two updates.
+static LeylineStreamInfo StreamFor(ULONG id)
+{
+    LeylineStreamInfo info = {};
+    info.StreamId     = id;
+    info.Direction    = id & 1 ? LEYLINE_STREAM_CAPTURE : LEYLINE_STREAM_RENDER;
+    info.SampleFormat = id % 3;
+    info.Channels     = id % 8 + 1;
+    info.SampleRate   = 8000 * (id % 24 + 1);
+    return info;
+}
+
+static ULONG PositionAt(ULONG id, ULONGLONG frames) { return (ULONG)(frames * 4) ^ id; }
+
+static bool IsConsistent(const LeylineStreamInfo& info)
+{
+    LeylineStreamInfo expected = StreamFor(info.StreamId);
+    return info.Direction == expected.Direction && info.SampleFormat == expected.SampleFormat &&
+           info.Channels == expected.Channels && info.SampleRate == expected.SampleRate &&
+           info.Position == PositionAt(info.StreamId, info.Frames) &&
+           info.UpdateQpc == (LONG64)info.Frames * 10 && info.State <= 3;
+}
+
+HOST_TEST(Shared_StreamSlotsClaimAndRelease)
+{
+    static LeylineSharedParameters params;
+    RtlZeroMemory(&params, sizeof(params));
+
+    LeylineStreamSlot* slots[LEYLINE_STREAM_SLOTS];
+    for (ULONG i = 0; i < LEYLINE_STREAM_SLOTS; ++i)
+    {
+        slots[i] = SharedParameterBlock::ClaimStreamSlot(&params, StreamFor(i + 1));
+        CHECK(slots[i] != nullptr);
+        for (ULONG j = 0; j < i; ++j) CHECK(slots[j] != slots[i]);
+    }
+    CHECK(SharedParameterBlock::ClaimStreamSlot(&params, StreamFor(99)) == nullptr);
+
+    LeylineStreamInfo info;
+    CHECK(SharedParameterBlock::ReadStreamSlot(slots[4], &info));
+    CHECK_EQ(info.StreamId, (ULONG)5);
+    CHECK_EQ(info.State, (ULONG)0);
+    CHECK_EQ(info.Frames, (ULONGLONG)0);
+
+    SharedParameterBlock::SetStreamState(slots[4], 3);
+    CHECK(SharedParameterBlock::PublishStreamProgress(slots[4], 1234, 480, 99));
+    SharedParameterBlock::CountUnderrun(slots[4]);
+    SharedParameterBlock::CountOverrun(slots[4]);
+    SharedParameterBlock::CountOverrun(slots[4]);
+    CHECK(SharedParameterBlock::ReadStreamSlot(slots[4], &info));
+    CHECK_EQ(info.State, (ULONG)3);
+    CHECK_EQ(info.Position, (ULONG)1234);
+    CHECK_EQ(info.Frames, (ULONGLONG)480);
+    CHECK_EQ(info.UpdateQpc, (LONG64)99);
+    CHECK_EQ(info.Underruns, (ULONG)1);
+    CHECK_EQ(info.Overruns, (ULONG)2);
+
+    // Freed, the slot reads as empty and the next stream gets it with clean counters.
+    SharedParameterBlock::ReleaseStreamSlot(slots[4]);
+    CHECK(!SharedParameterBlock::ReadStreamSlot(slots[4], &info));
+    LeylineStreamSlot* again = SharedParameterBlock::ClaimStreamSlot(&params, StreamFor(99));
+    CHECK(again == slots[4]);
+    CHECK(SharedParameterBlock::ReadStreamSlot(again, &info));
+    CHECK_EQ(info.StreamId, (ULONG)99);
+    CHECK_EQ(info.Underruns, (ULONG)0);
+    CHECK_EQ(info.Overruns, (ULONG)0);
+}
+
+// Streams are created, run and destroyed on eight threads while four readers walk
+// the slots. Fewer streams than slots, so every claim has to succeed; a reader
+// must never see a slot mixing two streams or two updates of one.
+HOST_TEST(Shared_StreamSlotsChurnUnderReaders)
+{
+    static LeylineSharedParameters params;
+    RtlZeroMemory(&params, sizeof(params));
+    SharedParameterBlock::Init(&params, 10000000, 4096, 192000);
+
+    const int streams = 8, readers = 4, lifetimes = 5000;
+    std::atomic<bool>      done(false);
+    std::atomic<ULONG>     torn(0), failedClaims(0), nextId(1);
+    std::atomic<ULONGLONG> reads(0), seen(0);
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&] {
+            ULONGLONG n = 0, listed = 0;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                for (ULONG i = 0; i < LEYLINE_STREAM_SLOTS; ++i)
+                {
+                    LeylineStreamInfo info;
+                    if (!SharedParameterBlock::ReadStreamSlot(&params.Streams[i], &info)) continue;
+                    if (!IsConsistent(info)) torn.fetch_add(1);
+                    ++listed;
+                }
+                ++n;
+                std::this_thread::yield();
+            }
+            reads.fetch_add(n);
+            seen.fetch_add(listed);
+        });
+    }
+
+    std::vector<std::thread> churn;
+    for (int s = 0; s < streams; ++s)
+    {
+        churn.emplace_back([&] {
+            for (int life = 0; life < lifetimes; ++life)
+            {
+                ULONG id = nextId.fetch_add(1);
+                LeylineStreamSlot* slot = SharedParameterBlock::ClaimStreamSlot(&params, StreamFor(id));
+                if (!slot) { failedClaims.fetch_add(1); continue; }
+
+                // Periods with a yield between them, so readers get to see the
+                // stream while it lives even on a single core.
+                SharedParameterBlock::SetStreamState(slot, 3);
+                for (ULONGLONG frames = 480; frames <= 480 * 4; frames += 480)
+                {
+                    SharedParameterBlock::PublishStreamProgress(slot, PositionAt(id, frames), frames, (LONG64)frames * 10);
+                    std::this_thread::yield();
+                }
+                SharedParameterBlock::CountUnderrun(slot);
+                SharedParameterBlock::SetStreamState(slot, 0);
+                SharedParameterBlock::ReleaseStreamSlot(slot);
+            }
+        });
+    }
+    for (std::thread& t : churn) t.join();
+    done = true;
+    for (std::thread& t : threads) t.join();
+
+    printf("    %llu slot scans, %llu streams seen, %u torn\n", (unsigned long long)reads.load(),
+           (unsigned long long)seen.load(), torn.load());
+    CHECK_EQ(torn.load(), (ULONG)0);
+    CHECK_EQ(failedClaims.load(), (ULONG)0);
+    CHECK(seen.load() > 0);
+    for (ULONG i = 0; i < LEYLINE_STREAM_SLOTS; ++i)
+    {
+        LeylineStreamInfo info;
+        CHECK(!SharedParameterBlock::ReadStreamSlot(&params.Streams[i], &info));
+        CHECK_EQ(params.Streams[i].Owner, 0);
+        CHECK_EQ(params.Streams[i].Sequence & 1, 0);
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARKS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Reader latency for a render position snapshot: idle, with writers hammering the
+// capture line and meter next door, and with them on the render line itself. Only
+// the last should cost much; the middle case is what the line split buys. Timed in
+// batches so the clock read stays out of the per-read figure.
+HOST_BENCH(Shared_ReaderLatencyUnderWriters)
+{
+    static LeylineSharedParameters params;
+    RtlZeroMemory(&params, sizeof(params));
+    SharedParameterBlock::Init(&params, 10000000, 4096, 192000);
+    SharedParameterBlock::PublishPosition(&params.Render, PositionFor(0));
+
+    const int batch = 64, batches = 20000;
+    const char* names[] = { "Shared_ReadPosition_Idle", "Shared_ReadPosition_OtherLinesBusy",
+                            "Shared_ReadPosition_SameLineBusy" };
+    double mean[3] = {};
+
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        std::atomic<bool> done(false);
+        std::vector<std::thread> writers;
+        for (int w = 0; mode > 0 && w < 2; ++w)
+        {
+            writers.emplace_back([&, w] {
+                ULONG n = 0;
+                while (!done.load(std::memory_order_relaxed))
+                {
+                    if (mode == 2)
+                        SharedParameterBlock::PublishPosition(&params.Render, PositionFor(++n));
+                    else if (w == 0)
+                        SharedParameterBlock::PublishPosition(&params.Capture, PositionFor(++n));
+                    else
+                    {
+                        MeterReading r = {};
+                        r.Channels = 2;
+                        r.Clips[0] = ++n;
+                        PeakMeter::Publish(&params.Meter, r);
+                    }
+                }
+            });
+        }
+
+        std::vector<double> samples(batches);
+        ULONG torn = 0;
+        for (int b = 0; b < batches; ++b)
+        {
+            uint64_t t0 = HostTest::NowNs();
+            for (int i = 0; i < batch; ++i)
+            {
+                LeylinePosition p;
+                SharedParameterBlock::ReadPosition(&params.Render, &p);
+                torn += !IsConsistent(p);
+            }
+            samples[b] = (double)(HostTest::NowNs() - t0) / batch;
+        }
+        done = true;
+        for (std::thread& t : writers) t.join();
+
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (double s : samples) sum += s;
+        mean[mode] = sum / batches;
+        HostTest::Report(names[mode], mean[mode], 0);
+        printf("    p50 %.1f ns, p99 %.1f ns, max %.1f ns per read\n",
+               samples[batches / 2], samples[batches * 99 / 100], samples[batches - 1]);
+        CHECK_EQ(torn, (ULONG)0);
+    }
+
+    // Generous: shared CI hosts are noisy, but a reader sharing a line with the
+    // meter or the other direction would be several times the idle cost.
+    CHECK(mean[1] < mean[0] * 4 + 20);
+}
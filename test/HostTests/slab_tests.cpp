@@ -0,0 +1,314 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// OBJECT HEAP TESTS
+// Slab hits and misses, slot reuse and alignment, delete through a base class,
+// per-tag counters and the full tag table, plus concurrent churn. The benchmark
+// opens and closes a million stream-sized objects through the slab, through the
+// heap with no slab, and through plain new/delete.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_slab.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Stands in for CMiniportWaveRTStream: reference-counted base with a virtual
+// destructor, cache-aligned state, a few KB in all.
+class FakeUnknown
+{
+public:
+    virtual ~FakeUnknown() {}
+};
+
+class FakeStream : public FakeUnknown, public HeapObject
+{
+public:
+    explicit FakeStream(ULONG id) : Id(id) {}
+    ~FakeStream() override { *Destroyed += 1; }
+
+    ULONG                       Id;
+    int*                        Destroyed = &s_Sink;
+    DECLSPEC_CACHEALIGN LONG64  Position;
+    UCHAR                       State[4096];
+
+    static int s_Sink;
+};
+
+int FakeStream::s_Sink = 0;
+
+// Pool tags spelled out: GCC warns on multi-character constants.
+static const ULONG kStreamTag = 0x54535753;     // 'TSWS'
+static const ULONG kRouteTag  = 0x54535254;     // 'TSRT'
+static const ULONG kBankTag   = 0x54535352;     // 'TSSR'
+static const ULONG kOtherTag  = 0x54533030;     // 'TS00'
+
+static const LeylinePoolTagStats* FindTag(const LeylineObjectStats& stats, ULONG tag)
+{
+    for (ULONG t = 0; t < stats.Tags; ++t)
+    {
+        if (stats.Tag[t].Tag == tag) return &stats.Tag[t];
+    }
+    return nullptr;
+}
+
+HOST_TEST(Slab_StreamsComeFromTheSlabUntilItIsFull)
+{
+    ObjectHeap heap;
+    CHECK_EQ(heap.Reserve(kStreamTag, sizeof(FakeStream), 4), STATUS_SUCCESS);
+    CHECK(heap.IsReady());
+
+    FakeStream* s[5];
+    for (ULONG i = 0; i < 5; ++i)
+    {
+        s[i] = new (heap, kStreamTag) FakeStream(i);
+        CHECK(s[i] != nullptr);
+        CHECK_EQ(s[i]->Id, i);
+        CHECK_EQ((ULONG_PTR)s[i] % SYSTEM_CACHE_ALIGNMENT_SIZE, (ULONG_PTR)0);
+    }
+
+    LeylineObjectStats stats;
+    heap.GetStats(&stats);
+    CHECK_EQ(stats.Slabs, (ULONG)1);
+    CHECK_EQ(stats.SlabHits, (ULONG)4);
+    CHECK_EQ(stats.SlabMisses, (ULONG)1);     // The fifth
+    CHECK_EQ(stats.Slab[0].InUse, (ULONG)4);
+    const LeylinePoolTagStats* tag = FindTag(stats, kStreamTag);
+    CHECK(tag != nullptr);
+    CHECK_EQ(tag->Live, (ULONG)5);
+    CHECK_EQ(tag->Bytes, (ULONG64)(5 * sizeof(FakeStream)));
+
+    for (FakeStream* stream : s) delete stream;
+    heap.GetStats(&stats);
+    tag = FindTag(stats, kStreamTag);
+    CHECK_EQ(tag->Live, (ULONG)0);
+    CHECK_EQ(tag->Peak, (ULONG)5);
+    CHECK_EQ(tag->Allocations, (ULONG)5);
+    CHECK_EQ(tag->Bytes, (ULONG64)0);
+    CHECK_EQ(tag->PeakBytes, (ULONG64)(5 * sizeof(FakeStream)));
+    CHECK_EQ(stats.Slab[0].InUse, (ULONG)0);
+    CHECK_EQ(stats.Slab[0].HighWater, (ULONG)4);
+    heap.Shutdown();
+}
+
+HOST_TEST(Slab_ReusedSlotsAreZeroed)
+{
+    ObjectHeap heap;
+    CHECK_EQ(heap.Reserve(kStreamTag, sizeof(FakeStream), 1), STATUS_SUCCESS);
+
+    FakeStream* a = new (heap, kStreamTag) FakeStream(1);
+    RtlFillMemory(a->State, sizeof(a->State), 0xA5);
+    a->Position = -1;
+    delete a;
+
+    FakeStream* b = new (heap, kStreamTag) FakeStream(2);
+    CHECK(b == a);
+    CHECK_EQ(b->Position, (LONG64)0);
+    for (UCHAR byte : b->State) CHECK_EQ(byte, (UCHAR)0);
+    delete b;
+
+    LeylineObjectStats stats;
+    heap.GetStats(&stats);
+    CHECK_EQ(stats.SlabHits, (ULONG)2);
+    CHECK_EQ(stats.SlabMisses, (ULONG)0);
+    heap.Shutdown();
+}
+
+HOST_TEST(Slab_DeleteThroughTheBaseRunsEveryDestructor)
+{
+    ObjectHeap heap;
+    CHECK_EQ(heap.Reserve(kStreamTag, sizeof(FakeStream), 2), STATUS_SUCCESS);
+
+    int destroyed = 0;
+    FakeStream* stream = new (heap, kStreamTag) FakeStream(7);
+    stream->Destroyed = &destroyed;
+    FakeUnknown* unknown = stream;
+    delete unknown;
+    CHECK_EQ(destroyed, 1);
+
+    LeylineObjectStats stats;
+    heap.GetStats(&stats);
+    CHECK_EQ(FindTag(stats, kStreamTag)->Live, (ULONG)0);
+    CHECK_EQ(stats.Slab[0].InUse, (ULONG)0);
+    heap.Shutdown();
+}
+
+HOST_TEST(Slab_UnslabbedTagsAreCountedByTag)
+{
+    ObjectHeap heap;
+    PVOID route  = heap.Allocate(200, kRouteTag);
+    PVOID bank   = heap.Allocate(64 * 1024, kBankTag);
+    PVOID route2 = heap.Allocate(300, kRouteTag);
+    CHECK(route && bank && route2);
+    CHECK_EQ(((PUCHAR)bank)[64 * 1024 - 1], (UCHAR)0);
+    for (PVOID object : { route, bank, route2 })
+        CHECK_EQ((ULONG_PTR)object % SYSTEM_CACHE_ALIGNMENT_SIZE, (ULONG_PTR)0);
+
+    LeylineObjectStats stats;
+    heap.GetStats(&stats);
+    CHECK_EQ(stats.Slabs, (ULONG)0);
+    CHECK_EQ(stats.Tags, (ULONG)2);
+    CHECK_EQ(stats.SlabHits + stats.SlabMisses, (ULONG)0);     // No slab for either tag
+    CHECK_EQ(FindTag(stats, kRouteTag)->Live, (ULONG)2);
+    CHECK_EQ(FindTag(stats, kRouteTag)->Bytes, (ULONG64)500);
+    CHECK_EQ(FindTag(stats, kBankTag)->Bytes, (ULONG64)(64 * 1024));
+
+    ObjectHeap::Free(route);
+    ObjectHeap::Free(nullptr);
+    heap.GetStats(&stats);
+    CHECK_EQ(FindTag(stats, kRouteTag)->Live, (ULONG)1);
+    CHECK_EQ(FindTag(stats, kRouteTag)->Bytes, (ULONG64)300);
+    CHECK_EQ(FindTag(stats, kRouteTag)->PeakBytes, (ULONG64)500);
+
+    ObjectHeap::Free(route2);
+    ObjectHeap::Free(bank);
+    heap.GetStats(&stats);
+    CHECK_EQ(FindTag(stats, kRouteTag)->Live + FindTag(stats, kBankTag)->Live, (ULONG)0);
+}
+
+HOST_TEST(Slab_TagsPastTheTableStillAllocate)
+{
+    ObjectHeap heap;
+    std::vector<PVOID> held;
+    for (ULONG t = 0; t < LEYLINE_SLAB_MAX_TAGS + 3; ++t)
+    {
+        PVOID p = heap.Allocate(32, kOtherTag + t);
+        CHECK(p != nullptr);
+        held.push_back(p);
+    }
+
+    LeylineObjectStats stats;
+    heap.GetStats(&stats);
+    CHECK_EQ(stats.Tags, (ULONG)LEYLINE_SLAB_MAX_TAGS);
+    CHECK_EQ(stats.Untracked, (ULONG)3);
+
+    for (PVOID p : held) ObjectHeap::Free(p);
+    heap.GetStats(&stats);
+    for (ULONG t = 0; t < stats.Tags; ++t) CHECK_EQ(stats.Tag[t].Live, (ULONG)0);
+}
+
+HOST_TEST(Slab_ReserveRejectsBadSlabs)
+{
+    ObjectHeap heap;
+    CHECK_EQ(heap.Reserve(0, 64, 4), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(heap.Reserve(kOtherTag + 1, 0, 4), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(heap.Reserve(kOtherTag + 1, 64, 0), STATUS_INVALID_PARAMETER);
+    CHECK_EQ(heap.Reserve(kOtherTag + 1, 64, LEYLINE_SLAB_MAX_OBJECTS + 1), STATUS_INVALID_PARAMETER);
+    CHECK(!heap.IsReady());
+
+    for (ULONG s = 0; s < LEYLINE_SLAB_MAX_SLABS; ++s)
+        CHECK_EQ(heap.Reserve(kOtherTag + 1 + s, 64, LEYLINE_SLAB_MAX_OBJECTS), STATUS_SUCCESS);
+    CHECK_EQ(heap.Reserve(kOtherTag + 1, 64, 1), STATUS_INVALID_PARAMETER);   // Tag already slabbed
+    CHECK_EQ(heap.Reserve(kOtherTag + 9, 64, 1), STATUS_INVALID_PARAMETER);   // No slab left
+
+    // A too-big object under a slabbed tag is a miss, not a failure.
+    PVOID big = heap.Allocate(65, kOtherTag + 1);
+    CHECK(big != nullptr);
+    LeylineObjectStats stats;
+    heap.GetStats(&stats);
+    CHECK_EQ(stats.SlabMisses, (ULONG)1);
+    ObjectHeap::Free(big);
+    heap.Shutdown();
+    CHECK(!heap.IsReady());
+}
+
+HOST_TEST(Slab_ConcurrentChurnNeverSharesASlot)
+{
+    ObjectHeap heap;
+    CHECK_EQ(heap.Reserve(kStreamTag, sizeof(FakeStream), 6), STATUS_SUCCESS);
+
+    const int threads = 4, rounds = 5000;
+    std::atomic<int> collisions(0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+    {
+        pool.emplace_back([&, t]
+        {
+            for (int i = 0; i < rounds; ++i)
+            {
+                FakeStream* a = new (heap, kStreamTag) FakeStream((ULONG)t);
+                FakeStream* b = new (heap, kStreamTag) FakeStream((ULONG)t);
+                std::this_thread::yield();
+                if (a->Id != (ULONG)t || b->Id != (ULONG)t) collisions++;
+                delete a;
+                delete b;
+            }
+        });
+    }
+    for (std::thread& th : pool) th.join();
+    CHECK_EQ(collisions.load(), 0);
+
+    LeylineObjectStats stats;
+    heap.GetStats(&stats);
+    const LeylinePoolTagStats* tag = FindTag(stats, kStreamTag);
+    CHECK_EQ(tag->Live, (ULONG)0);
+    CHECK_EQ(tag->Bytes, (ULONG64)0);
+    CHECK_EQ(tag->Allocations, (ULONG)(threads * rounds * 2));
+    CHECK_EQ(stats.SlabHits + stats.SlabMisses, (ULONG)(threads * rounds * 2));
+    CHECK_EQ(stats.Slab[0].InUse, (ULONG)0);
+    CHECK(stats.Slab[0].HighWater <= 6);
+    heap.Shutdown();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARKS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class PlainStream : public FakeUnknown
+{
+public:
+    explicit PlainStream(ULONG id) : Id(id), Position(0) { RtlZeroMemory(State, sizeof(State)); }
+
+    ULONG                       Id;
+    DECLSPEC_CACHEALIGN LONG64  Position;
+    UCHAR                       State[4096];
+};
+
+HOST_BENCH(Slab_MillionStreamOpenClose)
+{
+    const int iterations = 1000000;
+    double slabNs, poolNs, newNs;
+
+    ObjectHeap slabbed;
+    slabbed.Reserve(kStreamTag, sizeof(FakeStream), 16);
+    uint64_t t0 = HostTest::NowNs();
+    for (int i = 0; i < iterations; ++i)
+    {
+        FakeUnknown* s = new (slabbed, kStreamTag) FakeStream((ULONG)i);
+        delete s;
+    }
+    slabNs = (double)(HostTest::NowNs() - t0) / iterations;
+
+    ObjectHeap unslabbed;
+    t0 = HostTest::NowNs();
+    for (int i = 0; i < iterations; ++i)
+    {
+        FakeUnknown* s = new (unslabbed, kStreamTag) FakeStream((ULONG)i);
+        delete s;
+    }
+    poolNs = (double)(HostTest::NowNs() - t0) / iterations;
+
+    t0 = HostTest::NowNs();
+    for (int i = 0; i < iterations; ++i)
+    {
+        FakeUnknown* s = new PlainStream((ULONG)i);
+        asm volatile("" : : "r"(s) : "memory");     // Keep the pair from being elided
+        delete s;
+    }
+    newNs = (double)(HostTest::NowNs() - t0) / iterations;
+
+    HostTest::Report("Slab_StreamOpenClose_slab", slabNs, 0);
+    HostTest::Report("Slab_StreamOpenClose_heap", poolNs, 0);
+    HostTest::Report("Slab_StreamOpenClose_new", newNs, 0);
+
+    LeylineObjectStats stats;
+    slabbed.GetStats(&stats);
+    CHECK_EQ(stats.SlabMisses, (ULONG)0);
+    CHECK_EQ(stats.Slab[0].HighWater, (ULONG)1);
+    CHECK_EQ(FindTag(stats, kStreamTag)->Live, (ULONG)0);
+    CHECK_EQ(FindTag(stats, kStreamTag)->Allocations, (ULONG)iterations);
+    slabbed.Shutdown();
+}
@@ -0,0 +1,275 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SNAPSHOT TESTS
+// Writer to reader round trips: whole, sized by the two-call protocol, cut short
+// at every length, with longer and shorter records from other versions, and
+// against headers that lie about what they hold. The benchmark writes and parses
+// a snapshot of 64 streams.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_snapshot.h"
+#include "leyline_shared.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+// A stream record that differs in every field from its neighbours.
+static void FillStream(LeylineSnapshotStream* s, ULONG i)
+{
+    s->StreamId     = 100 + i;
+    s->Direction    = i & 1 ? LEYLINE_STREAM_CAPTURE : LEYLINE_STREAM_RENDER;
+    s->Cable        = i % LEYLINE_MAX_CABLES;
+    s->State        = i % 4;
+    s->Flags        = (i * 37) & 0x3FF;
+    s->SampleFormat = 1 + i % 4;
+    s->SampleRate   = 44100 + i;
+    s->Channels     = 1 + i % 8;
+    s->BlockAlign   = 4 * (1 + i % 8);
+    s->BufferSize   = 3840 * (i + 1);
+    s->Position     = 17 * i;
+    s->Underruns    = i;
+    s->Overruns     = 2 * i;
+    s->Frames       = 0x100000000ULL + i;
+    s->GlitchFrames = 3 * i;
+    s->Periods      = 1000 * i;
+    s->StartQpc     = 0x123456789LL + i;
+}
+
+static void FillDevice(LeylineSnapshotDevice* d)
+{
+    d->CableCount       = 3;
+    d->RegisterPeriodMs = 2;
+    d->ResamplerQuality = 1;
+    d->MeterDecayDb     = 20;
+    d->MeterRmsMs       = 300;
+    d->StreamsCreated   = 77;
+    d->LoopbackEnabled  = 0x5;
+    for (ULONG i = 0; i < LEYLINE_MAX_CABLES; ++i) d->LatencyFrames[i] = 480 + i;
+}
+
+static void FillPool(LeylineBufferPoolStats* p)
+{
+    p->Classes = 2;
+    p->Hits    = 10;
+    p->Misses  = 1;
+    for (ULONG i = 0; i < LEYLINE_POOL_MAX_CLASSES; ++i) p->Class[i] = { 16384u << i, 8, i, i + 1 };
+}
+
+// Snapshot of `streams` streams into `length` bytes of `buffer`.
+static ULONG Take(std::vector<UCHAR>& buffer, ULONG length, ULONG streams)
+{
+    SnapshotWriter writer;
+    writer.Begin(buffer.data(), length, 42, 10000000);
+    if (LeylineSnapshotDevice* device = writer.Device()) FillDevice(device);
+    if (LeylineBufferPoolStats* pool = writer.Pool()) FillPool(pool);
+    for (ULONG i = 0; i < streams; ++i)
+        if (LeylineSnapshotStream* stream = writer.AddStream()) FillStream(stream, i);
+    return writer.Finish();
+}
+
+HOST_TEST(Snapshot_RoundTrip)
+{
+    std::vector<UCHAR> buffer(64 * 1024);
+    ULONG written = Take(buffer, (ULONG)buffer.size(), 9);
+
+    SnapshotReader reader;
+    CHECK(reader.Parse(buffer.data(), written));
+    CHECK(reader.IsComplete());
+    CHECK_EQ(reader.Header().Version, (ULONG)LEYLINE_SNAPSHOT_VERSION);
+    CHECK_EQ(reader.Header().Qpc, (LONG64)42);
+    CHECK_EQ(reader.Header().Streams, (ULONG)9);
+
+    LeylineSnapshotDevice device, expectDevice = {};
+    FillDevice(&expectDevice);
+    CHECK(reader.GetDevice(&device));
+    CHECK(memcmp(&device, &expectDevice, sizeof(device)) == 0);
+
+    LeylineBufferPoolStats pool, expectPool = {};
+    FillPool(&expectPool);
+    CHECK(reader.GetPool(&pool));
+    CHECK(memcmp(&pool, &expectPool, sizeof(pool)) == 0);
+
+    CHECK_EQ(reader.GetStreamCount(), (ULONG)9);
+    for (ULONG i = 0; i < 9; ++i)
+    {
+        LeylineSnapshotStream stream, expect = {};
+        FillStream(&expect, i);
+        CHECK(reader.GetStream(i, &stream));
+        CHECK(memcmp(&stream, &expect, sizeof(stream)) == 0);
+    }
+    LeylineSnapshotStream past;
+    CHECK(!reader.GetStream(9, &past));
+}
+
+HOST_TEST(Snapshot_TwoCallSizing)
+{
+    // First call: a bare header says how much to send.
+    std::vector<UCHAR> buffer(sizeof(LeylineSnapshotHeader));
+    ULONG written = Take(buffer, (ULONG)buffer.size(), 64);
+    CHECK_EQ(written, (ULONG)sizeof(LeylineSnapshotHeader));
+
+    SnapshotReader reader;
+    CHECK(reader.Parse(buffer.data(), written));
+    CHECK(!reader.IsComplete());
+    CHECK_EQ(reader.Header().Streams, (ULONG)64);
+    CHECK_EQ(reader.GetStreamCount(), (ULONG)0);
+    LeylineSnapshotDevice device;
+    CHECK(!reader.GetDevice(&device));
+
+    // Second call at exactly that size gets everything.
+    ULONG total = reader.Header().TotalBytes;
+    CHECK_EQ(total, (ULONG)(sizeof(LeylineSnapshotHeader) + sizeof(LeylineSnapshotDevice) +
+                            sizeof(LeylineBufferPoolStats) + 64 * sizeof(LeylineSnapshotStream)));
+    buffer.assign(total, 0xCC);
+    written = Take(buffer, total, 64);
+    CHECK_EQ(written, total);
+    CHECK(reader.Parse(buffer.data(), written));
+    CHECK(reader.IsComplete());
+    CHECK_EQ(reader.GetStreamCount(), (ULONG)64);
+}
+
+HOST_TEST(Snapshot_EveryShortBufferParses)
+{
+    // Whatever the length, the writer stays inside it and what it returns parses,
+    // holding whole records only.
+    const ULONG streams = 5;
+    const ULONG total   = (ULONG)(sizeof(LeylineSnapshotHeader) + sizeof(LeylineSnapshotDevice) +
+                                  sizeof(LeylineBufferPoolStats) + streams * sizeof(LeylineSnapshotStream));
+    for (ULONG length = sizeof(LeylineSnapshotHeader); length <= total + 8; ++length)
+    {
+        std::vector<UCHAR> buffer(length + 16, 0xAB);
+        ULONG written = Take(buffer, length, streams);
+        CHECK(written <= length);
+        for (ULONG i = length; i < length + 16; ++i) CHECK_EQ(buffer[i], (UCHAR)0xAB);
+
+        SnapshotReader reader;
+        CHECK(reader.Parse(buffer.data(), written));
+        CHECK_EQ(reader.Header().TotalBytes, total);
+        CHECK_EQ(reader.IsComplete(), length >= total ? TRUE : FALSE);
+
+        ULONG fit = length < total - streams * (ULONG)sizeof(LeylineSnapshotStream) ? 0
+                  : (length - (total - streams * (ULONG)sizeof(LeylineSnapshotStream))) / (ULONG)sizeof(LeylineSnapshotStream);
+        if (fit > streams) fit = streams;
+        CHECK_EQ(reader.GetStreamCount(), fit);
+        for (ULONG i = 0; i < fit; ++i)
+        {
+            LeylineSnapshotStream stream;
+            CHECK(reader.GetStream(i, &stream));
+            CHECK_EQ(stream.StreamId, 100 + i);
+        }
+    }
+}
+
+// Streams only, `bytes` a record, as a driver of `version` would lay them out.
+static std::vector<UCHAR> Handmade(ULONG version, ULONG bytes, ULONG streams)
+{
+    std::vector<UCHAR> buffer(sizeof(LeylineSnapshotHeader) + bytes * streams, 0xEE);
+    LeylineSnapshotHeader* header = reinterpret_cast<LeylineSnapshotHeader*>(buffer.data());
+    RtlZeroMemory(header, sizeof(*header));
+    header->Magic           = LEYLINE_SNAPSHOT_MAGIC;
+    header->Version         = version;
+    header->HeaderBytes     = sizeof(LeylineSnapshotHeader);
+    header->StreamOffset    = sizeof(LeylineSnapshotHeader);
+    header->StreamBytes     = bytes;
+    header->Streams         = streams;
+    header->StreamsReturned = streams;
+    header->TotalBytes = header->WrittenBytes = (ULONG)buffer.size();
+
+    for (ULONG i = 0; i < streams; ++i)
+    {
+        LeylineSnapshotStream stream = {};
+        FillStream(&stream, i);
+        memcpy(buffer.data() + header->StreamOffset + i * bytes, &stream, bytes < sizeof(stream) ? bytes : sizeof(stream));
+    }
+    return buffer;
+}
+
+HOST_TEST(Snapshot_ReadsOtherVersionsRecords)
+{
+    SnapshotReader reader;
+
+    // A later version appends fields to each record; this reader keeps its own.
+    std::vector<UCHAR> newer = Handmade(LEYLINE_SNAPSHOT_VERSION + 1, sizeof(LeylineSnapshotStream) + 24, 3);
+    CHECK(reader.Parse(newer.data(), (ULONG)newer.size()));
+    for (ULONG i = 0; i < 3; ++i)
+    {
+        LeylineSnapshotStream stream, expect = {};
+        FillStream(&expect, i);
+        CHECK(reader.GetStream(i, &stream));
+        CHECK(memcmp(&stream, &expect, sizeof(stream)) == 0);
+    }
+
+    // An earlier, shorter record: what it did not have reads as zero.
+    std::vector<UCHAR> older = Handmade(LEYLINE_SNAPSHOT_VERSION, offsetof(LeylineSnapshotStream, Frames), 3);
+    CHECK(reader.Parse(older.data(), (ULONG)older.size()));
+    for (ULONG i = 0; i < 3; ++i)
+    {
+        LeylineSnapshotStream stream;
+        CHECK(reader.GetStream(i, &stream));
+        CHECK_EQ(stream.StreamId, 100 + i);
+        CHECK_EQ(stream.Overruns, 2 * i);
+        CHECK_EQ(stream.Frames, (ULONGLONG)0);
+        CHECK_EQ(stream.StartQpc, (LONG64)0);
+    }
+}
+
+HOST_TEST(Snapshot_RejectsInconsistentHeaders)
+{
+    std::vector<UCHAR> buffer(4096);
+    ULONG written = Take(buffer, (ULONG)buffer.size(), 4);
+    SnapshotReader reader;
+    CHECK(reader.Parse(buffer.data(), written));
+    CHECK(!reader.Parse(buffer.data(), written - 1));     // Claims more than was returned
+    CHECK(!reader.Parse(buffer.data(), 8));
+
+    auto Broken = [&](void (*Break)(LeylineSnapshotHeader*)) {
+        std::vector<UCHAR> copy(buffer.begin(), buffer.begin() + written);
+        Break(reinterpret_cast<LeylineSnapshotHeader*>(copy.data()));
+        return !reader.Parse(copy.data(), written);
+    };
+    CHECK(Broken([](LeylineSnapshotHeader* h) { h->Magic ^= 1; }));
+    CHECK(Broken([](LeylineSnapshotHeader* h) { h->Version = 0; }));
+    CHECK(Broken([](LeylineSnapshotHeader* h) { h->HeaderBytes = 16; }));
+    CHECK(Broken([](LeylineSnapshotHeader* h) { h->DeviceOffset = 8; }));
+    CHECK(Broken([](LeylineSnapshotHeader* h) { h->PoolBytes = 0x7FFFFFFF; }));
+    CHECK(Broken([](LeylineSnapshotHeader* h) { h->StreamsReturned = 5; }));
+    CHECK(Broken([](LeylineSnapshotHeader* h) { h->StreamBytes = 0; }));
+    CHECK(Broken([](LeylineSnapshotHeader* h) { h->StreamBytes = 0x40000000; }));
+}
+
+HOST_BENCH(Snapshot_SixtyFourStreams)
+{
+    const ULONG streams = 64;
+    std::vector<UCHAR> buffer(sizeof(LeylineSnapshotHeader) + sizeof(LeylineSnapshotDevice) +
+                              sizeof(LeylineBufferPoolStats) + streams * sizeof(LeylineSnapshotStream));
+
+    const int iterations = 200000;
+    ULONG     bytes      = 0;
+    uint64_t  t0         = HostTest::NowNs();
+    for (int i = 0; i < iterations; ++i) bytes += Take(buffer, (ULONG)buffer.size(), streams);
+    double write = (double)(HostTest::NowNs() - t0) / iterations;
+    HostTest::Report("snapshot_write_64_streams", write, (double)buffer.size() * 1e9 / write);
+
+    SnapshotReader reader;
+    ULONGLONG      frames = 0;
+    t0 = HostTest::NowNs();
+    for (int i = 0; i < iterations; ++i)
+    {
+        reader.Parse(buffer.data(), (ULONG)buffer.size());
+        for (ULONG s = 0; s < reader.GetStreamCount(); ++s)
+        {
+            LeylineSnapshotStream stream;
+            reader.GetStream(s, &stream);
+            frames += stream.Frames;
+        }
+    }
+    double read = (double)(HostTest::NowNs() - t0) / iterations;
+    HostTest::Report("snapshot_parse_64_streams", read, (double)buffer.size() * 1e9 / read);
+
+    CHECK_EQ(bytes, (ULONG)(buffer.size() * iterations));
+    CHECK(frames != 0);
+}
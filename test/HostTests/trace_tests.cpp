@@ -0,0 +1,252 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// TRACE TESTS
+// The event set through a capturing sink in place of EtwWrite: what a session's
+// level and keywords enable, payloads decoded back field by field, refused writes,
+// position sampling. The benchmark reports the cost of a trace point with no
+// session, with one, and with a sink that copies the event out.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_trace.h"
+
+#include <string.h>
+
+// Keeps what EtwWrite would have logged: the descriptor and the payload bytes.
+struct TraceCapture
+{
+    struct Record
+    {
+        EVENT_DESCRIPTOR Descriptor;
+        ULONG            Size;
+        UCHAR            Bytes[64];
+    };
+
+    Record   Records[16];
+    ULONG    Count;
+    NTSTATUS Result;
+
+    static NTSTATUS Sink(PVOID Context, PCEVENT_DESCRIPTOR Descriptor, ULONG Count, PEVENT_DATA_DESCRIPTOR Data)
+    {
+        TraceCapture* capture = static_cast<TraceCapture*>(Context);
+        if (!NT_SUCCESS(capture->Result)) return capture->Result;
+
+        Record& r = capture->Records[capture->Count++ % 16];
+        r.Descriptor = *Descriptor;
+        r.Size       = 0;
+        for (ULONG i = 0; i < Count; ++i)
+        {
+            memcpy(r.Bytes + r.Size, (const void*)(ULONG_PTR)Data[i].Ptr, Data[i].Size);
+            r.Size += Data[i].Size;
+        }
+        return STATUS_SUCCESS;
+    }
+
+    // The payload of the last event, if it was a `Payload` at least as long as
+    // the layout known here.
+    template<class Payload>
+    bool Decode(Payload* out) const
+    {
+        if (Count == 0) return false;
+        const Record& r = Records[(Count - 1) % 16];
+        if (r.Descriptor.Id != Payload::Event || r.Size < sizeof(Payload)) return false;
+        memcpy(out, r.Bytes, sizeof(Payload));
+        return true;
+    }
+};
+
+static NTSTATUS NullSink(PVOID, PCEVENT_DESCRIPTOR, ULONG, PEVENT_DATA_DESCRIPTOR)
+{
+    return STATUS_SUCCESS;
+}
+
+static bool EnabledSet(const TraceProvider& trace, LONG expected)
+{
+    for (ULONG id = 1; id < TraceEvent_Count; ++id)
+    {
+        bool want = (expected & (1L << id)) != 0;
+        if ((trace.IsEnabled((TraceEvent)id) != 0) != want) return false;
+    }
+    return true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ENABLE STATE
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_TEST(Trace_ZeroedProviderWritesNothing)
+{
+    TraceProvider trace = {};
+    TraceCapture  capture = {};
+    CHECK(EnabledSet(trace, 0));
+
+    trace.Write(TraceGlitch{ 1, TraceGlitch_Underrun, 48, 0, 960 });
+    CHECK_EQ(capture.Count, (ULONG)0);
+
+    // Enabled without a sink is still nothing.
+    trace.Enable(0, 0);
+    trace.Write(TraceGlitch{ 1, TraceGlitch_Underrun, 48, 0, 960 });
+    CHECK_EQ(trace.Dropped(), (ULONG)0);
+
+    trace.Attach(TraceCapture::Sink, &capture);
+    trace.Write(TraceGlitch{ 1, TraceGlitch_Underrun, 48, 0, 960 });
+    CHECK_EQ(capture.Count, (ULONG)1);
+}
+
+HOST_TEST(Trace_EnableFollowsLevelAndKeywords)
+{
+    const LONG lifecycle = (1L << TraceEvent_NewStream) | (1L << TraceEvent_SetState) | (1L << TraceEvent_AllocateBuffer);
+    const LONG position  = 1L << TraceEvent_Position;
+    const LONG glitch    = 1L << TraceEvent_Glitch;
+
+    TraceProvider trace = {};
+    trace.Enable(LEYLINE_TRACE_LEVEL_INFO, LEYLINE_TRACE_KEYWORD_LIFECYCLE);
+    CHECK(EnabledSet(trace, lifecycle));
+
+    // Positions are verbose: the keyword alone is not enough.
+    trace.Enable(LEYLINE_TRACE_LEVEL_INFO, LEYLINE_TRACE_KEYWORD_POSITION | LEYLINE_TRACE_KEYWORD_GLITCH);
+    CHECK(EnabledSet(trace, glitch));
+    trace.Enable(LEYLINE_TRACE_LEVEL_VERBOSE, LEYLINE_TRACE_KEYWORD_POSITION);
+    CHECK(EnabledSet(trace, position));
+
+    trace.Enable(LEYLINE_TRACE_LEVEL_WARNING, ~0ULL);
+    CHECK(EnabledSet(trace, glitch));
+
+    // Zero level and zero keywords are "everything", as ETW has it.
+    trace.Enable(0, 0);
+    CHECK(EnabledSet(trace, lifecycle | position | glitch));
+
+    trace.Disable();
+    CHECK(EnabledSet(trace, 0));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PAYLOADS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_TEST(Trace_EventsDecodeFromTheSink)
+{
+    TraceProvider trace = {};
+    TraceCapture  capture = {};
+    trace.Attach(TraceCapture::Sink, &capture);
+    trace.Enable(LEYLINE_TRACE_LEVEL_VERBOSE, ~0ULL);
+
+    trace.Write(TraceNewStream{ 7, 2, 1, 96000, 6, 12, 3 });
+    const TraceCapture::Record& first = capture.Records[0];
+    CHECK_EQ(first.Descriptor.Id, (USHORT)TraceEvent_NewStream);
+    CHECK_EQ(first.Descriptor.Level, (UCHAR)LEYLINE_TRACE_LEVEL_INFO);
+    CHECK_EQ(first.Descriptor.Keyword, LEYLINE_TRACE_KEYWORD_LIFECYCLE);
+    CHECK_EQ(first.Size, (ULONG)sizeof(TraceNewStream));
+    TraceNewStream stream;
+    CHECK(capture.Decode(&stream));
+    CHECK_EQ(stream.StreamId, (ULONG)7);
+    CHECK_EQ(stream.Cable, (ULONG)2);
+    CHECK_EQ(stream.SampleRate, (ULONG)96000);
+    CHECK_EQ(stream.BlockAlign, (ULONG)12);
+
+    trace.Write(TraceSetState{ 7, 2, 3, 0, 123456789 });
+    TraceSetState state;
+    CHECK(capture.Decode(&state));
+    CHECK_EQ(state.From, (ULONG)2);
+    CHECK_EQ(state.To, (ULONG)3);
+    CHECK_EQ(state.Qpc, (LONG64)123456789);
+
+    trace.Write(TraceAllocateBuffer{ 7, STATUS_SUCCESS, 38400, 38400, 33333, LEYLINE_TRACE_BUFFER_POOLED, 4200 });
+    TraceAllocateBuffer buffer;
+    CHECK(capture.Decode(&buffer));
+    CHECK_EQ(buffer.ActualBytes, (ULONG)38400);
+    CHECK_EQ(buffer.BufferUs, (ULONG)33333);
+    CHECK_EQ(buffer.Flags, (ULONG)LEYLINE_TRACE_BUFFER_POOLED);
+    CHECK_EQ(buffer.ElapsedNs, (ULONG64)4200);
+
+    trace.Write(TracePosition{ 7, 1920, 0x100000000ULL, -1 });
+    TracePosition position;
+    CHECK(capture.Decode(&position));
+    CHECK_EQ(capture.Records[3].Descriptor.Task, (USHORT)TraceTask_Position);
+    CHECK_EQ(position.Frames, 0x100000000ULL);
+    CHECK_EQ(position.Qpc, (LONG64)-1);
+
+    trace.Write(TraceGlitch{ 7, TraceGlitch_Overrun, 480, 0, 96000 });
+    TraceGlitch glitch;
+    CHECK(capture.Decode(&glitch));
+    CHECK_EQ(glitch.Kind, (ULONG)TraceGlitch_Overrun);
+    CHECK_EQ(glitch.Frames, (ULONG)480);
+    CHECK_EQ(glitch.AtFrame, (ULONG64)96000);
+
+    // A decoder asking for the wrong event gets nothing.
+    CHECK(!capture.Decode(&stream));
+    CHECK_EQ(capture.Count, (ULONG)5);
+}
+
+HOST_TEST(Trace_RefusedWritesCountAsDropped)
+{
+    TraceProvider trace = {};
+    TraceCapture  capture = {};
+    capture.Result = STATUS_INSUFFICIENT_RESOURCES;
+    trace.Attach(TraceCapture::Sink, &capture);
+    trace.Enable(0, 0);
+
+    for (int i = 0; i < 3; ++i) trace.Write(TraceGlitch{ 1, TraceGlitch_Underrun, 48, 0, 0 });
+    CHECK_EQ(trace.Dropped(), (ULONG)3);
+
+    // Disabled events are not drops.
+    trace.Disable();
+    trace.Write(TraceGlitch{ 1, TraceGlitch_Underrun, 48, 0, 0 });
+    CHECK_EQ(trace.Dropped(), (ULONG)3);
+}
+
+HOST_TEST(Trace_SampleFiresOncePerPeriod)
+{
+    ULONG counter = 0, fired = 0;
+    for (int i = 0; i < LEYLINE_TRACE_POSITION_SAMPLE * 10; ++i)
+    {
+        if (TraceProvider::Sample(&counter, LEYLINE_TRACE_POSITION_SAMPLE))
+        {
+            ++fired;
+            CHECK_EQ((i + 1) % LEYLINE_TRACE_POSITION_SAMPLE, 0);
+        }
+    }
+    CHECK_EQ(fired, (ULONG)10);
+
+    // A period of one traces every call.
+    counter = 0;
+    CHECK(TraceProvider::Sample(&counter, 1));
+    CHECK(TraceProvider::Sample(&counter, 1));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARK
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HOST_BENCH(Trace_PerEventCost)
+{
+    static TraceProvider trace;
+    static TraceCapture  capture;
+
+    struct Scenario { const char* Name; TraceSink Sink; bool Enabled; };
+    const Scenario scenarios[] =
+    {
+        { "trace_event_no_session",   TraceCapture::Sink, false },
+        { "trace_event_null_sink",    NullSink,           true },
+        { "trace_event_capture_sink", TraceCapture::Sink, true },
+    };
+
+    const int iterations = 10000000;
+    for (const Scenario& s : scenarios)
+    {
+        trace = TraceProvider();
+        capture = TraceCapture();
+        trace.Attach(s.Sink, &capture);
+        if (s.Enabled) trace.Enable(LEYLINE_TRACE_LEVEL_VERBOSE, ~0ULL);
+
+        uint64_t t0 = HostTest::NowNs();
+        for (int i = 0; i < iterations; ++i)
+            trace.Write(TracePosition{ 1, (ULONG)i * 4, (ULONG64)i, (LONG64)i });
+        double ns = (double)(HostTest::NowNs() - t0) / iterations;
+
+        HostTest::Report(s.Name, ns, 0);
+        CHECK_EQ(capture.Count, s.Enabled && s.Sink == TraceCapture::Sink ? (ULONG)iterations : (ULONG)0);
+    }
+}
@@ -0,0 +1,190 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// WAVERT MATH TESTS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#include "host_test.h"
+#include "leyline_wavertmath.h"
+
+#include <random>
+
+// The standard rates inside g_PcmDataRange / g_FloatDataRange (8 kHz .. 192 kHz),
+// at the widest frame those ranges allow (8 channels x 32 bits).
+static const ULONG kRates[]       = { 8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000,
+                                      88200, 96000, 176400, 192000 };
+static const ULONG kMaxBlockAlign = 8 * 4;
+
+// 10 MHz is the modern QPC; 3.579545 MHz is the ACPI PM timer; ~3 GHz is a raw TSC.
+static const LONG64 kFrequencies[] = { 10000000, 3579545, 2995200000LL };
+
+static ULONGLONG ReferenceFrames(ULONGLONG ticks, ULONG rate, LONG64 frequency)
+{
+    return (ULONGLONG)(((unsigned __int128)ticks * rate) / (ULONGLONG)frequency);
+}
+
+// The pre-StreamClock GetPosition math, kept here as the benchmark baseline.
+static ULONGLONG LegacyTicksToBytes(LONGLONG elapsedTicks, ULONG byteRate, LONGLONG frequency)
+{
+    if (frequency <= 0) return 0;
+    return (ULONGLONG)((elapsedTicks * (unsigned long long)byteRate) / (unsigned long long)frequency);
+}
+
+HOST_TEST(WaveRTMath_ReciprocalDivisionIsExact)
+{
+    std::mt19937_64 rng(7);
+    const ULONGLONG divisors[] = { 1, 2, 3, 7, 4096, 10000000, 3579545, 2995200000ULL,
+                                   0xFFFFFFFFULL, 0x8000000000000001ULL, ~0ULL };
+    for (ULONGLONG d : divisors)
+    {
+        WaveRTMath::Reciprocal r;
+        r.Init(d);
+        for (int i = 0; i < 200000; ++i)
+        {
+            ULONGLONG x = rng() >> (i % 64);
+            ULONGLONG rem;
+            ULONGLONG q = r.Divide(x, &rem);
+            if (q != x / d || rem != x % d) { CHECK_EQ(q, x / d); CHECK_EQ(rem, x % d); }
+        }
+        ULONGLONG rem;
+        CHECK_EQ(r.Divide(~0ULL, &rem), ~0ULL / d);
+    }
+}
+
+// Random points over ten years of uptime, for every rate and QPC frequency: the
+// frame count is exact, and the buffer offset is the exact frame wrapped into a
+// buffer that is not a power of two.
+HOST_TEST(WaveRTMath_StreamClockExactOverYearsAtEveryRate)
+{
+    std::mt19937_64 rng(11);
+    const ULONG bufferSize = 10 * 48 * kMaxBlockAlign * 10 + 12;   // ~100 ms, ragged tail
+    const ULONG bufferFrames = bufferSize / kMaxBlockAlign;
+
+    for (LONG64 freq : kFrequencies)
+    {
+        const ULONGLONG tenYears = (ULONGLONG)freq * 3600 * 24 * 3653;
+        for (ULONG rate : kRates)
+        {
+            WaveRTMath::StreamClock clock;
+            const LONG64 start = (LONG64)(rng() >> 20);
+            clock.Start(start, freq, rate, kMaxBlockAlign, bufferSize);
+
+            int errors = 0;
+            for (int i = 0; i < 20000; ++i)
+            {
+                ULONGLONG ticks  = rng() % tenYears;
+                ULONGLONG frames = clock.FramesAt(start + (LONG64)ticks);
+                ULONGLONG expect = ReferenceFrames(ticks, rate, freq);
+                if (frames != expect) ++errors;
+                if (clock.BufferOffset(frames) != (ULONG)(expect % bufferFrames) * kMaxBlockAlign) ++errors;
+            }
+            CHECK_EQ(errors, 0);
+        }
+    }
+}
+
+// Walk tick-by-tick across second boundaries far into the run: the frame count
+// must never step backwards or skip, which is what a drifting clock would do.
+HOST_TEST(WaveRTMath_StreamClockIsMonotonicAcrossSecondBoundaries)
+{
+    const LONG64 freq = 10000000;
+    for (ULONG rate : kRates)
+    {
+        WaveRTMath::StreamClock clock;
+        clock.Start(0, freq, rate, 4, 4096);
+
+        const LONG64 anchors[] = { 0, freq * 86400 * 100, freq * 86400 * 365 * 5 + freq / 3 };
+        for (LONG64 anchor : anchors)
+        {
+            ULONGLONG previous = clock.FramesAt(anchor - freq / 100);
+            int bad = 0;
+            for (LONG64 t = anchor - freq / 100; t < anchor + freq / 100; ++t)
+            {
+                ULONGLONG f = clock.FramesAt(t);
+                if (f < previous || f > previous + 1) ++bad;
+                previous = f;
+            }
+            CHECK_EQ(bad, 0);
+            CHECK_EQ(clock.FramesAt(anchor + freq), clock.FramesAt(anchor) + rate);
+        }
+    }
+}
+
+HOST_TEST(WaveRTMath_StreamClockClampsBeforeStart)
+{
+    WaveRTMath::StreamClock clock;
+    clock.Start(5000, 10000000, 48000, 4, 1920);
+    CHECK_EQ(clock.FramesAt(4999), (ULONGLONG)0);
+    CHECK_EQ(clock.FramesAt(5000), (ULONGLONG)0);
+    CHECK_EQ(clock.BufferOffset(480), (ULONG)0);
+    CHECK_EQ(clock.BufferOffset(481), (ULONG)4);
+}
+
+// Documents why the old path was replaced: at 192 kHz / 32-bit / 8 ch the 64-bit
+// product wraps after about 3.5 days on a 10 MHz QPC, far short of 100 days.
+HOST_TEST(WaveRTMath_LegacyTicksToBytesOverflowsWithinDays)
+{
+    const LONG64 freq     = 10000000;
+    const ULONG  byteRate = 192000 * kMaxBlockAlign;
+    const LONG64 fourDays = freq * 86400 * 4;
+
+    ULONGLONG exact = ReferenceFrames((ULONGLONG)fourDays, 192000, freq) * kMaxBlockAlign;
+    CHECK(LegacyTicksToBytes(fourDays, byteRate, freq) != exact);
+
+    WaveRTMath::StreamClock clock;
+    clock.Start(0, freq, 192000, kMaxBlockAlign, 0);
+    CHECK_EQ(clock.FramesAt(fourDays) * kMaxBlockAlign, exact);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BENCHMARKS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Per-call cost of the GetPosition math: the old divide + modulo against the
+// reciprocal clock, fed the same monotonic QPC sequence.
+HOST_BENCH(WaveRTMath_GetPositionCost)
+{
+    // Read through volatiles so the compiler cannot strength-reduce the divides by
+    // constants; in the driver these are per-stream members.
+    volatile LONG64 vFreq = 10000000;
+    volatile ULONG  vRate = 48000, vBlockAlign = 8;
+    const LONG64   freq       = vFreq;
+    const ULONG    rate       = vRate;
+    const ULONG    blockAlign = vBlockAlign;
+    const ULONG    bufferSize = 480 * blockAlign * 10;
+    const uint64_t calls      = 50ull * 1000 * 1000;
+
+    volatile ULONGLONG sink = 0;
+    LONG64 start = 123456789;
+
+    {
+        ULONGLONG acc = 0;
+        LONG64 now = start;
+        uint64_t t0 = HostTest::NowNs();
+        for (uint64_t i = 0; i < calls; ++i)
+        {
+            now += 997;
+            acc += LegacyTicksToBytes(now - start, rate * blockAlign, freq) % bufferSize;
+        }
+        double ns = (double)(HostTest::NowNs() - t0);
+        sink = acc;
+        HostTest::Report("position_legacy_div", ns / (double)calls, 0);
+    }
+    {
+        WaveRTMath::StreamClock clock;
+        clock.Start(start, freq, rate, blockAlign, bufferSize);
+        ULONGLONG acc = 0;
+        LONG64 now = start;
+        uint64_t t0 = HostTest::NowNs();
+        for (uint64_t i = 0; i < calls; ++i)
+        {
+            now += 997;
+            acc += clock.BufferOffset(clock.FramesAt(now));
+        }
+        double ns = (double)(HostTest::NowNs() - t0);
+        sink = acc;
+        HostTest::Report("position_stream_clock", ns / (double)calls, 0);
+    }
+    (void)sink;
+}
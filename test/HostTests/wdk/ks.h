@@ -0,0 +1,71 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// HOST STAND-IN: ks.h
+// The KS property verbs the portable node-property code dispatches on, the
+// data format/range header the format intersection reads, and the pin
+// descriptor the endpoint graph fills in. Values and layouts match the real
+// header.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+#include <guiddef.h>
+
+#define KSPROPERTY_TYPE_GET             0x00000001
+#define KSPROPERTY_TYPE_SET             0x00000002
+#define KSPROPERTY_TYPE_BASICSUPPORT    0x00000200
+
+typedef union
+{
+    struct
+    {
+        ULONG   FormatSize;
+        ULONG   Flags;
+        ULONG   SampleSize;
+        ULONG   Reserved;
+        GUID    MajorFormat;
+        GUID    SubFormat;
+        GUID    Specifier;
+    };
+    LONGLONG    Alignment;
+} KSDATAFORMAT, *PKSDATAFORMAT, KSDATARANGE, *PKSDATARANGE;
+
+typedef struct
+{
+    GUID    Set;
+    ULONG   Id;
+    ULONG   Flags;
+} KSIDENTIFIER, KSPIN_INTERFACE, KSPIN_MEDIUM;
+
+typedef enum
+{
+    KSPIN_DATAFLOW_IN  = 1,
+    KSPIN_DATAFLOW_OUT = 2,
+} KSPIN_DATAFLOW;
+
+typedef enum
+{
+    KSPIN_COMMUNICATION_NONE   = 0,
+    KSPIN_COMMUNICATION_SINK   = 1,
+    KSPIN_COMMUNICATION_SOURCE = 2,
+    KSPIN_COMMUNICATION_BOTH   = 3,
+    KSPIN_COMMUNICATION_BRIDGE = 4,
+} KSPIN_COMMUNICATION;
+
+typedef struct
+{
+    ULONG                   InterfacesCount;
+    const KSPIN_INTERFACE*  Interfaces;
+    ULONG                   MediumsCount;
+    const KSPIN_MEDIUM*     Mediums;
+    ULONG                   DataRangesCount;
+    const PKSDATARANGE*     DataRanges;
+    KSPIN_DATAFLOW          DataFlow;
+    KSPIN_COMMUNICATION     Communication;
+    const GUID*             Category;
+    const GUID*             Name;
+    LONGLONG                Reserved;       // Union with the constrained ranges
+} KSPIN_DESCRIPTOR;
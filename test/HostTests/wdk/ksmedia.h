@@ -0,0 +1,105 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// HOST STAND-IN: ksmedia.h
+// Wave formats, the audio data range and the format GUIDs, for the portable
+// format intersection. Byte-packed like mmreg.h; values match the real headers.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <ks.h>
+
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+
+#define WAVE_FORMAT_PCM         0x0001
+#define WAVE_FORMAT_IEEE_FLOAT  0x0003
+#define WAVE_FORMAT_EXTENSIBLE  0xFFFE
+
+#define SPEAKER_FRONT_LEFT              0x00000001
+#define SPEAKER_FRONT_RIGHT             0x00000002
+#define SPEAKER_FRONT_CENTER            0x00000004
+#define SPEAKER_LOW_FREQUENCY           0x00000008
+#define SPEAKER_BACK_LEFT               0x00000010
+#define SPEAKER_BACK_RIGHT              0x00000020
+#define SPEAKER_BACK_CENTER             0x00000100
+#define SPEAKER_SIDE_LEFT               0x00000200
+#define SPEAKER_SIDE_RIGHT              0x00000400
+#define SPEAKER_TOP_CENTER              0x00000800
+#define SPEAKER_TOP_FRONT_LEFT          0x00001000
+#define SPEAKER_TOP_FRONT_CENTER        0x00002000
+#define SPEAKER_TOP_FRONT_RIGHT         0x00004000
+#define SPEAKER_TOP_BACK_LEFT           0x00008000
+#define SPEAKER_TOP_BACK_CENTER         0x00010000
+#define SPEAKER_TOP_BACK_RIGHT          0x00020000
+
+#define KSAUDIO_SPEAKER_DIRECTOUT       0
+#define KSAUDIO_SPEAKER_MONO            (SPEAKER_FRONT_CENTER)
+#define KSAUDIO_SPEAKER_STEREO          (SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT)
+#define KSAUDIO_SPEAKER_QUAD            (SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT)
+#define KSAUDIO_SPEAKER_5POINT1         (SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER | \
+                                         SPEAKER_LOW_FREQUENCY | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT)
+#define KSAUDIO_SPEAKER_7POINT1_SURROUND (SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER | \
+                                         SPEAKER_LOW_FREQUENCY | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT | \
+                                         SPEAKER_SIDE_LEFT | SPEAKER_SIDE_RIGHT)
+
+#pragma pack(push, 1)
+
+typedef struct
+{
+    WORD    wFormatTag;
+    WORD    nChannels;
+    DWORD   nSamplesPerSec;
+    DWORD   nAvgBytesPerSec;
+    WORD    nBlockAlign;
+    WORD    wBitsPerSample;
+    WORD    cbSize;
+} WAVEFORMATEX, *PWAVEFORMATEX;
+
+typedef struct
+{
+    WAVEFORMATEX Format;
+    union
+    {
+        WORD wValidBitsPerSample;
+        WORD wSamplesPerBlock;
+        WORD wReserved;
+    } Samples;
+    DWORD   dwChannelMask;
+    GUID    SubFormat;
+} WAVEFORMATEXTENSIBLE, *PWAVEFORMATEXTENSIBLE;
+
+#pragma pack(pop)
+
+typedef struct
+{
+    KSDATAFORMAT DataFormat;
+    WAVEFORMATEX WaveFormatEx;
+} KSDATAFORMAT_WAVEFORMATEX;
+
+typedef struct
+{
+    KSDATAFORMAT         DataFormat;
+    WAVEFORMATEXTENSIBLE WaveFormatExt;
+} KSDATAFORMAT_WAVEFORMATEXTENSIBLE;
+
+typedef struct
+{
+    KSDATARANGE DataRange;
+    ULONG       MaximumChannels;
+    ULONG       MinimumBitsPerSample;
+    ULONG       MaximumBitsPerSample;
+    ULONG       MinimumSampleFrequency;
+    ULONG       MaximumSampleFrequency;
+} KSDATARANGE_AUDIO, *PKSDATARANGE_AUDIO;
+
+DEFINE_GUID(KSDATAFORMAT_TYPE_AUDIO,
+    0x73647561, 0x0000, 0x0010, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71);
+DEFINE_GUID(KSDATAFORMAT_SUBTYPE_PCM,
+    0x00000001, 0x0000, 0x0010, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71);
+DEFINE_GUID(KSDATAFORMAT_SUBTYPE_IEEE_FLOAT,
+    0x00000003, 0x0000, 0x0010, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71);
+DEFINE_GUID(KSDATAFORMAT_SPECIFIER_WAVEFORMATEX,
+    0x05589f81, 0xc356, 0x11ce, 0xbf, 0x01, 0x00, 0xaa, 0x00, 0x55, 0x59, 0x5a);
@@ -0,0 +1,58 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// HOST STAND-IN: portcls.h
+// The filter, pin, node and connection descriptors the endpoint graph generates.
+// Automation tables stay opaque. Layouts match the real header.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <wdm.h>
+#include <ks.h>
+
+#define PCFILTER_NODE   ((ULONG)-1)
+
+struct PCAUTOMATION_TABLE;
+
+typedef struct
+{
+    ULONG                       MaxGlobalInstanceCount;
+    ULONG                       MaxFilterInstanceCount;
+    ULONG                       MinFilterInstanceCount;
+    const PCAUTOMATION_TABLE*   AutomationTable;
+    KSPIN_DESCRIPTOR            KsPinDescriptor;
+} PCPIN_DESCRIPTOR;
+
+typedef struct
+{
+    ULONG                       Flags;
+    const PCAUTOMATION_TABLE*   AutomationTable;
+    const GUID*                 Type;
+    const GUID*                 Name;
+} PCNODE_DESCRIPTOR;
+
+typedef struct
+{
+    ULONG   FromNode;
+    ULONG   FromNodePin;
+    ULONG   ToNode;
+    ULONG   ToNodePin;
+} PCCONNECTION_DESCRIPTOR;
+
+typedef struct
+{
+    ULONG                           Version;
+    const PCAUTOMATION_TABLE*       AutomationTable;
+    ULONG                           PinSize;
+    ULONG                           PinCount;
+    const PCPIN_DESCRIPTOR*         Pins;
+    ULONG                           NodeSize;
+    ULONG                           NodeCount;
+    const PCNODE_DESCRIPTOR*        Nodes;
+    ULONG                           ConnectionCount;
+    const PCCONNECTION_DESCRIPTOR*  Connections;
+    ULONG                           CategoryCount;
+    const GUID*                     Categories;
+} PCFILTER_DESCRIPTOR, *PPCFILTER_DESCRIPTOR;
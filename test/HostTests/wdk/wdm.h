@@ -0,0 +1,205 @@
+// Copyright (c) 2026 Randall Rosas (Slategray).
+// All rights reserved.
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// HOST STAND-IN: wdm.h
+// Just enough of the WDM surface for the portable driver headers to build on a
+// Linux host with GCC/Clang. Semantics follow the real kernel routines.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BASIC TYPES
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef void                VOID;
+typedef void*               PVOID;
+typedef uint8_t             UCHAR, *PUCHAR;
+typedef int8_t              CHAR;
+typedef uint16_t            USHORT, *PUSHORT;
+typedef int16_t             SHORT;
+typedef uint32_t            ULONG, *PULONG;
+typedef int32_t             LONG, *PLONG;
+typedef int64_t             LONGLONG, LONG64;
+typedef uint64_t            ULONGLONG, ULONG64;
+typedef size_t              SIZE_T;
+typedef uintptr_t           ULONG_PTR;
+typedef wchar_t             WCHAR;
+typedef UCHAR               BOOLEAN;
+typedef LONG                NTSTATUS;
+
+#define MAXULONG                0xFFFFFFFFUL
+
+#define __int64                 long long
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+#define FORCEINLINE             inline __attribute__((always_inline))
+#define SYSTEM_CACHE_ALIGNMENT_SIZE 64
+#define DECLSPEC_CACHEALIGN     alignas(SYSTEM_CACHE_ALIGNMENT_SIZE)
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+#define NT_ASSERT(E)            assert(E)
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// STATUS CODES
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#define STATUS_SUCCESS                  ((NTSTATUS)0x00000000L)
+#define STATUS_BUFFER_OVERFLOW          ((NTSTATUS)0x80000005L)
+#define STATUS_UNSUCCESSFUL             ((NTSTATUS)0xC0000001L)
+#define STATUS_NOT_IMPLEMENTED          ((NTSTATUS)0xC0000002L)
+#define STATUS_INVALID_PARAMETER        ((NTSTATUS)0xC000000DL)
+#define STATUS_INSUFFICIENT_RESOURCES   ((NTSTATUS)0xC000009AL)
+#define STATUS_BUFFER_TOO_SMALL         ((NTSTATUS)0xC0000023L)
+#define STATUS_ACCESS_DENIED            ((NTSTATUS)0xC0000022L)
+#define STATUS_DEVICE_NOT_READY         ((NTSTATUS)0xC00000A3L)
+#define STATUS_INVALID_DEVICE_REQUEST   ((NTSTATUS)0xC0000010L)
+#define STATUS_NO_MATCH                 ((NTSTATUS)0xC0000272L)
+#define STATUS_NOT_SUPPORTED            ((NTSTATUS)0xC00000BBL)
+
+#define NT_SUCCESS(Status) (((NTSTATUS)(Status)) >= 0)
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MEMORY
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#define RtlCopyMemory(Destination, Source, Length) memcpy((Destination), (Source), (Length))
+#define RtlMoveMemory(Destination, Source, Length) memmove((Destination), (Source), (Length))
+#define RtlZeroMemory(Destination, Length)         memset((Destination), 0, (Length))
+#define RtlFillMemory(Destination, Length, Fill)   memset((Destination), (Fill), (Length))
+
+// Nonpaged pool is the C heap. ExAllocatePool2 zeroes unless told otherwise.
+typedef ULONG64 POOL_FLAGS;
+#define POOL_FLAG_UNINITIALIZED 0x0000000000000002ULL
+#define POOL_FLAG_NON_PAGED     0x0000000000000040ULL
+
+FORCEINLINE PVOID ExAllocatePool2(POOL_FLAGS Flags, SIZE_T NumberOfBytes, ULONG Tag)
+{
+    UNREFERENCED_PARAMETER(Tag);
+    return (Flags & POOL_FLAG_UNINITIALIZED) ? malloc(NumberOfBytes) : calloc(1, NumberOfBytes);
+}
+
+FORCEINLINE void ExFreePoolWithTag(PVOID P, ULONG Tag)
+{
+    UNREFERENCED_PARAMETER(Tag);
+    free(P);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ETW
+// The evntprov.h types the event writers build; there is no provider to write to.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef ULONGLONG REGHANDLE;
+
+typedef struct _EVENT_DESCRIPTOR
+{
+    USHORT    Id;
+    UCHAR     Version;
+    UCHAR     Channel;
+    UCHAR     Level;
+    UCHAR     Opcode;
+    USHORT    Task;
+    ULONGLONG Keyword;
+} EVENT_DESCRIPTOR, *PEVENT_DESCRIPTOR;
+
+typedef const EVENT_DESCRIPTOR* PCEVENT_DESCRIPTOR;
+
+typedef struct _EVENT_DATA_DESCRIPTOR
+{
+    ULONGLONG Ptr;
+    ULONG     Size;
+    ULONG     Reserved;
+} EVENT_DATA_DESCRIPTOR, *PEVENT_DATA_DESCRIPTOR;
+
+FORCEINLINE void EventDataDescCreate(PEVENT_DATA_DESCRIPTOR EventDataDescriptor, const void* DataPtr, ULONG DataSize)
+{
+    EventDataDescriptor->Ptr      = (ULONGLONG)(ULONG_PTR)DataPtr;
+    EventDataDescriptor->Size     = DataSize;
+    EventDataDescriptor->Reserved = 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ATOMICS
+// Acquire/release and Interlocked routines mapped onto the GCC __atomic builtins.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+FORCEINLINE LONG   ReadAcquire(LONG const volatile* Source)       { return __atomic_load_n(Source, __ATOMIC_ACQUIRE); }
+FORCEINLINE LONG   ReadNoFence(LONG const volatile* Source)       { return __atomic_load_n(Source, __ATOMIC_RELAXED); }
+FORCEINLINE void   WriteRelease(LONG volatile* Dest, LONG Value)  { __atomic_store_n(Dest, Value, __ATOMIC_RELEASE); }
+FORCEINLINE void   WriteNoFence(LONG volatile* Dest, LONG Value)  { __atomic_store_n(Dest, Value, __ATOMIC_RELAXED); }
+
+FORCEINLINE LONG64 ReadAcquire64(LONG64 const volatile* Source)        { return __atomic_load_n(Source, __ATOMIC_ACQUIRE); }
+FORCEINLINE LONG64 ReadNoFence64(LONG64 const volatile* Source)        { return __atomic_load_n(Source, __ATOMIC_RELAXED); }
+FORCEINLINE void   WriteRelease64(LONG64 volatile* Dest, LONG64 Value) { __atomic_store_n(Dest, Value, __ATOMIC_RELEASE); }
+FORCEINLINE void   WriteNoFence64(LONG64 volatile* Dest, LONG64 Value) { __atomic_store_n(Dest, Value, __ATOMIC_RELAXED); }
+
+FORCEINLINE LONG InterlockedIncrement(LONG volatile* Addend)                  { return __atomic_add_fetch(Addend, 1, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG InterlockedDecrement(LONG volatile* Addend)                  { return __atomic_sub_fetch(Addend, 1, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG InterlockedExchange(LONG volatile* Target, LONG Value)       { return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG InterlockedExchangeAdd(LONG volatile* Addend, LONG Value)    { return __atomic_fetch_add(Addend, Value, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG InterlockedOr(LONG volatile* Dest, LONG Value)              { return __atomic_fetch_or(Dest, Value, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG InterlockedAnd(LONG volatile* Dest, LONG Value)             { return __atomic_fetch_and(Dest, Value, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG InterlockedCompareExchange(LONG volatile* Dest, LONG Exchange, LONG Comparand)
+{
+    __atomic_compare_exchange_n(Dest, &Comparand, Exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return Comparand;
+}
+
+FORCEINLINE LONG64 InterlockedIncrement64(LONG64 volatile* Addend)               { return __atomic_add_fetch(Addend, 1, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG64 InterlockedDecrement64(LONG64 volatile* Addend)               { return __atomic_sub_fetch(Addend, 1, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG64 InterlockedExchange64(LONG64 volatile* Target, LONG64 Value)  { return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG64 InterlockedExchangeAdd64(LONG64 volatile* Addend, LONG64 Value) { return __atomic_fetch_add(Addend, Value, __ATOMIC_SEQ_CST); }
+FORCEINLINE LONG64 InterlockedCompareExchange64(LONG64 volatile* Dest, LONG64 Exchange, LONG64 Comparand)
+{
+    __atomic_compare_exchange_n(Dest, &Comparand, Exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return Comparand;
+}
+
+FORCEINLINE BOOLEAN BitScanForward(ULONG* Index, ULONG Mask)
+{
+    if (!Mask) return FALSE;
+    *Index = (ULONG)__builtin_ctz(Mask);
+    return TRUE;
+}
+
+FORCEINLINE ULONG64 UnsignedMultiplyHigh(ULONG64 Multiplier, ULONG64 Multiplicand)
+{
+    return (ULONG64)(((unsigned __int128)Multiplier * Multiplicand) >> 64);
+}
+
+FORCEINLINE void MemoryBarrier() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+#if defined(__x86_64__) || defined(__i386__)
+FORCEINLINE void YieldProcessor() { __builtin_ia32_pause(); }
+#else
+FORCEINLINE void YieldProcessor() {}
+#endif
+
+// Extended processor state: user mode has no kernel save area to manage, so saving
+// AVX state always succeeds and is a no-op.
+#define XSTATE_MASK_AVX         (1ULL << 2)
+
+typedef struct _XSTATE_SAVE
+{
+    ULONG64 Reserved;
+} XSTATE_SAVE, *PXSTATE_SAVE;
+
+FORCEINLINE NTSTATUS KeSaveExtendedProcessorState(ULONG64 Mask, PXSTATE_SAVE XStateSave)
+{
+    UNREFERENCED_PARAMETER(Mask);
+    XStateSave->Reserved = 0;
+    return STATUS_SUCCESS;
+}
+
+FORCEINLINE void KeRestoreExtendedProcessorState(PXSTATE_SAVE XStateSave) { UNREFERENCED_PARAMETER(XStateSave); }